@@ -2919,6 +2919,7 @@ acl_plugin_show_sessions (acl_main_t * am,
 	  vlib_cli_output (vm, "    link prev index: %u",
 			   sess->link_prev_idx);
 	  vlib_cli_output (vm, "    link list id: %u", sess->link_list_id);
+	  vlib_cli_output (vm, "    timer handle: %u", sess->timer_handle);
 	}
       vlib_cli_output (vm, "  connection add/del stats:", wk);
       pool_foreach (swif, im->sw_interfaces, (
@@ -2949,22 +2950,18 @@ acl_plugin_show_sessions (acl_main_t * am,
 					       }
 		    ));
 
-      vlib_cli_output (vm, "  connection timeout type lists:", wk);
+      vlib_cli_output (vm, "  session timers:");
       u8 tt = 0;
       for (tt = 0; tt < ACL_N_TIMEOUTS; tt++)
-	{
-	  u32 head_session_index = pw->fa_conn_list_head[tt];
-	  vlib_cli_output (vm, "  fa_conn_list_head[%d]: %d", tt,
-			   head_session_index);
-	  if (~0 != head_session_index)
-	    {
-	      fa_session_t *sess = pw->fa_sessions_pool + head_session_index;
-	      vlib_cli_output (vm, "    last active time: %lu",
-			       sess->last_active_time);
-	      vlib_cli_output (vm, "    link enqueue time: %lu",
-			       sess->link_enqueue_time);
-	    }
-	}
+	vlib_cli_output (vm,
+			 "    timeout type %d: started %lu, restarted at expiry %lu, expired %lu",
+			 tt, pw->cnt_session_timer_started_by_type[tt],
+			 pw->cnt_session_timer_restarted_by_type[tt],
+			 pw->cnt_deleted_sessions_by_type[tt]);
+      vlib_cli_output (vm, "  recycle list head: %d",
+		       pw->fa_recycle_list_head);
+      vlib_cli_output (vm, "  Count of recycled sessions: %lu",
+		       pw->cnt_recycled_sessions);
 
       vlib_cli_output (vm, "  Next expiry time: %lu", pw->next_expiry_time);
       vlib_cli_output (vm, "  Requeue until time: %lu",
@@ -2977,8 +2974,8 @@ acl_plugin_show_sessions (acl_main_t * am,
 		       pw->cnt_already_deleted_sessions);
       vlib_cli_output (vm, "  Session timers restarted: %lu",
 		       pw->cnt_session_timer_restarted);
-      vlib_cli_output (vm, "  Swipe until this time: %lu",
-		       pw->swipe_end_time);
+      vlib_cli_output (vm, "  Swipe at session index: %d",
+		       pw->swipe_session_index);
       vlib_cli_output (vm, "  sw_if_index serviced bitmap: %U",
 		       format_bitmap_hex, pw->serviced_sw_if_index_bitmap);
       vlib_cli_output (vm, "  pending clear intfc bitmap : %U",
@@ -3225,6 +3222,306 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
   return error;
 }
 
+/*
+ * Rule set generation for the lookup benchmark, loosely following the
+ * ClassBench ACL seed distributions: mostly host and /24 prefixes,
+ * TCP and UDP dominated, wildcard source ports, and destination ports
+ * which are exact, the ephemeral range, an arbitrary range or any.
+ */
+static u8
+acl_bench_prefix_len (u32 * seed)
+{
+  u32 r = random_u32 (seed) % 16;
+
+  if (r < 6)
+    return 32;
+  if (r < 10)
+    return 24;
+  if (r < 12)
+    return 16;
+  if (r < 13)
+    return 8;
+  if (r < 14)
+    return 0;
+  return 17 + random_u32 (seed) % 15;
+}
+
+static u32
+acl_bench_prefix_mask (u8 len)
+{
+  return (len ? ~((1ULL << (32 - len)) - 1) : 0);
+}
+
+static void
+acl_bench_make_rule (vl_api_acl_rule_t * r, u32 * seed)
+{
+  u32 src, dst, rnd;
+  u16 first, last;
+
+  memset (r, 0, sizeof (*r));
+  r->is_permit = random_u32 (seed) & 1;
+  r->src_ip_prefix_len = acl_bench_prefix_len (seed);
+  r->dst_ip_prefix_len = acl_bench_prefix_len (seed);
+  src = random_u32 (seed) & acl_bench_prefix_mask (r->src_ip_prefix_len);
+  dst = random_u32 (seed) & acl_bench_prefix_mask (r->dst_ip_prefix_len);
+  *(u32 *) r->src_ip_addr = clib_host_to_net_u32 (src);
+  *(u32 *) r->dst_ip_addr = clib_host_to_net_u32 (dst);
+
+  rnd = random_u32 (seed) % 10;
+  r->proto = (rnd < 6 ? IPPROTO_TCP : rnd < 9 ? IPPROTO_UDP : 0);
+
+  first = 0;
+  last = 65535;
+  if (random_u32 (seed) % 100 < 15)
+    first = last = random_u32 (seed);
+  r->srcport_or_icmptype_first = clib_host_to_net_u16 (first);
+  r->srcport_or_icmptype_last = clib_host_to_net_u16 (last);
+
+  rnd = random_u32 (seed) % 10;
+  if (rnd < 4)
+    {
+      first = last = random_u32 (seed) % 1024;
+    }
+  else if (rnd < 6)
+    {
+      first = 1024;
+      last = 65535;
+    }
+  else if (rnd < 8)
+    {
+      first = random_u32 (seed) % 64512;
+      last = first + random_u32 (seed) % 1024;
+    }
+  else
+    {
+      first = 0;
+      last = 65535;
+    }
+  r->dstport_or_icmpcode_first = clib_host_to_net_u16 (first);
+  r->dstport_or_icmpcode_last = clib_host_to_net_u16 (last);
+}
+
+/*
+ * Make a packet 5-tuple which falls within a given rule
+ */
+static void
+acl_bench_make_5tuple (fa_5tuple_t * pkt, const vl_api_acl_rule_t * r,
+		       u32 sw_if_index, u32 * seed)
+{
+  u32 mask;
+  u16 first, last;
+
+  memset (pkt, 0, sizeof (*pkt));
+  mask = acl_bench_prefix_mask (r->src_ip_prefix_len);
+  pkt->addr[0].ip4.as_u32 =
+    clib_host_to_net_u32 ((clib_net_to_host_u32 (*(u32 *) r->src_ip_addr) &
+			   mask) | (random_u32 (seed) & ~mask));
+  mask = acl_bench_prefix_mask (r->dst_ip_prefix_len);
+  pkt->addr[1].ip4.as_u32 =
+    clib_host_to_net_u32 ((clib_net_to_host_u32 (*(u32 *) r->dst_ip_addr) &
+			   mask) | (random_u32 (seed) & ~mask));
+
+  pkt->l4.proto = (r->proto ? r->proto : IPPROTO_TCP);
+  first = clib_net_to_host_u16 (r->srcport_or_icmptype_first);
+  last = clib_net_to_host_u16 (r->srcport_or_icmptype_last);
+  pkt->l4.port[0] = first + random_u32 (seed) % (last - first + 1);
+  first = clib_net_to_host_u16 (r->dstport_or_icmpcode_first);
+  last = clib_net_to_host_u16 (r->dstport_or_icmpcode_last);
+  pkt->l4.port[1] = first + random_u32 (seed) % (last - first + 1);
+
+  pkt->pkt.sw_if_index = sw_if_index;
+  pkt->pkt.is_input = 1;
+  pkt->pkt.l4_valid = 1;
+  if (IPPROTO_TCP == pkt->l4.proto)
+    {
+      pkt->pkt.tcp_flags = TCP_FLAG_SYN;
+      pkt->pkt.tcp_flags_valid = 1;
+    }
+}
+
+/*
+ * Write a packet with the given 5-tuple into a buffer, as ip4-input
+ * hands it over to the input ACL node
+ */
+static void
+acl_bench_make_buffer (vlib_buffer_t * b, fa_5tuple_t * pkt)
+{
+  ip4_header_t *ip;
+  tcp_header_t *tcp;
+
+  b->current_data = 0;
+  b->current_length = sizeof (*ip) + sizeof (*tcp);
+  ip = vlib_buffer_get_current (b);
+  memset (ip, 0, b->current_length);
+  ip->ip_version_and_header_length = 0x45;
+  ip->ttl = 64;
+  ip->protocol = pkt->l4.proto;
+  ip->length = clib_host_to_net_u16 (b->current_length);
+  ip->src_address.as_u32 = pkt->addr[0].ip4.as_u32;
+  ip->dst_address.as_u32 = pkt->addr[1].ip4.as_u32;
+  ip->checksum = ip4_header_checksum (ip);
+
+  /* the udp ports are where the tcp ones are */
+  tcp = (tcp_header_t *) (ip + 1);
+  tcp->src_port = clib_host_to_net_u16 (pkt->l4.port[0]);
+  tcp->dst_port = clib_host_to_net_u16 (pkt->l4.port[1]);
+  tcp->flags = pkt->pkt.tcp_flags;
+
+  vnet_buffer (b)->sw_if_index[VLIB_RX] = pkt->pkt.sw_if_index;
+}
+
+/*
+ * Benchmark the rule lookup: build a synthetic ACL, apply it, and time
+ * the lookups of 5-tuples drawn from its rules. With "node", also time
+ * frames of such packets through the staged passes of the ip4 input
+ * node; with "sessions", the permit rules are reflexive, so that
+ * after the first pass the permitted packets hit their sessions. Not
+ * for a live system.
+ */
+static clib_error_t *
+acl_test_aclplugin_lookup_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  u32 n_rules = 10000, n_pkts = 1000000, n_tuples = 1 << 16;
+  u32 seed = 0xdeadbeef, acl_index = ~0, sw_if_index, ii;
+  u32 n_matched = 0, n_permitted = 0;
+  u32 acl_match, rule_match, trace_bitmap;
+  u32 *buffers = 0, n_buffers, n_frames, n;
+  u64 c_node, n_session_adds;
+  u8 action, node = 0, sessions = 0;
+  vl_api_acl_rule_t *rules = 0;
+  fa_5tuple_t *pkts = 0;
+  u8 tag[64] = "lookup benchmark";
+  f64 t_start, t_build, t_lookup;
+  u64 c_start, c_lookup;
+  applied_hash_acl_info_t *pal;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rules %d", &n_rules))
+	;
+      else if (unformat (input, "packets %d", &n_pkts))
+	;
+      else if (unformat (input, "seed %d", &seed))
+	;
+      else if (unformat (input, "node"))
+	node = 1;
+      else if (unformat (input, "sessions"))
+	sessions = 1;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+  if (0 == n_rules || 0 == n_pkts)
+    return clib_error_return (0, "rules and packets must be non-zero");
+
+  /*
+   * apply on an interface index no interface uses yet, so that
+   * the benchmark does not interfere with the live lookups.
+   */
+  sw_if_index = pool_len (am->vnet_main->interface_main.sw_interfaces);
+
+  vec_validate (rules, n_rules - 1);
+  for (ii = 0; ii < n_rules; ii++)
+    {
+      acl_bench_make_rule (&rules[ii], &seed);
+      if (sessions && rules[ii].is_permit)
+	rules[ii].is_permit = 2;
+    }
+
+  t_start = vlib_time_now (vm);
+  rv = acl_add_list (n_rules, rules, &acl_index, tag);
+  if (rv)
+    {
+      vec_free (rules);
+      return clib_error_return (0, "failed to add the ACL: %d", rv);
+    }
+  hash_acl_apply (am, sw_if_index, 1, acl_index);
+  t_build = vlib_time_now (vm) - t_start;
+
+  n_tuples = clib_min (n_tuples, n_pkts);
+  vec_validate (pkts, n_tuples - 1);
+  for (ii = 0; ii < n_tuples; ii++)
+    acl_bench_make_5tuple (&pkts[ii], &rules[random_u32 (&seed) % n_rules],
+			   sw_if_index, &seed);
+
+  t_start = vlib_time_now (vm);
+  c_start = clib_cpu_time_now ();
+  for (ii = 0; ii < n_pkts; ii++)
+    {
+      trace_bitmap = 0;
+      acl_match = ~0;
+      action = hash_multi_acl_match_5tuple
+	(sw_if_index, &pkts[ii % n_tuples], 0, 0, 1, &acl_match,
+	 &rule_match, &trace_bitmap);
+      n_matched += (acl_match != ~0);
+      n_permitted += (action != 0);
+    }
+  c_lookup = clib_cpu_time_now () - c_start;
+  t_lookup = vlib_time_now (vm) - t_start;
+
+  pal = vec_elt_at_index (am->input_applied_hash_acl_info_by_sw_if_index,
+			  sw_if_index);
+  vlib_cli_output (vm, "%d rules, %d mask types to probe, built in %.3fms",
+		   n_rules,
+		   vec_len (pal->mask_info_by_partition
+			    [hash_acl_partition_index (0, 0)]),
+		   t_build * 1e3);
+  vlib_cli_output (vm, "%d lookups in %.3fs, %.2f lookups/sec",
+		   n_pkts, t_lookup, (f64) n_pkts / t_lookup);
+  vlib_cli_output (vm, "%d matched a rule, %d permitted", n_matched,
+		   n_permitted);
+  vlib_cli_output (vm, "%.2f clocks/lookup", (f64) c_lookup / n_pkts);
+
+  if (node)
+    {
+      /* whole frames of buffers, unless there are fewer packets */
+      n_buffers = n_tuples;
+      if (n_buffers >= VLIB_FRAME_SIZE)
+	n_buffers = clib_min (n_buffers, 4 * VLIB_FRAME_SIZE)
+	  & ~(VLIB_FRAME_SIZE - 1);
+      vec_validate (buffers, n_buffers - 1);
+      n = vlib_buffer_alloc (vm, buffers, n_buffers);
+      if (n != n_buffers)
+	{
+	  vlib_buffer_free (vm, buffers, n);
+	  vlib_cli_output (vm, "node: only %d of %d buffers", n, n_buffers);
+	  goto done;
+	}
+      for (ii = 0; ii < n_buffers; ii++)
+	acl_bench_make_buffer (vlib_get_buffer (vm, buffers[ii]), &pkts[ii]);
+
+      n_frames = clib_max (n_pkts / VLIB_FRAME_SIZE, 1);
+      n_session_adds = am->fa_session_total_adds;
+      c_node = acl_fa_node_bench (vm, buffers, n_buffers, n_frames);
+      n_session_adds = am->fa_session_total_adds - n_session_adds;
+      n = n_frames * clib_min (n_buffers, VLIB_FRAME_SIZE);
+
+      vlib_cli_output (vm, "node: %d packets in frames of %d, "
+		       "%.2f clocks/packet, %lld sessions added",
+		       n, clib_min (n_buffers, VLIB_FRAME_SIZE),
+		       (f64) c_node / n, n_session_adds);
+
+      vlib_buffer_free (vm, buffers, n_buffers);
+      if (n_session_adds)
+	vlib_process_signal_event (am->vlib_main, am->fa_cleaner_node_index,
+				   ACL_FA_CLEANER_DELETE_BY_SW_IF_INDEX,
+				   sw_if_index);
+    }
+
+done:
+  hash_acl_unapply (am, sw_if_index, 1, acl_index);
+  acl_del_list (acl_index);
+  vec_free (rules);
+  vec_free (pkts);
+  vec_free (buffers);
+
+  return (NULL);
+}
+
 static clib_error_t *
 acl_clear_aclplugin_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -3296,6 +3593,12 @@ VLIB_CLI_COMMAND (aclplugin_clear_command, static) = {
     .short_help = "clear acl-plugin sessions",
     .function = acl_clear_aclplugin_fn,
 };
+
+VLIB_CLI_COMMAND (aclplugin_test_lookup_command, static) = {
+    .path = "test acl-plugin lookup",
+    .short_help = "test acl-plugin lookup [rules <n>] [packets <n>] [seed <n>] [node [sessions]]",
+    .function = acl_test_aclplugin_lookup_fn,
+};
 /* *INDENT-ON* */
 
 static clib_error_t *
@@ -3386,17 +3689,17 @@ acl_init (vlib_main_t * vm)
   vec_validate (am->per_worker_data, tm->n_vlib_mains - 1);
   {
     u16 wk;
-    u8 tt;
     for (wk = 0; wk < vec_len (am->per_worker_data); wk++)
       {
 	acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
-	vec_validate (pw->fa_conn_list_head, ACL_N_TIMEOUTS - 1);
-	vec_validate (pw->fa_conn_list_tail, ACL_N_TIMEOUTS - 1);
-	for (tt = 0; tt < ACL_N_TIMEOUTS; tt++)
-	  {
-	    pw->fa_conn_list_head[tt] = ~0;
-	    pw->fa_conn_list_tail[tt] = ~0;
-	  }
+	vec_validate (pw->cnt_session_timer_started_by_type,
+		      ACL_N_TIMEOUTS - 1);
+	vec_validate (pw->cnt_session_timer_restarted_by_type,
+		      ACL_N_TIMEOUTS - 1);
+	vec_validate (pw->cnt_deleted_sessions_by_type, ACL_N_TIMEOUTS - 1);
+	pw->fa_recycle_list_head = ~0;
+	pw->fa_recycle_list_tail = ~0;
+	pw->swipe_session_index = ~0;
       }
   }
 
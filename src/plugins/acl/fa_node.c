@@ -545,12 +545,6 @@ acl_make_5tuple_session_key (int is_input, fa_5tuple_t * p5tuple_pkt,
 }
 
 
-static int
-acl_fa_ifc_has_sessions (acl_main_t * am, int sw_if_index0)
-{
-  return am->fa_sessions_hash_is_initialized;
-}
-
 static int
 acl_fa_ifc_has_in_acl (acl_main_t * am, int sw_if_index0)
 {
@@ -594,46 +588,36 @@ fa_session_get_timeout_type (acl_main_t * am, fa_session_t * sess)
 }
 
 
-static u64
-fa_session_get_shortest_timeout(acl_main_t * am)
-{
-  int timeout_type;
-  u64 timeout = ~0LL;
-  for(timeout_type = 0; timeout_type < ACL_N_TIMEOUTS; timeout_type++) {
-    if (timeout > am->session_timeout_sec[timeout_type]) {
-      timeout = am->session_timeout_sec[timeout_type];
-    }
-  }
-  return timeout;
-}
-
 /*
- * Get the timeout of the session in a list since its enqueue time.
+ * Get the idle timeout of a session.
  */
 
 static u64
-fa_session_get_list_timeout (acl_main_t * am, fa_session_t * sess)
+fa_session_get_timeout (acl_main_t * am, fa_session_t * sess)
 {
   u64 timeout = am->vlib_main->clib_time.clocks_per_second;
-  /*
-   * we have the shortest possible timeout type in all the lists
-   * (see README-multicore for the rationale)
-   */
-  timeout *= fa_session_get_shortest_timeout(am);
+  int timeout_type = fa_session_get_timeout_type (am, sess);
+  timeout *= am->session_timeout_sec[timeout_type];
   return timeout;
 }
 
 /*
- * Get the idle timeout of a session.
+ * The session timer wheels run off the CPU clock rather than
+ * the per-thread vlib time, so that the main thread can set them
+ * up on behalf of the workers.
  */
 
-static u64
-fa_session_get_timeout (acl_main_t * am, fa_session_t * sess)
+static f64
+acl_fa_session_timer_now (acl_main_t * am, u64 now)
 {
-  u64 timeout = am->vlib_main->clib_time.clocks_per_second;
-  int timeout_type = fa_session_get_timeout_type (am, sess);
-  timeout *= am->session_timeout_sec[timeout_type];
-  return timeout;
+  return now * am->vlib_main->clib_time.seconds_per_clock;
+}
+
+static u32
+acl_fa_session_timer_ticks (f64 seconds)
+{
+  u64 ticks = seconds / ACL_FA_SESSION_TIMER_INTERVAL + 1;
+  return clib_min (ticks, ACL_FA_SESSION_TIMER_MAX_TICKS);
 }
 
 static void
@@ -641,6 +625,8 @@ acl_fa_verify_init_sessions (acl_main_t * am)
 {
   if (!am->fa_sessions_hash_is_initialized) {
     u16 wk;
+    f64 now = acl_fa_session_timer_now (am, clib_cpu_time_now ());
+    void *oldheap = clib_mem_set_heap (am->acl_mheap);
     /* Allocate the per-worker sessions pools */
     for (wk = 0; wk < vec_len (am->per_worker_data); wk++) {
       acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
@@ -651,7 +637,15 @@ acl_fa_verify_init_sessions (acl_main_t * am)
       * clib_bitmap_validate(pool_header(pw->fa_sessions_pool)->free_bitmap, am->fa_conn_table_max_entries);
       */
       pool_init_fixed(pw->fa_sessions_pool, am->fa_conn_table_max_entries);
+
+      /* ... and the idle timers of those sessions */
+      pw->session_timer_wheel = clib_mem_alloc (sizeof (tw_timer_wheel_16t_2w_512sl_t));
+      tw_timer_wheel_init_16t_2w_512sl (pw->session_timer_wheel, 0,
+                                        ACL_FA_SESSION_TIMER_INTERVAL,
+                                        am->fa_max_deleted_sessions_per_interval);
+      pw->session_timer_wheel->last_run_time = now;
     }
+    clib_mem_set_heap (oldheap);
 
     /* ... and the interface session hash table */
     BV (clib_bihash_init) (&am->fa_sessions_hash,
@@ -669,90 +663,143 @@ static inline fa_session_t *get_session_ptr(acl_main_t *am, u16 thread_index, u3
   return sess;
 }
 
-static inline int is_valid_session_ptr(acl_main_t *am, u16 thread_index, fa_session_t *sess)
-{
-  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  return ((sess != 0) && ((sess - pw->fa_sessions_pool) < pool_len(pw->fa_sessions_pool)));
-}
+/*
+ * The TCP transient sessions of a worker are also kept on a list
+ * in the order they became transient, so the oldest one can be
+ * recycled when the session table is full. Only the owner thread
+ * may touch the list.
+ */
 
 static void
-acl_fa_conn_list_add_session (acl_main_t * am, fa_full_session_id_t sess_id, u64 now)
+acl_fa_recycle_list_add_session (acl_main_t * am, fa_full_session_id_t sess_id, u64 now)
 {
   fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
-  u8 list_id = fa_session_get_timeout_type(am, sess);
   uword thread_index = os_get_thread_index ();
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
   /* the retrieved session thread index must be necessarily the same as the one in the key */
   ASSERT (sess->thread_index == sess_id.thread_index);
   /* the retrieved session thread index must be the same as current thread */
   ASSERT (sess->thread_index == thread_index);
+  ASSERT (sess->link_list_id != ACL_TIMEOUT_TCP_TRANSIENT);
   sess->link_enqueue_time = now;
-  sess->link_list_id = list_id;
+  sess->link_list_id = ACL_TIMEOUT_TCP_TRANSIENT;
   sess->link_next_idx = ~0;
-  sess->link_prev_idx = pw->fa_conn_list_tail[list_id];
-  if (~0 != pw->fa_conn_list_tail[list_id]) {
-    fa_session_t *prev_sess = get_session_ptr(am, thread_index, pw->fa_conn_list_tail[list_id]);
+  sess->link_prev_idx = pw->fa_recycle_list_tail;
+  if (~0 != pw->fa_recycle_list_tail) {
+    fa_session_t *prev_sess = get_session_ptr(am, thread_index, pw->fa_recycle_list_tail);
     prev_sess->link_next_idx = sess_id.session_index;
     /* We should never try to link with a session on another thread */
     ASSERT(prev_sess->thread_index == sess->thread_index);
   }
-  pw->fa_conn_list_tail[list_id] = sess_id.session_index;
-  pw->serviced_sw_if_index_bitmap = clib_bitmap_set(pw->serviced_sw_if_index_bitmap, sess->sw_if_index, 1);
+  pw->fa_recycle_list_tail = sess_id.session_index;
 
-  if (~0 == pw->fa_conn_list_head[list_id]) {
-    pw->fa_conn_list_head[list_id] = sess_id.session_index;
+  if (~0 == pw->fa_recycle_list_head) {
+    pw->fa_recycle_list_head = sess_id.session_index;
   }
 }
 
-static int
-acl_fa_conn_list_delete_session (acl_main_t *am, fa_full_session_id_t sess_id)
+static void
+acl_fa_recycle_list_delete_session (acl_main_t *am, fa_full_session_id_t sess_id)
 {
   uword thread_index = os_get_thread_index ();
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  if (thread_index != sess_id.thread_index) {
-    /* If another thread attempts to delete the session, fail it. */
-#ifdef FA_NODE_VERBOSE_DEBUG
-    clib_warning("thread id in key %d != curr thread index, not deleting");
-#endif
-    return 0;
-  }
   fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
   /* we should never try to delete the session with another thread index */
   ASSERT(sess->thread_index == thread_index);
+  if (sess->link_list_id != ACL_TIMEOUT_TCP_TRANSIENT)
+    return;
   if (~0 != sess->link_prev_idx) {
     fa_session_t *prev_sess = get_session_ptr(am, thread_index, sess->link_prev_idx);
-    /* the previous session must be in the same list as this one */
-    ASSERT(prev_sess->link_list_id == sess->link_list_id);
     prev_sess->link_next_idx = sess->link_next_idx;
   }
   if (~0 != sess->link_next_idx) {
     fa_session_t *next_sess = get_session_ptr(am, thread_index, sess->link_next_idx);
-    /* The next session must be in the same list as the one we are deleting */
-    ASSERT(next_sess->link_list_id == sess->link_list_id);
     next_sess->link_prev_idx = sess->link_prev_idx;
   }
-  if (pw->fa_conn_list_head[sess->link_list_id] == sess_id.session_index) {
-    pw->fa_conn_list_head[sess->link_list_id] = sess->link_next_idx;
+  if (pw->fa_recycle_list_head == sess_id.session_index) {
+    pw->fa_recycle_list_head = sess->link_next_idx;
   }
-  if (pw->fa_conn_list_tail[sess->link_list_id] == sess_id.session_index) {
-    pw->fa_conn_list_tail[sess->link_list_id] = sess->link_prev_idx;
+  if (pw->fa_recycle_list_tail == sess_id.session_index) {
+    pw->fa_recycle_list_tail = sess->link_prev_idx;
+  }
+  sess->link_list_id = ~0;
+  sess->link_prev_idx = ~0;
+  sess->link_next_idx = ~0;
+}
+
+/*
+ * Bring the recycle list membership in line with the current
+ * timeout type of the session, which might have been changed by
+ * packets seen on another thread.
+ */
+static void
+acl_fa_recycle_list_update_session (acl_main_t * am, fa_full_session_id_t sess_id,
+                                    fa_session_t * sess, int timeout_type, u64 now)
+{
+  int is_transient = (ACL_TIMEOUT_TCP_TRANSIENT == timeout_type);
+  int is_listed = (ACL_TIMEOUT_TCP_TRANSIENT == sess->link_list_id);
+  if (is_transient && !is_listed)
+    acl_fa_recycle_list_add_session(am, sess_id, now);
+  else if (!is_transient && is_listed)
+    acl_fa_recycle_list_delete_session(am, sess_id);
+}
+
+/*
+ * Start the idle timer of a session owned by the current thread,
+ * for the given number of seconds. The wheel memory lives on
+ * the plugin heap, so the caller must have switched to it.
+ */
+static void
+acl_fa_session_timer_start (acl_main_t * am, fa_full_session_id_t sess_id,
+                            fa_session_t * sess, int timeout_type, f64 seconds)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[sess_id.thread_index];
+  ASSERT (sess_id.thread_index == os_get_thread_index ());
+  ASSERT (sess_id.session_index <= ACL_FA_SESSION_TIMER_HANDLE_MASK);
+  /*
+   * An established TCP session can turn transient through a packet
+   * seen by another worker, which can not touch our timer. So do not
+   * wait longer than the transient timeout before looking at it again.
+   */
+  if ((ACL_TIMEOUT_TCP_IDLE == timeout_type) && (vec_len (vlib_mains) > 1))
+    seconds = clib_min (seconds, am->session_timeout_sec[ACL_TIMEOUT_TCP_TRANSIENT]);
+  sess->timer_handle =
+    tw_timer_start_16t_2w_512sl (pw->session_timer_wheel,
+                                 sess_id.session_index, timeout_type,
+                                 acl_fa_session_timer_ticks (seconds));
+  pw->cnt_session_timer_started_by_type[timeout_type]++;
+}
+
+static void
+acl_fa_session_timer_stop (acl_main_t * am, fa_full_session_id_t sess_id,
+                           fa_session_t * sess)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[sess_id.thread_index];
+  ASSERT (sess_id.thread_index == os_get_thread_index ());
+  if (~0 != sess->timer_handle) {
+    tw_timer_stop_16t_2w_512sl (pw->session_timer_wheel, sess->timer_handle);
+    sess->timer_handle = ~0;
   }
-  return 1;
 }
 
 static int
 acl_fa_restart_timer_for_session (acl_main_t * am, u64 now, fa_full_session_id_t sess_id)
 {
-  if (acl_fa_conn_list_delete_session(am, sess_id)) {
-    acl_fa_conn_list_add_session(am, sess_id, now);
+  if (sess_id.thread_index == os_get_thread_index ()) {
+    fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
+    int timeout_type = fa_session_get_timeout_type (am, sess);
+    void *oldheap = clib_mem_set_heap (am->acl_mheap);
+    acl_fa_session_timer_stop (am, sess_id, sess);
+    acl_fa_session_timer_start (am, sess_id, sess, timeout_type,
+                                am->session_timeout_sec[timeout_type]);
+    acl_fa_recycle_list_update_session (am, sess_id, sess, timeout_type, now);
+    clib_mem_set_heap (oldheap);
     return 1;
   } else {
     /*
-     * Our thread does not own this connection, so we can not delete
-     * The session. To avoid the complicated signaling, we simply
-     * pick the list waiting time to be the shortest of the timeouts.
-     * This way we do not have to do anything special, and let
-     * the regular requeue check take care of everything.
+     * Our thread does not own this connection, so we can not touch
+     * its timer. The owner rechecks the session against its current
+     * timeout type when the timer expires, and reschedules it then.
      */
     return 0;
   }
@@ -790,6 +837,20 @@ acl_fa_delete_session (acl_main_t * am, u32 sw_if_index, fa_full_session_id_t se
   clib_smp_atomic_add(&am->fa_session_total_dels, 1);
 }
 
+/*
+ * Stop the timer of a session, take it off the recycle list and delete it.
+ */
+static void
+acl_fa_unlink_and_delete_session (acl_main_t * am, u32 sw_if_index, fa_full_session_id_t sess_id)
+{
+  fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
+  void *oldheap = clib_mem_set_heap(am->acl_mheap);
+  acl_fa_session_timer_stop (am, sess_id, sess);
+  clib_mem_set_heap (oldheap);
+  acl_fa_recycle_list_delete_session (am, sess_id);
+  acl_fa_delete_session (am, sw_if_index, sess_id);
+}
+
 static int
 acl_fa_can_add_session (acl_main_t * am, int is_input, u32 sw_if_index)
 {
@@ -798,89 +859,70 @@ acl_fa_can_add_session (acl_main_t * am, int is_input, u32 sw_if_index)
   return (curr_sess_count < am->fa_conn_table_max_entries);
 }
 
-static u64
-acl_fa_get_list_head_expiry_time(acl_main_t *am, acl_fa_per_worker_data_t *pw, u64 now, u16 thread_index, int timeout_type)
-{
-  fa_session_t *sess = get_session_ptr(am, thread_index, pw->fa_conn_list_head[timeout_type]);
-  /*
-   * We can not check just the index here because inbetween the worker thread might
-   * dequeue the connection from the head just as we are about to check it.
-   */
-  if (!is_valid_session_ptr(am, thread_index, sess)) {
-    return ~0LL; // infinity.
-  } else {
-    u64 timeout_time =
-              sess->link_enqueue_time + fa_session_get_list_timeout (am, sess);
-    return timeout_time;
-  }
-}
-
-static int
-acl_fa_conn_time_to_check (acl_main_t *am, acl_fa_per_worker_data_t *pw, u64 now, u16 thread_index, u32 session_index)
-{
-  fa_session_t *sess = get_session_ptr(am, thread_index, session_index);
-  u64 timeout_time =
-              sess->link_enqueue_time + fa_session_get_list_timeout (am, sess);
-  return (timeout_time < now) || (sess->link_enqueue_time <= pw->swipe_end_time);
-}
-
 /*
- * see if there are sessions ready to be checked,
- * do the maintenance (requeue or delete), and
- * return the total number of sessions reclaimed.
+ * Advance the session timer wheel of this thread and act on the
+ * expired timers in bulk: a session that saw traffic since its timer
+ * was started gets a new timer for the rest of its idle timeout,
+ * the others are deleted. The packets only ever touch the session
+ * timestamp, so this is the only place the timers get restarted,
+ * besides a change of the timeout type on the owner thread.
+ * Return the number of timers processed.
  */
 static int
 acl_fa_check_idle_sessions(acl_main_t *am, u16 thread_index, u64 now)
 {
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  f64 cps = am->vlib_main->clib_time.clocks_per_second;
   fa_full_session_id_t fsid;
   fsid.thread_index = thread_index;
   int total_expired = 0;
+  void *oldheap = clib_mem_set_heap (am->acl_mheap);
 
-  {
-    u8 tt = 0;
-    for(tt = 0; tt < ACL_N_TIMEOUTS; tt++) {
-      while((vec_len(pw->expired) < am->fa_max_deleted_sessions_per_interval)
-	    && (~0 != pw->fa_conn_list_head[tt])
-	    && (acl_fa_conn_time_to_check(am, pw, now, thread_index,
-					  pw->fa_conn_list_head[tt]))) {
-	fsid.session_index = pw->fa_conn_list_head[tt];
-	vec_add1(pw->expired, fsid.session_index);
-	acl_fa_conn_list_delete_session(am, fsid);
-      }
-    }
-  }
+  pw->session_timer_wheel->max_expirations = am->fa_max_deleted_sessions_per_interval;
+  pw->expired = tw_timer_expire_timers_vec_16t_2w_512sl (pw->session_timer_wheel,
+                                                         acl_fa_session_timer_now (am, now),
+                                                         pw->expired);
+  clib_mem_set_heap (oldheap);
 
-  u32 *psid = NULL;
-  vec_foreach (psid, pw->expired)
+  u32 *phandle = NULL;
+  vec_foreach (phandle, pw->expired)
   {
-    fsid.session_index = *psid;
+    fsid.session_index = *phandle & ACL_FA_SESSION_TIMER_HANDLE_MASK;
     if (!pool_is_free_index (pw->fa_sessions_pool, fsid.session_index))
       {
 	fa_session_t *sess = get_session_ptr(am, thread_index, fsid.session_index);
 	u32 sw_if_index = sess->sw_if_index;
+	int timeout_type = fa_session_get_timeout_type (am, sess);
 	u64 sess_timeout_time =
 	  sess->last_active_time + fa_session_get_timeout (am, sess);
-	if ((now < sess_timeout_time) && (0 == clib_bitmap_get(pw->pending_clear_sw_if_index_bitmap, sw_if_index)))
+	/* the timer has fired, so its handle is no longer valid */
+	sess->timer_handle = ~0;
+	if (now < sess_timeout_time)
 	  {
 #ifdef FA_NODE_VERBOSE_DEBUG
 	    clib_warning ("ACL_FA_NODE_CLEAN: Restarting timer for session %d",
-	       (int) session_index);
+	       (int) fsid.session_index);
 #endif
 	    /* There was activity on the session, so the idle timeout
-	       has not passed. Enqueue for another time period. */
-
-	    acl_fa_conn_list_add_session(am, fsid, now);
+	       has not passed. Wait for the remainder of it. */
+	    oldheap = clib_mem_set_heap (am->acl_mheap);
+	    acl_fa_session_timer_start (am, fsid, sess, timeout_type,
+	                                (sess_timeout_time - now) / cps);
+	    clib_mem_set_heap (oldheap);
+	    acl_fa_recycle_list_update_session (am, fsid, sess, timeout_type, now);
 	    pw->cnt_session_timer_restarted++;
+	    pw->cnt_session_timer_restarted_by_type[timeout_type]++;
 	  }
 	else
 	  {
 #ifdef FA_NODE_VERBOSE_DEBUG
 	    clib_warning ("ACL_FA_NODE_CLEAN: Deleting session %d",
-	       (int) session_index);
+	       (int) fsid.session_index);
 #endif
+	    acl_fa_recycle_list_delete_session (am, fsid);
 	    acl_fa_delete_session (am, sw_if_index, fsid);
 	    pw->cnt_deleted_sessions++;
+	    pw->cnt_deleted_sessions_by_type[timeout_type]++;
 	  }
       }
     else
@@ -892,27 +934,63 @@ acl_fa_check_idle_sessions(acl_main_t *am, u16 thread_index, u64 now)
   /* zero out the vector which we have acted on */
   if (pw->expired)
     _vec_len (pw->expired) = 0;
-  /* if we were advancing and reached the end
-   * (no more sessions to recycle), reset the fast-forward timestamp */
-
-  if (pw->swipe_end_time && 0 == total_expired)
-    pw->swipe_end_time = 0;
   return (total_expired);
 }
 
-always_inline void
+/*
+ * While clearing the sessions of some interfaces, walk a chunk of
+ * the session pool and delete the sessions on those interfaces.
+ * Return the number of sessions deleted, set the swipe index to ~0
+ * once the whole pool has been walked.
+ */
+static int
+acl_fa_swipe_sessions(acl_main_t *am, u16 thread_index)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  u32 n_walked = 0;
+  int n_deleted = 0;
+  fa_full_session_id_t fsid;
+  fsid.thread_index = thread_index;
+
+  while ((pw->swipe_session_index < pool_len (pw->fa_sessions_pool))
+         && (n_deleted < am->fa_max_deleted_sessions_per_interval)
+         && (n_walked < ACL_FA_SWIPE_SESSIONS_PER_INTERVAL))
+    {
+      fsid.session_index = pw->swipe_session_index++;
+      n_walked++;
+      if (pool_is_free_index (pw->fa_sessions_pool, fsid.session_index))
+        continue;
+      fa_session_t *sess = get_session_ptr(am, thread_index, fsid.session_index);
+      if (clib_bitmap_get(pw->pending_clear_sw_if_index_bitmap, sess->sw_if_index))
+        {
+          acl_fa_unlink_and_delete_session (am, sess->sw_if_index, fsid);
+          pw->cnt_deleted_sessions++;
+          n_deleted++;
+        }
+    }
+  if (pw->swipe_session_index >= pool_len (pw->fa_sessions_pool))
+    pw->swipe_session_index = ~0;
+  return n_deleted;
+}
+
+always_inline int
 acl_fa_try_recycle_session (acl_main_t * am, int is_input, u16 thread_index, u32 sw_if_index)
 {
   /* try to recycle a TCP transient session */
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  u8 timeout_type = ACL_TIMEOUT_TCP_TRANSIENT;
   fa_full_session_id_t sess_id;
-  sess_id.session_index = pw->fa_conn_list_head[timeout_type];
-  if (~0 != sess_id.session_index) {
-    sess_id.thread_index = thread_index;
-    acl_fa_conn_list_delete_session(am, sess_id);
-    acl_fa_delete_session(am, sw_if_index, sess_id);
+  sess_id.thread_index = thread_index;
+  while (~0 != (sess_id.session_index = pw->fa_recycle_list_head)) {
+    fa_session_t *sess = get_session_ptr(am, thread_index, sess_id.session_index);
+    if (ACL_TIMEOUT_TCP_TRANSIENT == fa_session_get_timeout_type (am, sess)) {
+      acl_fa_unlink_and_delete_session(am, sess->sw_if_index, sess_id);
+      pw->cnt_recycled_sessions++;
+      return 1;
+    }
+    /* established meanwhile via another thread, not a candidate */
+    acl_fa_recycle_list_delete_session(am, sess_id);
   }
+  return 0;
 }
 
 static fa_session_t *
@@ -925,6 +1003,7 @@ acl_fa_add_session (acl_main_t * am, int is_input, u32 sw_if_index, u64 now,
   uword thread_index = os_get_thread_index();
   void *oldheap = clib_mem_set_heap(am->acl_mheap);
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  int timeout_type;
 
   f_sess_id.thread_index = thread_index;
   fa_session_t *sess;
@@ -947,13 +1026,18 @@ acl_fa_add_session (acl_main_t * am, int is_input, u32 sw_if_index, u64 now,
   sess->link_list_id = ~0;
   sess->link_prev_idx = ~0;
   sess->link_next_idx = ~0;
+  sess->timer_handle = ~0;
 
 
 
   ASSERT(am->fa_sessions_hash_is_initialized == 1);
   BV (clib_bihash_add_del) (&am->fa_sessions_hash,
 			    &kv, 1);
-  acl_fa_conn_list_add_session(am, f_sess_id, now);
+  timeout_type = fa_session_get_timeout_type (am, sess);
+  acl_fa_session_timer_start (am, f_sess_id, sess, timeout_type,
+                              am->session_timeout_sec[timeout_type]);
+  acl_fa_recycle_list_update_session (am, f_sess_id, sess, timeout_type, now);
+  pw->serviced_sw_if_index_bitmap = clib_bitmap_set(pw->serviced_sw_if_index_bitmap, sw_if_index, 1);
 
   vec_validate (pw->fa_session_adds_by_sw_if_index, sw_if_index);
   clib_mem_set_heap (oldheap);
@@ -972,14 +1056,79 @@ acl_fa_find_session (acl_main_t * am, u32 sw_if_index0, fa_5tuple_t * p5tuple,
 }
 
 
-always_inline uword
-acl_fa_node_fn (vlib_main_t * vm,
-		vlib_node_runtime_t * node, vlib_frame_t * frame, int is_ip6,
-		int is_input, int is_l2_path, u32 * l2_feat_next_node_index,
-		vlib_node_registration_t * acl_fa_node)
+/*
+ * Extract the L3/L4 matching info into a 5-tuple structure,
+ * then create a session key whose layout is independent on forward or reverse
+ * direction of the packet.
+ */
+always_inline void
+acl_fa_make_5tuple_and_key (acl_main_t * am, vlib_buffer_t * b0,
+			    u32 sw_if_index0, int is_ip6, int is_input,
+			    int is_l2_path, fa_5tuple_t * p5tuple,
+			    fa_5tuple_t * kv_sess)
+{
+  acl_fill_5tuple (am, b0, is_ip6, is_input, is_l2_path, p5tuple);
+  p5tuple->l4.lsb_of_sw_if_index = sw_if_index0 & 0xffff;
+  acl_make_5tuple_session_key (is_input, p5tuple, kv_sess);
+  p5tuple->pkt.sw_if_index = sw_if_index0;
+  p5tuple->pkt.is_ip6 = is_ip6;
+  p5tuple->pkt.is_input = is_input;
+  p5tuple->pkt.mask_type_index_lsb = ~0;
+}
+
+/*
+ * Track a packet on the session it hit, and return the action for it.
+ */
+always_inline u8
+acl_fa_track_session_hit (acl_main_t * am, int is_input, u32 sw_if_index0,
+			  u64 now, fa_full_session_id_t f_sess_id,
+			  fa_5tuple_t * p5tuple, u32 * trace_bitmap,
+			  u32 * pkts_restart_session_timer)
+{
+  fa_session_t *sess = get_session_ptr(am, f_sess_id.thread_index, f_sess_id.session_index);
+  int old_timeout_type = fa_session_get_timeout_type (am, sess);
+  u8 action = acl_fa_track_session (am, is_input, sw_if_index0, now,
+				    sess, p5tuple);
+  int new_timeout_type = fa_session_get_timeout_type (am, sess);
+
+  /* Tracking might have changed the session timeout type, e.g. from transient to established */
+  if (PREDICT_FALSE (old_timeout_type != new_timeout_type))
+    {
+      acl_fa_restart_timer_for_session (am, now, f_sess_id);
+      *pkts_restart_session_timer += 1;
+      *trace_bitmap |=
+	0x00010000 + ((0xff & old_timeout_type) << 8) +
+	(0xff & new_timeout_type);
+    }
+  /*
+   * I estimate the likelihood to be very low - the VPP needs
+   * to have >64K interfaces to start with and then on
+   * exactly 64K indices apart needs to be exactly the same
+   * 5-tuple... Anyway, since this probability is nonzero -
+   * print an error and drop the unlucky packet.
+   * If this shows up in real world, we would need to bump
+   * the hash key length.
+   */
+  if (PREDICT_FALSE(sess->sw_if_index != sw_if_index0)) {
+    clib_warning("BUG: session LSB16(sw_if_index) and 5-tuple collision!");
+    action = 0;
+  }
+  return action;
+}
+
+/*
+ * With is_bench set the passes run as they do in the node, but the
+ * buffers are left where they are: no feature next, no trace, nothing
+ * enqueued and no counters, for the lookup benchmark.
+ */
+always_inline void
+acl_fa_node_inline (vlib_main_t * vm,
+		    vlib_node_runtime_t * node, u32 * from, u32 n_vectors,
+		    int is_ip6, int is_input, int is_l2_path,
+		    u32 * l2_feat_next_node_index,
+		    vlib_node_registration_t * acl_fa_node, int is_bench)
 {
-  u32 n_left_from, *from, *to_next;
-  acl_fa_next_t next_index;
+  u32 i;
   u32 pkts_acl_checked = 0;
   u32 pkts_new_session = 0;
   u32 pkts_exist_session = 0;
@@ -987,200 +1136,215 @@ acl_fa_node_fn (vlib_main_t * vm,
   u32 pkts_restart_session_timer = 0;
   u32 trace_bitmap = 0;
   acl_main_t *am = &acl_main;
-  fa_5tuple_t fa_5tuple, kv_sess;
   clib_bihash_kv_40_8_t value_sess;
   vlib_node_runtime_t *error_node;
   u64 now = clib_cpu_time_now ();
   uword thread_index = os_get_thread_index ();
-
-  from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  int with_sessions = am->fa_sessions_hash_is_initialized;
+  /* the session table was modified by an earlier packet of this frame */
+  int sessions_changed = 0;
 
   error_node = vlib_node_get_runtime (vm, acl_fa_node->index);
 
-  while (n_left_from > 0)
+  /*
+   * The frame is processed in passes, so that the memory accesses of
+   * one packet overlap with the work on the others: extract the
+   * 5-tuples and hash the session keys, touch the session hash
+   * buckets, look up the sessions, and only then track the hits and
+   * classify the misses.
+   */
+  vlib_get_buffers (vm, from, pw->bufs, n_vectors);
+
+  for (i = 0; i < n_vectors; i++)
     {
-      u32 n_left_to_next;
+      vlib_buffer_t *b0 = pw->bufs[i];
+      fa_5tuple_t *p5tuple = &pw->fa_5tuples[i];
+      u32 sw_if_index0;
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      if (i + 4 < n_vectors)
+	vlib_prefetch_buffer_header (pw->bufs[i + 4], LOAD);
+      if (i + 2 < n_vectors)
+	CLIB_PREFETCH (vlib_buffer_get_current (pw->bufs[i + 2]),
+		       2 * CLIB_CACHE_LINE_BYTES, LOAD);
 
-      while (n_left_from > 0 && n_left_to_next > 0)
-	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0 = 0;
-	  u8 action = 0;
-	  u32 sw_if_index0;
-	  int acl_check_needed = 1;
-	  u32 match_acl_in_index = ~0;
-	  u32 match_rule_index = ~0;
-	  u8 error0 = 0;
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-	  if (is_input)
-	    sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	  else
-	    sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
-
-	  /*
-	   * Extract the L3/L4 matching info into a 5-tuple structure,
-	   * then create a session key whose layout is independent on forward or reverse
-	   * direction of the packet.
-	   */
+      if (is_input)
+	sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+      else
+	sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
+      pw->sw_if_indices[i] = sw_if_index0;
 
-	  acl_fill_5tuple (am, b0, is_ip6, is_input, is_l2_path, &fa_5tuple);
-          fa_5tuple.l4.lsb_of_sw_if_index = sw_if_index0 & 0xffff;
-	  acl_make_5tuple_session_key (is_input, &fa_5tuple, &kv_sess);
-	  fa_5tuple.pkt.sw_if_index = sw_if_index0;
-          fa_5tuple.pkt.is_ip6 = is_ip6;
-          fa_5tuple.pkt.is_input = is_input;
-          fa_5tuple.pkt.mask_type_index_lsb = ~0;
+      acl_fa_make_5tuple_and_key (am, b0, sw_if_index0, is_ip6, is_input,
+				  is_l2_path, p5tuple, &pw->kv_sess[i]);
 #ifdef FA_NODE_VERBOSE_DEBUG
-	  clib_warning
-	    ("ACL_FA_NODE_DBG: session 5-tuple %016llx %016llx %016llx %016llx %016llx : %016llx",
-	     kv_sess.kv.key[0], kv_sess.kv.key[1], kv_sess.kv.key[2],
-	     kv_sess.kv.key[3], kv_sess.kv.key[4], kv_sess.kv.value);
-	  clib_warning
-	    ("ACL_FA_NODE_DBG: packet 5-tuple %016llx %016llx %016llx %016llx %016llx : %016llx",
-	     fa_5tuple.kv.key[0], fa_5tuple.kv.key[1], fa_5tuple.kv.key[2],
-	     fa_5tuple.kv.key[3], fa_5tuple.kv.key[4], fa_5tuple.kv.value);
+      clib_warning
+	("ACL_FA_NODE_DBG: session 5-tuple %016llx %016llx %016llx %016llx %016llx : %016llx",
+	 pw->kv_sess[i].kv.key[0], pw->kv_sess[i].kv.key[1],
+	 pw->kv_sess[i].kv.key[2], pw->kv_sess[i].kv.key[3],
+	 pw->kv_sess[i].kv.key[4], pw->kv_sess[i].kv.value);
+      clib_warning
+	("ACL_FA_NODE_DBG: packet 5-tuple %016llx %016llx %016llx %016llx %016llx : %016llx",
+	 p5tuple->kv.key[0], p5tuple->kv.key[1], p5tuple->kv.key[2],
+	 p5tuple->kv.key[3], p5tuple->kv.key[4], p5tuple->kv.value);
 #endif
 
-	  /* Try to match an existing session first */
+      if (with_sessions)
+	{
+	  pw->hashes[i] = BV (clib_bihash_hash) (&pw->kv_sess[i].kv);
+	  BV (clib_bihash_prefetch_bucket) (&am->fa_sessions_hash,
+					    pw->hashes[i]);
+	}
+    }
+
+  if (with_sessions)
+    {
+      for (i = 0; i < n_vectors; i++)
+	BV (clib_bihash_prefetch_data) (&am->fa_sessions_hash, pw->hashes[i]);
 
-	  if (acl_fa_ifc_has_sessions (am, sw_if_index0))
+      /* Try to match an existing session first */
+      for (i = 0; i < n_vectors; i++)
+	{
+	  pw->sess_found[i] =
+	    (0 == BV (clib_bihash_search_inline_2_with_hash)
+	     (&am->fa_sessions_hash, pw->hashes[i], &pw->kv_sess[i].kv,
+	      &value_sess));
+	  if (pw->sess_found[i])
 	    {
-	      if (acl_fa_find_session
-		  (am, sw_if_index0, &kv_sess, &value_sess))
-		{
-		  trace_bitmap |= 0x80000000;
-		  error0 = ACL_FA_ERROR_ACL_EXIST_SESSION;
-		  fa_full_session_id_t f_sess_id;
-
-                  f_sess_id.as_u64 = value_sess.value;
-                  ASSERT(f_sess_id.thread_index < vec_len(vlib_mains));
-
-		  fa_session_t *sess = get_session_ptr(am, f_sess_id.thread_index, f_sess_id.session_index);
-		  int old_timeout_type =
-		    fa_session_get_timeout_type (am, sess);
-		  action =
-		    acl_fa_track_session (am, is_input, sw_if_index0, now,
-					  sess, &fa_5tuple);
-		  /* expose the session id to the tracer */
-		  match_rule_index = f_sess_id.session_index;
-		  int new_timeout_type =
-		    fa_session_get_timeout_type (am, sess);
-		  acl_check_needed = 0;
-		  pkts_exist_session += 1;
-		  /* Tracking might have changed the session timeout type, e.g. from transient to established */
-		  if (PREDICT_FALSE (old_timeout_type != new_timeout_type))
-		    {
-		      acl_fa_restart_timer_for_session (am, now, f_sess_id);
-		      pkts_restart_session_timer++;
-		      trace_bitmap |=
-			0x00010000 + ((0xff & old_timeout_type) << 8) +
-			(0xff & new_timeout_type);
-		    }
-                  /*
-                   * I estimate the likelihood to be very low - the VPP needs
-                   * to have >64K interfaces to start with and then on
-                   * exactly 64K indices apart needs to be exactly the same
-                   * 5-tuple... Anyway, since this probability is nonzero -
-                   * print an error and drop the unlucky packet.
-                   * If this shows up in real world, we would need to bump
-                   * the hash key length.
-                   */
-		  if (PREDICT_FALSE(sess->sw_if_index != sw_if_index0)) {
-                    clib_warning("BUG: session LSB16(sw_if_index) and 5-tuple collision!");
-                    acl_check_needed = 0;
-                    action = 0;
-                  }
-		}
+	      fa_full_session_id_t f_sess_id;
+	      fa_session_t *sess;
+
+	      pw->sess_values[i] = value_sess.value;
+	      f_sess_id.as_u64 = value_sess.value;
+	      sess = get_session_ptr (am, f_sess_id.thread_index,
+				      f_sess_id.session_index);
+	      CLIB_PREFETCH (sess, 2 * CLIB_CACHE_LINE_BYTES, STORE);
 	    }
+	}
+    }
 
-	  if (acl_check_needed)
+  for (i = 0; i < n_vectors; i++)
+    {
+      vlib_buffer_t *b0 = pw->bufs[i];
+      fa_5tuple_t *p5tuple = &pw->fa_5tuples[i];
+      u32 sw_if_index0 = pw->sw_if_indices[i];
+      u32 next0 = 0;
+      u8 action = 0;
+      int acl_check_needed = 1;
+      int sess_found = 0;
+      u32 match_acl_in_index = ~0;
+      u32 match_rule_index = ~0;
+      u8 error0 = 0;
+
+      if (with_sessions)
+	{
+	  sess_found = pw->sess_found[i];
+	  /*
+	   * A session added or recycled by an earlier packet of this
+	   * frame makes the batched lookup result stale, redo it.
+	   */
+	  if (PREDICT_FALSE (sessions_changed))
 	    {
-	      action =
-		multi_acl_match_5tuple (sw_if_index0, &fa_5tuple, is_l2_path,
-				       is_ip6, is_input, &match_acl_in_index,
-				       &match_rule_index, &trace_bitmap);
-	      error0 = action;
-	      if (1 == action)
-		pkts_acl_permit += 1;
-	      if (2 == action)
-		{
-		  if (!acl_fa_can_add_session (am, is_input, sw_if_index0))
-                    acl_fa_try_recycle_session (am, is_input, thread_index, sw_if_index0);
-
-		  if (acl_fa_can_add_session (am, is_input, sw_if_index0))
-		    {
-                      fa_session_t *sess = acl_fa_add_session (am, is_input, sw_if_index0, now,
-					                       &kv_sess);
-                      acl_fa_track_session (am, is_input, sw_if_index0, now,
-                                            sess, &fa_5tuple);
-		      pkts_new_session += 1;
-		    }
-		  else
-		    {
-		      action = 0;
-		      error0 = ACL_FA_ERROR_ACL_TOO_MANY_SESSIONS;
-		    }
-		}
+	      sess_found = acl_fa_find_session (am, sw_if_index0,
+						&pw->kv_sess[i], &value_sess);
+	      pw->sess_values[i] = value_sess.value;
 	    }
+	}
 
+      if (sess_found)
+	{
+	  trace_bitmap |= 0x80000000;
+	  error0 = ACL_FA_ERROR_ACL_EXIST_SESSION;
+	  fa_full_session_id_t f_sess_id;
+
+	  f_sess_id.as_u64 = pw->sess_values[i];
+	  ASSERT(f_sess_id.thread_index < vec_len(vlib_mains));
+
+	  action =
+	    acl_fa_track_session_hit (am, is_input, sw_if_index0, now,
+				      f_sess_id, p5tuple, &trace_bitmap,
+				      &pkts_restart_session_timer);
+	  /* expose the session id to the tracer */
+	  match_rule_index = f_sess_id.session_index;
+	  acl_check_needed = 0;
+	  pkts_exist_session += 1;
+	}
 
-
-	  if (action > 0)
+      if (acl_check_needed)
+	{
+	  action =
+	    multi_acl_match_5tuple (sw_if_index0, p5tuple, is_l2_path,
+				   is_ip6, is_input, &match_acl_in_index,
+				   &match_rule_index, &trace_bitmap);
+	  error0 = action;
+	  if (1 == action)
+	    pkts_acl_permit += 1;
+	  if (2 == action)
 	    {
-	      if (is_l2_path)
-		next0 = vnet_l2_feature_next (b0, l2_feat_next_node_index, 0);
-	      else
-		vnet_feature_next (sw_if_index0, &next0, b0);
-	    }
+	      if (!acl_fa_can_add_session (am, is_input, sw_if_index0))
+		acl_fa_try_recycle_session (am, is_input, thread_index, sw_if_index0);
 
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
-			     && (b0->flags & VLIB_BUFFER_IS_TRACED)))
-	    {
-	      acl_fa_trace_t *t = vlib_add_trace (vm, node, b0, sizeof (*t));
-	      t->sw_if_index = sw_if_index0;
-	      t->next_index = next0;
-	      t->match_acl_in_index = match_acl_in_index;
-	      t->match_rule_index = match_rule_index;
-	      t->packet_info[0] = fa_5tuple.kv.key[0];
-	      t->packet_info[1] = fa_5tuple.kv.key[1];
-	      t->packet_info[2] = fa_5tuple.kv.key[2];
-	      t->packet_info[3] = fa_5tuple.kv.key[3];
-	      t->packet_info[4] = fa_5tuple.kv.key[4];
-	      t->packet_info[5] = fa_5tuple.kv.value;
-	      t->action = action;
-	      t->trace_bitmap = trace_bitmap;
+	      if (acl_fa_can_add_session (am, is_input, sw_if_index0))
+		{
+		  fa_session_t *sess = acl_fa_add_session (am, is_input, sw_if_index0, now,
+							   &pw->kv_sess[i]);
+		  acl_fa_track_session (am, is_input, sw_if_index0, now,
+					sess, p5tuple);
+		  pkts_new_session += 1;
+		}
+	      else
+		{
+		  action = 0;
+		  error0 = ACL_FA_ERROR_ACL_TOO_MANY_SESSIONS;
+		}
+	      sessions_changed = 1;
 	    }
+	}
 
-	  next0 = next0 < node->n_next_nodes ? next0 : 0;
-	  if (0 == next0)
-	    b0->error = error_node->errors[error0];
+      if (is_bench)
+	{
+	  pw->nexts[i] = action > 0;
+	  continue;
+	}
 
-	  pkts_acl_checked += 1;
+      if (action > 0)
+	{
+	  if (is_l2_path)
+	    next0 = vnet_l2_feature_next (b0, l2_feat_next_node_index, 0);
+	  else
+	    vnet_feature_next (sw_if_index0, &next0, b0);
+	}
 
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next, bi0,
-					   next0);
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  acl_fa_trace_t *t = vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->sw_if_index = sw_if_index0;
+	  t->next_index = next0;
+	  t->match_acl_in_index = match_acl_in_index;
+	  t->match_rule_index = match_rule_index;
+	  t->packet_info[0] = p5tuple->kv.key[0];
+	  t->packet_info[1] = p5tuple->kv.key[1];
+	  t->packet_info[2] = p5tuple->kv.key[2];
+	  t->packet_info[3] = p5tuple->kv.key[3];
+	  t->packet_info[4] = p5tuple->kv.key[4];
+	  t->packet_info[5] = p5tuple->kv.value;
+	  t->action = action;
+	  t->trace_bitmap = trace_bitmap;
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      next0 = next0 < node->n_next_nodes ? next0 : 0;
+      if (0 == next0)
+	b0->error = error_node->errors[error0];
+      pw->nexts[i] = next0;
+
+      pkts_acl_checked += 1;
     }
 
+  if (is_bench)
+    return;
+
+  vlib_buffer_enqueue_to_next (vm, node, from, pw->nexts, n_vectors);
+
   vlib_node_increment_counter (vm, acl_fa_node->index,
 			       ACL_FA_ERROR_ACL_CHECK, pkts_acl_checked);
   vlib_node_increment_counter (vm, acl_fa_node->index,
@@ -1194,6 +1358,17 @@ acl_fa_node_fn (vlib_main_t * vm,
   vlib_node_increment_counter (vm, acl_fa_node->index,
 			       ACL_FA_ERROR_ACL_RESTART_SESSION_TIMER,
 			       pkts_restart_session_timer);
+}
+
+always_inline uword
+acl_fa_node_fn (vlib_main_t * vm,
+		vlib_node_runtime_t * node, vlib_frame_t * frame, int is_ip6,
+		int is_input, int is_l2_path, u32 * l2_feat_next_node_index,
+		vlib_node_registration_t * acl_fa_node)
+{
+  acl_fa_node_inline (vm, node, vlib_frame_vector_args (frame),
+		      frame->n_vectors, is_ip6, is_input, is_l2_path,
+		      l2_feat_next_node_index, acl_fa_node, 0 /* is_bench */ );
   return frame->n_vectors;
 }
 
@@ -1278,6 +1453,141 @@ acl_out_ip4_fa_node_fn (vlib_main_t * vm,
   return acl_fa_node_fn (vm, node, frame, 0, 0, 0, 0, &acl_out_fa_ip4_node);
 }
 
+/*
+ * Run frames of buffers through the staged passes of the ip4 input
+ * node, and return the clocks taken. One untimed pass over the buffers
+ * comes first, so that the sessions the ACLs make are in place.
+ */
+u64
+acl_fa_node_bench (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
+		   u32 n_frames)
+{
+  acl_main_t *am = &acl_main;
+  vlib_node_runtime_t *node;
+  u32 i, n, offset;
+  u64 c_start;
+
+  acl_fa_verify_init_sessions (am);
+  node = vlib_node_get_runtime (vm, acl_in_fa_ip4_node.index);
+
+  for (offset = 0; offset < n_buffers; offset += n)
+    {
+      n = clib_min (VLIB_FRAME_SIZE, n_buffers - offset);
+      acl_fa_node_inline (vm, node, buffers + offset, n, 0, 1, 0, 0,
+			  &acl_in_fa_ip4_node, 1 /* is_bench */ );
+    }
+
+  c_start = clib_cpu_time_now ();
+  for (i = 0, offset = 0; i < n_frames; i++)
+    {
+      n = clib_min (VLIB_FRAME_SIZE, n_buffers - offset);
+      acl_fa_node_inline (vm, node, buffers + offset, n, 0, 1, 0, 0,
+			  &acl_in_fa_ip4_node, 1 /* is_bench */ );
+      offset = (offset + n) % n_buffers;
+    }
+  return clib_cpu_time_now () - c_start;
+}
+
+/*
+ * Packets that hit a session, and those the ACLs permit or deny
+ * outright, are dealt with here. Packets that would add a session are
+ * punted to the node, which keeps the session lookups of its frame
+ * consistent as it adds them.
+ */
+always_inline u32
+acl_fa_fused_inline (vlib_main_t * vm, vlib_buffer_t * b0, int is_ip6,
+		     int is_input, vlib_node_registration_t * acl_fa_node)
+{
+  acl_main_t *am = &acl_main;
+  clib_bihash_kv_40_8_t value_sess;
+  fa_5tuple_t fa_5tuple, kv_sess;
+  u64 now = vnet_feature_fused_cpu_time (vm);
+  u32 match_acl_in_index = ~0;
+  u32 match_rule_index = ~0;
+  u32 trace_bitmap = 0;
+  u32 pkts_restart_session_timer = 0;
+  u32 sw_if_index0;
+  u8 action;
+  u8 error0;
+
+  if (is_input)
+    sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+  else
+    sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
+
+  acl_fa_make_5tuple_and_key (am, b0, sw_if_index0, is_ip6, is_input,
+			      0 /* is_l2_path */ , &fa_5tuple, &kv_sess);
+
+  if (am->fa_sessions_hash_is_initialized
+      && acl_fa_find_session (am, sw_if_index0, &kv_sess, &value_sess))
+    {
+      fa_full_session_id_t f_sess_id;
+
+      error0 = ACL_FA_ERROR_ACL_EXIST_SESSION;
+      f_sess_id.as_u64 = value_sess.value;
+      action = acl_fa_track_session_hit (am, is_input, sw_if_index0, now,
+					 f_sess_id, &fa_5tuple,
+					 &trace_bitmap,
+					 &pkts_restart_session_timer);
+      vlib_node_increment_counter (vm, acl_fa_node->index,
+				   ACL_FA_ERROR_ACL_EXIST_SESSION, 1);
+      if (PREDICT_FALSE (pkts_restart_session_timer))
+	vlib_node_increment_counter (vm, acl_fa_node->index,
+				     ACL_FA_ERROR_ACL_RESTART_SESSION_TIMER,
+				     1);
+    }
+  else
+    {
+      action = multi_acl_match_5tuple (sw_if_index0, &fa_5tuple,
+				       0 /* is_l2 */ , is_ip6, is_input,
+				       &match_acl_in_index,
+				       &match_rule_index, &trace_bitmap);
+      if (2 == action)
+	return VNET_FEATURE_FUSED_PUNT;
+      error0 = action;
+      if (1 == action)
+	vlib_node_increment_counter (vm, acl_fa_node->index,
+				     ACL_FA_ERROR_ACL_PERMIT, 1);
+    }
+
+  vlib_node_increment_counter (vm, acl_fa_node->index,
+			       ACL_FA_ERROR_ACL_CHECK, 1);
+
+  if (action > 0)
+    return VNET_FEATURE_FUSED_CONTINUE;
+
+  b0->error = vlib_node_get_runtime (vm, acl_fa_node->index)->errors[error0];
+  return 0;
+}
+
+static u32
+acl_in_ip6_fa_fused (vlib_main_t * vm, vlib_buffer_t * b,
+		     void *feature_config)
+{
+  return acl_fa_fused_inline (vm, b, 1, 1, &acl_in_fa_ip6_node);
+}
+
+static u32
+acl_in_ip4_fa_fused (vlib_main_t * vm, vlib_buffer_t * b,
+		     void *feature_config)
+{
+  return acl_fa_fused_inline (vm, b, 0, 1, &acl_in_fa_ip4_node);
+}
+
+static u32
+acl_out_ip6_fa_fused (vlib_main_t * vm, vlib_buffer_t * b,
+		      void *feature_config)
+{
+  return acl_fa_fused_inline (vm, b, 1, 0, &acl_out_fa_ip6_node);
+}
+
+static u32
+acl_out_ip4_fa_fused (vlib_main_t * vm, vlib_buffer_t * b,
+		      void *feature_config)
+{
+  return acl_fa_fused_inline (vm, b, 0, 0, &acl_out_fa_ip4_node);
+}
+
 /*
  * This process ensures the connection cleanup happens every so often
  * even in absence of traffic, as well as provides general orchestration
@@ -1327,13 +1637,19 @@ acl_fa_worker_conn_cleaner_process(vlib_main_t * vm,
 #endif
    /* allow another interrupt to be queued */
    pw->interrupt_is_pending = 0;
+   if (!am->fa_sessions_hash_is_initialized) {
+     /* no sessions, no timers and nothing to clear yet */
+     pw->clear_in_process = 0;
+     pw->interrupt_generation = am->fa_interrupt_generation;
+     return 0;
+   }
    if (pw->clear_in_process) {
-     if (0 == pw->swipe_end_time) {
+     if (~0 == pw->swipe_session_index) {
        /*
         * Someone has just set the flag to start clearing.
-        * we do this by combing through the connections up to a "time T"
-        * which is now, and requeueing everything except the expired
-        * connections and those matching the interface(s) being cleared.
+        * we do this by combing through the session pool a chunk
+        * at a time, deleting the sessions on the interface(s)
+        * being cleared.
         */
 
        /*
@@ -1368,16 +1684,17 @@ acl_fa_worker_conn_cleaner_process(vlib_main_t * vm,
                       format_bitmap_hex, pw->pending_clear_sw_if_index_bitmap,
                       format_bitmap_hex, pw->serviced_sw_if_index_bitmap);
 #endif
-         /* swipe through the connection lists until enqueue timestamps become above "now" */
-         pw->swipe_end_time = now;
+         /* swipe through the session pool from the start */
+         pw->swipe_session_index = 0;
        }
      }
    }
    num_expired = acl_fa_check_idle_sessions(am, thread_index, now);
-   // clib_warning("WORKER-CLEAR: checked %d sessions (clear_in_progress: %d)", num_expired, pw->clear_in_process);
    if (pw->clear_in_process) {
-     if (0 == num_expired) {
-       /* we were clearing but we could not process any more connections. time to stop. */
+     num_expired += acl_fa_swipe_sessions(am, thread_index);
+     // clib_warning("WORKER-CLEAR: checked %d sessions (clear_in_progress: %d)", num_expired, pw->clear_in_process);
+     if (~0 == pw->swipe_session_index) {
+       /* we have walked all of the session pool. time to stop. */
        clib_bitmap_zero(pw->pending_clear_sw_if_index_bitmap);
        pw->clear_in_process = 0;
 #ifdef FA_NODE_VERBOSE_DEBUG
@@ -1454,36 +1771,14 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
     {
       now = clib_cpu_time_now ();
       next_expire = now + am->fa_current_cleaner_timer_wait_interval;
-      int has_pending_conns = 0;
-      u16 ti;
-      u8 tt;
-
       /*
-       * walk over all per-thread list heads of different timeouts,
-       * and see if there are any connections pending.
-       * If there aren't - we do not need to wake up until the
-       * worker code signals that it has added a connection.
-       *
-       * Also, while we are at it, calculate the earliest we need to wake up.
+       * The per-worker timer wheels take care of finding the expired
+       * sessions, they only need to be advanced while there are any
+       * sessions at all. If there aren't - we do not need to wake up
+       * until the worker code signals that it has added a connection.
        */
-      for(ti = 0; ti < vec_len(vlib_mains); ti++) {
-        if (ti >= vec_len(am->per_worker_data)) {
-          continue;
-        }
-        acl_fa_per_worker_data_t *pw = &am->per_worker_data[ti];
-        for(tt = 0; tt < vec_len(pw->fa_conn_list_head); tt++) {
-          u64 head_expiry = acl_fa_get_list_head_expiry_time(am, pw, now, ti, tt);
-          if ((head_expiry < next_expire) && !pw->interrupt_is_pending) {
-#ifdef FA_NODE_VERBOSE_DEBUG
-            clib_warning("Head expiry: %lu, now: %lu, next_expire: %lu (worker: %d, tt: %d)", head_expiry, now, next_expire, ti, tt);
-#endif
-            next_expire = head_expiry;
-	  }
-          if (~0 != pw->fa_conn_list_head[tt]) {
-            has_pending_conns = 1;
-          }
-        }
-      }
+      int has_pending_conns =
+        (am->fa_session_total_adds != am->fa_session_total_dels);
 
       /* If no pending connections and no ACL applied then no point in timing out */
       if (!has_pending_conns && (0 == am->fa_total_enabled_count))
@@ -1841,6 +2136,7 @@ VNET_FEATURE_INIT (acl_in_ip6_fa_feature, static) =
   .arc_name = "ip6-unicast",
   .node_name = "acl-plugin-in-ip6-fa",
   .runs_before = VNET_FEATURES ("ip6-flow-classify"),
+  .fused_function = acl_in_ip6_fa_fused,
 };
 
 VLIB_REGISTER_NODE (acl_in_fa_ip4_node) =
@@ -1864,6 +2160,7 @@ VNET_FEATURE_INIT (acl_in_ip4_fa_feature, static) =
   .arc_name = "ip4-unicast",
   .node_name = "acl-plugin-in-ip4-fa",
   .runs_before = VNET_FEATURES ("ip4-flow-classify"),
+  .fused_function = acl_in_ip4_fa_fused,
 };
 
 
@@ -1888,6 +2185,7 @@ VNET_FEATURE_INIT (acl_out_ip6_fa_feature, static) =
   .arc_name = "ip6-output",
   .node_name = "acl-plugin-out-ip6-fa",
   .runs_before = VNET_FEATURES ("interface-output"),
+  .fused_function = acl_out_ip6_fa_fused,
 };
 
 VLIB_REGISTER_NODE (acl_out_fa_ip4_node) =
@@ -1912,6 +2210,7 @@ VNET_FEATURE_INIT (acl_out_ip4_fa_feature, static) =
   .arc_name = "ip4-output",
   .node_name = "acl-plugin-out-ip4-fa",
   .runs_before = VNET_FEATURES ("interface-output"),
+  .fused_function = acl_out_ip4_fa_fused,
 };
 
 
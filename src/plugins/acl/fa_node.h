@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <vppinfra/bihash_40_8.h>
+#include <vppinfra/tw_timer_16t_2w_512sl.h>
 
 #define TCP_FLAG_FIN    0x01
 #define TCP_FLAG_SYN    0x02
@@ -19,6 +20,19 @@
 #define ACL_FA_CONN_TABLE_DEFAULT_HASH_MEMORY_SIZE (1<<30)
 #define ACL_FA_CONN_TABLE_DEFAULT_MAX_ENTRIES 1000000
 
+/*
+ * Session idle timers: one second ticks on a 2 x 512 slot wheel,
+ * so a timer can be up to ~72 hours out. Longer timeouts are
+ * reached by rescheduling at expiry. The timer id is the timeout
+ * type, the user handle is the session index.
+ */
+#define ACL_FA_SESSION_TIMER_INTERVAL 1.0
+#define ACL_FA_SESSION_TIMER_MAX_TICKS (512 * 512 - 1)
+#define ACL_FA_SESSION_TIMER_HANDLE_MASK ((1 << 28) - 1)
+
+/* How many session pool slots a worker looks at per interrupt while clearing */
+#define ACL_FA_SWIPE_SESSIONS_PER_INTERVAL (64 * 1024)
+
 typedef union {
   u64 as_u64;
   struct {
@@ -67,7 +81,8 @@ typedef struct {
   u32 link_prev_idx;      /* +4 bytes = 12 */
   u32 link_next_idx;      /* +4 bytes = 16 */
   u8 link_list_id;        /* +1 bytes = 17 */
-  u8 reserved1[7];        /* +7 bytes = 24 */
+  u8 reserved1[3];        /* +3 bytes = 20 */
+  u32 timer_handle;       /* +4 bytes = 24 */
   u64 reserved2[5];       /* +5*8 bytes = 64 */
 } fa_session_t;
 
@@ -106,13 +121,15 @@ CT_ASSERT_EQUAL(fa_full_session_id_size_is_64, sizeof(fa_full_session_id_t), siz
 typedef struct {
   /* The pool of sessions managed by this worker */
   fa_session_t *fa_sessions_pool;
-  /* per-worker ACL_N_TIMEOUTS of conn lists */
-  u32 *fa_conn_list_head;
-  u32 *fa_conn_list_tail;
+  /* idle timers of the sessions owned by this worker */
+  tw_timer_wheel_16t_2w_512sl_t *session_timer_wheel;
+  /* TCP transient sessions, oldest first, for recycling */
+  u32 fa_recycle_list_head;
+  u32 fa_recycle_list_tail;
   /* adds and deletes per-worker-per-interface */
   u64 *fa_session_dels_by_sw_if_index;
   u64 *fa_session_adds_by_sw_if_index;
-  /* Vector of expired connections retrieved from lists */
+  /* Vector of expired session timer handles */
   u32 *expired;
   /* the earliest next expiry time */
   u64 next_expiry_time;
@@ -124,10 +141,16 @@ typedef struct {
   u64 cnt_deleted_sessions;
   /* Counter of already deleted sessions being deleted - should not increment unless a bug */
   u64 cnt_already_deleted_sessions;
-  /* Number of times we requeued a session to a head of the list */
+  /* Number of times an expired session timer found the session active and was restarted */
   u64 cnt_session_timer_restarted;
-  /* swipe up to this enqueue time, rather than following the timeouts */
-  u64 swipe_end_time;
+  /* Per timeout type: timers started, restarted at expiry, sessions deleted at expiry */
+  u64 *cnt_session_timer_started_by_type;
+  u64 *cnt_session_timer_restarted_by_type;
+  u64 *cnt_deleted_sessions_by_type;
+  /* Number of sessions recycled to make room for a new one */
+  u64 cnt_recycled_sessions;
+  /* the next session pool index to look at while clearing, ~0 if not clearing */
+  u32 swipe_session_index;
   /* bitmap of sw_if_index serviced by this worker */
   uword *serviced_sw_if_index_bitmap;
   /* bitmap of sw_if_indices to clear. set by main thread, cleared by worker */
@@ -151,6 +174,18 @@ typedef struct {
    * Set to copy of a "generation" counter in main thread so we can sync the interrupts.
    */
   int interrupt_generation;
+  /*
+   * Per-frame scratch for the data path, filled by the staged passes
+   * in acl_fa_node_fn, kept here rather than on the worker's stack.
+   */
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE];
+  u32 sw_if_indices[VLIB_FRAME_SIZE];
+  fa_5tuple_t fa_5tuples[VLIB_FRAME_SIZE];
+  fa_5tuple_t kv_sess[VLIB_FRAME_SIZE];
+  u64 hashes[VLIB_FRAME_SIZE];
+  u64 sess_values[VLIB_FRAME_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE];
+  u8 sess_found[VLIB_FRAME_SIZE];
 } acl_fa_per_worker_data_t;
 
 
@@ -168,6 +203,9 @@ enum
 
 void acl_fa_enable_disable(u32 sw_if_index, int is_input, int enable_disable);
 
+u64 acl_fa_node_bench(vlib_main_t * vm, u32 * buffers, u32 n_buffers,
+		       u32 n_frames);
+
 void show_fa_sessions_hash(vlib_main_t * vm, u32 verbose);
 
 u8 *format_acl_plugin_5tuple (u8 * s, va_list * args);
@@ -73,7 +73,7 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   u64 *pmatch = (u64 *)match;
   u64 *pmask;
   u64 *pkey;
-  int mask_type_index;
+  hash_applied_mask_info_t *minfo;
   u32 curr_match_index = ~0;
 
   u32 sw_if_index = match->pkt.sw_if_index;
@@ -81,18 +81,20 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, is_input, sw_if_index);
   applied_hash_acl_info_t **applied_hash_acls = is_input ? &am->input_applied_hash_acl_info_by_sw_if_index :
                                                     &am->output_applied_hash_acl_info_by_sw_if_index;
+  hash_applied_mask_info_t *mask_infos =
+    vec_elt_at_index((*applied_hash_acls), sw_if_index)->mask_info_by_partition[
+      hash_acl_partition_index(match->pkt.is_ip6, match->pkt.is_nonfirst_fragment)];
 
   DBG("TRYING TO MATCH: %016llx %016llx %016llx %016llx %016llx %016llx",
 	       pmatch[0], pmatch[1], pmatch[2], pmatch[3], pmatch[4], pmatch[5]);
 
-  for(mask_type_index=0; mask_type_index < pool_len(am->ace_mask_type_pool); mask_type_index++) {
-    if (!clib_bitmap_get(vec_elt_at_index((*applied_hash_acls), sw_if_index)->mask_type_index_bitmap, mask_type_index)) {
-      /* This bit is not set. Avoid trying to match */
-      continue;
+  vec_foreach(minfo, mask_infos) {
+    if (minfo->first_applied_entry_index >= curr_match_index) {
+      /* Neither this nor any later tuple can yield a higher priority match */
+      break;
     }
-    ace_mask_type_entry_t *mte = vec_elt_at_index(am->ace_mask_type_pool, mask_type_index);
     pmatch = (u64 *)match;
-    pmask = (u64 *)&mte->mask;
+    pmask = (u64 *)&minfo->mask;
     pkey = (u64 *)kv.key;
     /*
     * unrolling the below loop results in a noticeable performance increase.
@@ -109,8 +111,8 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
     *pkey++ = *pmatch++ & *pmask++;
     *pkey++ = *pmatch++ & *pmask++;
 
-    kv_key->pkt.mask_type_index_lsb = mask_type_index;
-    DBG("        KEY %3d: %016llx %016llx %016llx %016llx %016llx %016llx", mask_type_index,
+    kv_key->pkt.mask_type_index_lsb = minfo->mask_type_index;
+    DBG("        KEY %3d: %016llx %016llx %016llx %016llx %016llx %016llx", minfo->mask_type_index,
 		kv.key[0], kv.key[1], kv.key[2], kv.key[3], kv.key[4], kv.key[5]);
     int res = BV (clib_bihash_search) (&am->acl_lookup_hash, &kv, &result);
     if (res == 0) {
@@ -259,6 +261,76 @@ applied_hash_entries_analyze(acl_main_t *am, applied_hash_ace_entry_t **applied_
    */
 }
 
+/*
+ * Does an applied entry with this mask and match apply to the packets
+ * of a given partition of the lookup ?
+ */
+static int
+hash_acl_entry_in_partition(fa_5tuple_t *mask, fa_5tuple_t *match, int is_ip6, int is_nonfirst_fragment)
+{
+  if (match->pkt.is_ip6 != is_ip6)
+    return 0;
+  if (mask->pkt.is_nonfirst_fragment && (match->pkt.is_nonfirst_fragment != is_nonfirst_fragment))
+    return 0;
+  return 1;
+}
+
+/*
+ * Compile the lookup for an interface and direction from its applied entries:
+ * for each partition, the mask types in use, in the order of the highest
+ * priority entry using them. The new lookup is built aside and swapped in,
+ * so the data path sees either the old or the new one.
+ */
+static void
+hash_acl_compile_applied_lookup(acl_main_t *am, u32 sw_if_index, u8 is_input)
+{
+  applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, is_input, sw_if_index);
+  applied_hash_acl_info_t **applied_hash_acls = is_input ? &am->input_applied_hash_acl_info_by_sw_if_index
+                                                         : &am->output_applied_hash_acl_info_by_sw_if_index;
+  applied_hash_acl_info_t *pal = vec_elt_at_index((*applied_hash_acls), sw_if_index);
+  int is_ip6, is_nonfirst_fragment;
+  u32 i;
+
+  for (is_ip6 = 0; is_ip6 <= 1; is_ip6++) {
+    for (is_nonfirst_fragment = 0; is_nonfirst_fragment <= 1; is_nonfirst_fragment++) {
+      int pi = hash_acl_partition_index(is_ip6, is_nonfirst_fragment);
+      hash_applied_mask_info_t *new_mask_infos = 0;
+      hash_applied_mask_info_t *old_mask_infos;
+      uword *seen = 0;
+
+      /*
+       * the applied entries are in priority order, so the first entry seen
+       * with a given mask type is the highest priority one, and the tuples
+       * come out sorted.
+       */
+      for (i = 0; i < vec_len((*applied_hash_aces)); i++) {
+        applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), i);
+        hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+        hash_ace_info_t *hi = vec_elt_at_index(ha->rules, pae->hash_ace_info_index);
+        ace_mask_type_entry_t *mte = pool_elt_at_index(am->ace_mask_type_pool, hi->mask_type_index);
+
+        if (clib_bitmap_get(seen, hi->mask_type_index))
+          continue;
+        if (!hash_acl_entry_in_partition(&mte->mask, &hi->match, is_ip6, is_nonfirst_fragment))
+          continue;
+
+        seen = clib_bitmap_set(seen, hi->mask_type_index, 1);
+        hash_applied_mask_info_t minfo = {
+          .mask = mte->mask,
+          .mask_type_index = hi->mask_type_index,
+          .first_applied_entry_index = i,
+        };
+        vec_add1(new_mask_infos, minfo);
+      }
+      clib_bitmap_free(seen);
+
+      old_mask_infos = pal->mask_info_by_partition[pi];
+      pal->mask_info_by_partition[pi] = new_mask_infos;
+      vec_free(old_mask_infos);
+    }
+  }
+}
+
 static void *
 hash_acl_set_heap(acl_main_t *am)
 {
@@ -379,6 +451,7 @@ hash_acl_apply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
     activate_applied_ace_hash_entry(am, sw_if_index, is_input, applied_hash_aces, new_index);
   }
   applied_hash_entries_analyze(am, applied_hash_aces);
+  hash_acl_compile_applied_lookup(am, sw_if_index, is_input);
 done:
   clib_mem_set_heap (oldheap);
 }
@@ -587,6 +660,7 @@ hash_acl_unapply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
 
   /* After deletion we might not need some of the mask-types anymore... */
   hash_acl_build_applied_lookup_bitmap(am, sw_if_index, is_input);
+  hash_acl_compile_applied_lookup(am, sw_if_index, is_input);
   clib_mem_set_heap (oldheap);
 }
 
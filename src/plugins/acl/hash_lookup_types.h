@@ -74,6 +74,32 @@ typedef struct {
   u8 action;
 } applied_hash_ace_entry_t;
 
+/*
+ * The compiled lookup for an interface and direction is partitioned
+ * by the address family and by whether the packet is a non-initial fragment,
+ * since the mask types relevant to each of these are largely disjoint.
+ */
+#define HASH_ACL_N_PARTITIONS 4
+
+always_inline int
+hash_acl_partition_index(int is_ip6, int is_nonfirst_fragment)
+{
+  return ((is_ip6 << 1) | is_nonfirst_fragment);
+}
+
+/*
+ * One mask type ("tuple") to probe within a partition of the compiled lookup,
+ * with the lowest applied entry index that uses this mask type in the partition.
+ * The tuples are sorted by that index, which is the highest priority
+ * the tuple can yield, so the lookup stops as soon as the current match
+ * beats the next tuple.
+ */
+typedef struct {
+  fa_5tuple_t mask;
+  u32 mask_type_index;
+  u32 first_applied_entry_index;
+} hash_applied_mask_info_t;
+
 typedef struct {
    /*
     * A logical OR of all the applied_ace_hash_entry_t=>
@@ -82,6 +108,11 @@ typedef struct {
    uword *mask_type_index_bitmap;
    /* applied ACLs so we can track them independently from main ACL module */
    u32 *applied_acls;
+   /*
+    * the compiled lookup: the tuples to probe in priority order, per partition.
+    * Rebuilt off the data path whenever the applied ACLs change.
+    */
+   hash_applied_mask_info_t *mask_info_by_partition[HASH_ACL_N_PARTITIONS];
 } applied_hash_acl_info_t;
 
 
@@ -111,6 +111,9 @@ next:
   next = b->next_buffer;
   mb = rte_mbuf_from_vlib_buffer (b);
 
+  /* the next packet in this buffer is another flow */
+  b->flags &= ~VNET_BUFFER_F_FLOW_HASH_VALID;
+
   if (PREDICT_FALSE (b->n_add_refs))
     {
       rte_mbuf_refcnt_update (mb, b->n_add_refs);
@@ -68,6 +68,32 @@ dpdk_rx_error_from_mb (struct rte_mbuf *mb, u32 * next, u8 * error)
     *error = DPDK_ERROR_NONE;
 }
 
+/*
+ * Seed the buffer's cached flow hash from the NIC's RSS hash, so the
+ * forwarding nodes need not parse the headers again to pick an ECMP path.
+ * Only for untagged IP, where the RSS hash covers the same fields as the
+ * default IP flow hash. The low bits of the RSS hash picked the RX queue,
+ * and so the worker, so they are the same for all of a worker's packets:
+ * mix them into the rest before they pick a path.
+ */
+always_inline void
+dpdk_rx_flow_hash_from_mb (vlib_buffer_t * b, struct rte_mbuf *mb, u32 next)
+{
+  u32 h0, h1, h2;
+
+  if ((mb->ol_flags & PKT_RX_RSS_HASH) &&
+      (next == VNET_DEVICE_INPUT_NEXT_IP4_NCS_INPUT ||
+       next == VNET_DEVICE_INPUT_NEXT_IP4_INPUT ||
+       next == VNET_DEVICE_INPUT_NEXT_IP6_INPUT))
+    {
+      h0 = mb->hash.rss;
+      h1 = 0xdeadbeef;
+      h2 = 0;
+      hash_v3_finalize32 (h0, h1, h2);
+      vnet_buffer_flow_hash_set (b, h2);
+    }
+}
+
 static void
 dpdk_rx_trace (dpdk_main_t * dm,
 	       vlib_node_runtime_t * node,
@@ -404,6 +430,13 @@ dpdk_device_input (dpdk_main_t * dm, dpdk_device_t * xd,
 	  b3->current_length = mb3->data_len - offset3;
 	  n_rx_bytes += mb3->pkt_len;
 
+	  if (or_ol_flags & PKT_RX_RSS_HASH)
+	    {
+	      dpdk_rx_flow_hash_from_mb (b0, mb0, next0);
+	      dpdk_rx_flow_hash_from_mb (b1, mb1, next1);
+	      dpdk_rx_flow_hash_from_mb (b2, mb2, next2);
+	      dpdk_rx_flow_hash_from_mb (b3, mb3, next3);
+	    }
 
 	  /* Process subsequent segments of multi-segment packets */
 	  if (maybe_multiseg)
@@ -480,6 +513,8 @@ dpdk_device_input (dpdk_main_t * dm, dpdk_device_t * xd,
 	  b0->current_length = mb0->data_len - offset0;
 	  n_rx_bytes += mb0->pkt_len;
 
+	  dpdk_rx_flow_hash_from_mb (b0, mb0, next0);
+
 	  /* Process subsequent segments of multi-segment packets */
 	  dpdk_process_subseq_segs (vm, b0, mb0, fl);
 
@@ -574,6 +609,8 @@ poll_rate_limit (dpdk_main_t * dm)
         - required by ipX-lookup
     - <code>b->flags</code>
         - to indicate multi-segment pkts (VLIB_BUFFER_NEXT_PRESENT), etc.
+    - <code>vnet_buffer2(b)->flow_hash</code>
+        - the NIC's RSS hash for IP packets (VNET_BUFFER_F_FLOW_HASH_VALID)
 
     <em>Next Nodes:</em>
     - Static arcs to: error-drop, ethernet-input,
@@ -33,6 +33,7 @@
 
 snat_main_t snat_main;
 
+static vnet_feature_fused_function_t nat44_classify_fused;
 
 /* Hook up input features */
 VNET_FEATURE_INIT (ip4_snat_in2out, static) = {
@@ -49,6 +50,7 @@ VNET_FEATURE_INIT (ip4_nat_classify, static) = {
   .arc_name = "ip4-unicast",
   .node_name = "nat44-classify",
   .runs_before = VNET_FEATURES ("ip4-lookup"),
+  .fused_function = nat44_classify_fused,
 };
 VNET_FEATURE_INIT (ip4_snat_det_in2out, static) = {
   .arc_name = "ip4-unicast",
@@ -64,6 +66,7 @@ VNET_FEATURE_INIT (ip4_nat_det_classify, static) = {
   .arc_name = "ip4-unicast",
   .node_name = "nat44-det-classify",
   .runs_before = VNET_FEATURES ("ip4-lookup"),
+  .fused_function = nat44_classify_fused,
 };
 VNET_FEATURE_INIT (ip4_snat_in2out_worker_handoff, static) = {
   .arc_name = "ip4-unicast",
@@ -79,6 +82,7 @@ VNET_FEATURE_INIT (ip4_nat_handoff_classify, static) = {
   .arc_name = "ip4-unicast",
   .node_name = "nat44-handoff-classify",
   .runs_before = VNET_FEATURES ("ip4-lookup"),
+  .fused_function = nat44_classify_fused,
 };
 VNET_FEATURE_INIT (ip4_snat_in2out_fast, static) = {
   .arc_name = "ip4-unicast",
@@ -341,6 +345,48 @@ nat_session_alloc_or_recycle (snat_main_t *sm, snat_user_t *u, u32 thread_index)
   return s;
 }
 
+/* Whether a packet is for the outside, by its destination */
+always_inline u32
+nat44_classify_next (snat_main_t * sm, ip4_header_t * ip0)
+{
+  snat_address_t *ap;
+  snat_session_key_t m_key0;
+  clib_bihash_kv_8_8_t kv0, value0;
+
+  vec_foreach (ap, sm->addresses)
+    {
+      if (ip0->dst_address.as_u32 == ap->addr.as_u32)
+        return NAT44_CLASSIFY_NEXT_OUT2IN;
+    }
+
+  if (PREDICT_FALSE (pool_elts (sm->static_mappings)))
+    {
+      m_key0.addr = ip0->dst_address;
+      m_key0.port = 0;
+      m_key0.protocol = 0;
+      m_key0.fib_index = sm->outside_fib_index;
+      kv0.key = m_key0.as_u64;
+      if (!clib_bihash_search_8_8 (&sm->static_mapping_by_external, &kv0, &value0))
+        return NAT44_CLASSIFY_NEXT_OUT2IN;
+      udp_header_t * udp0 = ip4_next_header (ip0);
+      m_key0.port = clib_net_to_host_u16 (udp0->dst_port);
+      m_key0.protocol = ip_proto_to_snat_proto (ip0->protocol);
+      kv0.key = m_key0.as_u64;
+      if (!clib_bihash_search_8_8 (&sm->static_mapping_by_external, &kv0, &value0))
+        return NAT44_CLASSIFY_NEXT_OUT2IN;
+    }
+
+  return NAT44_CLASSIFY_NEXT_IN2OUT;
+}
+
+/* The packet always leaves for in2out or out2in, ending its chain */
+static u32
+nat44_classify_fused (vlib_main_t * vm, vlib_buffer_t * b0,
+                      void *feature_config)
+{
+  return nat44_classify_next (&snat_main, vlib_buffer_get_current (b0));
+}
+
 static inline uword
 nat44_classify_node_fn_inline (vlib_main_t * vm,
                                vlib_node_runtime_t * node,
@@ -365,11 +411,7 @@ nat44_classify_node_fn_inline (vlib_main_t * vm,
 	{
           u32 bi0;
 	  vlib_buffer_t *b0;
-          u32 next0 = NAT44_CLASSIFY_NEXT_IN2OUT;
-          ip4_header_t *ip0;
-          snat_address_t *ap;
-          snat_session_key_t m_key0;
-          clib_bihash_kv_8_8_t kv0, value0;
+          u32 next0;
 
           /* speculatively enqueue b0 to the current next frame */
 	  bi0 = from[0];
@@ -380,38 +422,8 @@ nat44_classify_node_fn_inline (vlib_main_t * vm,
 	  n_left_to_next -= 1;
 
 	  b0 = vlib_get_buffer (vm, bi0);
-          ip0 = vlib_buffer_get_current (b0);
-
-          vec_foreach (ap, sm->addresses)
-            {
-              if (ip0->dst_address.as_u32 == ap->addr.as_u32)
-                {
-                  next0 = NAT44_CLASSIFY_NEXT_OUT2IN;
-                  goto enqueue0;
-                }
-            }
-
-          if (PREDICT_FALSE (pool_elts (sm->static_mappings)))
-            {
-              m_key0.addr = ip0->dst_address;
-              m_key0.port = 0;
-              m_key0.protocol = 0;
-              m_key0.fib_index = sm->outside_fib_index;
-              kv0.key = m_key0.as_u64;
-              if (!clib_bihash_search_8_8 (&sm->static_mapping_by_external, &kv0, &value0))
-                {
-                  next0 = NAT44_CLASSIFY_NEXT_OUT2IN;
-                  goto enqueue0;
-                }
-              udp_header_t * udp0 = ip4_next_header (ip0);
-              m_key0.port = clib_net_to_host_u16 (udp0->dst_port);
-              m_key0.protocol = ip_proto_to_snat_proto (ip0->protocol);
-              kv0.key = m_key0.as_u64;
-              if (!clib_bihash_search_8_8 (&sm->static_mapping_by_external, &kv0, &value0))
-                next0 = NAT44_CLASSIFY_NEXT_OUT2IN;
-            }
+          next0 = nat44_classify_next (sm, vlib_buffer_get_current (b0));
 
-        enqueue0:
           /* verify speculative enqueue, maybe switch current next frame */
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
 					   to_next, n_left_to_next,
@@ -0,0 +1,93 @@
+
+# vppapigentab.py
+# This file is automatically generated. Do not edit.
+# pylint: disable=W,C,R
+_tabversion = '3.10'
+
+_lr_method = 'LALR'
+
+_lr_signature = "AUTOREPLY BOOL DEFINE DONT_TRACE ENUM EVENTS F64 FALSE I16 I32 I64 I8 ID IMPORT MANUAL_ENDIAN MANUAL_PRINT NUM OPTION RETURNS RPC SERVICE STREAM STRING STRING_LITERAL TRUE TYPEDEF TYPEONLY U16 U32 U64 U8slist : stmt\n                 | slist stmtstmt : define\n                | typedef\n                | option\n                | import\n                | enum\n                | serviceimport : IMPORT STRING_LITERAL ';' service : SERVICE '{' service_statements '}' ';' service_statements : service_statement\n                        | service_statements service_statementservice_statement : RPC ID RETURNS ID ';'\n                             | RPC ID RETURNS STREAM ID ';'\n                             | RPC ID RETURNS ID EVENTS event_list ';' event_list : events\n                      | event_list events events : ID\n                  | ID ',' enum : ENUM ID '{' enum_statements '}' ';'  enum : ENUM ID ':' enum_size '{' enum_statements '}' ';'  enum_size : U8\n                      | U16\n                      | U32 define : DEFINE ID '{' block_statements_opt '}' ';' define : flist DEFINE ID '{' block_statements_opt '}' ';' flist : flag\n                 | flist flagflag : MANUAL_PRINT\n                | MANUAL_ENDIAN\n                | DONT_TRACE\n                | TYPEONLY\n                | AUTOREPLYtypedef : TYPEDEF ID '{' block_statements_opt '}' ';' block_statements_opt : block_statementsblock_statements : block_statement\n                            | block_statements block_statementblock_statement : declaration\n                           | option enum_statements : enum_statement\n                            | enum_statements enum_statementenum_statement : ID '=' NUM ','\n                          | ID ',' declaration : type_specifier ID ';' declaration : type_specifier ID '[' NUM ']' ';'\n                       | type_specifier ID '[' ID ']' ';' option : OPTION ID '=' assignee ';' assignee : NUM\n                    | TRUE\n                    | FALSE\n                    | STRING_LITERAL type_specifier : U8\n                          | U16\n                          | U32\n                          | U64\n                          | I8\n                          | I16\n                          | I32\n                          | I64\n                          | F64\n                          | BOOL\n                          | STRINGtype_specifier : ID "
+    
+_lr_action_items = {'U16':([36,37,39,56,58,59,62,75,76,81,93,117,118,],[57,57,74,-36,57,-39,-38,57,-47,-37,-44,-45,-46,]),'OPTION':([0,1,5,6,11,12,14,17,21,22,35,36,37,56,58,59,62,75,76,77,81,91,93,94,95,106,113,117,118,],[2,2,-4,-8,-7,-5,-1,-6,-3,-2,-9,2,2,-36,2,-39,-38,2,-47,-10,-37,-25,-44,-34,-20,-26,-21,-45,-46,]),'SERVICE':([0,1,5,6,11,12,14,17,21,22,35,76,77,91,94,95,106,113,],[3,3,-4,-8,-7,-5,-1,-6,-3,-2,-9,-47,-10,-25,-34,-20,-26,-21,]),'U32':([36,37,39,56,58,59,62,75,76,81,93,117,118,],[51,51,73,-36,51,-39,-38,51,-47,-37,-44,-45,-46,]),'F64':([36,37,56,58,59,62,75,76,81,93,117,118,],[52,52,-36,52,-39,-38,52,-47,-37,-44,-45,-46,]),'TRUE':([31,],[42,]),'MANUAL_ENDIAN':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,91,94,95,106,113,],[4,4,-30,-4,-8,-31,-7,-5,-1,4,-27,-6,-32,-33,-29,-3,-2,-28,-9,-47,-10,-25,-34,-20,-26,-21,]),'U8':([36,37,39,56,58,59,62,75,76,81,93,117,118,],[49,49,71,-36,49,-39,-38,49,-47,-37,-44,-45,-46,]),'I8':([36,37,56,58,59,62,75,76,81,93,117,118,],[53,53,-36,53,-39,-38,53,-47,-37,-44,-45,-46,]),'STREAM':([78,],[89,]),',':([70,96,110,],[86,104,116,]),'ID':([2,9,10,13,30,34,36,37,38,49,50,51,52,53,55,56,57,58,59,60,61,62,63,64,65,66,68,69,75,76,78,81,83,86,87,89,92,93,97,101,104,108,109,110,114,116,117,118,],[23,26,27,28,40,48,63,63,70,-52,-62,-54,-60,-56,80,-36,-53,63,-39,-58,-57,-38,-63,-55,-59,-61,-40,70,63,-47,90,-37,-41,-43,70,99,103,-44,70,110,-42,110,-16,-18,-17,-19,-45,-46,]),'RPC':([24,32,33,46,100,107,115,],[34,-11,34,-12,-13,-14,-15,]),'NUM':([31,85,92,],[44,96,102,]),'IMPORT':([0,1,5,6,11,12,14,17,21,22,35,76,77,91,94,95,106,113,],[7,7,-4,-8,-7,-5,-1,-6,-3,-2,-9,-47,-10,-25,-34,-20,-26,-21,]),';':([25,41,42,43,44,45,47,79,80,82,84,90,98,99,105,108,109,110,111,112,114,116,],[35,-50,-49,76,-48,-51,77,91,93,94,95,100,106,107,113,115,-16,-18,117,118,-17,-19,]),':':([28,],[39,]),'=':([23,70,],[31,85,]),'DONT_TRACE':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,91,94,95,106,113,],[8,8,-30,-4,-8,-31,-7,-5,-1,8,-27,-6,-32,-33,-29,-3,-2,-28,-9,-47,-10,-25,-34,-20,-26,-21,]),'$end':([1,5,6,11,12,14,17,21,22,35,76,77,91,94,95,106,113,],[0,-4,-8,-7,-5,-1,-6,-3,-2,-9,-47,-10,-25,-34,-20,-26,-21,]),'TYPEDEF':([0,1,5,6,11,12,14,17,21,22,35,76,77,91,94,95,106,113,],[10,10,-4,-8,-7,-5,-1,-6,-3,-2,-9,-47,-10,-25,-34,-20,-26,-21,]),'I16':([36,37,56,58,59,62,75,76,81,93,117,118,],[61,61,-36,61,-39,-38,61,-47,-37,-44,-45,-46,]),'STRING':([36,37,56,58,59,62,75,76,81,93,117,118,],[50,50,-36,50,-39,-38,50,-47,-37,-44,-45,-46,]),'I32':([36,37,56,58,59,62,75,76,81,93,117,118,],[60,60,-36,60,-39,-38,60,-47,-37,-44,-45,-46,]),'ENUM':([0,1,5,6,11,12,14,17,21,22,35,76,77,91,94,95,106,113,],[13,13,-4,-8,-7,-5,-1,-6,-3,-2,-9,-47,-10,-25,-34,-20,-26,-21,]),'AUTOREPLY':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,91,94,95,106,113,],[19,19,-30,-4,-8,-31,-7,-5,-1,19,-27,-6,-32,-33,-29,-3,-2,-28,-9,-47,-10,-25,-34,-20,-26,-21,]),'[':([80,],[92,]),']':([102,103,],[111,112,]),'MANUAL_PRINT':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,91,94,95,106,113,],[20,20,-30,-4,-8,-31,-7,-5,-1,20,-27,-6,-32,-33,-29,-3,-2,-28,-9,-47,-10,-25,-34,-20,-26,-21,]),'FALSE':([31,],[41,]),'STRING_LITERAL':([7,31,],[25,45,]),'TYPEONLY':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,91,94,95,106,113,],[18,18,-30,-4,-8,-31,-7,-5,-1,18,-27,-6,-32,-33,-29,-3,-2,-28,-9,-47,-10,-25,-34,-20,-26,-21,]),'U64':([36,37,56,58,59,62,75,76,81,93,117,118,],[64,64,-36,64,-39,-38,64,-47,-37,-44,-45,-46,]),'RETURNS':([48,],[78,]),'EVENTS':([90,],[101,]),'I64':([36,37,56,58,59,62,75,76,81,93,117,118,],[65,65,-36,65,-39,-38,65,-47,-37,-44,-45,-46,]),'BOOL':([36,37,56,58,59,62,75,76,81,93,117,118,],[66,66,-36,66,-39,-38,66,-47,-37,-44,-45,-46,]),'{':([3,26,27,28,40,71,72,73,74,],[24,36,37,38,75,-22,87,-24,-23,]),'DEFINE':([0,1,4,5,6,8,11,12,14,15,16,17,18,19,20,21,22,29,35,76,77,91,94,95,106,113,],[9,9,-30,-4,-8,-31,-7,-5,-1,30,-27,-6,-32,-33,-29,-3,-2,-28,-9,-47,-10,-25,-34,-20,-26,-21,]),'}':([32,33,46,54,56,58,59,62,67,68,69,76,81,83,86,88,93,97,100,104,107,115,117,118,],[-11,47,-12,79,-36,-35,-39,-38,82,-40,84,-47,-37,-41,-43,98,-44,105,-13,-42,-14,-15,-45,-46,]),}
+
+_lr_action = {}
+for _k, _v in _lr_action_items.items():
+   for _x,_y in zip(_v[0],_v[1]):
+      if not _x in _lr_action:  _lr_action[_x] = {}
+      _lr_action[_x][_k] = _y
+del _lr_action_items
+
+_lr_goto_items = {'slist':([0,],[1,]),'enum_statement':([38,69,87,97,],[68,83,68,83,]),'service_statements':([24,],[33,]),'assignee':([31,],[43,]),'enum_size':([39,],[72,]),'typedef':([0,1,],[5,5,]),'type_specifier':([36,37,58,75,],[55,55,55,55,]),'service':([0,1,],[6,6,]),'service_statement':([24,33,],[32,46,]),'block_statement':([36,37,58,75,],[56,56,81,56,]),'enum_statements':([38,87,],[69,97,]),'import':([0,1,],[17,17,]),'events':([101,108,],[109,114,]),'define':([0,1,],[21,21,]),'block_statements':([36,37,75,],[58,58,58,]),'option':([0,1,36,37,58,75,],[12,12,59,59,59,59,]),'enum':([0,1,],[11,11,]),'block_statements_opt':([36,37,75,],[54,67,88,]),'stmt':([0,1,],[14,22,]),'flist':([0,1,],[15,15,]),'flag':([0,1,15,],[16,16,29,]),'declaration':([36,37,58,75,],[62,62,62,62,]),'event_list':([101,],[108,]),}
+
+_lr_goto = {}
+for _k, _v in _lr_goto_items.items():
+   for _x, _y in zip(_v[0], _v[1]):
+       if not _x in _lr_goto: _lr_goto[_x] = {}
+       _lr_goto[_x][_k] = _y
+del _lr_goto_items
+_lr_productions = [
+  ("S' -> slist","S'",1,None,None,None),
+  ('slist -> stmt','slist',1,'p_slist','vppapigen',316),
+  ('slist -> slist stmt','slist',2,'p_slist','vppapigen',317),
+  ('stmt -> define','stmt',1,'p_stmt','vppapigen',324),
+  ('stmt -> typedef','stmt',1,'p_stmt','vppapigen',325),
+  ('stmt -> option','stmt',1,'p_stmt','vppapigen',326),
+  ('stmt -> import','stmt',1,'p_stmt','vppapigen',327),
+  ('stmt -> enum','stmt',1,'p_stmt','vppapigen',328),
+  ('stmt -> service','stmt',1,'p_stmt','vppapigen',329),
+  ('import -> IMPORT STRING_LITERAL ;','import',3,'p_import','vppapigen',333),
+  ('service -> SERVICE { service_statements } ;','service',5,'p_service','vppapigen',337),
+  ('service_statements -> service_statement','service_statements',1,'p_service_statements','vppapigen',341),
+  ('service_statements -> service_statements service_statement','service_statements',2,'p_service_statements','vppapigen',342),
+  ('service_statement -> RPC ID RETURNS ID ;','service_statement',5,'p_service_statement','vppapigen',349),
+  ('service_statement -> RPC ID RETURNS STREAM ID ;','service_statement',6,'p_service_statement','vppapigen',350),
+  ('service_statement -> RPC ID RETURNS ID EVENTS event_list ;','service_statement',7,'p_service_statement','vppapigen',351),
+  ('event_list -> events','event_list',1,'p_event_list','vppapigen',360),
+  ('event_list -> event_list events','event_list',2,'p_event_list','vppapigen',361),
+  ('events -> ID','events',1,'p_event','vppapigen',368),
+  ('events -> ID ,','events',2,'p_event','vppapigen',369),
+  ('enum -> ENUM ID { enum_statements } ;','enum',6,'p_enum','vppapigen',373),
+  ('enum -> ENUM ID : enum_size { enum_statements } ;','enum',8,'p_enum_type','vppapigen',377),
+  ('enum_size -> U8','enum_size',1,'p_enum_size','vppapigen',384),
+  ('enum_size -> U16','enum_size',1,'p_enum_size','vppapigen',385),
+  ('enum_size -> U32','enum_size',1,'p_enum_size','vppapigen',386),
+  ('define -> DEFINE ID { block_statements_opt } ;','define',6,'p_define','vppapigen',390),
+  ('define -> flist DEFINE ID { block_statements_opt } ;','define',7,'p_define_flist','vppapigen',395),
+  ('flist -> flag','flist',1,'p_flist','vppapigen',399),
+  ('flist -> flist flag','flist',2,'p_flist','vppapigen',400),
+  ('flag -> MANUAL_PRINT','flag',1,'p_flag','vppapigen',407),
+  ('flag -> MANUAL_ENDIAN','flag',1,'p_flag','vppapigen',408),
+  ('flag -> DONT_TRACE','flag',1,'p_flag','vppapigen',409),
+  ('flag -> TYPEONLY','flag',1,'p_flag','vppapigen',410),
+  ('flag -> AUTOREPLY','flag',1,'p_flag','vppapigen',411),
+  ('typedef -> TYPEDEF ID { block_statements_opt } ;','typedef',6,'p_typedef','vppapigen',417),
+  ('block_statements_opt -> block_statements','block_statements_opt',1,'p_block_statements_opt','vppapigen',421),
+  ('block_statements -> block_statement','block_statements',1,'p_block_statements','vppapigen',425),
+  ('block_statements -> block_statements block_statement','block_statements',2,'p_block_statements','vppapigen',426),
+  ('block_statement -> declaration','block_statement',1,'p_block_statement','vppapigen',433),
+  ('block_statement -> option','block_statement',1,'p_block_statement','vppapigen',434),
+  ('enum_statements -> enum_statement','enum_statements',1,'p_enum_statements','vppapigen',438),
+  ('enum_statements -> enum_statements enum_statement','enum_statements',2,'p_enum_statements','vppapigen',439),
+  ('enum_statement -> ID = NUM ,','enum_statement',4,'p_enum_statement','vppapigen',446),
+  ('enum_statement -> ID ,','enum_statement',2,'p_enum_statement','vppapigen',447),
+  ('declaration -> type_specifier ID ;','declaration',3,'p_declaration','vppapigen',454),
+  ('declaration -> type_specifier ID [ NUM ] ;','declaration',6,'p_declaration_array','vppapigen',461),
+  ('declaration -> type_specifier ID [ ID ] ;','declaration',6,'p_declaration_array','vppapigen',462),
+  ('option -> OPTION ID = assignee ;','option',5,'p_option','vppapigen',483),
+  ('assignee -> NUM','assignee',1,'p_assignee','vppapigen',487),
+  ('assignee -> TRUE','assignee',1,'p_assignee','vppapigen',488),
+  ('assignee -> FALSE','assignee',1,'p_assignee','vppapigen',489),
+  ('assignee -> STRING_LITERAL','assignee',1,'p_assignee','vppapigen',490),
+  ('type_specifier -> U8','type_specifier',1,'p_type_specifier','vppapigen',494),
+  ('type_specifier -> U16','type_specifier',1,'p_type_specifier','vppapigen',495),
+  ('type_specifier -> U32','type_specifier',1,'p_type_specifier','vppapigen',496),
+  ('type_specifier -> U64','type_specifier',1,'p_type_specifier','vppapigen',497),
+  ('type_specifier -> I8','type_specifier',1,'p_type_specifier','vppapigen',498),
+  ('type_specifier -> I16','type_specifier',1,'p_type_specifier','vppapigen',499),
+  ('type_specifier -> I32','type_specifier',1,'p_type_specifier','vppapigen',500),
+  ('type_specifier -> I64','type_specifier',1,'p_type_specifier','vppapigen',501),
+  ('type_specifier -> F64','type_specifier',1,'p_type_specifier','vppapigen',502),
+  ('type_specifier -> BOOL','type_specifier',1,'p_type_specifier','vppapigen',503),
+  ('type_specifier -> STRING','type_specifier',1,'p_type_specifier','vppapigen',504),
+  ('type_specifier -> ID','type_specifier',1,'p_typedef_specifier','vppapigen',509),
+]
@@ -8013,6 +8013,8 @@ api_ip_add_del_route (vat_main_t * vam)
   u8 is_add = 1;
   u32 next_hop_weight = 1;
   u8 is_multipath = 0;
+  u8 is_resilient = 0;
+  u8 is_uniform = 0;
   u8 address_set = 0;
   u8 address_length_set = 0;
   u32 next_hop_table_id = 0;
@@ -8101,6 +8103,10 @@ api_ip_add_del_route (vat_main_t * vam)
 	resolve_attached = 1;
       else if (unformat (i, "multipath"))
 	is_multipath = 1;
+      else if (unformat (i, "resilient"))
+	is_resilient = 1;
+      else if (unformat (i, "uniform"))
+	is_uniform = 1;
       else if (unformat (i, "vrf %d", &vrf_id))
 	;
       else if (unformat (i, "count %d", &count))
@@ -8198,6 +8204,8 @@ api_ip_add_del_route (vat_main_t * vam)
       mp->is_local = is_local;
       mp->is_classify = is_classify;
       mp->is_multipath = is_multipath;
+      mp->is_resilient = is_resilient;
+      mp->is_uniform = is_uniform;
       mp->is_resolve_host = resolve_host;
       mp->is_resolve_attached = resolve_attached;
       mp->next_hop_weight = next_hop_weight;
@@ -8479,6 +8487,7 @@ api_mpls_route_add_del (vat_main_t * vam)
   mpls_label_t *next_hop_out_label_stack = NULL;
   mpls_label_t local_label = MPLS_LABEL_INVALID;
   u8 is_eos = 0;
+  u8 is_uniform = 0;
   dpo_proto_t next_hop_proto = DPO_PROTO_IP4;
 
   /* Parse args required to build the message */
@@ -8540,6 +8549,8 @@ api_mpls_route_add_del (vat_main_t * vam)
 	;
       else if (unformat (i, "out-label %d", &next_hop_out_label))
 	vec_add1 (next_hop_out_label_stack, ntohl (next_hop_out_label));
+      else if (unformat (i, "uniform"))
+	is_uniform = 1;
       else
 	{
 	  clib_warning ("parse error '%U'", format_unformat_error, i);
@@ -8588,6 +8599,7 @@ api_mpls_route_add_del (vat_main_t * vam)
       mp->mr_next_hop_via_label = ntohl (next_hop_via_label);
       mp->mr_label = ntohl (local_label);
       mp->mr_eos = is_eos;
+      mp->mr_is_uniform = is_uniform;
 
       mp->mr_next_hop_n_out_labels = vec_len (next_hop_out_label_stack);
       if (0 != mp->mr_next_hop_n_out_labels)
@@ -22711,7 +22723,7 @@ _(ip_add_del_route,                                                     \
   "<addr>/<mask> via <addr> [table-id <n>]\n"                           \
   "[<intfc> | sw_if_index <id>] [resolve-attempts <n>]\n"               \
   "[weight <n>] [drop] [local] [classify <n>] [del]\n"                  \
-  "[multipath] [count <n>]")                                            \
+  "[multipath] [resilient] [out-label <n>]... [uniform] [count <n>]")   \
 _(ip_mroute_add_del,                                                    \
   "<src> <grp>/<mask> [table-id <n>]\n"                                 \
   "[<intfc> | sw_if_index <id>] [local] [del]")                         \
@@ -22721,7 +22733,7 @@ _(mpls_route_add_del,                                                   \
   "<label> <eos> via <addr> [table-id <n>]\n"                           \
   "[<intfc> | sw_if_index <id>] [resolve-attempts <n>]\n"               \
   "[weight <n>] [drop] [local] [classify <n>] [del]\n"                  \
-  "[multipath] [count <n>]")                                            \
+  "[multipath] [out-label <n>]... [uniform] [count <n>]")               \
 _(mpls_ip_bind_unbind,                                                  \
   "<label> <addr/len>")                                                 \
 _(mpls_tunnel_add_del,                                                  \
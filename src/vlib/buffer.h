@@ -82,6 +82,7 @@ typedef struct
                 <br> VLIB_BUFFER_FLOW_REPORT: buffer is a flow report,
                 <br> VLIB_BUFFER_EXT_HDR_VALID: buffer contains valid external buffer manager header,
                 set to avoid adding it to a flow report
+                <br> VLIB_BUFFER_IS_LATENCY_TRACED: buffer is sampled by latency trace
                 <br> VLIB_BUFFER_FLAG_USER(n): user-defined bit N
              */
 
@@ -99,6 +100,7 @@ typedef struct
 #define VLIB_BUFFER_RECYCLE (1 << 10)
 #define VLIB_BUFFER_FLOW_REPORT (1 << 11)
 #define VLIB_BUFFER_EXT_HDR_VALID (1 << 12)
+#define VLIB_BUFFER_IS_LATENCY_TRACED (1 << 13)
 
   /* User defined buffer flags. */
 #define LOG2_VLIB_BUFFER_FLAG_USER(n) (32 - (n))
@@ -143,7 +145,9 @@ typedef struct
   /**< Only valid for first buffer in chain. Current length plus
      total length given here give total number of bytes in buffer chain.
   */
-  u32 align_pad; /**< available */
+  u32 latency_trace_index; /**< Specifies latency trace record
+                              if VLIB_BUFFER_IS_LATENCY_TRACED is set.
+                           */
   u32 opaque2[12];  /**< More opaque data, see ../vnet/vnet/buffer.h */
 
   /***** end of second cache line */
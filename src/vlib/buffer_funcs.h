@@ -81,6 +81,50 @@ vlib_get_buffer_index (vlib_main_t * vm, void *p)
   return offset >> CLIB_LOG2_CACHE_LINE_BYTES;
 }
 
+/** \brief Translate array of buffer indices into buffer pointers
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param bi - (u32 *) array of buffer indices
+    @param b - (vlib_buffer_t **) array to store buffer pointers
+    @param count - (int) number of elements
+*/
+always_inline void
+vlib_get_buffers (vlib_main_t * vm, u32 * bi, vlib_buffer_t ** b, int count)
+{
+  uword buffer_mem_start = vm->buffer_main->buffer_mem_start;
+
+  while (count >= 4)
+    {
+#if defined (CLIB_HAVE_VEC128_UNALIGNED_LOAD_STORE) && uword_bits == 64
+      u64x2 base = { buffer_mem_start, buffer_mem_start };
+      u32x4 zero = { 0 };
+      u32x4 bi4 = u32x4_load_unaligned ((u32x4 *) bi);
+      /* zero-extend the four indices into two u64x2 vectors */
+      u64x2 b0 = (u64x2) u32x4_interleave_lo (bi4, zero);
+      u64x2 b1 = (u64x2) u32x4_interleave_hi (bi4, zero);
+      u64x2_store_unaligned ((b0 << CLIB_LOG2_CACHE_LINE_BYTES) + base,
+			     (u64x2 *) b);
+      u64x2_store_unaligned ((b1 << CLIB_LOG2_CACHE_LINE_BYTES) + base,
+			     (u64x2 *) (b + 2));
+#else
+      b[0] = vlib_get_buffer (vm, bi[0]);
+      b[1] = vlib_get_buffer (vm, bi[1]);
+      b[2] = vlib_get_buffer (vm, bi[2]);
+      b[3] = vlib_get_buffer (vm, bi[3]);
+#endif
+      b += 4;
+      bi += 4;
+      count -= 4;
+    }
+  while (count)
+    {
+      b[0] = vlib_get_buffer (vm, bi[0]);
+      b += 1;
+      bi += 1;
+      count -= 1;
+    }
+}
+
 /** \brief Get next buffer in buffer linklist, or zero for end of list.
 
     @param vm - (vlib_main_t *) vlib main data structure pointer
@@ -585,27 +629,22 @@ vlib_buffer_copy (vlib_main_t * vm, vlib_buffer_t * b)
   return fd;
 }
 
-/** \brief Create multiple clones of buffer and store them in the supplied array
+/** \brief Create up to 256 clones of buffer, sharing its tail
 
-    @param vm - (vlib_main_t *) vlib main data structure pointer
-    @param src_buffer - (u32) source buffer index
-    @param buffers - (u32 * ) buffer index array
-    @param n_buffers - (u8) number of buffer clones requested
-    @param head_end_offset - (u16) offset relative to current position
-           where packet head ends
-    @return - (u8) number of buffers actually cloned, may be
-    less than the number requested or zero
+    The reference count on the shared tail is a u8, hence the limit.
+    See vlib_buffer_clone.
 */
 
-always_inline u8
-vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
-		   u8 n_buffers, u16 head_end_offset)
+always_inline u16
+vlib_buffer_clone_256 (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
+		       u16 n_buffers, u16 head_end_offset)
 {
-  u8 i;
+  u16 i;
   vlib_buffer_t *s = vlib_get_buffer (vm, src_buffer);
 
   ASSERT (s->n_add_refs == 0);
   ASSERT (n_buffers);
+  ASSERT (n_buffers <= 256);
 
   if (s->current_length <= head_end_offset + CLIB_CACHE_LINE_BYTES * 2)
     {
@@ -644,6 +683,7 @@ vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
       d->flags = s->flags | VLIB_BUFFER_NEXT_PRESENT;
       d->flags &= ~VLIB_BUFFER_EXT_HDR_VALID;
       clib_memcpy (d->opaque, s->opaque, sizeof (s->opaque));
+      clib_memcpy (d->opaque2, s->opaque2, sizeof (s->opaque2));
       clib_memcpy (vlib_buffer_get_current (d), vlib_buffer_get_current (s),
 		   head_end_offset);
       d->next_buffer = src_buffer;
@@ -659,6 +699,51 @@ vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
   return n_buffers;
 }
 
+/** \brief Create multiple clones of buffer and store them in the supplied array
+
+    Each clone is a private head buffer, holding a copy of the first
+    head_end_offset bytes, chained to the shared, reference counted, tail.
+    Fan-outs wider than the tail's reference count allows are served
+    from copies of the source, each shared by up to 256 clones.
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param src_buffer - (u32) source buffer index
+    @param buffers - (u32 * ) buffer index array
+    @param n_buffers - (u16) number of buffer clones requested
+    @param head_end_offset - (u16) offset relative to current position
+           where packet head ends
+    @return - (u16) number of buffers actually cloned, may be
+    less than the number requested or zero
+*/
+
+always_inline u16
+vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
+		   u16 n_buffers, u16 head_end_offset)
+{
+  vlib_buffer_t *s = vlib_get_buffer (vm, src_buffer);
+  u16 n_cloned = 0;
+
+  while (n_buffers > 256)
+    {
+      vlib_buffer_t *copy;
+
+      copy = vlib_buffer_copy (vm, s);
+      if (PREDICT_FALSE (copy == 0))
+	break;
+      n_cloned += vlib_buffer_clone_256 (vm,
+					 vlib_get_buffer_index (vm, copy),
+					 (buffers + n_cloned),
+					 256, head_end_offset);
+      n_buffers -= 256;
+    }
+  n_cloned += vlib_buffer_clone_256 (vm, src_buffer,
+				     buffers + n_cloned,
+				     clib_min (n_buffers, 256),
+				     head_end_offset);
+
+  return n_cloned;
+}
+
 /** \brief Attach cloned tail to the buffer
 
     @param vm - (vlib_main_t *) vlib main data structure pointer
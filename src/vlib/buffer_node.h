@@ -229,6 +229,107 @@ do {									\
     }									\
 } while (0)
 
+/** \brief Enqueue a whole vector of buffers to per-buffer next nodes.
+ Replaces the speculative enqueue / validate boilerplate for nodes which
+ compute all next indices up front. Runs of buffers going to the same
+ next node are detected with a vector compare and copied into the next
+ frame in one go, so mixed traffic costs one frame switch per run rather
+ than a misprediction per packet.
+
+ @param vm vlib_main_t pointer, varies by thread
+ @param node current node vlib_node_runtime_t pointer
+ @param buffers array of buffer indices
+ @param nexts array of next indices, one per buffer
+ @param count number of buffers (and next indices)
+*/
+static_always_inline void
+vlib_buffer_enqueue_to_next (vlib_main_t * vm, vlib_node_runtime_t * node,
+			     u32 * buffers, u16 * nexts, uword count)
+{
+  u32 *to_next, n_left_to_next, max;
+  u16 next_index;
+
+  if (PREDICT_FALSE (count == 0))
+    return;
+
+  next_index = nexts[0];
+  vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+  max = clib_min (n_left_to_next, count);
+
+  while (count)
+    {
+      u32 n_enqueued;
+
+      if ((nexts[0] != next_index) || n_left_to_next == 0)
+	{
+	  vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+	  next_index = nexts[0];
+	  vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+	  max = clib_min (n_left_to_next, count);
+	}
+
+      if (PREDICT_FALSE (count < 8 || max < 8))
+	{
+	  /* tail: one at a time */
+	  to_next[0] = buffers[0];
+	  to_next += 1;
+	  buffers += 1;
+	  nexts += 1;
+	  n_left_to_next -= 1;
+	  count -= 1;
+	  max -= 1;
+	  continue;
+	}
+
+#if defined (CLIB_HAVE_VEC128_MSB_MASK)
+      {
+	u16x8 next8 = u16x8_load_unaligned ((u16x8 *) nexts);
+	u32 bitmap = u8x16_compare_byte_mask ((u8x16) u16x8_is_equal
+					      (next8,
+					       u16x8_splat (next_index)));
+	/* number of leading buffers which share next_index */
+	count_trailing_zeros (n_enqueued, ~bitmap);
+	n_enqueued /= 2;
+      }
+#else
+      {
+	u16 x = 0;
+	x |= next_index ^ nexts[1];
+	x |= next_index ^ nexts[2];
+	x |= next_index ^ nexts[3];
+	x |= next_index ^ nexts[4];
+	x |= next_index ^ nexts[5];
+	x |= next_index ^ nexts[6];
+	x |= next_index ^ nexts[7];
+	n_enqueued = (x == 0) ? 8 : 1;
+      }
+#endif
+
+      if (n_enqueued == 8)
+	{
+	  clib_memcpy (to_next, buffers, 8 * sizeof (u32));
+	  to_next += 8;
+	  buffers += 8;
+	  nexts += 8;
+	  n_left_to_next -= 8;
+	  count -= 8;
+	  max -= 8;
+	  continue;
+	}
+
+      /* copy the run, next iteration switches frames */
+      vlib_copy_buffers (to_next, buffers, n_enqueued);
+      to_next += n_enqueued;
+      buffers += n_enqueued;
+      nexts += n_enqueued;
+      n_left_to_next -= n_enqueued;
+      count -= n_enqueued;
+      max -= n_enqueued;
+    }
+
+  vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+}
+
 always_inline uword
 generic_buffer_node_inline (vlib_main_t * vm,
 			    vlib_node_runtime_t * node,
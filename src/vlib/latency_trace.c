@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * latency_trace.c: sampled per-packet latency trace through the graph
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/threads.h>
+
+/*
+ * Buffer latency_trace_index layout:
+ *   [31:24] thread owning the record ring
+ *   [23:12] ring slot
+ *   [11:0]  record generation, bumped on reuse and on completion
+ */
+always_inline u32
+latency_trace_index_make (u32 thread_index, u32 slot, u32 generation)
+{
+  return (thread_index << 24) | (slot << 12) | (generation & 0xfff);
+}
+
+always_inline vlib_latency_trace_record_t *
+latency_trace_record_get (u32 index)
+{
+  vlib_main_t *owner_vm;
+  vlib_latency_trace_record_t *r;
+  u32 thread_index = index >> 24;
+
+  if (PREDICT_FALSE (thread_index >= vec_len (vlib_mains)))
+    return 0;
+
+  owner_vm = vlib_mains[thread_index];
+  if (PREDICT_FALSE (owner_vm == 0
+		     || owner_vm->latency_trace_main.records == 0))
+    return 0;
+
+  r = owner_vm->latency_trace_main.records
+    + ((index >> 12) & (VLIB_LATENCY_TRACE_RING_SIZE - 1));
+
+  /* Slot reused, or record already completed by a clone */
+  if (PREDICT_FALSE (r->generation != (index & 0xfff)))
+    return 0;
+
+  return r;
+}
+
+always_inline uword
+latency_trace_bucket (u64 clocks)
+{
+  uword log2, sub;
+
+  if (clocks < (1 << VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS))
+    return clocks;
+
+  log2 = min_log2_u64 (clocks);
+  sub = (clocks >> (log2 - VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS))
+    & ((1 << VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS) - 1);
+
+  return ((log2 - VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS + 1)
+	  << VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS) + sub;
+}
+
+/* Upper bound in clocks of a histogram bucket */
+static u64
+latency_trace_bucket_limit (uword bucket)
+{
+  uword log2, sub;
+
+  if (bucket < (1 << VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS))
+    return bucket + 1;
+
+  log2 = (bucket >> VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS)
+    + VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS - 1;
+  sub = bucket & ((1 << VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS) - 1);
+
+  return ((1ULL << log2)
+	  + ((sub + 1) << (log2 - VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS)));
+}
+
+void
+vlib_latency_trace_sample_pending (vlib_main_t * vm, u64 ingress_time)
+{
+  vlib_latency_trace_main_t *ltm = &vm->latency_trace_main;
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_pending_frame_t *p;
+  vlib_frame_t *f;
+  vlib_buffer_t *b;
+  u32 *from, n_left;
+
+  if (PREDICT_FALSE (vm->thread_index > 255 || ltm->records == 0))
+    return;
+
+  vec_foreach (p, nm->pending_frames)
+  {
+    f = vlib_get_frame (vm, p->frame_index);
+    from = vlib_frame_vector_args (f);
+    n_left = f->n_vectors;
+
+    /* Skip whole frames between samples */
+    if (n_left <= ltm->sample_countdown)
+      {
+	ltm->sample_countdown -= n_left;
+	continue;
+      }
+
+    from += ltm->sample_countdown;
+    n_left -= ltm->sample_countdown;
+
+    while (n_left > 0)
+      {
+	vlib_latency_trace_record_t *r;
+	u32 slot;
+
+	b = vlib_get_buffer (vm, from[0]);
+
+	/* Already traced, e.g. handed off from another thread */
+	if (!(b->flags & VLIB_BUFFER_IS_LATENCY_TRACED)
+	    || latency_trace_record_get (b->latency_trace_index) == 0)
+	  {
+	    slot = ltm->next_record++ & (VLIB_LATENCY_TRACE_RING_SIZE - 1);
+	    r = ltm->records + slot;
+
+	    /* Ring wrapped before this record completed */
+	    if (r->n_hops > 0)
+	      ltm->n_lost++;
+
+	    r->generation = (r->generation + 1) & 0xfff;
+	    r->ingress_time = ingress_time;
+	    r->n_hops = 0;
+	    r->truncated = 0;
+
+	    b->latency_trace_index =
+	      latency_trace_index_make (vm->thread_index, slot,
+					r->generation);
+	    b->flags |= VLIB_BUFFER_IS_LATENCY_TRACED;
+	  }
+
+	if (n_left <= ltm->sample_interval)
+	  {
+	    ltm->sample_countdown = ltm->sample_interval - n_left;
+	    break;
+	  }
+	from += ltm->sample_interval;
+	n_left -= ltm->sample_interval;
+      }
+  }
+}
+
+static void
+latency_trace_complete (vlib_main_t * vm, vlib_latency_trace_record_t * r,
+			u64 exit_time)
+{
+  vlib_latency_trace_main_t *ltm = &vm->latency_trace_main;
+  vlib_latency_trace_path_t *path;
+  vlib_latency_trace_hop_t *h;
+  uword *pi;
+  u32 i, n_hops;
+
+  /*
+   * The record is in the ring of the thread the packet arrived on, which
+   * may reuse it, resetting n_hops, while this thread completes it after
+   * a handoff. Read the hop count once and trust no more than that.
+   */
+  n_hops = clib_min (*(volatile u8 *) &r->n_hops,
+		     VLIB_LATENCY_TRACE_MAX_HOPS);
+  if (0 == n_hops)
+    return;
+
+  vec_reset_length (ltm->scratch_nodes);
+  for (i = 0; i < n_hops; i++)
+    {
+      h = r->hops + i;
+      vec_add1 (ltm->scratch_nodes, h->node_index
+		| ((i > 0 && h->thread_index != h[-1].thread_index)
+		   ? VLIB_LATENCY_TRACE_HANDOFF : 0));
+    }
+
+  if (ltm->path_index_by_nodes == 0)
+    ltm->path_index_by_nodes = hash_create_vec (0, sizeof (u32),
+						sizeof (uword));
+
+  pi = hash_get_mem (ltm->path_index_by_nodes, &ltm->scratch_nodes);
+  if (pi)
+    path = vec_elt_at_index (ltm->paths, pi[0]);
+  else
+    {
+      vec_add2 (ltm->paths, path, 1);
+      memset (path, 0, sizeof (path[0]));
+      path->nodes = vec_dup (ltm->scratch_nodes);
+      vec_validate (path->hop_clocks, n_hops - 1);
+      hash_set_mem (ltm->path_index_by_nodes, &path->nodes,
+		    path - ltm->paths);
+    }
+
+  path->count++;
+  path->histogram[latency_trace_bucket (exit_time - r->ingress_time)]++;
+  for (i = 0; i + 1 < n_hops && i < vec_len (path->hop_clocks); i++)
+    {
+      u64 dt = r->hops[i + 1].clocks - r->hops[i].clocks;
+      path->hop_clocks[i] += dt;
+      if (r->hops[i + 1].thread_index != r->hops[i].thread_index)
+	path->handoff_clocks += dt;
+    }
+}
+
+void
+vlib_latency_trace_frame (vlib_main_t * vm, u32 node_index,
+			  vlib_frame_t * f, u64 entry_time)
+{
+  vlib_node_t *n = vlib_get_node (vm, node_index);
+  int is_exit = (n->flags & (VLIB_NODE_FLAG_IS_OUTPUT
+			     | VLIB_NODE_FLAG_IS_DROP
+			     | VLIB_NODE_FLAG_IS_PUNT)) != 0;
+  u32 *from = vlib_frame_vector_args (f);
+  u32 n_left = f->n_vectors;
+
+  while (n_left > 0)
+    {
+      vlib_buffer_t *b = vlib_get_buffer (vm, from[0]);
+      vlib_latency_trace_record_t *r;
+      vlib_latency_trace_hop_t *h;
+
+      from += 1;
+      n_left -= 1;
+
+      if (PREDICT_TRUE (!(b->flags & VLIB_BUFFER_IS_LATENCY_TRACED)))
+	continue;
+
+      r = latency_trace_record_get (b->latency_trace_index);
+      if (PREDICT_FALSE (r == 0))
+	{
+	  b->flags &= ~VLIB_BUFFER_IS_LATENCY_TRACED;
+	  continue;
+	}
+
+      if (r->n_hops < VLIB_LATENCY_TRACE_MAX_HOPS)
+	{
+	  h = r->hops + r->n_hops++;
+	  h->node_index = node_index;
+	  h->thread_index = vm->thread_index;
+	  h->clocks = entry_time - r->ingress_time;
+	}
+      else
+	r->truncated = 1;
+
+      if (is_exit)
+	{
+	  latency_trace_complete (vm, r, entry_time);
+	  /* Invalidate outstanding references, e.g. from clones */
+	  r->generation = (r->generation + 1) & 0xfff;
+	  r->n_hops = 0;
+	  b->flags &= ~VLIB_BUFFER_IS_LATENCY_TRACED;
+	}
+    }
+}
+
+static clib_error_t *
+latency_trace_enable_disable (vlib_main_t * vm, int enable,
+			      u32 sample_interval)
+{
+  vlib_latency_trace_main_t *ltm;
+  vlib_main_t *this_vm;
+  int i;
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vm = vlib_mains[i];
+      if (this_vm == 0)
+	continue;
+      ltm = &this_vm->latency_trace_main;
+
+      ltm->enabled = enable;
+      ltm->sample_interval = sample_interval;
+      ltm->sample_countdown = sample_interval - 1;
+
+      /* Rings are only touched by workers; allocate on the main heap */
+      if (enable && ltm->records == 0)
+	{
+	  vec_validate_aligned (ltm->records,
+				VLIB_LATENCY_TRACE_RING_SIZE - 1,
+				CLIB_CACHE_LINE_BYTES);
+	  ltm->next_record = 0;
+	}
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+static clib_error_t *
+latency_trace_command_fn (vlib_main_t * vm,
+			  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  u32 sample_interval = 1000;
+  int enable = -1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "on") || unformat (input, "enable"))
+	enable = 1;
+      else if (unformat (input, "off") || unformat (input, "disable"))
+	enable = 0;
+      else if (unformat (input, "sample %u", &sample_interval))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (enable == -1)
+    return clib_error_return (0, "specify on or off");
+  if (sample_interval == 0)
+    return clib_error_return (0, "sample interval must be non-zero");
+
+  return latency_trace_enable_disable (vm, enable, sample_interval);
+}
+
+/*?
+ * Enable or disable sampled latency tracing. One in every
+ * '<em>sample</em>' packets (default 1000) leaving the input nodes is
+ * stamped with the time the input node ran, and the time it enters each
+ * node is recorded until it reaches an output, drop or punt node. Results
+ * are shown per path (node sequence) with '<em>show latency-trace</em>'.
+ *
+ * @cliexpar
+ * @cliexcmd{latency-trace on sample 100}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (latency_trace_command, static) = {
+  .path = "latency-trace",
+  .short_help = "latency-trace <on|off> [sample <n>]",
+  .function = latency_trace_command_fn,
+};
+/* *INDENT-ON* */
+
+typedef struct
+{
+  u32 *nodes;
+  u64 count;
+  u64 *hop_clocks;
+  u64 handoff_clocks;
+  u64 histogram[VLIB_LATENCY_TRACE_N_BUCKETS];
+} latency_trace_path_summary_t;
+
+static u64
+latency_trace_percentile (latency_trace_path_summary_t * s, f64 pct)
+{
+  u64 target = (u64) (pct * s->count), sum = 0;
+  uword i;
+
+  for (i = 0; i < VLIB_LATENCY_TRACE_N_BUCKETS; i++)
+    {
+      sum += s->histogram[i];
+      if (sum > target)
+	return latency_trace_bucket_limit (i);
+    }
+  return latency_trace_bucket_limit (VLIB_LATENCY_TRACE_N_BUCKETS - 1);
+}
+
+static u8 *
+format_latency_trace_path (u8 * s, va_list * args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  latency_trace_path_summary_t *ps =
+    va_arg (*args, latency_trace_path_summary_t *);
+  f64 us = vm->clib_time.seconds_per_clock * 1e6;
+  u32 i, node_index;
+
+  s = format (s, "packets %Lu latency p50 %.2fus p99 %.2fus p999 %.2fus",
+	      ps->count,
+	      latency_trace_percentile (ps, 0.5) * us,
+	      latency_trace_percentile (ps, 0.99) * us,
+	      latency_trace_percentile (ps, 0.999) * us);
+  if (ps->handoff_clocks)
+    s = format (s, ", handoff wait avg %.2fus",
+		(f64) ps->handoff_clocks / ps->count * us);
+
+  for (i = 0; i < vec_len (ps->nodes); i++)
+    {
+      node_index = ps->nodes[i] & ~VLIB_LATENCY_TRACE_HANDOFF;
+      s = format (s, "\n    %s%-30v", (ps->nodes[i]
+					 & VLIB_LATENCY_TRACE_HANDOFF) ?
+		  "(handoff) " : "",
+		  vlib_get_node (vm, node_index)->name);
+      if (i + 1 < vec_len (ps->nodes))
+	s = format (s, " %10.2fus", (f64) ps->hop_clocks[i] / ps->count * us);
+    }
+  return s;
+}
+
+static int
+latency_trace_path_summary_cmp (void *a1, void *a2)
+{
+  latency_trace_path_summary_t *p1 = a1, *p2 = a2;
+
+  return (p1->count < p2->count) - (p1->count > p2->count);
+}
+
+static clib_error_t *
+show_latency_trace_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  latency_trace_path_summary_t *summaries = 0, *ps;
+  vlib_latency_trace_path_t *path;
+  uword *summary_index_by_nodes;
+  vlib_main_t *this_vm;
+  u32 max_paths = 20;
+  u64 n_lost = 0;
+  uword *p;
+  int i, j;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "paths %u", &max_paths))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  summary_index_by_nodes = hash_create_vec (0, sizeof (u32), sizeof (uword));
+
+  /* Merge per-thread paths with the same node sequence */
+  vlib_worker_thread_barrier_sync (vm);
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vm = vlib_mains[i];
+      if (this_vm == 0)
+	continue;
+      n_lost += this_vm->latency_trace_main.n_lost;
+
+      vec_foreach (path, this_vm->latency_trace_main.paths)
+      {
+	if (path->count == 0)
+	  continue;
+	p = hash_get_mem (summary_index_by_nodes, &path->nodes);
+	if (p)
+	  ps = vec_elt_at_index (summaries, p[0]);
+	else
+	  {
+	    vec_add2 (summaries, ps, 1);
+	    memset (ps, 0, sizeof (ps[0]));
+	    ps->nodes = vec_dup (path->nodes);
+	    vec_validate (ps->hop_clocks, vec_len (path->nodes) - 1);
+	    hash_set_mem (summary_index_by_nodes, &ps->nodes,
+			  ps - summaries);
+	  }
+	ps->count += path->count;
+	ps->handoff_clocks += path->handoff_clocks;
+	for (j = 0; j < vec_len (path->nodes); j++)
+	  ps->hop_clocks[j] += path->hop_clocks[j];
+	for (j = 0; j < VLIB_LATENCY_TRACE_N_BUCKETS; j++)
+	  ps->histogram[j] += path->histogram[j];
+      }
+    }
+  vlib_worker_thread_barrier_release (vm);
+
+  hash_free (summary_index_by_nodes);
+
+  vlib_cli_output (vm, "Latency trace %s, %d paths, %Lu samples lost",
+		   vm->latency_trace_main.enabled ? "enabled" : "disabled",
+		   vec_len (summaries), n_lost);
+
+  /* Busiest paths first */
+  vec_sort_with_function (summaries, latency_trace_path_summary_cmp);
+
+  vec_foreach (ps, summaries)
+  {
+    if (ps - summaries < max_paths)
+      vlib_cli_output (vm, "[%d] %U", ps - summaries,
+		       format_latency_trace_path, vm, ps);
+    vec_free (ps->nodes);
+    vec_free (ps->hop_clocks);
+  }
+  vec_free (summaries);
+
+  return 0;
+}
+
+/*?
+ * Show sampled latency per path. For each distinct node sequence, shows
+ * the number of samples, p50/p99/p999 ingress-to-exit latency, the
+ * average time spent waiting in handoff queues, and the average time from
+ * entering each node to entering the next one.
+ *
+ * @cliexpar
+ * @cliexcmd{show latency-trace paths 5}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_latency_trace_command, static) = {
+  .path = "show latency-trace",
+  .short_help = "show latency-trace [paths <n>]",
+  .function = show_latency_trace_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_latency_trace_command_fn (vlib_main_t * vm,
+				unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  vlib_latency_trace_path_t *path;
+  vlib_main_t *this_vm;
+  int i;
+
+  /* Paths are owned by their thread's heap: zero them, don't free */
+  vlib_worker_thread_barrier_sync (vm);
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vm = vlib_mains[i];
+      if (this_vm == 0)
+	continue;
+      this_vm->latency_trace_main.n_lost = 0;
+      vec_foreach (path, this_vm->latency_trace_main.paths)
+      {
+	path->count = 0;
+	path->handoff_clocks = 0;
+	vec_zero (path->hop_clocks);
+	memset (path->histogram, 0, sizeof (path->histogram));
+      }
+    }
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_latency_trace_command, static) = {
+  .path = "clear latency-trace",
+  .short_help = "clear latency-trace",
+  .function = clear_latency_trace_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * latency_trace.h: sampled per-packet latency trace through the graph
+ */
+
+#ifndef included_vlib_latency_trace_h
+#define included_vlib_latency_trace_h
+
+/** \file
+    Sampled latency trace. One packet in every sample_interval leaving
+    the input nodes is stamped with its ingress time and gets a record
+    in a per-thread ring. Each node entry adds a hop (node, thread,
+    clocks since ingress). When the packet reaches an output or drop
+    node the record is folded into per-path statistics, keyed by the
+    node sequence.
+*/
+
+/* Hops kept per packet; longer paths are truncated. */
+#define VLIB_LATENCY_TRACE_MAX_HOPS 14
+
+/* Records per thread ring, must be a power of 2 <= 4096 */
+#define VLIB_LATENCY_TRACE_LOG2_RING_SIZE 12
+#define VLIB_LATENCY_TRACE_RING_SIZE (1 << VLIB_LATENCY_TRACE_LOG2_RING_SIZE)
+
+/* Log2 histogram with 4 linear sub-buckets per power of 2 */
+#define VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS 2
+#define VLIB_LATENCY_TRACE_N_BUCKETS (64 << VLIB_LATENCY_TRACE_LOG2_SUB_BUCKETS)
+
+/* Path element flag: packet changed threads (handoff) before this node */
+#define VLIB_LATENCY_TRACE_HANDOFF (1 << 31)
+
+typedef struct
+{
+  u16 node_index;
+  u16 thread_index;
+  /* Entry time, clocks since ingress */
+  u32 clocks;
+} vlib_latency_trace_hop_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u64 ingress_time;
+  u16 generation;
+  u8 n_hops;
+  u8 truncated;
+  vlib_latency_trace_hop_t hops[VLIB_LATENCY_TRACE_MAX_HOPS];
+} vlib_latency_trace_record_t;
+
+typedef struct
+{
+  /* Node indices, VLIB_LATENCY_TRACE_HANDOFF set on thread change */
+  u32 *nodes;
+
+  /* Packets which completed along this path */
+  u64 count;
+
+  /* Per-hop sum of clocks spent from this node to the next one */
+  u64 *hop_clocks;
+
+  /* Sum of clocks from handoff node entry to entry on the next thread */
+  u64 handoff_clocks;
+
+  /* Ingress to output/drop latency */
+  u32 histogram[VLIB_LATENCY_TRACE_N_BUCKETS];
+} vlib_latency_trace_path_t;
+
+typedef struct
+{
+  /* Non-zero when latency tracing is on for this thread */
+  u32 enabled;
+
+  /* Trace one in every sample_interval packets */
+  u32 sample_interval;
+  u32 sample_countdown;
+
+  /* Ring of in-flight records, allocated by the main thread */
+  vlib_latency_trace_record_t *records;
+  u32 next_record;
+
+  /* Completed paths, owned by this thread */
+  vlib_latency_trace_path_t *paths;
+  uword *path_index_by_nodes;
+  u32 *scratch_nodes;
+
+  /* Records overwritten in the ring before completing */
+  u64 n_lost;
+} vlib_latency_trace_main_t;
+
+struct vlib_main_t;
+struct vlib_frame_t;
+
+void vlib_latency_trace_sample_pending (struct vlib_main_t *vm,
+					u64 ingress_time);
+void vlib_latency_trace_frame (struct vlib_main_t *vm, u32 node_index,
+			       struct vlib_frame_t *f, u64 entry_time);
+
+#endif /* included_vlib_latency_trace_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * perf_counter.c: per-node hardware performance counters (Linux)
+ */
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include <vlib/vlib.h>
+
+typedef struct
+{
+  u32 type;
+  u64 config;
+} vlib_perf_counter_event_t;
+
+/* Must match foreach_vlib_perf_counter order */
+static vlib_perf_counter_event_t vlib_perf_counter_events[] = {
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_DTLB
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))},
+};
+
+STATIC_ASSERT (ARRAY_LEN (vlib_perf_counter_events) == VLIB_N_PERF_COUNTERS,
+	       "perf counter event table out of sync");
+
+#if defined (__x86_64__)
+always_inline u64
+vlib_perf_counter_rdpmc (u32 counter)
+{
+  u32 lo, hi;
+  asm volatile ("rdpmc":"=a" (lo), "=d" (hi):"c" (counter));
+  return ((u64) hi << 32) | lo;
+}
+
+/* Read a counter from user space, see perf_event_open(2) */
+always_inline u64
+vlib_perf_counter_read_one (struct perf_event_mmap_page *pc)
+{
+  u32 seq, idx, width;
+  u64 count;
+  i64 pmc;
+
+  do
+    {
+      seq = pc->lock;
+      CLIB_MEMORY_BARRIER ();
+      idx = pc->index;
+      count = pc->offset;
+      if (PREDICT_TRUE (idx != 0))
+	{
+	  width = pc->pmc_width;
+	  pmc = vlib_perf_counter_rdpmc (idx - 1);
+	  pmc <<= 64 - width;
+	  pmc >>= 64 - width;
+	  count += pmc;
+	}
+      CLIB_MEMORY_BARRIER ();
+    }
+  while (pc->lock != seq);
+
+  return count;
+}
+
+static void
+vlib_perf_counter_read_rdpmc (vlib_main_t * vm, u64 * counters)
+{
+  vlib_perf_counter_main_t *pcm = &vm->perf_counter_main;
+  int i;
+
+  for (i = 0; i < VLIB_N_PERF_COUNTERS; i++)
+    counters[i] = vlib_perf_counter_read_one (pcm->mmap_pages[i]);
+}
+#endif
+
+/* Slow path: one read(2) for the whole group */
+static void
+vlib_perf_counter_read_syscall (vlib_main_t * vm, u64 * counters)
+{
+  vlib_perf_counter_main_t *pcm = &vm->perf_counter_main;
+  u64 data[1 + VLIB_N_PERF_COUNTERS];
+  int i;
+
+  if (read (pcm->fds[0], data, sizeof (data)) != sizeof (data))
+    {
+      memset (counters, 0, VLIB_N_PERF_COUNTERS * sizeof (u64));
+      return;
+    }
+
+  /* data[0] is the number of counters in the group */
+  for (i = 0; i < VLIB_N_PERF_COUNTERS; i++)
+    counters[i] = data[1 + i];
+}
+
+static void
+vlib_perf_counters_close (vlib_main_t * vm)
+{
+  vlib_perf_counter_main_t *pcm = &vm->perf_counter_main;
+  uword page_size = clib_mem_get_page_size ();
+  int i;
+
+  pcm->read = 0;
+
+  for (i = 0; i < VLIB_N_PERF_COUNTERS; i++)
+    {
+      if (pcm->mmap_pages[i])
+	munmap (pcm->mmap_pages[i], page_size);
+      pcm->mmap_pages[i] = 0;
+      if (pcm->fds[i] > 0)
+	close (pcm->fds[i]);
+      pcm->fds[i] = -1;
+    }
+}
+
+static clib_error_t *
+vlib_perf_counters_open (vlib_main_t * vm, pid_t lwp)
+{
+  vlib_perf_counter_main_t *pcm = &vm->perf_counter_main;
+  uword page_size = clib_mem_get_page_size ();
+  struct perf_event_attr pe;
+  int can_rdpmc = 1;
+  int i;
+
+  for (i = 0; i < VLIB_N_PERF_COUNTERS; i++)
+    pcm->fds[i] = -1;
+
+  for (i = 0; i < VLIB_N_PERF_COUNTERS; i++)
+    {
+      struct perf_event_mmap_page *p;
+
+      memset (&pe, 0, sizeof (pe));
+      pe.size = sizeof (pe);
+      pe.type = vlib_perf_counter_events[i].type;
+      pe.config = vlib_perf_counter_events[i].config;
+      pe.read_format = PERF_FORMAT_GROUP;
+      pe.exclude_kernel = 1;
+      pe.exclude_hv = 1;
+      pe.disabled = (i == 0);
+
+      pcm->fds[i] = syscall (__NR_perf_event_open, &pe, lwp, -1 /* cpu */ ,
+			     pcm->fds[0], 0 /* flags */ );
+      if (pcm->fds[i] < 0)
+	{
+	  clib_error_t *error =
+	    clib_error_return_unix (0, "perf_event_open (%d) thread %d", i,
+				    lwp);
+	  vlib_perf_counters_close (vm);
+	  return error;
+	}
+
+      p = mmap (0, page_size, PROT_READ, MAP_SHARED, pcm->fds[i], 0);
+      if (p == MAP_FAILED)
+	{
+	  can_rdpmc = 0;
+	  continue;
+	}
+      pcm->mmap_pages[i] = p;
+      can_rdpmc &= p->cap_user_rdpmc;
+    }
+
+  ioctl (pcm->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl (pcm->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+#if defined (__x86_64__)
+  if (can_rdpmc)
+    pcm->read = vlib_perf_counter_read_rdpmc;
+  else
+#endif
+    pcm->read = vlib_perf_counter_read_syscall;
+
+  return 0;
+}
+
+clib_error_t *
+vlib_perf_counters_enable_disable (vlib_main_t * vm, int enable)
+{
+  clib_error_t *error = 0;
+  vlib_main_t *this_vm;
+  int i;
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vm = vlib_mains[i];
+      if (this_vm == 0)
+	continue;
+
+      /* Counters are attached to, and read by, the thread itself */
+      vlib_perf_counters_close (this_vm);
+      if (enable)
+	{
+	  error = vlib_perf_counters_open (this_vm,
+					   vlib_worker_threads[i].lwp);
+	  if (error)
+	    break;
+	  vec_validate (this_vm->perf_counter_main.by_node,
+			vec_len (this_vm->node_main.nodes) - 1);
+	}
+    }
+
+  /* All or nothing */
+  if (error)
+    for (i = 0; i < vec_len (vlib_mains); i++)
+      if (vlib_mains[i])
+	vlib_perf_counters_close (vlib_mains[i]);
+
+  vlib_worker_thread_barrier_release (vm);
+
+  return error;
+}
+
+static u8 *
+format_vlib_node_perf_counters (u8 * s, va_list * va)
+{
+  vlib_node_t *n = va_arg (*va, vlib_node_t *);
+  vlib_node_perf_counters_t *pc = va_arg (*va, vlib_node_perf_counters_t *);
+  f64 v;
+
+  if (!n)
+    return format (s, "%=30s%=12s%=12s%=10s%=8s%=12s%=12s%=12s%=12s",
+		   "Name", "Calls", "Vectors", "Clk/Pkt", "IPC",
+		   "Inst/Pkt", "Cache/Pkt", "Branch/Pkt", "dTLB/Pkt");
+
+  v = pc->vectors ? (f64) pc->vectors : 1.0;
+
+  return format (s, "%-30v%12Lu%12Lu%10.2e%8.2f%12.2f%12.3f%12.3f%12.3f",
+		 n->name, pc->calls, pc->vectors,
+		 (f64) pc->clocks / v,
+		 pc->clocks ?
+		 (f64) pc->counters[VLIB_PERF_COUNTER_INSTRUCTIONS] /
+		 (f64) pc->clocks : 0.0,
+		 (f64) pc->counters[VLIB_PERF_COUNTER_INSTRUCTIONS] / v,
+		 (f64) pc->counters[VLIB_PERF_COUNTER_CACHE_MISSES] / v,
+		 (f64) pc->counters[VLIB_PERF_COUNTER_BRANCH_MISSES] / v,
+		 (f64) pc->counters[VLIB_PERF_COUNTER_DTLB_MISSES] / v);
+}
+
+static clib_error_t *
+set_node_perf_counters (vlib_main_t * vm,
+			unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  int enable = -1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "on") || unformat (input, "enable"))
+	enable = 1;
+      else if (unformat (input, "off") || unformat (input, "disable"))
+	enable = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (enable == -1)
+    return clib_error_return (0, "specify on or off");
+
+  return vlib_perf_counters_enable_disable (vm, enable);
+}
+
+/*?
+ * Enable or disable per-node hardware performance counters. While
+ * enabled, every thread reads instruction, cache miss, branch miss and
+ * dTLB miss counters around each node dispatch. Results are shown with
+ * '<em>show runtime perf-counters</em>'. Sampling adds overhead to every
+ * dispatch, so leave it off in production.
+ *
+ * @cliexpar
+ * @cliexcmd{set runtime perf-counters on}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_node_perf_counters_command, static) = {
+  .path = "set runtime perf-counters",
+  .short_help = "set runtime perf-counters <on|off>",
+  .function = set_node_perf_counters,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_node_perf_counters (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_node_perf_counters_t **pcs = 0, *pc;
+  vlib_main_t **stat_vms = 0, *stat_vm;
+  vlib_node_t *n;
+  int i, j;
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      stat_vm = vlib_mains[i];
+      if (stat_vm)
+	vec_add1 (stat_vms, stat_vm);
+    }
+
+  /* Snapshot under the barrier, format outside of it */
+  vlib_worker_thread_barrier_sync (vm);
+  for (j = 0; j < vec_len (stat_vms); j++)
+    vec_add1 (pcs, vec_dup (stat_vms[j]->perf_counter_main.by_node));
+  vlib_worker_thread_barrier_release (vm);
+
+  if (vm->perf_counter_main.read == 0)
+    vlib_cli_output (vm, "perf counters are disabled, "
+		     "use 'set runtime perf-counters on'");
+
+  for (j = 0; j < vec_len (stat_vms); j++)
+    {
+      stat_vm = stat_vms[j];
+
+      if (vec_len (stat_vms) > 1)
+	{
+	  vlib_worker_thread_t *w = vlib_worker_threads + j;
+	  if (j > 0)
+	    vlib_cli_output (vm, "---------------");
+	  vlib_cli_output (vm, "Thread %d %s", j, w->name);
+	}
+
+      vlib_cli_output (vm, "%U", format_vlib_node_perf_counters, 0, 0);
+      vec_foreach (pc, pcs[j])
+      {
+	if (pc->calls == 0)
+	  continue;
+	n = vlib_get_node (stat_vm, pc - pcs[j]);
+	vlib_cli_output (vm, "%U", format_vlib_node_perf_counters, n, pc);
+      }
+      vec_free (pcs[j]);
+    }
+
+  vec_free (pcs);
+  vec_free (stat_vms);
+  return 0;
+}
+
+/*?
+ * Show per-node hardware performance counters, per thread: clocks per
+ * packet, instructions per clock, and instructions, cache misses, branch
+ * misses and dTLB load misses per packet.
+ *
+ * @cliexpar
+ * @cliexcmd{show runtime perf-counters}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_node_perf_counters_command, static) = {
+  .path = "show runtime perf-counters",
+  .short_help = "show runtime perf-counters",
+  .function = show_node_perf_counters,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
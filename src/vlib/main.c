@@ -910,6 +910,34 @@ add_trajectory_trace (vlib_buffer_t * b, u32 node_index)
 #endif
 }
 
+static never_inline void
+dispatch_node_perf_counters_update (vlib_main_t * vm, u32 node_index,
+				    u64 * before, uword n_vectors,
+				    u64 n_clocks)
+{
+  vlib_perf_counter_main_t *pcm = &vm->perf_counter_main;
+  vlib_node_perf_counters_t *pc;
+  u64 after[VLIB_N_PERF_COUNTERS];
+  int i;
+
+  /* Sampling may have been turned off during the dispatch */
+  if (PREDICT_FALSE (pcm->read == 0))
+    return;
+
+  pcm->read (vm, after);
+
+  /* Sized when sampling is enabled; don't grow it from a worker heap */
+  if (PREDICT_FALSE (node_index >= vec_len (pcm->by_node)))
+    return;
+
+  pc = vec_elt_at_index (pcm->by_node, node_index);
+  pc->calls += 1;
+  pc->vectors += n_vectors;
+  pc->clocks += n_clocks;
+  for (i = 0; i < VLIB_N_PERF_COUNTERS; i++)
+    pc->counters[i] += after[i] - before[i];
+}
+
 static_always_inline u64
 dispatch_node (vlib_main_t * vm,
 	       vlib_node_runtime_t * node,
@@ -959,6 +987,8 @@ dispatch_node (vlib_main_t * vm,
   if (1 /* || vm->thread_index == node->thread_index */ )
     {
       vlib_main_t *stat_vm;
+      vlib_perf_counter_read_function_t *perf_counter_read;
+      u64 perf_counters_before[VLIB_N_PERF_COUNTERS];
 
       stat_vm = /* vlib_mains ? vlib_mains[0] : */ vm;
 
@@ -972,6 +1002,14 @@ dispatch_node (vlib_main_t * vm,
        * "bad monkey" contexts, and you want to know exactly
        * which nodes they've visited... See ixge.c...
        */
+      perf_counter_read = vm->perf_counter_main.read;
+      if (PREDICT_FALSE (perf_counter_read != 0))
+	perf_counter_read (vm, perf_counters_before);
+
+      if (PREDICT_FALSE (vm->latency_trace_main.enabled != 0) && frame)
+	vlib_latency_trace_frame (vm, node->node_index, frame,
+				  last_time_stamp);
+
       if (VLIB_BUFFER_TRACE_TRAJECTORY && frame)
 	{
 	  int i;
@@ -989,6 +1027,11 @@ dispatch_node (vlib_main_t * vm,
 
       t = clib_cpu_time_now ();
 
+      if (PREDICT_FALSE (perf_counter_read != 0))
+	dispatch_node_perf_counters_update (vm, node->node_index,
+					    perf_counters_before, n,
+					    t - last_time_stamp);
+
       vlib_elog_main_loop_event (vm, node->node_index, t, n,	/* is_after */
 				 1);
 
@@ -1430,13 +1473,86 @@ vl_api_send_pending_rpc_requests (vlib_main_t * vm)
 }
 
 
+static never_inline int
+dispatch_pending_batch_defer (vlib_main_t * vm, u64 cpu_time_now)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_pending_frame_t *p;
+  u32 n_vectors = 0;
+  u64 delay = 0;
+  uword bin;
+
+  vec_foreach (p, nm->pending_frames)
+    n_vectors += vlib_get_frame (vm, p->frame_index)->n_vectors;
+
+  if (nm->batch_first_deferred_time)
+    delay = cpu_time_now - nm->batch_first_deferred_time;
+
+  /* Keep accumulating unless we have enough vectors, the oldest
+     deferred vector is out of budget, or the main thread wants
+     the barrier. */
+  if (n_vectors < nm->batch_min_vectors
+      && delay < nm->batch_max_delay_clocks
+      && !*vlib_worker_threads->wait_at_barrier)
+    {
+      if (nm->batch_first_deferred_time == 0)
+	nm->batch_first_deferred_time = cpu_time_now;
+      nm->batch_n_deferrals += 1;
+      return 1;
+    }
+
+  nm->batch_first_deferred_time = 0;
+  nm->batch_n_dispatches += 1;
+  nm->batch_n_vectors += n_vectors;
+  nm->batch_delay_clocks += delay;
+  nm->batch_max_delay_clocks_seen =
+    clib_max (nm->batch_max_delay_clocks_seen, delay);
+  bin = min_log2 (clib_max (n_vectors, 1));
+  bin = clib_min (bin, VLIB_BATCH_N_HISTOGRAM_BINS - 1);
+  nm->batch_vectors_histogram[bin] += 1;
+
+  return 0;
+}
+
+/* Returns non-zero when dispatch of pending frames should wait for
+   more vectors to accumulate. */
+static_always_inline int
+dispatch_pending_should_defer (vlib_main_t * vm, int is_main,
+			       u64 cpu_time_now)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+
+  if (PREDICT_TRUE (nm->batch_min_vectors == 0) || is_main
+      || _vec_len (nm->pending_frames) == 0)
+    return 0;
+
+  return dispatch_pending_batch_defer (vm, cpu_time_now);
+}
+
+static_always_inline u64
+dispatch_pending_frames (vlib_main_t * vm, u64 cpu_time_now,
+			 u64 ingress_time)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  uword i;
+
+  if (PREDICT_FALSE (vm->latency_trace_main.enabled != 0))
+    vlib_latency_trace_sample_pending (vm, ingress_time);
+
+  for (i = 0; i < _vec_len (nm->pending_frames); i++)
+    cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+  /* Reset pending vector for next iteration. */
+  _vec_len (nm->pending_frames) = 0;
+
+  return cpu_time_now;
+}
+
 static_always_inline void
 vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 {
   vlib_node_main_t *nm = &vm->node_main;
   vlib_thread_main_t *tm = vlib_get_thread_main ();
-  uword i;
-  u64 cpu_time_now;
+  u64 cpu_time_now, ingress_time = 0;
   vlib_frame_queue_main_t *fqm;
   u32 *last_node_runtime_indices = 0;
 
@@ -1487,11 +1603,23 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 
       if (!is_main)
 	{
+	  /* Don't hold deferred frames across the barrier */
+	  if (PREDICT_FALSE (_vec_len (nm->pending_frames) > 0
+			     && *vlib_worker_threads->wait_at_barrier))
+	    {
+	      nm->batch_first_deferred_time = 0;
+	      cpu_time_now = dispatch_pending_frames (vm, cpu_time_now,
+						      ingress_time);
+	    }
 	  vlib_worker_thread_barrier_check ();
 	  vec_foreach (fqm, tm->frame_queue_mains)
 	    vlib_frame_queue_dequeue (vm, fqm);
 	}
 
+      /* Frames held back by adaptive batching keep their ingress time */
+      if (_vec_len (nm->pending_frames) == 0)
+	ingress_time = cpu_time_now;
+
       /* Process pre-input nodes. */
       if (is_main)
 	vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_PRE_INPUT])
@@ -1610,11 +1738,13 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 
       /* Input nodes may have added work to the pending vector.
          Process pending vector until there is nothing left.
-         All pending vectors will be processed from input -> output. */
-      for (i = 0; i < _vec_len (nm->pending_frames); i++)
-	cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
-      /* Reset pending vector for next iteration. */
-      _vec_len (nm->pending_frames) = 0;
+         All pending vectors will be processed from input -> output.
+         With adaptive batching small vectors may be held back for a
+         few main loops so that input nodes can add to them. */
+      if (PREDICT_TRUE (!dispatch_pending_should_defer (vm, is_main,
+							cpu_time_now)))
+	cpu_time_now = dispatch_pending_frames (vm, cpu_time_now,
+						ingress_time);
 
       /* Pending internal nodes may resume processes. */
       if (is_main && _vec_len (nm->data_from_advancing_timing_wheel) > 0)
@@ -154,6 +154,12 @@ typedef struct vlib_main_t
   /* Event logger. */
   elog_main_t elog_main;
 
+  /* Per-node hardware performance counters. */
+  vlib_perf_counter_main_t perf_counter_main;
+
+  /* Sampled per-packet latency trace. */
+  vlib_latency_trace_main_t latency_trace_main;
+
   /* Node call and return event types. */
   elog_event_type_t *node_call_elog_event_types;
   elog_event_type_t *node_return_elog_event_types;
@@ -701,6 +701,26 @@ typedef struct
   /* Time of last node runtime stats clear. */
   f64 time_last_runtime_stats_clear;
 
+  /* Adaptive dispatch batching (worker threads only). Dispatch of
+     pending frames is deferred while fewer than batch_min_vectors
+     vectors are pending and the oldest deferred vector has waited
+     less than batch_max_delay_clocks. Zero batch_min_vectors disables. */
+  u32 batch_min_vectors;
+  u64 batch_max_delay_clocks;
+
+  /* CPU time of first deferral, zero when nothing is deferred. */
+  u64 batch_first_deferred_time;
+
+  /* Adaptive dispatch batching statistics. */
+  u64 batch_n_dispatches;
+  u64 batch_n_vectors;
+  u64 batch_n_deferrals;
+  u64 batch_delay_clocks;
+  u64 batch_max_delay_clocks_seen;
+  /* Dispatches by log2 of pending vectors: 1, 2-3, 4-7, ... 256+ */
+#define VLIB_BATCH_N_HISTOGRAM_BINS 9
+  u64 batch_vectors_histogram[VLIB_BATCH_N_HISTOGRAM_BINS];
+
   /* Node registrations added by constructors */
   vlib_node_registration_t *node_registrations;
 } vlib_node_main_t;
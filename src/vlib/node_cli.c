@@ -422,6 +422,12 @@ clear_node_runtime (vlib_main_t * vm,
 	  r = vlib_node_get_runtime (stat_vm, n->index);
 	  r->max_clock = 0;
 	}
+      vec_zero (stat_vm->perf_counter_main.by_node);
+      nm->batch_n_dispatches = nm->batch_n_vectors = 0;
+      nm->batch_n_deferrals = nm->batch_delay_clocks = 0;
+      nm->batch_max_delay_clocks_seen = 0;
+      memset (nm->batch_vectors_histogram, 0,
+	      sizeof (nm->batch_vectors_histogram));
       /* Note: input/output rates computed using vlib_global_main */
       nm->time_last_runtime_stats_clear = vlib_time_now (vm);
     }
@@ -441,6 +447,140 @@ VLIB_CLI_COMMAND (clear_node_runtime_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_dispatch_batching (vlib_main_t * vm,
+		       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  u32 min_vectors = 0, max_delay_us = 50;
+  u64 max_delay_clocks;
+  vlib_main_t *this_vm;
+  int i;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "min-vectors %u", &min_vectors))
+	;
+      else if (unformat (input, "max-delay %u", &max_delay_us))
+	;
+      else if (unformat (input, "off") || unformat (input, "disable"))
+	min_vectors = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (min_vectors > VLIB_FRAME_SIZE)
+    return clib_error_return (0, "min-vectors must be <= %d",
+			      VLIB_FRAME_SIZE);
+
+  max_delay_clocks = (u64) (max_delay_us * 1e-6 *
+			    vm->clib_time.clocks_per_second);
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vm = vlib_mains[i];
+      if (this_vm == 0)
+	continue;
+      this_vm->node_main.batch_min_vectors = min_vectors;
+      this_vm->node_main.batch_max_delay_clocks = max_delay_clocks;
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+/*?
+ * Configure adaptive dispatch batching on worker threads. When the
+ * vectors produced by input nodes in one main loop add up to fewer than
+ * '<em>min-vectors</em>', their dispatch is deferred to a later main
+ * loop so that more packets can join the same frames. Deferral stops
+ * as soon as enough vectors are pending or the oldest deferred vector
+ * has waited '<em>max-delay</em>' microseconds (default 50). The main
+ * thread is never deferred.
+ *
+ * @cliexpar
+ * @cliexcmd{set dispatch-batching min-vectors 32 max-delay 20}
+ * @cliexcmd{set dispatch-batching off}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_dispatch_batching_command, static) = {
+  .path = "set dispatch-batching",
+  .short_help = "set dispatch-batching [min-vectors <n>] [max-delay <usec>] "
+                "| off",
+  .function = set_dispatch_batching,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_dispatch_batching (vlib_main_t * vm,
+			unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_node_main_t *nm;
+  vlib_main_t *this_vm;
+  f64 us_per_clock = 1e6 / vm->clib_time.clocks_per_second;
+  u8 *s = 0;
+  int i, b;
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      this_vm = vlib_mains[i];
+      if (this_vm == 0)
+	continue;
+      nm = &this_vm->node_main;
+
+      vlib_cli_output (vm, "Thread %d %s: %s", i, vlib_worker_threads[i].name,
+		       i == 0 ? "not batched" :
+		       nm->batch_min_vectors ? "enabled" : "disabled");
+      if (i == 0)
+	continue;
+
+      vlib_cli_output (vm, "  min-vectors %u, max-delay %.1fus",
+		       nm->batch_min_vectors,
+		       nm->batch_max_delay_clocks * us_per_clock);
+      vlib_cli_output (vm, "  dispatches %Lu, deferrals %Lu, "
+		       "average vectors/dispatch %.2f",
+		       nm->batch_n_dispatches, nm->batch_n_deferrals,
+		       nm->batch_n_dispatches ?
+		       (f64) nm->batch_n_vectors / nm->batch_n_dispatches :
+		       0.0);
+      vlib_cli_output (vm, "  added latency: average %.2fus, max %.2fus",
+		       nm->batch_n_dispatches ?
+		       nm->batch_delay_clocks * us_per_clock /
+		       nm->batch_n_dispatches : 0.0,
+		       nm->batch_max_delay_clocks_seen * us_per_clock);
+
+      vec_reset_length (s);
+      for (b = 0; b < VLIB_BATCH_N_HISTOGRAM_BINS; b++)
+	s = format (s, " %d%s: %Lu", 1 << b,
+		    b == VLIB_BATCH_N_HISTOGRAM_BINS - 1 ? "+" : "",
+		    nm->batch_vectors_histogram[b]);
+      vlib_cli_output (vm, "  vectors/dispatch histogram:%v", s);
+    }
+
+  vec_free (s);
+  return 0;
+}
+
+/*?
+ * Show adaptive dispatch batching configuration and per-thread
+ * statistics: achieved vectors per dispatch, a log2 histogram of
+ * vectors per dispatch and the latency added by deferral.
+ *
+ * @cliexpar
+ * @cliexcmd{show dispatch-batching}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_dispatch_batching_command, static) = {
+  .path = "show dispatch-batching",
+  .short_help = "show dispatch-batching",
+  .function = show_dispatch_batching,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
 /* Dummy function to get us linked in. */
 void
 vlib_node_cli_reference (void)
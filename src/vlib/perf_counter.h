@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * perf_counter.h: per-node hardware performance counters
+ */
+
+#ifndef included_vlib_perf_counter_h
+#define included_vlib_perf_counter_h
+
+/** \file
+    Optional per-node hardware performance counter sampling. When
+    enabled, each thread reads a group of counters before and after
+    every node dispatch and accumulates the deltas per node.
+*/
+
+/* Counter enum, short name, description */
+#define foreach_vlib_perf_counter				\
+  _(INSTRUCTIONS, instructions, "instructions")			\
+  _(CACHE_MISSES, cache_misses, "cache misses")			\
+  _(BRANCH_MISSES, branch_misses, "branch misses")		\
+  _(DTLB_MISSES, dtlb_misses, "dTLB load misses")
+
+typedef enum
+{
+#define _(f,n,s) VLIB_PERF_COUNTER_##f,
+  foreach_vlib_perf_counter
+#undef _
+    VLIB_N_PERF_COUNTERS,
+} vlib_perf_counter_t;
+
+/* Per-node totals, one set per thread */
+typedef struct
+{
+  u64 calls;
+  u64 vectors;
+  u64 clocks;
+  u64 counters[VLIB_N_PERF_COUNTERS];
+} vlib_node_perf_counters_t;
+
+struct vlib_main_t;
+
+typedef void (vlib_perf_counter_read_function_t) (struct vlib_main_t * vm,
+						  u64 * counters);
+
+typedef struct
+{
+  /* Counter read function, NULL when sampling is disabled */
+  vlib_perf_counter_read_function_t *read;
+
+  /* perf_event_open file descriptors, first one is the group leader */
+  int fds[VLIB_N_PERF_COUNTERS];
+
+  /* Self-monitoring (rdpmc) pages, one per counter */
+  void *mmap_pages[VLIB_N_PERF_COUNTERS];
+
+  /* Totals indexed by node index */
+  vlib_node_perf_counters_t *by_node;
+} vlib_perf_counter_main_t;
+
+clib_error_t *vlib_perf_counters_enable_disable (struct vlib_main_t * vm,
+						 int enable);
+
+#endif /* included_vlib_perf_counter_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
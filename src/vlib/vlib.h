@@ -56,8 +56,10 @@ struct vlib_main_t;
 #include <vlib/counter.h>
 #include <vlib/error.h>
 #include <vlib/init.h>
+#include <vlib/latency_trace.h>
 #include <vlib/mc.h>
 #include <vlib/node.h>
+#include <vlib/perf_counter.h>
 #include <vlib/trace.h>
 
 /* Main include depends on other vlib/ includes so we put it last. */
@@ -210,14 +210,13 @@ bier_lookup (vlib_main_t * vm,
              * Create the number of clones we need based on the number
              * of fmasks we are sending to.
              */
-            u8 num_cloned, clone;
+            u16 num_cloned, clone;
             u32 n_clones;
 
             n_clones = vec_len(blm->blm_fmasks[thread_index]);
 
             if (PREDICT_TRUE(0 != n_clones))
             {
-                ASSERT(n_clones < 256);
                 num_cloned = vlib_buffer_clone(vm, bi0,
                                                blm->blm_clones[thread_index],
                                                n_clones, 128);
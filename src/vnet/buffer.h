@@ -61,7 +61,8 @@
   _(13, IS_NATED, "nated")				\
   _(14, L2_HDR_OFFSET_VALID, 0)				\
   _(15, L3_HDR_OFFSET_VALID, 0)				\
-  _(16, L4_HDR_OFFSET_VALID, 0)
+  _(16, L4_HDR_OFFSET_VALID, 0)				\
+  _(17, FLOW_HASH_VALID, "flow-hash-valid")
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -365,6 +366,16 @@ STATIC_ASSERT (sizeof (vnet_buffer_opaque_t) <=
 /* Full cache line (64 bytes) of additional space */
 typedef struct
 {
+  /**
+   * Flow hash cached by the first node that computed it, or taken from
+   * the NIC's RSS hash on input. Valid only if VNET_BUFFER_F_FLOW_HASH_VALID
+   * is set and the packet is still on the RX interface it was computed on;
+   * a decap into a tunnel interface changes the flow and so invalidates it.
+   * Lives in opaque2 so that it survives the rewrite of the opaque union.
+   */
+  u32 flow_hash;
+  u32 flow_hash_sw_if_index;
+
   union
   {
 #if VLIB_BUFFER_TRACE_TRAJECTORY > 0
@@ -374,12 +385,53 @@ typedef struct
       u16 *trajectory_trace;
     };
 #endif
-    u32 unused[12];
+    u32 unused[10];
   };
 } vnet_buffer_opaque2_t;
 
 #define vnet_buffer2(b) ((vnet_buffer_opaque2_t *) (b)->opaque2)
 
+/**
+ * @brief Retrieve the flow hash cached in the buffer, if it is valid.
+ * Each retrieval rotates the cached value so that successive load-balance
+ * stages that re-use it do not select on the same bits and polarise.
+ */
+always_inline int
+vnet_buffer_flow_hash_get (vlib_buffer_t * b, u32 * hash)
+{
+  vnet_buffer_opaque2_t *o2;
+
+  if (!(b->flags & VNET_BUFFER_F_FLOW_HASH_VALID))
+    return (0);
+
+  o2 = vnet_buffer2 (b);
+
+  if (PREDICT_FALSE (o2->flow_hash_sw_if_index !=
+		     vnet_buffer (b)->sw_if_index[VLIB_RX]))
+    {
+      b->flags &= ~VNET_BUFFER_F_FLOW_HASH_VALID;
+      return (0);
+    }
+
+  *hash = o2->flow_hash;
+  o2->flow_hash = (*hash >> 1) | (*hash << 31);
+
+  return (1);
+}
+
+/**
+ * @brief Cache a flow hash in the buffer for later stages to re-use.
+ */
+always_inline void
+vnet_buffer_flow_hash_set (vlib_buffer_t * b, u32 hash)
+{
+  vnet_buffer_opaque2_t *o2 = vnet_buffer2 (b);
+
+  o2->flow_hash = hash;
+  o2->flow_hash_sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_RX];
+  b->flags |= VNET_BUFFER_F_FLOW_HASH_VALID;
+}
+
 /*
  * The opaque2 field of the vlib_buffer_t is intepreted as a
  * vnet_buffer_opaque2_t. Hence it should be big enough to accommodate one.
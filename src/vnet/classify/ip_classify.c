@@ -64,9 +64,10 @@ ip_classify_inline (vlib_main_t * vm,
 		    vlib_node_runtime_t * node,
 		    vlib_frame_t * frame, int is_ip4)
 {
-  u32 n_left_from, *from, *to_next;
-  ip_lookup_next_t next_index;
+  u32 n_left_from, *from;
   vnet_classify_main_t *vcm = &vnet_classify_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
   f64 now = vlib_time_now (vm);
   u32 hits = 0;
   u32 misses = 0;
@@ -84,13 +85,14 @@ ip_classify_inline (vlib_main_t * vm,
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+  b = bufs;
 
   /* First pass: compute hashes */
 
   while (n_left_from > 2)
     {
       vlib_buffer_t *b0, *b1;
-      u32 bi0, bi1;
       u8 *h0, *h1;
       u32 cd_index0, cd_index1;
       classify_dpo_t *cd0, *cd1;
@@ -101,8 +103,8 @@ ip_classify_inline (vlib_main_t * vm,
       {
 	vlib_buffer_t *p1, *p2;
 
-	p1 = vlib_get_buffer (vm, from[1]);
-	p2 = vlib_get_buffer (vm, from[2]);
+	p1 = b[1];
+	p2 = b[2];
 
 	vlib_prefetch_buffer_header (p1, STORE);
 	CLIB_PREFETCH (p1->data, CLIB_CACHE_LINE_BYTES, STORE);
@@ -110,13 +112,11 @@ ip_classify_inline (vlib_main_t * vm,
 	CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, STORE);
       }
 
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
+      b0 = b[0];
       h0 = (void *) vlib_buffer_get_current (b0) -
 	ethernet_buffer_header_size (b0);
 
-      bi1 = from[1];
-      b1 = vlib_get_buffer (vm, bi1);
+      b1 = b[1];
       h1 = (void *) vlib_buffer_get_current (b1) -
 	ethernet_buffer_header_size (b1);
 
@@ -133,12 +133,12 @@ ip_classify_inline (vlib_main_t * vm,
       t1 = pool_elt_at_index (vcm->tables, table_index1);
 
       vnet_buffer (b0)->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
+	vnet_classify_hash_packet_inline (t0, (u8 *) h0);
 
       vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
 
       vnet_buffer (b1)->l2_classify.hash =
-	vnet_classify_hash_packet (t1, (u8 *) h1);
+	vnet_classify_hash_packet_inline (t1, (u8 *) h1);
 
       vnet_classify_prefetch_bucket (t1, vnet_buffer (b1)->l2_classify.hash);
 
@@ -146,22 +146,20 @@ ip_classify_inline (vlib_main_t * vm,
 
       vnet_buffer (b1)->l2_classify.table_index = table_index1;
 
-      from += 2;
+      b += 2;
       n_left_from -= 2;
     }
 
   while (n_left_from > 0)
     {
       vlib_buffer_t *b0;
-      u32 bi0;
       u8 *h0;
       u32 cd_index0;
       classify_dpo_t *cd0;
       u32 table_index0;
       vnet_classify_table_t *t0;
 
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
+      b0 = b[0];
       h0 = (void *) vlib_buffer_get_current (b0) -
 	ethernet_buffer_header_size (b0);
 
@@ -171,76 +169,81 @@ ip_classify_inline (vlib_main_t * vm,
 
       t0 = pool_elt_at_index (vcm->tables, table_index0);
       vnet_buffer (b0)->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
+	vnet_classify_hash_packet_inline (t0, (u8 *) h0);
 
       vnet_buffer (b0)->l2_classify.table_index = table_index0;
       vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
 
-      from++;
+      b += 1;
       n_left_from--;
     }
 
-  next_index = node->cached_next_index;
-  from = vlib_frame_vector_args (frame);
+  /*
+   * Second pass: prefetch the entries of the whole frame, so the
+   * bucket loads issued above have had the frame's worth of time to
+   * land before any of them is dereferenced.
+   */
+  b = bufs;
   n_left_from = frame->n_vectors;
 
   while (n_left_from > 0)
     {
-      u32 n_left_to_next;
+      vnet_classify_table_t *t0;
+      u32 table_index0;
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      table_index0 = vnet_buffer (b[0])->l2_classify.table_index;
 
-      /* Not enough load/store slots to dual loop... */
-      while (n_left_from > 0 && n_left_to_next > 0)
+      if (PREDICT_TRUE (table_index0 != ~0))
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0 = IP_LOOKUP_NEXT_DROP;
-	  u32 table_index0;
-	  vnet_classify_table_t *t0;
-	  vnet_classify_entry_t *e0;
-	  u64 hash0;
-	  u8 *h0;
-
-	  /* Stride 3 seems to work best */
-	  if (PREDICT_TRUE (n_left_from > 3))
-	    {
-	      vlib_buffer_t *p1 = vlib_get_buffer (vm, from[3]);
-	      vnet_classify_table_t *tp1;
-	      u32 table_index1;
-	      u64 phash1;
+	  t0 = pool_elt_at_index (vcm->tables, table_index0);
+	  vnet_classify_prefetch_entry (t0,
+					vnet_buffer (b[0])->l2_classify.hash);
+	}
 
-	      table_index1 = vnet_buffer (p1)->l2_classify.table_index;
+      b += 1;
+      n_left_from--;
+    }
 
-	      if (PREDICT_TRUE (table_index1 != ~0))
-		{
-		  tp1 = pool_elt_at_index (vcm->tables, table_index1);
-		  phash1 = vnet_buffer (p1)->l2_classify.hash;
-		  vnet_classify_prefetch_entry (tp1, phash1);
-		}
-	    }
+  /* Third pass: match, walking the table chain on a miss */
+  b = bufs;
+  next = nexts;
+  n_left_from = frame->n_vectors;
 
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  h0 = b0->data;
-	  table_index0 = vnet_buffer (b0)->l2_classify.table_index;
-	  e0 = 0;
-	  t0 = 0;
-	  vnet_buffer (b0)->l2_classify.opaque_index = ~0;
-
-	  if (PREDICT_TRUE (table_index0 != ~0))
-	    {
-	      hash0 = vnet_buffer (b0)->l2_classify.hash;
-	      t0 = pool_elt_at_index (vcm->tables, table_index0);
+  while (n_left_from > 0)
+    {
+      vlib_buffer_t *b0;
+      u32 next0 = IP_LOOKUP_NEXT_DROP;
+      u32 table_index0;
+      vnet_classify_table_t *t0;
+      vnet_classify_entry_t *e0;
+      u64 hash0;
+      u8 *h0;
+
+      b0 = b[0];
+      h0 = b0->data;
+      table_index0 = vnet_buffer (b0)->l2_classify.table_index;
+      e0 = 0;
+      t0 = 0;
+      vnet_buffer (b0)->l2_classify.opaque_index = ~0;
+
+      if (PREDICT_TRUE (table_index0 != ~0))
+	{
+	  hash0 = vnet_buffer (b0)->l2_classify.hash;
+	  t0 = pool_elt_at_index (vcm->tables, table_index0);
 
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+	  e0 = vnet_classify_find_entry_inline (t0, (u8 *) h0, hash0, now);
+	  if (e0)
+	    {
+	      vnet_buffer (b0)->l2_classify.opaque_index = e0->opaque_index;
+	      vlib_buffer_advance (b0, e0->advance);
+	      next0 = (e0->next_index < node->n_next_nodes) ?
+		e0->next_index : next0;
+	      hits++;
+	    }
+	  else
+	    {
+	      e0 = vnet_classify_find_entry_in_chain (vcm, &t0, (u8 *) h0,
+						      now);
 	      if (e0)
 		{
 		  vnet_buffer (b0)->l2_classify.opaque_index
@@ -249,59 +252,35 @@ ip_classify_inline (vlib_main_t * vm,
 		  next0 = (e0->next_index < node->n_next_nodes) ?
 		    e0->next_index : next0;
 		  hits++;
+		  chain_hits++;
 		}
 	      else
 		{
-		  while (1)
-		    {
-		      if (t0->next_table_index != ~0)
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 = vnet_classify_find_entry
-			(t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < node->n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
-		    }
+		  next0 = (t0->miss_next_index < n_next) ?
+		    t0->miss_next_index : next0;
+		  misses++;
 		}
 	    }
+	}
 
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
-			     && (b0->flags & VLIB_BUFFER_IS_TRACED)))
-	    {
-	      ip_classify_trace_t *t =
-		vlib_add_trace (vm, node, b0, sizeof (*t));
-	      t->next_index = next0;
-	      t->table_index = t0 ? t0 - vcm->tables : ~0;
-	      t->entry_index = e0 ? e0 - t0->entries : ~0;
-	    }
-
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  ip_classify_trace_t *t =
+	    vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->next_index = next0;
+	  t->table_index = t0 ? t0 - vcm->tables : ~0;
+	  t->entry_index = e0 ? e0 - t0->entries : ~0;
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      next[0] = next0;
+      b += 1;
+      next += 1;
+      n_left_from--;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   vlib_node_increment_counter (vm, node->node_index,
 			       IP_CLASSIFY_ERROR_MISS, misses);
   vlib_node_increment_counter (vm, node->node_index,
@@ -2642,6 +2642,189 @@ test_classify_churn (test_classify_main_t * tm)
   return 0;
 }
 
+/*
+ * Scalar reference for the hash and the masked match, a byte or a u64
+ * at a time, to check the wide loads of the inline versions against.
+ */
+static u64
+test_classify_ref_hash (vnet_classify_table_t * t, u8 * h)
+{
+  u8 *data = h + t->skip_n_vectors * sizeof (u32x4);
+  u8 *mask = (u8 *) t->mask;
+  u64 xor_sum = 0;
+  int i;
+
+  for (i = 0; i < t->match_n_vectors * 2; i++)
+    xor_sum ^= clib_mem_unaligned (data + 8 * i, u64)
+      & clib_mem_unaligned (mask + 8 * i, u64);
+
+  return clib_xxhash (xor_sum);
+}
+
+static int
+test_classify_ref_match (vnet_classify_table_t * t, u8 * h, u8 * key_h)
+{
+  u8 *data = h + t->skip_n_vectors * sizeof (u32x4);
+  u8 *key = key_h + t->skip_n_vectors * sizeof (u32x4);
+  u8 *mask = (u8 *) t->mask;
+  int i;
+
+  for (i = 0; i < t->match_n_vectors * sizeof (u32x4); i++)
+    if ((data[i] & mask[i]) != (key[i] & mask[i]))
+      return 0;
+  return 1;
+}
+
+#define TEST_CLASSIFY_MATCH_N_TABLES 5
+#define TEST_CLASSIFY_PACKET_BYTES 112
+
+static clib_error_t *
+test_classify_match (test_classify_main_t * tm)
+{
+  vnet_classify_main_t *cm = tm->classify_main;
+  vlib_main_t *vm = tm->vlib_main;
+  u32 table_indices[TEST_CLASSIFY_MATCH_N_TABLES];
+  u32 *added[TEST_CLASSIFY_MATCH_N_TABLES];
+  vnet_classify_table_t *t;
+  vnet_classify_entry_t *e;
+  u8 *mask = 0, *packets = 0, *h, *m;
+  u32 n_packets, n_hash_errors = 0, n_match_errors = 0, n_hits = 0;
+  u32 i, j, k, n, rk, ri, *ip;
+  int rv;
+
+  memset (added, 0, sizeof (added));
+  vec_validate_aligned (mask, TEST_CLASSIFY_MATCH_N_TABLES * sizeof (u32x4),
+			sizeof (u32x4));
+
+  /*
+   * A chain of tables matching 1 to 5 vectors, 16 to 80 bytes, on random
+   * masks, every other one skipping a vector. Bytes are taken from the
+   * top of random_u32 (), whose low byte repeats every 256 calls.
+   */
+  for (k = 0; k < TEST_CLASSIFY_MATCH_N_TABLES; k++)
+    {
+      for (i = 0; i < vec_len (mask); i++)
+	mask[i] = random_u32 (&tm->seed) >> 24;
+      t = vnet_classify_new_table (cm, mask, tm->buckets, 4 << 20,
+				   k & 1 /* skip */ , k + 1 /* match */ );
+      t->miss_next_index = IP_LOOKUP_NEXT_DROP;
+      table_indices[k] = t - cm->tables;
+    }
+  for (k = 0; k + 1 < TEST_CLASSIFY_MATCH_N_TABLES; k++)
+    {
+      t = pool_elt_at_index (cm->tables, table_indices[k]);
+      t->next_table_index = table_indices[k + 1];
+    }
+
+  /*
+   * Per table, random packets, every other one added as a session, and
+   * each added one again with a masked bit flipped. The packets start
+   * at an odd address, so no load is aligned.
+   */
+  n = clib_min (tm->sessions, 256);
+  n_packets = TEST_CLASSIFY_MATCH_N_TABLES * (n + (n + 1) / 2);
+  vec_validate (packets, n_packets * TEST_CLASSIFY_PACKET_BYTES);
+  for (i = 0; i < vec_len (packets); i++)
+    packets[i] = random_u32 (&tm->seed) >> 24;
+
+  h = packets + 1;
+  for (k = 0; k < TEST_CLASSIFY_MATCH_N_TABLES; k++)
+    {
+      t = pool_elt_at_index (cm->tables, table_indices[k]);
+      for (i = 0; i < n; i++, h += TEST_CLASSIFY_PACKET_BYTES)
+	{
+	  if (i & 1)
+	    continue;
+	  rv = vnet_classify_add_del_session (cm, table_indices[k], h,
+					      IP_LOOKUP_NEXT_DROP,
+					      (k << 16) | i /* opaque_index */ ,
+					      0 /* advance */ , 0, 0,
+					      1 /* is_add */ );
+	  if (rv != 0)
+	    clib_warning ("add: returned %d", rv);
+	  else
+	    vec_add1 (added[k], (h - packets - 1) / TEST_CLASSIFY_PACKET_BYTES);
+	}
+    }
+  for (k = 0; k < TEST_CLASSIFY_MATCH_N_TABLES; k++)
+    {
+      t = pool_elt_at_index (cm->tables, table_indices[k]);
+      m = (u8 *) t->mask;
+      vec_foreach (ip, added[k])
+      {
+	clib_memcpy (h, packets + 1 + ip[0] * TEST_CLASSIFY_PACKET_BYTES,
+		     TEST_CLASSIFY_PACKET_BYTES - 1);
+	do
+	  j = random_u32 (&tm->seed) % (t->match_n_vectors * sizeof (u32x4));
+	while (m[j] == 0);
+	h[t->skip_n_vectors * sizeof (u32x4) + j] ^= m[j] & -m[j];
+	h += TEST_CLASSIFY_PACKET_BYTES;
+      }
+    }
+
+  /* look each packet up the chain, as the classifier nodes do */
+  for (i = 0; i < n_packets; i++)
+    {
+      u64 hash;
+
+      h = packets + 1 + i * TEST_CLASSIFY_PACKET_BYTES;
+
+      for (k = 0; k < TEST_CLASSIFY_MATCH_N_TABLES; k++)
+	{
+	  t = pool_elt_at_index (cm->tables, table_indices[k]);
+	  if (vnet_classify_hash_packet (t, h) != test_classify_ref_hash (t, h))
+	    n_hash_errors++;
+	}
+
+      rk = ri = ~0;
+      for (k = 0; k < TEST_CLASSIFY_MATCH_N_TABLES && rk == ~0; k++)
+	{
+	  t = pool_elt_at_index (cm->tables, table_indices[k]);
+	  vec_foreach (ip, added[k])
+	  {
+	    if (test_classify_ref_match
+		(t, h, packets + 1 + ip[0] * TEST_CLASSIFY_PACKET_BYTES))
+	      {
+		rk = k;
+		ri = ip[0] - k * n;
+		break;
+	      }
+	  }
+	}
+
+      t = pool_elt_at_index (cm->tables, table_indices[0]);
+      hash = vnet_classify_hash_packet (t, h);
+      e = vnet_classify_find_entry (t, h, hash, 0 /* time_now */ );
+      if (e == 0)
+	e = vnet_classify_find_entry_in_chain (cm, &t, h, 0 /* time_now */ );
+
+      if (e)
+	n_hits++;
+      if ((e == 0 && rk != ~0) || (e && e->opaque_index != ((rk << 16) | ri)))
+	{
+	  n_match_errors++;
+	  if (tm->verbose)
+	    vlib_cli_output (vm, "packet %d: found %d expected %d/%d", i,
+			     e ? e->opaque_index : ~0, rk, ri);
+	}
+    }
+
+  vlib_cli_output (vm, "%d packets through a chain of %d tables, %d hits: "
+		   "%d hash and %d match mismatches, MUST be zero",
+		   n_packets, TEST_CLASSIFY_MATCH_N_TABLES, n_hits,
+		   n_hash_errors, n_match_errors);
+
+  vnet_classify_delete_table_index (cm, table_indices[0], 1 /* del_chain */ );
+  for (k = 0; k < TEST_CLASSIFY_MATCH_N_TABLES; k++)
+    vec_free (added[k]);
+  vec_free (mask);
+  vec_free (packets);
+
+  if (n_hash_errors || n_match_errors)
+    return clib_error_return (0, "classify match test failed");
+  return 0;
+}
+
 static clib_error_t *
 test_classify_command_fn (vlib_main_t * vm,
 			  unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -2687,6 +2870,8 @@ test_classify_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (input, "churn-test"))
 	which = 0;
+      else if (unformat (input, "match-test"))
+	which = 1;
       else
 	break;
     }
@@ -2696,6 +2881,9 @@ test_classify_command_fn (vlib_main_t * vm,
     case 0:
       error = test_classify_churn (tm);
       break;
+    case 1:
+      error = test_classify_match (tm);
+      break;
     default:
       error = clib_error_return (0, "No such test");
       break;
@@ -2710,7 +2898,7 @@ VLIB_CLI_COMMAND (test_classify_command, static) = {
     .short_help =
     "test classify [src <ip>] [sessions <nn>] [buckets <nn>] [seed <nnn>]\n"
     "              [memory-size <nn>[M|G]]\n"
-    "              [churn-test]",
+    "              [churn-test | match-test]",
     .function = test_classify_command_fn,
 };
 /* *INDENT-ON* */
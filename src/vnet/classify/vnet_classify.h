@@ -232,6 +232,38 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 
   ASSERT (t);
   mask = t->mask;
+#ifdef CLIB_HAVE_VEC128
+  {
+    u8 *data = h + t->skip_n_vectors * sizeof (u32x4);
+    u64x4u *d4 = (u64x4u *) data, *m4 = (u64x4u *) mask;
+    u64x2u *d2 = (u64x2u *) data, *m2 = (u64x2u *) mask;
+    u64x4 x4 = { 0 };
+    u64x2 x2 = { 0 };
+
+    switch (t->match_n_vectors)
+      {
+      case 5:
+	x2 = d2[4] & m2[4];
+	/* FALLTHROUGH */
+      case 4:
+	x4 = (d4[0] & m4[0]) ^ (d4[1] & m4[1]);
+	break;
+      case 3:
+	x2 = d2[2] & m2[2];
+	/* FALLTHROUGH */
+      case 2:
+	x4 = d4[0] & m4[0];
+	break;
+      case 1:
+	x2 = d2[0] & m2[0];
+	break;
+      default:
+	abort ();
+      }
+    xor_sum.as_u64[0] = x4[0] ^ x4[2] ^ x2[0];
+    xor_sum.as_u64[1] = x4[1] ^ x4[3] ^ x2[1];
+  }
+#else
 #ifdef CLASSIFY_USE_SSE
   if (U32X4_ALIGNED (h))
     {				//SSE can't handle unaligned data
@@ -289,6 +321,7 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 	  abort ();
 	}
     }
+#endif /* CLIB_HAVE_VEC128 */
 
   return clib_xxhash (xor_sum.as_u64[0] ^ xor_sum.as_u64[1]);
 }
@@ -366,6 +399,49 @@ vnet_classify_prefetch_entry (vnet_classify_table_t * t, u64 hash)
   CLIB_PREFETCH (e, CLIB_CACHE_LINE_BYTES, LOAD);
 }
 
+#ifdef CLIB_HAVE_VEC128
+/*
+ * Masked compare of the packet data against an entry key, over all of
+ * the table's match vectors at once: the up to 80 bytes are taken as
+ * 32 byte chunks and a 16 byte tail, with no branch per vector and no
+ * alignment requirement on the data. In the AVX2 variants of the
+ * classifier nodes each 32 byte chunk is a single instruction.
+ */
+static inline int
+vnet_classify_key_match (vnet_classify_table_t * t, u8 * data, u32x4 * key)
+{
+  u64x4u *d4 = (u64x4u *) data, *m4 = (u64x4u *) t->mask;
+  u64x2u *d2 = (u64x2u *) data, *m2 = (u64x2u *) t->mask;
+  u64x4u *k4 = (u64x4u *) key;
+  u64x2u *k2 = (u64x2u *) key;
+  u64x4 r4 = { 0 };
+  u64x2 r2 = { 0 };
+
+  switch (t->match_n_vectors)
+    {
+    case 5:
+      r2 = (d2[4] & m2[4]) ^ k2[4];
+      /* FALLTHROUGH */
+    case 4:
+      r4 = ((d4[0] & m4[0]) ^ k4[0]) | ((d4[1] & m4[1]) ^ k4[1]);
+      break;
+    case 3:
+      r2 = (d2[2] & m2[2]) ^ k2[2];
+      /* FALLTHROUGH */
+    case 2:
+      r4 = (d4[0] & m4[0]) ^ k4[0];
+      break;
+    case 1:
+      r2 = (d2[0] & m2[0]) ^ k2[0];
+      break;
+    default:
+      abort ();
+    }
+
+  return ((r4[0] | r4[1] | r4[2] | r4[3] | r2[0] | r2[1]) == 0);
+}
+#endif /* CLIB_HAVE_VEC128 */
+
 vnet_classify_entry_t *vnet_classify_find_entry (vnet_classify_table_t * t,
 						 u8 * h, u64 hash, f64 now);
 
@@ -374,12 +450,14 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 				 u8 * h, u64 hash, f64 now)
 {
   vnet_classify_entry_t *v;
+#ifndef CLIB_HAVE_VEC128
   u32x4 *mask, *key;
   union
   {
     u32x4 as_u32x4;
     u64 as_u64[2];
   } result __attribute__ ((aligned (sizeof (u32x4))));
+#endif
   vnet_classify_bucket_t *b;
   u32 value_index;
   u32 bucket_index;
@@ -388,7 +466,9 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 
   bucket_index = hash & (t->nbuckets - 1);
   b = &t->buckets[bucket_index];
+#ifndef CLIB_HAVE_VEC128
   mask = t->mask;
+#endif
 
   if (b->offset == 0)
     return 0;
@@ -406,6 +486,24 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 
   v = vnet_classify_entry_at_index (t, v, value_index);
 
+#ifdef CLIB_HAVE_VEC128
+  {
+    u8 *data = h + t->skip_n_vectors * sizeof (u32x4);
+    for (i = 0; i < limit; i++)
+      {
+	if (vnet_classify_key_match (t, data, v->key))
+	  {
+	    if (PREDICT_TRUE (now))
+	      {
+		v->hits++;
+		v->last_heard = now;
+	      }
+	    return (v);
+	  }
+	v = vnet_classify_entry_at_index (t, v, 1);
+      }
+  }
+#else
 #ifdef CLASSIFY_USE_SSE
   if (U32X4_ALIGNED (h))
     {
@@ -508,6 +606,52 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 	  v = vnet_classify_entry_at_index (t, v, 1);
 	}
     }
+#endif /* CLIB_HAVE_VEC128 */
+  return 0;
+}
+
+/*
+ * Continue the lookup after a miss in table *tp down its chain of
+ * next tables. The packet is hashed for a batch of the following
+ * tables in one pass, with their buckets prefetched, before any of
+ * them is probed, so the bucket misses overlap. Returns the first
+ * matching entry with *tp set to its table, or 0 with *tp set to
+ * the last table of the chain.
+ */
+#define VNET_CLASSIFY_CHAIN_BATCH 8
+
+static inline vnet_classify_entry_t *
+vnet_classify_find_entry_in_chain (vnet_classify_main_t * cm,
+				   vnet_classify_table_t ** tp, u8 * h,
+				   f64 now)
+{
+  vnet_classify_table_t *tables[VNET_CLASSIFY_CHAIN_BATCH];
+  u64 hashes[VNET_CLASSIFY_CHAIN_BATCH];
+  vnet_classify_table_t *t = *tp;
+  vnet_classify_entry_t *e;
+  int i, n;
+
+  while (t->next_table_index != ~0)
+    {
+      for (n = 0; n < VNET_CLASSIFY_CHAIN_BATCH
+	   && t->next_table_index != ~0; n++)
+	{
+	  t = pool_elt_at_index (cm->tables, t->next_table_index);
+	  tables[n] = t;
+	  hashes[n] = vnet_classify_hash_packet_inline (t, h);
+	  vnet_classify_prefetch_bucket (t, hashes[n]);
+	}
+      for (i = 0; i < n; i++)
+	{
+	  e = vnet_classify_find_entry_inline (tables[i], h, hashes[i], now);
+	  if (e)
+	    {
+	      *tp = tables[i];
+	      return e;
+	    }
+	}
+    }
+  *tp = t;
   return 0;
 }
 
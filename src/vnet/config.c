@@ -352,6 +352,67 @@ vnet_config_del_feature (vlib_main_t * vm,
   return new->config_string_heap_index + 1;
 }
 
+/*
+ * Make a config that runs the first n_fused features of the given one in
+ * a single fused node, given its own config data, followed by the rest
+ * of its features. The caller holds a reference to the new config.
+ */
+u32
+vnet_config_fuse_features (vlib_main_t * vm,
+			   vnet_config_main_t * cm,
+			   u32 config_string_heap_index,
+			   u32 n_fused,
+			   u32 fused_node_index,
+			   void *fused_config, u32 n_fused_config_bytes)
+{
+  vnet_config_t *old, *new;
+  vnet_config_feature_t *new_features, *f;
+  u32 n_fused_config_u32s, i;
+
+  {
+    u32 *p = vnet_get_config_heap (cm, config_string_heap_index);
+
+    old = pool_elt_at_index (cm->config_pool, p[-1]);
+  }
+
+  ASSERT (n_fused <= vec_len (old->features));
+
+  new_features = duplicate_feature_vector (old->features);
+  for (i = 0; i < n_fused; i++)
+    vnet_config_feature_free (new_features + i);
+  vec_delete (new_features, n_fused, 0);
+
+  /* The fused node goes first, whatever the feature order */
+  vec_insert (new_features, 1, 0);
+  f = new_features;
+  f->feature_index = ~0;
+  f->node_index = fused_node_index;
+
+  n_fused_config_u32s =
+    round_pow2 (n_fused_config_bytes,
+		sizeof (f->feature_config[0])) /
+    sizeof (f->feature_config[0]);
+  vec_add (f->feature_config, fused_config, n_fused_config_u32s);
+
+  new = find_config_with_features (vm, cm, new_features);
+  new->reference_count += 1;
+
+  vec_validate (cm->config_pool_index_by_user_index,
+		new->config_string_heap_index + 1);
+  cm->config_pool_index_by_user_index[new->config_string_heap_index + 1]
+    = new - cm->config_pool;
+  return new->config_string_heap_index + 1;
+}
+
+/* Drop a reference taken by vnet_config_fuse_features */
+void
+vnet_config_release (vnet_config_main_t * cm, u32 config_string_heap_index)
+{
+  u32 *p = vnet_get_config_heap (cm, config_string_heap_index);
+
+  remove_reference (cm, pool_elt_at_index (cm->config_pool, p[-1]));
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
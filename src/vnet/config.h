@@ -161,6 +161,16 @@ u32 vnet_config_del_feature (vlib_main_t * vm,
 			     void *feature_config,
 			     u32 n_feature_config_bytes);
 
+/* Calls to fuse the leading features of a configuration into one node. */
+u32 vnet_config_fuse_features (vlib_main_t * vm,
+			       vnet_config_main_t * cm,
+			       u32 config_id,
+			       u32 n_fused,
+			       u32 fused_node_index,
+			       void *fused_config, u32 n_fused_config_bytes);
+
+void vnet_config_release (vnet_config_main_t * cm, u32 config_id);
+
 u8 *vnet_config_format_features (vlib_main_t * vm,
 				 vnet_config_main_t * cm,
 				 u32 config_index, u8 * s);
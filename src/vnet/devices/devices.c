@@ -18,6 +18,7 @@
 #include <vnet/feature/feature.h>
 #include <vnet/ip/ip.h>
 #include <vnet/ethernet/ethernet.h>
+#include <vnet/span/span.h>
 
 vnet_device_main_t vnet_device_main;
 
@@ -85,6 +86,8 @@ VNET_FEATURE_INIT (span_input, static) = {
   .arc_name = "device-input",
   .node_name = "span-input",
   .runs_before = VNET_FEATURES ("ethernet-input"),
+  .fused_function = span_input_fused,
+  .fused_flush_function = span_input_fused_flush,
 };
 
 VNET_FEATURE_INIT (p2p_ethernet_node, static) = {
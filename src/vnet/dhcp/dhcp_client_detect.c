@@ -314,12 +314,34 @@ VLIB_REGISTER_NODE (dhcp_client_detect_node) = {
 
 VLIB_NODE_FUNCTION_MULTIARCH (dhcp_client_detect_node,
                               dhcp_client_detect_node_fn);
+/* *INDENT-ON* */
+
+static u32
+dhcp_client_detect_fused (vlib_main_t * vm, vlib_buffer_t * b0,
+			  void *feature_config)
+{
+  ip4_header_t *ip0 = vlib_buffer_get_current (b0);
+  udp_header_t *udp0;
+
+  if (ip0->protocol != IP_PROTOCOL_UDP)
+    return VNET_FEATURE_FUSED_CONTINUE;
 
+  udp0 = (udp_header_t *) (ip0 + 1);
+  if (clib_net_to_host_u16 (UDP_DST_PORT_dhcp_to_client) != udp0->dst_port)
+    return VNET_FEATURE_FUSED_CONTINUE;
+
+  vlib_node_increment_counter (vm, dhcp_client_detect_node.index,
+			       DHCP_CLIENT_DETECT_ERROR_EXTRACT, 1);
+  return DHCP_CLIENT_DETECT_NEXT_EXTRACT;
+}
+
+/* *INDENT-OFF* */
 VNET_FEATURE_INIT (ip4_dvr_reinject_feat_node, static) =
 {
   .arc_name = "ip4-unicast",
   .node_name = "ip4-dhcp-client-detect",
   .runs_before = VNET_FEATURES ("ip4-drop"),
+  .fused_function = dhcp_client_detect_fused,
 };
 
 /* *INDENT-ON* */
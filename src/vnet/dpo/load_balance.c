@@ -482,6 +482,105 @@ load_balance_fill_buckets (load_balance_t *lb,
     }
 }
 
+/**
+ * @brief Resilient (consistent) hashing.
+ * Given the normalised next-hops, compute the next-hop for each bucket such
+ * that buckets currently forwarding via a next-hop that remains keep it.
+ * Only the buckets of removed next-hops, or those in excess of a next-hop's
+ * new share, are re-assigned. The bucket count never shrinks, and when it
+ * grows each new bucket inherits from the old bucket the flow hash would
+ * have selected, so flows stay put.
+ * Returns a vector of next-hops, one per-bucket with weight 1, suitable
+ * for load_balance_fill_buckets.
+ */
+static load_balance_path_t *
+load_balance_resilient_next_hops (load_balance_t *lb,
+                                  const load_balance_path_t *nhs,
+                                  u32 *n_buckets_in_out)
+{
+    load_balance_path_t *rnhs, *rnh;
+    u32 n_buckets, n_old, ii, jj;
+    u32 *quota, *owner;
+    const dpo_id_t *old;
+
+    quota = owner = NULL;
+    rnhs = NULL;
+    n_old = lb->lb_n_buckets;
+
+    /*
+     * all of these are powers of 2, so is the result.
+     */
+    n_buckets = clib_max(*n_buckets_in_out, LB_RESILIENT_MIN_BUCKETS);
+    n_buckets = clib_max(n_buckets, n_old);
+
+    /*
+     * the share of the buckets each next-hop gets. the normalised weights
+     * sum to the normalised number of buckets.
+     */
+    vec_validate(quota, vec_len(nhs) - 1);
+    vec_foreach_index(jj, nhs)
+    {
+        quota[jj] = nhs[jj].path_weight * (n_buckets / *n_buckets_in_out);
+    }
+
+    /*
+     * keep the existing assignments for next-hops that remain
+     */
+    vec_validate_init_empty(owner, n_buckets - 1, ~0);
+
+    if (0 != n_old)
+    {
+        old = load_balance_get_buckets(lb);
+
+        for (ii = 0; ii < n_buckets; ii++)
+        {
+            vec_foreach_index(jj, nhs)
+            {
+                if (!dpo_cmp(&old[ii & (n_old - 1)], &nhs[jj].path_dpo))
+                    break;
+            }
+            if (jj < vec_len(nhs) && 0 != quota[jj])
+            {
+                owner[ii] = jj;
+                quota[jj]--;
+            }
+        }
+    }
+
+    /*
+     * spread the orphaned buckets over the next-hops with share to spare
+     */
+    jj = 0;
+    for (ii = 0; ii < n_buckets; ii++)
+    {
+        if (~0 != owner[ii])
+            continue;
+
+        while (0 == quota[jj])
+            jj = (jj + 1) % vec_len(nhs);
+
+        owner[ii] = jj;
+        quota[jj]--;
+        jj = (jj + 1) % vec_len(nhs);
+    }
+
+    vec_validate(rnhs, n_buckets - 1);
+    for (ii = 0; ii < n_buckets; ii++)
+    {
+        rnh = &rnhs[ii];
+        rnh->path_index = nhs[owner[ii]].path_index;
+        rnh->path_weight = 1;
+        dpo_copy(&rnh->path_dpo, &nhs[owner[ii]].path_dpo);
+    }
+
+    vec_free(quota);
+    vec_free(owner);
+
+    *n_buckets_in_out = n_buckets;
+
+    return (rnhs);
+}
+
 static inline void
 load_balance_set_n_buckets (load_balance_t *lb,
                             u32 n_buckets)
@@ -516,6 +615,27 @@ load_balance_multipath_update (const dpo_id_t *dpo,
 
     ASSERT (n_buckets >= vec_len (raw_nhs));
 
+    if (flags & LOAD_BALANCE_FLAG_RESILIENT)
+    {
+        /*
+         * replace the normalised next-hops with the per-bucket choice.
+         * a map's buckets follow the normalised layout, so the two are
+         * mutually exclusive.
+         */
+        load_balance_path_t *rnhs;
+
+        ASSERT(!(flags & LOAD_BALANCE_FLAG_USES_MAP));
+
+        rnhs = load_balance_resilient_next_hops(lb, nhs, &n_buckets);
+
+        vec_foreach (nh, nhs)
+        {
+            dpo_reset(&nh->path_dpo);
+        }
+        vec_free(nhs);
+        nhs = rnhs;
+    }
+
     /*
      * Save the old load-balance map used, and get a new one if required.
      */
@@ -158,8 +158,15 @@ typedef enum load_balance_format_flags_t_ {
 typedef enum load_balance_flags_t_ {
     LOAD_BALANCE_FLAG_NONE = 0,
     LOAD_BALANCE_FLAG_USES_MAP = (1 << 0),
+    LOAD_BALANCE_FLAG_RESILIENT = (1 << 1),
 } load_balance_flags_t;
 
+/**
+ * The minimum number of buckets in a resilient load-balance. More buckets
+ * spread the flows of a removed path more evenly over those remaining.
+ */
+#define LB_RESILIENT_MIN_BUCKETS 64
+
 extern index_t load_balance_create(u32 num_buckets,
 				   dpo_proto_t lb_proto,
 				   flow_hash_config_t fhc);
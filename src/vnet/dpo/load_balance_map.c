@@ -57,6 +57,11 @@ typedef struct load_balance_map_path_t_ {
      */
     u32 lbmp_weight;
 
+    /**
+     * the preference of the path. lower is better.
+     */
+    u16 lbmp_preference;
+
     /**
      * The sate of the path
      */
@@ -280,19 +285,46 @@ load_balance_map_db_remove (load_balance_map_t *lbm)
     LOAD_BALANCE_MAP_DBG(lbm, "DB-removed");
 }
 
+/**
+ * @brief Is the path one that should be forwarded over; it is resolved and
+ * of the best preference amongst those resolved.
+ */
+static inline int
+load_balance_map_path_is_usable (const load_balance_map_path_t *lbmp,
+                                 u16 preference)
+{
+    return (fib_path_is_resolved(lbmp->lbmp_index) &&
+            lbmp->lbmp_preference == preference);
+}
+
 /**
  * @brief from the paths that are usable, fill the Map.
+ * The map can contain paths of two preferences, the primaries and their
+ * pre-computed backups. The backups are only usable when all the primaries
+ * are unresolved.
  */
 static void
 load_balance_map_fill (load_balance_map_t *lbm)
 {
     load_balance_map_path_t *lbmp;
     u32 n_buckets, bucket, ii, jj;
-    u16 *tmp_buckets;
+    u16 *tmp_buckets, preference;
 
     tmp_buckets = NULL;
     n_buckets = vec_len(lbm->lbm_buckets);
 
+    /*
+     * find the best preference amongst the resolved paths
+     */
+    preference = 0xffff;
+    vec_foreach (lbmp, lbm->lbm_paths)
+    {
+        if (fib_path_is_resolved(lbmp->lbmp_index))
+        {
+            preference = clib_min(preference, lbmp->lbmp_preference);
+        }
+    }
+
     /*
      * run throught the set of paths once, and build a vector of the
      * indices that are usable. we do this is a scratch space, since we
@@ -303,7 +335,7 @@ load_balance_map_fill (load_balance_map_t *lbm)
     bucket = jj = 0;
     vec_foreach (lbmp, lbm->lbm_paths)
     {
-        if (fib_path_is_resolved(lbmp->lbmp_index))
+        if (load_balance_map_path_is_usable(lbmp, preference))
         {
             for (ii = 0; ii < lbmp->lbmp_weight; ii++)
             {
@@ -319,7 +351,7 @@ load_balance_map_fill (load_balance_map_t *lbm)
 
     /*
      * If the number of temporaries written is as many as we need, implying
-     * all paths were up, then we can simply copy the scratch area over the
+     * all paths were up and of the same preference, then we can simply copy the scratch area over the
      * actual buckets' memory
      */
     if (jj == n_buckets)
@@ -350,7 +382,7 @@ load_balance_map_fill (load_balance_map_t *lbm)
             bucket = jj = 0;
             vec_foreach (lbmp, lbm->lbm_paths)
             {
-                if (fib_path_is_resolved(lbmp->lbmp_index))
+                if (load_balance_map_path_is_usable(lbmp, preference))
                 {
                     for (ii = 0; ii < lbmp->lbmp_weight; ii++)
                     {
@@ -395,6 +427,8 @@ load_balance_map_alloc (const load_balance_path_t *paths)
     {
         lbm->lbm_paths[ii].lbmp_index  = paths[ii].path_index;
         lbm->lbm_paths[ii].lbmp_weight = paths[ii].path_weight;
+        lbm->lbm_paths[ii].lbmp_preference =
+            fib_path_get_preference(paths[ii].path_index);
     }
 
     return (lbm);
@@ -497,7 +531,9 @@ load_balance_map_path_state_change_walk (fib_node_ptr_t *fptr,
 /**
  * @brief the state of a path has changed (it has no doubt gone down).
  * This is the trigger to perform a PIC edge cutover and update the maps
- * to exclude this path.
+ * to exclude this path, or to switch to the backups if it was the last
+ * primary. The cost is per-map, not per-prefix, the maps are shared by
+ * all the entries using the same set of paths.
  */
 void
 load_balance_map_path_state_change (fib_node_index_t path_index)
@@ -442,14 +442,14 @@ lookup_dpo_ip4_inline (vlib_main_t * vm,
 	    {
 		flow_hash_config0 = lb0->lb_hash_config;
 		hash_c0 = vnet_buffer (b0)->ip.flow_hash =
-		    ip4_compute_flow_hash (ip0, flow_hash_config0);
+		    ip4_compute_flow_hash_cached (b0, ip0, flow_hash_config0);
 	    }
 
 	    if (PREDICT_FALSE (lb1->lb_n_buckets > 1))
 	    {
 		flow_hash_config1 = lb1->lb_hash_config;
 		hash_c1 = vnet_buffer (b1)->ip.flow_hash =
-		    ip4_compute_flow_hash (ip1, flow_hash_config1);
+		    ip4_compute_flow_hash_cached (b1, ip1, flow_hash_config1);
 	    }
 
 	    dpo0 = load_balance_get_bucket_i(lb0,
@@ -558,7 +558,7 @@ lookup_dpo_ip4_inline (vlib_main_t * vm,
 	    {
 		flow_hash_config0 = lb0->lb_hash_config;
 		hash_c0 = vnet_buffer (b0)->ip.flow_hash =
-		    ip4_compute_flow_hash (ip0, flow_hash_config0);
+		    ip4_compute_flow_hash_cached (b0, ip0, flow_hash_config0);
 	    }
 
 	    dpo0 = load_balance_get_bucket_i(lb0,
@@ -784,14 +784,14 @@ lookup_dpo_ip6_inline (vlib_main_t * vm,
 	    {
 		flow_hash_config0 = lb0->lb_hash_config;
 		hash_c0 = vnet_buffer (b0)->ip.flow_hash =
-		    ip6_compute_flow_hash (ip0, flow_hash_config0);
+		    ip6_compute_flow_hash_cached (b0, ip0, flow_hash_config0);
 	    }
 
 	    if (PREDICT_FALSE (lb1->lb_n_buckets > 1))
 	    {
 		flow_hash_config1 = lb1->lb_hash_config;
 		hash_c1 = vnet_buffer (b1)->ip.flow_hash =
-		    ip6_compute_flow_hash (ip1, flow_hash_config1);
+		    ip6_compute_flow_hash_cached (b1, ip1, flow_hash_config1);
 	    }
 
 	    dpo0 = load_balance_get_bucket_i(lb0,
@@ -900,7 +900,7 @@ lookup_dpo_ip6_inline (vlib_main_t * vm,
 	    {
 		flow_hash_config0 = lb0->lb_hash_config;
 		hash_c0 = vnet_buffer (b0)->ip.flow_hash =
-		    ip6_compute_flow_hash (ip0, flow_hash_config0);
+		    ip6_compute_flow_hash_cached (b0, ip0, flow_hash_config0);
 	    }
 
 	    dpo0 = load_balance_get_bucket_i(lb0,
@@ -1067,7 +1067,7 @@ lookup_dpo_mpls_inline (vlib_main_t * vm,
                 if (PREDICT_FALSE(lb0->lb_n_buckets > 1))
                 {
                     hash0 = vnet_buffer (b0)->ip.flow_hash =
-                        mpls_compute_flow_hash(hdr0, lb0->lb_hash_config);
+                        mpls_compute_flow_hash_cached(b0, hdr0, lb0->lb_hash_config);
                     dpo0 = load_balance_get_fwd_bucket
                         (lb0,
                          (hash0 & (lb0->lb_n_buckets_minus_1)));
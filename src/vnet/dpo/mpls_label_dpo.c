@@ -48,8 +48,10 @@ mpls_label_dpo_create (mpls_label_t *label_stack,
                        u8 ttl,
                        u8 exp,
                        dpo_proto_t payload_proto,
+                       mpls_label_dpo_flags_t flags,
 		       const dpo_id_t *dpo)
 {
+    mpls_unicast_header_t *hdr;
     mpls_label_dpo_t *mld;
     u32 ii;
 
@@ -68,6 +70,7 @@ mpls_label_dpo_create (mpls_label_t *label_stack,
     mld->mld_n_labels = vec_len(label_stack);
     mld->mld_n_hdr_bytes = mld->mld_n_labels * sizeof(mld->mld_hdr[0]);
     mld->mld_payload_proto = payload_proto;
+    mld->mld_flags = flags;
 
     /*
      * construct label rewrite headers for each value value passed.
@@ -77,25 +80,26 @@ mpls_label_dpo_create (mpls_label_t *label_stack,
 
     for (ii = 0; ii < mld->mld_n_labels-1; ii++)
     {
-	vnet_mpls_uc_set_label(&mld->mld_hdr[ii].label_exp_s_ttl, label_stack[ii]);
-	vnet_mpls_uc_set_ttl(&mld->mld_hdr[ii].label_exp_s_ttl, 255);
-	vnet_mpls_uc_set_exp(&mld->mld_hdr[ii].label_exp_s_ttl, 0);
-	vnet_mpls_uc_set_s(&mld->mld_hdr[ii].label_exp_s_ttl, MPLS_NON_EOS);
-	mld->mld_hdr[ii].label_exp_s_ttl =
-	    clib_host_to_net_u32(mld->mld_hdr[ii].label_exp_s_ttl);
+        hdr = (mpls_unicast_header_t*) mpls_label_dpo_get_hdr(mld, ii);
+
+	vnet_mpls_uc_set_label(&hdr->label_exp_s_ttl, label_stack[ii]);
+	vnet_mpls_uc_set_ttl(&hdr->label_exp_s_ttl, 255);
+	vnet_mpls_uc_set_exp(&hdr->label_exp_s_ttl, 0);
+	vnet_mpls_uc_set_s(&hdr->label_exp_s_ttl, MPLS_NON_EOS);
+	hdr->label_exp_s_ttl = clib_host_to_net_u32(hdr->label_exp_s_ttl);
     }
 
     /*
      * the inner most label
      */
     ii = mld->mld_n_labels-1;
+    hdr = (mpls_unicast_header_t*) mpls_label_dpo_get_hdr(mld, ii);
 
-    vnet_mpls_uc_set_label(&mld->mld_hdr[ii].label_exp_s_ttl, label_stack[ii]);
-    vnet_mpls_uc_set_ttl(&mld->mld_hdr[ii].label_exp_s_ttl, ttl);
-    vnet_mpls_uc_set_exp(&mld->mld_hdr[ii].label_exp_s_ttl, exp);
-    vnet_mpls_uc_set_s(&mld->mld_hdr[ii].label_exp_s_ttl, eos);
-    mld->mld_hdr[ii].label_exp_s_ttl =
-	clib_host_to_net_u32(mld->mld_hdr[ii].label_exp_s_ttl);
+    vnet_mpls_uc_set_label(&hdr->label_exp_s_ttl, label_stack[ii]);
+    vnet_mpls_uc_set_ttl(&hdr->label_exp_s_ttl, ttl);
+    vnet_mpls_uc_set_exp(&hdr->label_exp_s_ttl, exp);
+    vnet_mpls_uc_set_s(&hdr->label_exp_s_ttl, eos);
+    hdr->label_exp_s_ttl = clib_host_to_net_u32(hdr->label_exp_s_ttl);
 
     /*
      * stack this label objct on its parent.
@@ -132,9 +136,13 @@ format_mpls_label_dpo (u8 *s, va_list *args)
     for (ii = 0; ii < mld->mld_n_labels; ii++)
     {
 	hdr.label_exp_s_ttl =
-	    clib_net_to_host_u32(mld->mld_hdr[ii].label_exp_s_ttl);
+	    clib_net_to_host_u32(mpls_label_dpo_get_hdr(mld, ii)->label_exp_s_ttl);
 	s = format(s, "%U", format_mpls_header, hdr);
     }
+    if (mld->mld_flags & MPLS_LABEL_DPO_FLAG_UNIFORM_MODE)
+    {
+        s = format(s, " uniform");
+    }
 
     s = format(s, "\n%U", format_white_space, indent);
     s = format(s, "%U", format_dpo_id, &mld->mld_dpo, indent+2);
@@ -182,10 +190,12 @@ typedef struct mpls_label_imposition_trace_t_
 
 always_inline mpls_unicast_header_t *
 mpls_label_paint (vlib_buffer_t * b0,
-                  mpls_label_dpo_t *mld0,
-                  u8 ttl0)
+                  const mpls_label_dpo_t *mld0,
+                  u8 ttl0,
+                  u8 exp0)
 {
     mpls_unicast_header_t *hdr0;
+    u32 ii;
 
     vlib_buffer_advance(b0, -(mld0->mld_n_hdr_bytes));
 
@@ -194,19 +204,131 @@ mpls_label_paint (vlib_buffer_t * b0,
     if (1 == mld0->mld_n_labels)
     {
         /* optimise for the common case of one label */
-        *hdr0 = mld0->mld_hdr[0];
+        *hdr0 = *mpls_label_dpo_get_hdr(mld0, 0);
+    }
+    else if (PREDICT_TRUE((b0->current_data + mld0->mld_n_hdr_bytes -
+                           (i32) sizeof(mld0->mld_hdr)) >=
+                          -VLIB_BUFFER_PRE_DATA_SIZE))
+    {
+        /*
+         * The template is right aligned, so paint the whole of it with
+         * one fixed size copy that ends where the payload starts. The
+         * bytes written before the new header are unused headroom.
+         */
+        clib_memcpy((u8*)hdr0 + mld0->mld_n_hdr_bytes - sizeof(mld0->mld_hdr),
+                    mld0->mld_hdr,
+                    sizeof(mld0->mld_hdr));
     }
     else
     {
-        clib_memcpy(hdr0, mld0->mld_hdr, mld0->mld_n_hdr_bytes);
-        hdr0 = hdr0 + (mld0->mld_n_labels - 1);
+        clib_memcpy(hdr0, mpls_label_dpo_get_hdr(mld0, 0),
+                    mld0->mld_n_hdr_bytes);
     }
+
+    if (PREDICT_FALSE(mld0->mld_flags & MPLS_LABEL_DPO_FLAG_UNIFORM_MODE))
+    {
+        /*
+         * uniform mode; every label in the stack inherits the TTL and
+         * EXP of the payload.
+         */
+        for (ii = 0; ii < mld0->mld_n_labels; ii++)
+        {
+            ((u8*)&hdr0[ii])[2] = ((((u8*)&hdr0[ii])[2] & 0xf1) |
+                                   ((exp0 & 0x7) << 1));
+            ((u8*)&hdr0[ii])[3] = ttl0;
+        }
+    }
+
     /* fixup the TTL for the inner most label */
+    hdr0 = hdr0 + (mld0->mld_n_labels - 1);
     ((char*)hdr0)[3] = ttl0;
 
     return (hdr0);
 }
 
+/**
+ * @brief Derive, from the payload, the TTL and EXP of the labels to impose.
+ * IP payloads have their TTL decremented on ingress to the LSP.
+ */
+always_inline void
+mpls_label_imposition_ttl_exp (vlib_buffer_t * b0,
+                               const mpls_label_dpo_t *mld0,
+                               u8 payload_is_ip4,
+                               u8 payload_is_ip6,
+                               u8 payload_is_ethernet,
+                               u8 *ttl0,
+                               u8 *exp0)
+{
+    if (payload_is_ip4)
+    {
+        ip4_header_t * ip0 = vlib_buffer_get_current(b0);
+        u32 checksum0;
+
+        checksum0 = ip0->checksum + clib_host_to_net_u16 (0x0100);
+        checksum0 += checksum0 >= 0xffff;
+
+        ip0->checksum = checksum0;
+        ip0->ttl -= 1;
+
+        *ttl0 = ip0->ttl;
+        /* the precedence bits of the DSCP */
+        *exp0 = ip0->tos >> 5;
+    }
+    else if (payload_is_ip6)
+    {
+        ip6_header_t * ip0 = vlib_buffer_get_current(b0);
+
+        ip0->hop_limit -= 1;
+
+        *ttl0 = ip0->hop_limit;
+        *exp0 = ip6_traffic_class(ip0) >> 5;
+    }
+    else if (payload_is_ethernet)
+    {
+        /*
+         * nothing to change in the ethernet header
+         */
+        *ttl0 = 255;
+        *exp0 = 0;
+    }
+    else if (PREDICT_TRUE(vnet_buffer(b0)->mpls.first))
+    {
+        /*
+         * The first label to be imposed on the packet. this is a label swap.
+         * in which case we stashed the TTL and EXP bits in the
+         * packet in the lookup node
+         */
+        ASSERT(0 != vnet_buffer (b0)->mpls.ttl);
+
+        *ttl0 = vnet_buffer(b0)->mpls.ttl - 1;
+        *exp0 = vnet_buffer(b0)->mpls.exp;
+    }
+    else if (mld0->mld_flags & MPLS_LABEL_DPO_FLAG_UNIFORM_MODE)
+    {
+        /*
+         * not the first label. implying we are recusring down a chain of
+         * output labels. In uniform mode the new LSP inherits from the
+         * label imposed at the previous level.
+         */
+        const mpls_unicast_header_t *hdr0 = vlib_buffer_get_current(b0);
+        mpls_label_t ho0 = clib_net_to_host_u32(hdr0->label_exp_s_ttl);
+
+        *ttl0 = vnet_mpls_uc_get_ttl(ho0);
+        *exp0 = vnet_mpls_uc_get_exp(ho0);
+    }
+    else
+    {
+        /*
+         * not the first label. implying we are recusring down a chain of
+         * output labels.
+         * Each layer is considered a new LSP - hence the TTL is reset.
+         */
+        *ttl0 = 255;
+        *exp0 = 0;
+    }
+    vnet_buffer(b0)->mpls.first = 0;
+}
+
 always_inline uword
 mpls_label_imposition_inline (vlib_main_t * vm,
                               vlib_node_runtime_t * node,
@@ -235,7 +357,8 @@ mpls_label_imposition_inline (vlib_main_t * vm,
             mpls_label_dpo_t *mld0, *mld1, *mld2, *mld3;
             vlib_buffer_t * b0, *b1, * b2, *b3;
             u32 next0, next1, next2, next3;
-            u8 ttl0, ttl1,ttl2, ttl3 ;
+            u8 ttl0, ttl1, ttl2, ttl3;
+            u8 exp0, exp1, exp2, exp3;
 
             bi0 = to_next[0] = from[0];
             bi1 = to_next[1] = from[1];
@@ -282,136 +405,24 @@ mpls_label_imposition_inline (vlib_main_t * vm,
             mld2 = mpls_label_dpo_get(mldi2);
             mld3 = mpls_label_dpo_get(mldi3);
 
-            if (payload_is_ip4)
-            {
-                /*
-                 * decrement the TTL on ingress to the LSP
-                 */
-                ip4_header_t * ip0 = vlib_buffer_get_current(b0);
-                ip4_header_t * ip1 = vlib_buffer_get_current(b1);
-                ip4_header_t * ip2 = vlib_buffer_get_current(b2);
-                ip4_header_t * ip3 = vlib_buffer_get_current(b3);
-                u32 checksum0;
-                u32 checksum1;
-                u32 checksum2;
-                u32 checksum3;
-
-                checksum0 = ip0->checksum + clib_host_to_net_u16 (0x0100);
-                checksum1 = ip1->checksum + clib_host_to_net_u16 (0x0100);
-                checksum2 = ip2->checksum + clib_host_to_net_u16 (0x0100);
-                checksum3 = ip3->checksum + clib_host_to_net_u16 (0x0100);
-
-                checksum0 += checksum0 >= 0xffff;
-                checksum1 += checksum1 >= 0xffff;
-                checksum2 += checksum2 >= 0xffff;
-                checksum3 += checksum3 >= 0xffff;
-
-                ip0->checksum = checksum0;
-                ip1->checksum = checksum1;
-                ip2->checksum = checksum2;
-                ip3->checksum = checksum3;
-
-                ip0->ttl -= 1;
-                ip1->ttl -= 1;
-                ip2->ttl -= 1;
-                ip3->ttl -= 1;
-
-                ttl1 = ip1->ttl;
-                ttl0 = ip0->ttl;
-                ttl3 = ip3->ttl;
-                ttl2 = ip2->ttl;
-            }
-            else if (payload_is_ip6)
-            {
-                /*
-                 * decrement the TTL on ingress to the LSP
-                 */
-                ip6_header_t * ip0 = vlib_buffer_get_current(b0);
-                ip6_header_t * ip1 = vlib_buffer_get_current(b1);
-                ip6_header_t * ip2 = vlib_buffer_get_current(b2);
-                ip6_header_t * ip3 = vlib_buffer_get_current(b3);
-
-                ip0->hop_limit -= 1;
-                ip1->hop_limit -= 1;
-                ip2->hop_limit -= 1;
-                ip3->hop_limit -= 1;
-
-                ttl0 = ip0->hop_limit;
-                ttl1 = ip1->hop_limit;
-                ttl2 = ip2->hop_limit;
-                ttl3 = ip3->hop_limit;
-            }
-            else if (payload_is_ethernet)
-            {
-                /*
-                 * nothing to chang ein the ethernet header
-                 */
-                ttl0 = ttl1 = ttl2 = ttl3 = 255;
-            }
-            else
-            {
-                /*
-                 * else, the packet to be encapped is an MPLS packet
-                 */
-                if (PREDICT_TRUE(vnet_buffer(b0)->mpls.first))
-                {
-                    /*
-                     * The first label to be imposed on the packet. this is a label swap.
-                     * in which case we stashed the TTL and EXP bits in the
-                     * packet in the lookup node
-                     */
-                    ASSERT(0 != vnet_buffer (b0)->mpls.ttl);
-
-                    ttl0 = vnet_buffer(b0)->mpls.ttl - 1;
-                }
-                else
-                {
-                    /*
-                     * not the first label. implying we are recusring down a chain of
-                     * output labels.
-                     * Each layer is considered a new LSP - hence the TTL is reset.
-                     */
-                    ttl0 = 255;
-                }
-                if (PREDICT_TRUE(vnet_buffer(b1)->mpls.first))
-                {
-                    ASSERT(1 != vnet_buffer (b1)->mpls.ttl);
-                    ttl1 = vnet_buffer(b1)->mpls.ttl - 1;
-                }
-                else
-                {
-                    ttl1 = 255;
-                }
-                if (PREDICT_TRUE(vnet_buffer(b2)->mpls.first))
-                {
-                    ASSERT(1 != vnet_buffer (b2)->mpls.ttl);
-
-                    ttl2 = vnet_buffer(b2)->mpls.ttl - 1;
-                }
-                else
-                {
-                    ttl2 = 255;
-                }
-                if (PREDICT_TRUE(vnet_buffer(b3)->mpls.first))
-                {
-                    ASSERT(1 != vnet_buffer (b3)->mpls.ttl);
-                    ttl3 = vnet_buffer(b3)->mpls.ttl - 1;
-                }
-                else
-                {
-                    ttl3 = 255;
-                }
-            }
-            vnet_buffer(b0)->mpls.first = 0;
-            vnet_buffer(b1)->mpls.first = 0;
-            vnet_buffer(b2)->mpls.first = 0;
-            vnet_buffer(b3)->mpls.first = 0;
+            mpls_label_imposition_ttl_exp(b0, mld0, payload_is_ip4,
+                                          payload_is_ip6, payload_is_ethernet,
+                                          &ttl0, &exp0);
+            mpls_label_imposition_ttl_exp(b1, mld1, payload_is_ip4,
+                                          payload_is_ip6, payload_is_ethernet,
+                                          &ttl1, &exp1);
+            mpls_label_imposition_ttl_exp(b2, mld2, payload_is_ip4,
+                                          payload_is_ip6, payload_is_ethernet,
+                                          &ttl2, &exp2);
+            mpls_label_imposition_ttl_exp(b3, mld3, payload_is_ip4,
+                                          payload_is_ip6, payload_is_ethernet,
+                                          &ttl3, &exp3);
 
             /* Paint the MPLS header */
-            hdr0 = mpls_label_paint(b0, mld0, ttl0);
-            hdr1 = mpls_label_paint(b1, mld1, ttl1);
-            hdr2 = mpls_label_paint(b2, mld2, ttl2);
-            hdr3 = mpls_label_paint(b3, mld3, ttl3);
+            hdr0 = mpls_label_paint(b0, mld0, ttl0, exp0);
+            hdr1 = mpls_label_paint(b1, mld1, ttl1, exp1);
+            hdr2 = mpls_label_paint(b2, mld2, ttl2, exp2);
+            hdr3 = mpls_label_paint(b3, mld3, ttl3, exp3);
 
             next0 = mld0->mld_dpo.dpoi_next_node;
             next1 = mld1->mld_dpo.dpoi_next_node;
@@ -460,7 +471,7 @@ mpls_label_imposition_inline (vlib_main_t * vm,
             vlib_buffer_t * b0;
             u32 bi0, mldi0;
             u32 next0;
-            u8 ttl;
+            u8 ttl0, exp0;
 
             bi0 = from[0];
             to_next[0] = bi0;
@@ -475,67 +486,12 @@ mpls_label_imposition_inline (vlib_main_t * vm,
             mldi0 = vnet_buffer(b0)->ip.adj_index[VLIB_TX];
             mld0 = mpls_label_dpo_get(mldi0);
 
-            if (payload_is_ip4)
-            {
-                /*
-                 * decrement the TTL on ingress to the LSP
-                 */
-                ip4_header_t * ip0 = vlib_buffer_get_current(b0);
-                u32 checksum0;
-
-                checksum0 = ip0->checksum + clib_host_to_net_u16 (0x0100);
-                checksum0 += checksum0 >= 0xffff;
-
-                ip0->checksum = checksum0;
-                ip0->ttl -= 1;
-                ttl = ip0->ttl;
-            }
-            else if (payload_is_ip6)
-            {
-                /*
-                 * decrement the TTL on ingress to the LSP
-                 */
-                ip6_header_t * ip0 = vlib_buffer_get_current(b0);
-
-                ip0->hop_limit -= 1;
-                ttl = ip0->hop_limit;
-            }
-            else
-            {
-                /*
-                 * else, the packet to be encapped is an MPLS packet
-                 */
-                if (vnet_buffer(b0)->mpls.first)
-                {
-                    /*
-                     * The first label to be imposed on the packet. this is a label swap.
-                     * in which case we stashed the TTL and EXP bits in the
-                     * packet in the lookup node
-                     */
-                    ASSERT(0 != vnet_buffer (b0)->mpls.ttl);
-
-                    ttl = vnet_buffer(b0)->mpls.ttl - 1;
-                }
-                else
-                {
-                    /*
-                     * not the first label. implying we are recusring down a chain of
-                     * output labels.
-                     * Each layer is considered a new LSP - hence the TTL is reset.
-                     */
-                    ttl = 255;
-                }
-            }
-            vnet_buffer(b0)->mpls.first = 0;
+            mpls_label_imposition_ttl_exp(b0, mld0, payload_is_ip4,
+                                          payload_is_ip6, payload_is_ethernet,
+                                          &ttl0, &exp0);
 
             /* Paint the MPLS header */
-            vlib_buffer_advance(b0, -(mld0->mld_n_hdr_bytes));
-            hdr0 = vlib_buffer_get_current(b0);
-            clib_memcpy(hdr0, mld0->mld_hdr, mld0->mld_n_hdr_bytes);
-
-            /* fixup the TTL for the inner most label */
-            hdr0 = hdr0 + (mld0->mld_n_labels - 1);
-            ((char*)hdr0)[3] = ttl;
+            hdr0 = mpls_label_paint(b0, mld0, ttl0, exp0);
 
             next0 = mld0->mld_dpo.dpoi_next_node;
             vnet_buffer(b0)->ip.adj_index[VLIB_TX] = mld0->mld_dpo.dpoi_index;
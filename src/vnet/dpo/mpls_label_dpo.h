@@ -21,6 +21,20 @@
 #include <vnet/dpo/dpo.h>
 
 
+/**
+ * Flags controlling how the label stack is imposed
+ */
+typedef enum mpls_label_dpo_flags_t_
+{
+    MPLS_LABEL_DPO_FLAG_NONE = 0,
+    /**
+     * Uniform mode; all labels in the stack take the TTL and EXP of the
+     * payload. The default is pipe mode, where only the inner most label
+     * takes the payload's TTL.
+     */
+    MPLS_LABEL_DPO_FLAG_UNIFORM_MODE = (1 << 0),
+} __attribute__((packed)) mpls_label_dpo_flags_t;
+
 /**
  * Maximum number of labels in one DPO
  */
@@ -33,6 +47,8 @@ typedef struct mpls_label_dpo_t
     /**
      * The MPLS label header to impose. Outer most label first.
      * Each DPO will occupy one cache line, stuff that many labels in.
+     * The stack is right aligned, i.e. it ends at the end of the array,
+     * so that it can be painted with a single fixed size copy.
      */
     mpls_unicast_header_t mld_hdr[MPLS_LABEL_DPO_MAX_N_LABELS];
 
@@ -46,6 +62,11 @@ typedef struct mpls_label_dpo_t
      */
     dpo_proto_t mld_payload_proto;
 
+    /**
+     * Imposition flags/mode
+     */
+    mpls_label_dpo_flags_t mld_flags;
+
     /**
      * Size of the label stack
      */
@@ -79,6 +100,8 @@ STATIC_ASSERT((sizeof(mpls_label_dpo_t) <= CLIB_CACHE_LINE_BYTES),
  * @param exp The inner most label's EXP bit
  * @param payload_proto The ptocool of the payload packets that will
  *                      be imposed with this label header.
+ * @param flags MPLS_LABEL_DPO_FLAG_UNIFORM_MODE for every label to take
+ *              the payload's TTL and EXP, else pipe mode
  * @param dpo The parent of the created MPLS label object
  */
 extern index_t mpls_label_dpo_create(mpls_label_t *label_stack,
@@ -86,6 +109,7 @@ extern index_t mpls_label_dpo_create(mpls_label_t *label_stack,
                                      u8 ttl,
                                      u8 exp,
                                      dpo_proto_t payload_proto,
+                                     mpls_label_dpo_flags_t flags,
 				     const dpo_id_t *dpo);
 
 extern u8* format_mpls_label_dpo(u8 *s, va_list *args);
@@ -102,6 +126,16 @@ mpls_label_dpo_get (index_t index)
     return (pool_elt_at_index(mpls_label_dpo_pool, index));
 }
 
+/**
+ * @brief Get the ii'th label header of the stack to impose, outer most first
+ */
+static inline const mpls_unicast_header_t *
+mpls_label_dpo_get_hdr (const mpls_label_dpo_t *mld, u32 ii)
+{
+    return (&mld->mld_hdr[MPLS_LABEL_DPO_MAX_N_LABELS -
+                          mld->mld_n_labels + ii]);
+}
+
 extern void mpls_label_dpo_module_init(void);
 
 #endif
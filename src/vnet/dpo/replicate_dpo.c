@@ -651,7 +651,7 @@ replicate_inline (vlib_main_t * vm,
             const replicate_t *rep0;
             vlib_buffer_t * b0, *c0;
             const dpo_id_t *dpo0;
-	    u8 num_cloned;
+	    u16 num_cloned;
 
             bi0 = from[0];
             from += 1;
@@ -667,7 +667,8 @@ replicate_inline (vlib_main_t * vm,
 
 	    vec_validate (rm->clones[thread_index], rep0->rep_n_buckets - 1);
 
-	    num_cloned = vlib_buffer_clone (vm, bi0, rm->clones[thread_index], rep0->rep_n_buckets, 128);
+	    num_cloned = vlib_buffer_clone (vm, bi0, rm->clones[thread_index],
+                                            rep0->rep_n_buckets, 128);
 
 	    if (num_cloned != rep0->rep_n_buckets)
 	      {
@@ -678,6 +679,17 @@ replicate_inline (vlib_main_t * vm,
 
             for (bucket = 0; bucket < num_cloned; bucket++)
             {
+                /*
+                 * on wide fan-outs the clone headers written by the
+                 * clone have long since left the L1 by the time we
+                 * get to them.
+                 */
+                if (bucket + 4 < num_cloned)
+                {
+                    vlib_prefetch_buffer_with_index
+                        (vm, rm->clones[thread_index][bucket + 4], STORE);
+                }
+
                 ci0 = rm->clones[thread_index][bucket];
                 c0 = vlib_get_buffer(vm, ci0);
 
@@ -92,6 +92,7 @@ vnet_feature_init (vlib_main_t * vm)
       arc_index = areg->feature_arc_index;
       cm = &fm->feature_config_mains[arc_index];
       vcm = &cm->config_main;
+      cm->fused_node_index = ~0;
       if ((error = vnet_feature_arc_init (vm, vcm,
 					  areg->start_nodes,
 					  areg->n_start_nodes,
@@ -196,7 +197,9 @@ vnet_feature_enable_disable_with_index (u8 arc_index, u32 feature_index,
 
   cm = &fm->feature_config_mains[arc_index];
   vec_validate_init_empty (cm->config_index_by_sw_if_index, sw_if_index, ~0);
-  ci = cm->config_index_by_sw_if_index[sw_if_index];
+  vec_validate_init_empty (cm->feature_config_index_by_sw_if_index,
+			   sw_if_index, ~0);
+  ci = cm->feature_config_index_by_sw_if_index[sw_if_index];
 
   vec_validate (fm->feature_count_by_sw_if_index[arc_index], sw_if_index);
   feature_count = fm->feature_count_by_sw_if_index[arc_index][sw_if_index];
@@ -209,7 +212,13 @@ vnet_feature_enable_disable_with_index (u8 arc_index, u32 feature_index,
 	: vnet_config_del_feature)
     (vlib_get_main (), &cm->config_main, ci, feature_index, feature_config,
      n_feature_config_bytes);
-  cm->config_index_by_sw_if_index[sw_if_index] = ci;
+  cm->feature_config_index_by_sw_if_index[sw_if_index] = ci;
+
+  /* the arc starts with these features, or with them fused */
+  if (cm->fusion_enabled)
+    vnet_feature_fusion_update (arc_index, sw_if_index);
+  else
+    cm->config_index_by_sw_if_index[sw_if_index] = ci;
 
   /* update feature count */
   enable_disable = (enable_disable > 0);
@@ -314,6 +323,7 @@ vnet_interface_features_show (vlib_main_t * vm, u32 sw_if_index)
   u32 cfg_index;
   vnet_config_feature_t *feat;
   vlib_node_t *n;
+  u32 n_fused;
   int i;
 
   vlib_cli_output (vm, "Driver feature paths configured on %U...",
@@ -329,8 +339,8 @@ vnet_interface_features_show (vlib_main_t * vm, u32 sw_if_index)
       vlib_cli_output (vm, "\n%s:", areg->arc_name);
       areg = areg->next;
 
-      if (NULL == cm[feature_arc].config_index_by_sw_if_index ||
-	  vec_len (cm[feature_arc].config_index_by_sw_if_index) <=
+      if (NULL == cm[feature_arc].feature_config_index_by_sw_if_index ||
+	  vec_len (cm[feature_arc].feature_config_index_by_sw_if_index) <=
 	  sw_if_index)
 	{
 	  vlib_cli_output (vm, "  none configured");
@@ -338,7 +348,8 @@ vnet_interface_features_show (vlib_main_t * vm, u32 sw_if_index)
 	}
 
       current_config_index =
-	vec_elt (cm[feature_arc].config_index_by_sw_if_index, sw_if_index);
+	vec_elt (cm[feature_arc].feature_config_index_by_sw_if_index,
+		 sw_if_index);
 
       if (current_config_index == ~0)
 	{
@@ -352,12 +363,23 @@ vnet_interface_features_show (vlib_main_t * vm, u32 sw_if_index)
       cfg_index = vcm->config_pool_index_by_user_index[current_config_index];
       cfg = pool_elt_at_index (vcm->config_pool, cfg_index);
 
+      n_fused = 0;
+      if (sw_if_index <
+	  vec_len (cm[feature_arc].fused_chain_index_by_sw_if_index))
+	{
+	  u32 chain_index =
+	    cm[feature_arc].fused_chain_index_by_sw_if_index[sw_if_index];
+	  if (chain_index != ~0)
+	    n_fused = vec_len (pool_elt_at_index (fm->fused_chains,
+						  chain_index)->steps);
+	}
+
       for (i = 0; i < vec_len (cfg->features); i++)
 	{
 	  feat = cfg->features + i;
 	  node_index = feat->node_index;
 	  n = vlib_get_node (vm, node_index);
-	  vlib_cli_output (vm, "  %v", n->name);
+	  vlib_cli_output (vm, "  %v%s", n->name, i < n_fused ? " (fused)" : "");
 	}
     }
 }
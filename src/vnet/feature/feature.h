@@ -39,6 +39,31 @@ typedef struct _vnet_feature_arc_registration
 typedef clib_error_t *(vnet_feature_enable_disable_function_t)
   (u32 sw_if_index, int enable_disable);
 
+/** Fused feature verdict: go on to the next feature */
+#define VNET_FEATURE_FUSED_CONTINUE ((u32) ~0)
+/** Fused feature verdict: hand the packet to the feature's own node */
+#define VNET_FEATURE_FUSED_PUNT ((u32) ~1)
+
+/**
+ * Per packet function of a feature, run in place of the feature's node
+ * when the feature is fused with others on an interface. Given the
+ * feature's config data, returns VNET_FEATURE_FUSED_CONTINUE, a next
+ * index of the feature's node, or VNET_FEATURE_FUSED_PUNT for the
+ * packets it cannot handle itself. Packets sent to a next of the
+ * feature's node leave with their config index at the feature, as if
+ * they had just reached it through the arc.
+ */
+typedef u32 (vnet_feature_fused_function_t) (vlib_main_t * vm,
+					     vlib_buffer_t * b,
+					     void *feature_config);
+
+/**
+ * Called by the fused node once its frame has been through the fused
+ * functions, for features that batch work across packets, e.g. frames
+ * of copies sent to other nodes.
+ */
+typedef void (vnet_feature_fused_flush_function_t) (vlib_main_t * vm);
+
 /** feature registration object */
 typedef struct _vnet_feature_registration
 {
@@ -58,14 +83,63 @@ typedef struct _vnet_feature_registration
 
   /** Function to enable/disable feature  **/
   vnet_feature_enable_disable_function_t *enable_disable_cb;
+
+  /** Per packet function, if the feature can be fused **/
+  vnet_feature_fused_function_t *fused_function;
+  /** Per frame function, if the fused function batches work **/
+  vnet_feature_fused_flush_function_t *fused_flush_function;
 } vnet_feature_registration_t;
 
 typedef struct vnet_feature_config_main_t_
 {
   vnet_config_main_t config_main;
+  /** Config the arc starts with: fused, if the interface's are */
   u32 *config_index_by_sw_if_index;
+  /** Config of the features enabled on the interface */
+  u32 *feature_config_index_by_sw_if_index;
+  /** Fused chain of the interface, ~0 if none */
+  u32 *fused_chain_index_by_sw_if_index;
+  /** Node running the arc's fused chains, ~0 until created */
+  u32 fused_node_index;
+  /** Set if the arc's fusable features are fused */
+  u8 fusion_enabled;
 } vnet_feature_config_main_t;
 
+/** One feature of a fused chain */
+typedef struct
+{
+  vnet_feature_fused_function_t *function;
+  vnet_feature_fused_flush_function_t *flush_function;
+  /** Feature config data, as in the interface's config */
+  u32 *feature_config;
+  /** The feature's node */
+  u32 node_index;
+  /** Next from the fused node to the feature's node */
+  u32 punt_next_index;
+  /** Config index the feature's node expects */
+  u32 punt_config_index;
+  /** Next from the fused node for each next of the feature's node */
+  u32 *next_by_feature_next;
+} vnet_feature_fused_step_t;
+
+/**
+ * The leading fusable features enabled on an interface, run in turn on
+ * each packet by the arc's fused node.
+ */
+typedef struct
+{
+  vnet_feature_fused_step_t *steps;
+  /** Set if any step has a flush function */
+  u8 has_flush;
+  /** The fused config, starting with the fused node */
+  u32 config_index;
+  u32 sw_if_index;
+  u8 arc_index;
+} vnet_feature_fused_chain_t;
+
+/** Fewest fusable features worth fusing */
+#define VNET_FEATURE_FUSION_MIN_FEATURES 2
+
 typedef struct
 {
   /** feature arc configuration list */
@@ -89,6 +163,9 @@ typedef struct
   /** feature reference counts by interface */
   i16 **feature_count_by_sw_if_index;
 
+  /** pool of fused feature chains */
+  vnet_feature_fused_chain_t *fused_chains;
+
   /** Feature arc index for device-input */
   u8 device_input_feature_arc_index;
 
@@ -178,6 +255,17 @@ vnet_get_feature_config_index (u8 arc, u32 sw_if_index)
   return vec_elt (cm->config_index_by_sw_if_index, sw_if_index);
 }
 
+/**
+ * CPU time for fused functions to take as the packet's arrival, as the
+ * feature nodes read the clock once for their frame: the time the fused
+ * node was dispatched at.
+ */
+static_always_inline u64
+vnet_feature_fused_cpu_time (vlib_main_t * vm)
+{
+  return vm->cpu_time_last_node_dispatch;
+}
+
 static_always_inline void *
 vnet_feature_arc_start_with_data (u8 arc, u32 sw_if_index, u32 * next,
 				  vlib_buffer_t * b, u32 n_data_bytes)
@@ -376,6 +464,9 @@ clib_error_t *vnet_feature_arc_init (vlib_main_t * vm,
 
 void vnet_interface_features_show (vlib_main_t * vm, u32 sw_if_index);
 
+void vnet_feature_fusion_update (u8 arc_index, u32 sw_if_index);
+int vnet_feature_fusion_enable_disable (u8 arc_index, int enable_disable);
+
 #endif /* included_feature_h */
 
 /*
@@ -0,0 +1,611 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Feature arc fusion.
+ *
+ * The leading features enabled on an interface that provide a per packet
+ * fused_function are run, one after the other, by a single node of the
+ * arc: "<arc>-fused". The interface then starts the arc with a config
+ * whose first feature is the fused node, its data the index of the
+ * fused chain, followed by the features that were not fused. Packets a
+ * fused function cannot deal with are handed to the feature's own node,
+ * positioned in the interface's feature config as if they had reached
+ * it through the arc. Traced packets get a record for each fused
+ * feature they go through.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+
+#define foreach_vnet_feature_fused_error			\
+  _(FUSED, "packets through fused features")			\
+  _(PUNT, "packets handed to a feature node")
+
+typedef enum
+{
+#define _(sym,str) VNET_FEATURE_FUSED_ERROR_##sym,
+  foreach_vnet_feature_fused_error
+#undef _
+    VNET_FEATURE_FUSED_N_ERROR,
+} vnet_feature_fused_error_t;
+
+static char *vnet_feature_fused_error_strings[] = {
+#define _(sym,string) string,
+  foreach_vnet_feature_fused_error
+#undef _
+};
+
+/*
+ * A traced packet gets a record for each fused feature it goes through,
+ * with that feature's verdict, and one for where it leaves the node.
+ */
+typedef struct
+{
+  u32 chain_index;
+  u32 node_index;
+  u32 verdict;
+  u32 next_index;
+} vnet_feature_fused_trace_t;
+
+static u8 *
+format_vnet_feature_fused_trace (u8 * s, va_list * args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  vnet_feature_fused_trace_t *t = va_arg (*args, vnet_feature_fused_trace_t *);
+
+  if (t->node_index == ~0)
+    return format (s, "fused chain %d next %d", t->chain_index,
+		   t->next_index);
+
+  s = format (s, "fused chain %d %U: ", t->chain_index,
+	      format_vlib_node_name, vm, t->node_index);
+  if (t->verdict == VNET_FEATURE_FUSED_CONTINUE)
+    s = format (s, "continue");
+  else if (t->verdict == VNET_FEATURE_FUSED_PUNT)
+    s = format (s, "punt");
+  else
+    s = format (s, "next %d", t->verdict);
+  return s;
+}
+
+static_always_inline void
+vnet_feature_fused_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      vlib_buffer_t * b, u32 chain_index,
+			      u32 node_index, u32 verdict, u32 next_index)
+{
+  vnet_feature_fused_trace_t *t = vlib_add_trace (vm, node, b, sizeof (*t));
+
+  t->chain_index = chain_index;
+  t->node_index = node_index;
+  t->verdict = verdict;
+  t->next_index = next_index;
+}
+
+static uword
+vnet_feature_fused_node_fn (vlib_main_t * vm,
+			    vlib_node_runtime_t * node, vlib_frame_t * frame)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  vnet_feature_fused_chain_t *chains[VLIB_FRAME_SIZE], *flushed;
+  u16 nexts[VLIB_FRAME_SIZE], active[VLIB_FRAME_SIZE];
+  u32 n_active, n_punted = 0, n_left, step, i, *from;
+  int is_traced = (node->flags & VLIB_NODE_FLAG_TRACE) != 0;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  /* Where each packet goes once past the fused features */
+  b = bufs;
+  for (i = 0; i < n_left; i++)
+    {
+      u32 next0, *chain_index0;
+
+      chain_index0 =
+	vnet_feature_next_with_data (vnet_buffer (b[0])->sw_if_index
+				     [VLIB_RX], &next0, b[0],
+				     sizeof (chain_index0[0]));
+      chains[i] = pool_elt_at_index (fm->fused_chains, chain_index0[0]);
+      nexts[i] = next0;
+      active[i] = i;
+      b += 1;
+    }
+  n_active = n_left;
+
+  /*
+   * One feature at a time across the frame, so each feature's function
+   * runs back to back for all the packets still going through features.
+   */
+  for (step = 0; n_active; step++)
+    {
+      u32 n_still_active = 0;
+
+      for (i = 0; i < n_active; i++)
+	{
+	  u16 j = active[i];
+	  vnet_feature_fused_step_t *s0;
+	  u32 r0;
+
+	  if (step >= vec_len (chains[j]->steps))
+	    continue;
+
+	  s0 = vec_elt_at_index (chains[j]->steps, step);
+	  r0 = s0->function (vm, bufs[j], s0->feature_config);
+
+	  if (PREDICT_FALSE (is_traced
+			     && (bufs[j]->flags & VLIB_BUFFER_IS_TRACED)))
+	    vnet_feature_fused_add_trace (vm, node, bufs[j],
+					  chains[j] - fm->fused_chains,
+					  s0->node_index, r0, 0);
+
+	  if (PREDICT_TRUE (r0 == VNET_FEATURE_FUSED_CONTINUE))
+	    {
+	      active[n_still_active++] = j;
+	      continue;
+	    }
+
+	  /* leave as if from the feature's position in the arc */
+	  bufs[j]->current_config_index = s0->punt_config_index;
+	  if (PREDICT_FALSE (r0 == VNET_FEATURE_FUSED_PUNT ||
+			     r0 >= vec_len (s0->next_by_feature_next)))
+	    {
+	      /* the feature's node takes it from here */
+	      nexts[j] = s0->punt_next_index;
+	      n_punted++;
+	    }
+	  else
+	    nexts[j] = s0->next_by_feature_next[r0];
+	}
+      n_active = n_still_active;
+    }
+
+  /* Hand on what the fused functions batched, once per chain in a row */
+  flushed = 0;
+  for (i = 0; i < n_left; i++)
+    {
+      vnet_feature_fused_step_t *s0;
+
+      if (PREDICT_TRUE (!chains[i]->has_flush || chains[i] == flushed))
+	continue;
+      vec_foreach (s0, chains[i]->steps)
+      {
+	if (s0->flush_function)
+	  s0->flush_function (vm);
+      }
+      flushed = chains[i];
+    }
+
+  if (PREDICT_FALSE (is_traced))
+    {
+      for (i = 0; i < n_left; i++)
+	{
+	  if (bufs[i]->flags & VLIB_BUFFER_IS_TRACED)
+	    vnet_feature_fused_add_trace (vm, node, bufs[i],
+					  chains[i] - fm->fused_chains,
+					  ~0, 0, nexts[i]);
+	}
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, n_left);
+
+  vlib_node_increment_counter (vm, node->node_index,
+			       VNET_FEATURE_FUSED_ERROR_FUSED,
+			       n_left - n_punted);
+  vlib_node_increment_counter (vm, node->node_index,
+			       VNET_FEATURE_FUSED_ERROR_PUNT, n_punted);
+  return n_left;
+}
+
+static vnet_feature_registration_t *
+vnet_feature_reg_by_index (u8 arc_index, u32 feature_index)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_registration_t *reg;
+
+  reg = fm->next_feature_by_arc[arc_index];
+  while (reg)
+    {
+      if (reg->feature_index == feature_index)
+	return reg;
+      reg = reg->next;
+    }
+  return 0;
+}
+
+/* The arc's fused node, created the first time the arc is fused */
+static u32
+vnet_feature_fused_node (vlib_main_t * vm, u8 arc_index)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm = &fm->feature_config_mains[arc_index];
+  vnet_config_main_t *vcm = &cm->config_main;
+  vnet_feature_arc_registration_t *areg;
+  vlib_node_registration_t r;
+  u32 i, slot = 0;
+
+  if (cm->fused_node_index != ~0)
+    return cm->fused_node_index;
+
+  areg = fm->next_arc;
+  while (areg && areg->feature_arc_index != arc_index)
+    areg = areg->next;
+  ASSERT (areg);
+
+  memset (&r, 0, sizeof (r));
+  r.function = vnet_feature_fused_node_fn;
+  r.name = (char *) format (0, "%s-fused", areg->arc_name);
+  r.type = VLIB_NODE_TYPE_INTERNAL;
+  r.vector_size = sizeof (u32);
+  r.format_trace = format_vnet_feature_fused_trace;
+  r.n_errors = VNET_FEATURE_FUSED_N_ERROR;
+  r.error_strings = vnet_feature_fused_error_strings;
+
+  cm->fused_node_index = vlib_register_node (vm, &r);
+  vec_free (r.name);
+
+  /* The arc's start nodes must agree on the next index to any feature */
+  for (i = 0; i < vec_len (vcm->start_node_indices); i++)
+    slot = clib_max (slot, vec_len (vlib_get_node
+				    (vm,
+				     vcm->start_node_indices[i])->next_nodes));
+  for (i = 0; i < vec_len (vcm->start_node_indices); i++)
+    vlib_node_add_next_with_slot (vm, vcm->start_node_indices[i],
+				  cm->fused_node_index, slot);
+
+  return cm->fused_node_index;
+}
+
+static void
+vnet_feature_fused_chain_free (vnet_feature_fused_chain_t * chain)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm =
+    &fm->feature_config_mains[chain->arc_index];
+  vnet_feature_fused_step_t *s;
+
+  vnet_config_release (&cm->config_main, chain->config_index);
+
+  vec_foreach (s, chain->steps)
+  {
+    vec_free (s->feature_config);
+    vec_free (s->next_by_feature_next);
+  }
+  vec_free (chain->steps);
+  pool_put (fm->fused_chains, chain);
+}
+
+/*
+ * Fuse the leading fusable features of the given feature config, if
+ * there are enough of them. Returns the chain index, or ~0.
+ */
+static u32
+vnet_feature_fused_chain_compile (vlib_main_t * vm, u8 arc_index,
+				  u32 sw_if_index, u32 ci)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm = &fm->feature_config_mains[arc_index];
+  vnet_config_main_t *vcm = &cm->config_main;
+  vnet_feature_registration_t *reg;
+  vnet_feature_fused_chain_t *chain;
+  vnet_feature_fused_step_t *s;
+  vnet_config_feature_t *f;
+  vnet_config_t *cfg;
+  u32 n_fused, pos, chain_index, fused_node_index, i, j;
+
+  cfg = pool_elt_at_index (vcm->config_pool,
+			   heap_elt_at_index (vcm->config_string_heap,
+					      ci)[-1]);
+
+  n_fused = 0;
+  vec_foreach (f, cfg->features)
+  {
+    reg = vnet_feature_reg_by_index (arc_index, f->feature_index);
+    if (!reg || !reg->fused_function)
+      break;
+    n_fused++;
+  }
+
+  if (n_fused < VNET_FEATURE_FUSION_MIN_FEATURES)
+    return ~0;
+
+  fused_node_index = vnet_feature_fused_node (vm, arc_index);
+
+  pool_get (fm->fused_chains, chain);
+  memset (chain, 0, sizeof (*chain));
+  chain->sw_if_index = sw_if_index;
+  chain->arc_index = arc_index;
+
+  /* the first feature's data follows the next index to it */
+  pos = ci + 1;
+  for (i = 0; i < n_fused; i++)
+    {
+      vlib_node_t *n;
+
+      f = vec_elt_at_index (cfg->features, i);
+      reg = vnet_feature_reg_by_index (arc_index, f->feature_index);
+      n = vlib_get_node (vm, f->node_index);
+
+      vec_add2 (chain->steps, s, 1);
+      s->function = reg->fused_function;
+      s->flush_function = reg->fused_flush_function;
+      chain->has_flush |= (s->flush_function != 0);
+      s->feature_config = vec_dup (f->feature_config);
+      s->node_index = f->node_index;
+      s->punt_next_index =
+	vlib_node_add_next (vm, fused_node_index, f->node_index);
+      s->punt_config_index = pos;
+
+      vec_validate_init_empty (s->next_by_feature_next,
+			       vec_len (n->next_nodes) - 1, ~0);
+      for (j = 0; j < vec_len (n->next_nodes); j++)
+	if (n->next_nodes[j] != ~0)
+	  s->next_by_feature_next[j] =
+	    vlib_node_add_next (vm, fused_node_index, n->next_nodes[j]);
+
+      pos += vec_len (f->feature_config) + 1;
+    }
+
+  chain_index = chain - fm->fused_chains;
+  chain->config_index =
+    vnet_config_fuse_features (vm, vcm, ci, n_fused, fused_node_index,
+			       &chain_index, sizeof (chain_index));
+  return chain_index;
+}
+
+/**
+ * Start the interface's arc with its features fused, if the arc is fused
+ * and enough of them can be, or with the features themselves otherwise.
+ * Called whenever the interface's features change.
+ */
+void
+vnet_feature_fusion_update (u8 arc_index, u32 sw_if_index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm = &fm->feature_config_mains[arc_index];
+  u32 ci, old_chain_index, chain_index = ~0;
+
+  vec_validate_init_empty (cm->config_index_by_sw_if_index, sw_if_index, ~0);
+  vec_validate_init_empty (cm->feature_config_index_by_sw_if_index,
+			   sw_if_index, ~0);
+  vec_validate_init_empty (cm->fused_chain_index_by_sw_if_index,
+			   sw_if_index, ~0);
+
+  ci = cm->feature_config_index_by_sw_if_index[sw_if_index];
+  old_chain_index = cm->fused_chain_index_by_sw_if_index[sw_if_index];
+
+  if (cm->fusion_enabled && ci != ~0)
+    chain_index =
+      vnet_feature_fused_chain_compile (vm, arc_index, sw_if_index, ci);
+
+  cm->config_index_by_sw_if_index[sw_if_index] =
+    (chain_index != ~0 ?
+     pool_elt_at_index (fm->fused_chains, chain_index)->config_index : ci);
+  cm->fused_chain_index_by_sw_if_index[sw_if_index] = chain_index;
+
+  /* only now nothing starts with the old chain */
+  if (old_chain_index != ~0)
+    vnet_feature_fused_chain_free (pool_elt_at_index (fm->fused_chains,
+						      old_chain_index));
+}
+
+int
+vnet_feature_fusion_enable_disable (u8 arc_index, int enable_disable)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm;
+  u32 sw_if_index;
+
+  if (arc_index == (u8) ~ 0)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  cm = &fm->feature_config_mains[arc_index];
+  cm->fusion_enabled = (enable_disable != 0);
+
+  for (sw_if_index = 0;
+       sw_if_index < vec_len (cm->feature_config_index_by_sw_if_index);
+       sw_if_index++)
+    vnet_feature_fusion_update (arc_index, sw_if_index);
+
+  return 0;
+}
+
+static clib_error_t *
+set_feature_fusion_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error = 0;
+  u8 *arc_name = 0;
+  u8 enable = 1;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "Arc not specified...");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "disable"))
+	enable = 0;
+      else if (!arc_name && unformat (line_input, "%v", &arc_name))
+	;
+      else
+	{
+	  error = unformat_parse_error (line_input);
+	  goto done;
+	}
+    }
+
+  if (!arc_name)
+    {
+      error = clib_error_return (0, "Arc not specified...");
+      goto done;
+    }
+
+  vec_add1 (arc_name, 0);
+  if (vnet_feature_fusion_enable_disable
+      (vnet_get_feature_arc_index ((const char *) arc_name), enable))
+    error = clib_error_return (0, "Unknown arc %s...", arc_name);
+
+done:
+  vec_free (arc_name);
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Run the leading features enabled on each interface of the given arc
+ * in a single "<arc>-fused" node, for the features that support it and
+ * wherever there are at least two of them. The features' own nodes still
+ * see the packets their fused functions hand back.
+ *
+ * @cliexpar
+ * Example:
+ * @cliexcmd{set feature fusion ip4-unicast}
+ * @cliexend
+ * @endparblock
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_feature_fusion_command, static) = {
+  .path = "set feature fusion",
+  .short_help = "set feature fusion <arc_name> [disable]",
+  .function = set_feature_fusion_command_fn,
+};
+/* *INDENT-ON* */
+
+/* A node's clocks and packets since the last "clear runtime", all threads */
+static void
+vnet_feature_fusion_node_stats (u32 node_index, u64 * clocks, u64 * vectors)
+{
+  vlib_node_t *n;
+
+  *clocks = *vectors = 0;
+
+  /* *INDENT-OFF* */
+  foreach_vlib_main (({
+    n = vlib_get_node (this_vlib_main, node_index);
+    vlib_node_sync_stats (this_vlib_main, n);
+    *clocks += n->stats_total.clocks - n->stats_last_clear.clocks;
+    *vectors += n->stats_total.vectors - n->stats_last_clear.vectors;
+  }));
+  /* *INDENT-ON* */
+}
+
+static f64
+vnet_feature_fusion_clocks_per_packet (u32 node_index)
+{
+  u64 clocks, vectors;
+
+  vnet_feature_fusion_node_stats (node_index, &clocks, &vectors);
+  return vectors ? (f64) clocks / vectors : 0.0;
+}
+
+static clib_error_t *
+show_feature_fusion_command_fn (vlib_main_t * vm,
+				unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_arc_registration_t *areg;
+  vnet_feature_fused_chain_t *chain;
+  vnet_feature_fused_step_t *s;
+  u64 clocks, vectors, chain_clocks, chain_vectors;
+
+  areg = fm->next_arc;
+  while (areg)
+    {
+      vnet_feature_config_main_t *cm =
+	&fm->feature_config_mains[areg->feature_arc_index];
+
+      if (cm->fusion_enabled)
+	vlib_cli_output (vm, "%s: fused", areg->arc_name);
+      areg = areg->next;
+    }
+
+  /* Stats scraped with the workers stopped, as "show runtime" does */
+  vlib_worker_thread_barrier_sync (vm);
+
+  /* *INDENT-OFF* */
+  pool_foreach (chain, fm->fused_chains,
+  ({
+    vnet_feature_config_main_t *cm =
+      &fm->feature_config_mains[chain->arc_index];
+
+    vlib_cli_output (vm, "[%d] %U arc %d", chain - fm->fused_chains,
+		     format_vnet_sw_if_index_name, vnm, chain->sw_if_index,
+		     chain->arc_index);
+    /* features past the first only see the packets it passed on */
+    chain_clocks = chain_vectors = 0;
+    vec_foreach (s, chain->steps)
+      {
+        vnet_feature_fusion_node_stats (s->node_index, &clocks, &vectors);
+        chain_clocks += clocks;
+        if (s == chain->steps)
+          chain_vectors = vectors;
+        vlib_cli_output (vm, "  %-32U %10.2f clocks/packet",
+                         format_vlib_node_name, vm, s->node_index,
+                         vectors ? (f64) clocks / vectors : 0.0);
+      }
+    vlib_cli_output (vm, "  %-32s %10.2f clocks/packet", "unfused",
+                     chain_vectors ? (f64) chain_clocks / chain_vectors : 0.0);
+    vlib_cli_output (vm, "  %-32U %10.2f clocks/packet",
+                     format_vlib_node_name, vm, cm->fused_node_index,
+                     vnet_feature_fusion_clocks_per_packet
+                     (cm->fused_node_index));
+  }));
+  /* *INDENT-ON* */
+
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+/*?
+ * Display the arcs whose features are fused and each interface's chain
+ * of fused features. For each chain, the clocks per packet of each of
+ * its features' nodes, the clocks all of them took per packet reaching
+ * the first, and the clocks per packet of the arc's fused node are
+ * taken from the runtime stats. To compare fused
+ * with unfused, clear the runtime stats and run traffic with the arc
+ * unfused, then fuse it and run the same traffic again: the feature
+ * nodes then only see the packets punted to them.
+ *
+ * @cliexpar
+ * Example:
+ * @cliexcmd{show feature fusion}
+ * @cliexend
+ * @endparblock
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_feature_fusion_command, static) = {
+  .path = "show feature fusion",
+  .short_help = "show feature fusion",
+  .function = show_feature_fusion_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
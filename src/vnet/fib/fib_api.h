@@ -43,6 +43,8 @@ add_del_route_t_handler (u8 is_multipath,
                          u8 is_dvr,
                          u8 is_source_lookup,
                          u8 is_udp_encap,
+                         u8 is_resilient,
+                         u8 is_uniform,
 			 u32 fib_index,
 			 const fib_prefix_t * prefix,
 			 dpo_proto_t next_hop_proto,
@@ -59,4 +61,23 @@ void
 copy_fib_next_hop (fib_route_path_encode_t * api_rpath,
 		   void * fp_arg);
 
+/**
+ * The number of entries a (m)FIB dump sends before it yields
+ */
+u32 fib_api_dump_batch_size (void);
+
+/**
+ * Whether a (m)FIB dump should pause before its next message, as the
+ * client's queue is full. The walk function then returns
+ * FIB_TABLE_WALK_PAUSE and the dump yields until the queue drains.
+ */
+int fib_api_dump_should_pause (vl_api_registration_t * reg);
+
+/**
+ * Yield between the batches of a (m)FIB dump, and until the client can
+ * take another message; returns the client's registration, or NULL if
+ * the client went away in the meantime.
+ */
+vl_api_registration_t *fib_api_dump_yield (u32 client_index);
+
 #endif /* __FIB_API_H__ */
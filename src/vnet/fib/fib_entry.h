@@ -217,10 +217,15 @@ typedef enum fib_entry_attribute_t_ {
      * that is covers
      */
     FIB_ENTRY_ATTRIBUTE_COVERED_INHERIT,
+    /**
+     * The entry's load-balance uses resilient hashing; a change in the
+     * set of paths moves only the buckets of the paths removed.
+     */
+    FIB_ENTRY_ATTRIBUTE_RESILIENT,
     /**
      * Marker. add new entries before this one.
      */
-    FIB_ENTRY_ATTRIBUTE_LAST = FIB_ENTRY_ATTRIBUTE_COVERED_INHERIT,
+    FIB_ENTRY_ATTRIBUTE_LAST = FIB_ENTRY_ATTRIBUTE_RESILIENT,
 } fib_entry_attribute_t;
 
 #define FIB_ENTRY_ATTRIBUTES {		       		\
@@ -233,6 +238,7 @@ typedef enum fib_entry_attribute_t_ {
     [FIB_ENTRY_ATTRIBUTE_URPF_EXEMPT] = "uRPF-exempt",  \
     [FIB_ENTRY_ATTRIBUTE_MULTICAST] = "multicast",	\
     [FIB_ENTRY_ATTRIBUTE_COVERED_INHERIT] = "covered-inherit",  \
+    [FIB_ENTRY_ATTRIBUTE_RESILIENT] = "resilient",	\
 }
 
 #define FOR_EACH_FIB_ATTRIBUTE(_item)			\
@@ -251,6 +257,7 @@ typedef enum fib_entry_flag_t_ {
     FIB_ENTRY_FLAG_LOOSE_URPF_EXEMPT = (1 << FIB_ENTRY_ATTRIBUTE_URPF_EXEMPT),
     FIB_ENTRY_FLAG_MULTICAST = (1 << FIB_ENTRY_ATTRIBUTE_MULTICAST),
     FIB_ENTRY_FLAG_COVERED_INHERIT = (1 << FIB_ENTRY_ATTRIBUTE_COVERED_INHERIT),
+    FIB_ENTRY_FLAG_RESILIENT = (1 << FIB_ENTRY_ATTRIBUTE_RESILIENT),
 } __attribute__((packed)) fib_entry_flag_t;
 
 /**
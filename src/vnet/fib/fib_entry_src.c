@@ -187,6 +187,7 @@ typedef struct fib_entry_src_collect_forwarding_ctx_t_
     fib_forward_chain_type_t fct;
     int n_recursive_constrained;
     u16 preference;
+    u16 backup_preference;
 } fib_entry_src_collect_forwarding_ctx_t;
 
 /**
@@ -199,7 +200,16 @@ fib_entry_calc_lb_flags (fib_entry_src_collect_forwarding_ctx_t *ctx)
     /**
      * We'll use a LB map if the path-list has multiple recursive paths.
      * recursive paths implies BGP, and hence scale.
+     * Backup paths are only collected under the same conditions, so if
+     * there are any the map is always used to keep them out of forwarding
+     * until the primaries fail.
+     * Resilient hashing needs the buckets to follow the paths, which
+     * a map would undo, so it takes precedence.
      */
+    if (ctx->esrc->fes_entry_flags & FIB_ENTRY_FLAG_RESILIENT)
+    {
+        return (LOAD_BALANCE_FLAG_RESILIENT);
+    }
     if (ctx->n_recursive_constrained > 1 &&
         fib_path_list_is_popular(ctx->esrc->fes_pl))
     {
@@ -341,6 +351,33 @@ fib_entry_src_get_path_forwarding (fib_node_index_t path_index,
     }
 }
 
+/**
+ * @brief Should this path, from a lower preference than those already
+ * collected, be added as a backup
+ */
+static int
+fib_entry_src_collect_backup (const fib_entry_src_collect_forwarding_ctx_t *ctx,
+                              fib_node_index_t path_index)
+{
+    if (0xffff != ctx->backup_preference)
+    {
+        /*
+         * only one level of backups
+         */
+        return (ctx->backup_preference == fib_path_get_preference(path_index));
+    }
+
+    /*
+     * the backup and at least one primary must be recursive constrained,
+     * (this path is already counted) since it is those paths that trigger
+     * the LB map cutover when they become unresolved.
+     */
+    return (!(ctx->esrc->fes_entry_flags & FIB_ENTRY_FLAG_RESILIENT) &&
+            fib_path_list_is_popular(ctx->esrc->fes_pl) &&
+            fib_path_is_recursive_constrained(path_index) &&
+            ctx->n_recursive_constrained > 1);
+}
+
 static fib_path_list_walk_rc_t
 fib_entry_src_collect_forwarding (fib_node_index_t pl_index,
                                   fib_node_index_t path_index,
@@ -375,9 +412,20 @@ fib_entry_src_collect_forwarding (fib_node_index_t pl_index,
     {
         /*
          * this path does not belong to the same preference as the
-         * previous paths encountered. we are done now.
+         * previous paths encountered. If the entry will use a LB map
+         * then collect the next preference level as pre-computed backups.
+         * the map steers the backup's buckets to the primaries until the
+         * primaries go down, when the map cuts over to the backups - PIC
+         * edge. Otherwise we are done now.
          */
-        return (FIB_PATH_LIST_WALK_STOP);
+        if (fib_entry_src_collect_backup(ctx, path_index))
+        {
+            ctx->backup_preference = fib_path_get_preference(path_index);
+        }
+        else
+        {
+            return (FIB_PATH_LIST_WALK_STOP);
+        }
     }
 
     /*
@@ -451,6 +499,7 @@ fib_entry_src_mk_lb (fib_entry_t *fib_entry,
         .n_recursive_constrained = 0,
         .fct = fct,
         .preference = 0xffff,
+        .backup_preference = 0xffff,
     };
 
     /*
@@ -47,6 +47,13 @@ format_fib_path_ext (u8 * s, va_list * args)
                        format_mpls_unicast_label,
                        path_ext->fpe_path.frp_label_stack[ii]);
         }
+        if (path_ext->fpe_path.frp_flags & FIB_ROUTE_PATH_MPLS_UNIFORM)
+        {
+            /* each label is followed by a space, an empty stack is not */
+            s = format(s, "%suniform",
+                       (vec_len(path_ext->fpe_path.frp_label_stack) ?
+                        "" : " "));
+        }
         break;
     case FIB_PATH_EXT_ADJ: {
         fib_path_ext_adj_attr_t attr;
@@ -248,6 +255,10 @@ fib_path_ext_stack (fib_path_ext_t *path_ext,
             mldi = mpls_label_dpo_create(path_ext->fpe_label_stack,
                                          eos, 255, 0,
                                          chain_proto,
+                                         ((path_ext->fpe_path.frp_flags &
+                                           FIB_ROUTE_PATH_MPLS_UNIFORM) ?
+                                          MPLS_LABEL_DPO_FLAG_UNIFORM_MODE :
+                                          MPLS_LABEL_DPO_FLAG_NONE),
                                          &nh->path_dpo);
 
 	    dpo_set(&nh->path_dpo,
@@ -1185,6 +1185,89 @@ fib_table_walk (u32 fib_index,
     }
 }
 
+static fib_table_walk_rc_t
+fib_table_walk_iter_collect (fib_node_index_t fei,
+                             void *ctx)
+{
+    fib_table_walk_iter_t *iter = ctx;
+
+    fib_entry_lock(fei);
+    vec_add1(iter->ftwi_entries, fei);
+
+    return (FIB_TABLE_WALK_CONTINUE);
+}
+
+void
+fib_table_walk_iter_add (fib_table_walk_iter_t *iter,
+                         u32 fib_index,
+                         fib_protocol_t proto)
+{
+    u32 n_entries;
+
+    n_entries = vec_len(iter->ftwi_entries);
+    fib_table_walk(fib_index, proto, fib_table_walk_iter_collect, iter);
+
+    if (vec_len(iter->ftwi_entries) > n_entries)
+    {
+        qsort(iter->ftwi_entries + n_entries,
+              vec_len(iter->ftwi_entries) - n_entries,
+              sizeof(fib_node_index_t),
+              (void *) fib_entry_cmp_for_sort);
+    }
+}
+
+int
+fib_table_walk_iter_next (fib_table_walk_iter_t *iter,
+                          u32 n_entries,
+                          fib_table_walk_fn_t fn,
+                          void *ctx)
+{
+    fib_node_index_t fei;
+
+    while (n_entries > 0 &&
+           iter->ftwi_pos < vec_len(iter->ftwi_entries))
+    {
+        fei = iter->ftwi_entries[iter->ftwi_pos++];
+
+        /*
+         * an entry with no sources has been removed from its table since
+         * the walk began; only our lock keeps it alive.
+         */
+        if (FIB_SOURCE_MAX == fib_entry_get_best_source(fei))
+            continue;
+
+        switch (fn(fei, ctx))
+        {
+        case FIB_TABLE_WALK_CONTINUE:
+        case FIB_TABLE_WALK_SUB_TREE_STOP:
+            n_entries--;
+            break;
+        case FIB_TABLE_WALK_STOP:
+            iter->ftwi_pos = vec_len(iter->ftwi_entries);
+            break;
+        case FIB_TABLE_WALK_PAUSE:
+            /* visit this entry again on the next call */
+            iter->ftwi_pos--;
+            return (1);
+        }
+    }
+
+    return (iter->ftwi_pos < vec_len(iter->ftwi_entries));
+}
+
+void
+fib_table_walk_iter_done (fib_table_walk_iter_t *iter)
+{
+    fib_node_index_t *fei;
+
+    vec_foreach(fei, iter->ftwi_entries)
+    {
+        fib_entry_unlock(*fei);
+    }
+    vec_free(iter->ftwi_entries);
+    iter->ftwi_pos = 0;
+}
+
 void
 fib_table_sub_tree_walk (u32 fib_index,
                          fib_protocol_t proto,
@@ -809,6 +809,11 @@ typedef enum fib_table_walk_rc_t_
      * Stop the walk completely
      */
     FIB_TABLE_WALK_STOP,
+    /**
+     * Stop the walk before this entry, to be resumed from it. Only a
+     * resumable walk can pause, any other walk stops.
+     */
+    FIB_TABLE_WALK_PAUSE,
 } fib_table_walk_rc_t;
 
 /**
@@ -839,6 +844,52 @@ extern void fib_table_sub_tree_walk(u32 fib_index,
                                     fib_table_walk_fn_t fn,
                                     void *ctx);
 
+/**
+ * @brief State for a resumable walk of one or more FIB tables.
+ * The entries are collected, and locked, when they are added to the walk,
+ * so the table can be modified between the steps of the walk without
+ * invalidating it. Entries removed from the table in the meantime are
+ * skipped.
+ */
+typedef struct fib_table_walk_iter_t_
+{
+    /**
+     * The locked entries to visit
+     */
+    fib_node_index_t *ftwi_entries;
+
+    /**
+     * The position of the next entry to visit
+     */
+    u32 ftwi_pos;
+} fib_table_walk_iter_t;
+
+/**
+ * @brief Add all the entries in a FIB table to a resumable walk. The
+ * table's entries are visited, in prefix order, after those of the tables
+ * added before it. The iterator must be zero initialised before the first
+ * addition.
+ */
+extern void fib_table_walk_iter_add(fib_table_walk_iter_t *iter,
+                                    u32 fib_index,
+                                    fib_protocol_t proto);
+
+/**
+ * @brief Visit at most n_entries of the walk.
+ * If the walk function returns FIB_TABLE_WALK_PAUSE, the walk stops and
+ * the next call starts with the same entry.
+ * Returns non-zero if there are entries left to visit.
+ */
+extern int fib_table_walk_iter_next(fib_table_walk_iter_t *iter,
+                                    u32 n_entries,
+                                    fib_table_walk_fn_t fn,
+                                    void *ctx);
+
+/**
+ * @brief End a resumable walk, releasing the locks on the entries
+ */
+extern void fib_table_walk_iter_done(fib_table_walk_iter_t *iter);
+
 /**
  * @brief format (display) the memory used by the FIB tables
  */
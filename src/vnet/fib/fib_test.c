@@ -307,7 +307,7 @@ fib_test_validate_rep_v (const replicate_t *rep,
                             format_dpo_type, dpo->dpoi_type);
 	    
 		mld = mpls_label_dpo_get(dpo->dpoi_index);
-                hdr = clib_net_to_host_u32(mld->mld_hdr[0].label_exp_s_ttl);
+                hdr = clib_net_to_host_u32(mpls_label_dpo_get_hdr(mld, 0)->label_exp_s_ttl);
 
 		FIB_TEST_LB((vnet_mpls_uc_get_label(hdr) ==
 			     exp->label_o_adj.label),
@@ -391,7 +391,7 @@ fib_test_validate_lb_v (const load_balance_t *lb,
 
 		for (ii = 0; ii < mld->mld_n_labels; ii++)
 		{
-		    hdr = clib_net_to_host_u32(mld->mld_hdr[ii].label_exp_s_ttl);
+		    hdr = clib_net_to_host_u32(mpls_label_dpo_get_hdr(mld, ii)->label_exp_s_ttl);
 		    FIB_TEST_LB((vnet_mpls_uc_get_label(hdr) ==
 				 exp->label_stack_o_adj.label_stack[ii]),
 				"bucket %d stacks on label %d",
@@ -439,7 +439,7 @@ fib_test_validate_lb_v (const load_balance_t *lb,
 			   format_dpo_type, dpo->dpoi_type);
 	    
 		mld = mpls_label_dpo_get(dpo->dpoi_index);
-                hdr = clib_net_to_host_u32(mld->mld_hdr[0].label_exp_s_ttl);
+                hdr = clib_net_to_host_u32(mpls_label_dpo_get_hdr(mld, 0)->label_exp_s_ttl);
 
 		FIB_TEST_LB((vnet_mpls_uc_get_label(hdr) ==
 			     exp->label_o_adj.label),
@@ -476,7 +476,7 @@ fib_test_validate_lb_v (const load_balance_t *lb,
 			   format_dpo_type, dpo->dpoi_type);
 	    
 		mld = mpls_label_dpo_get(dpo->dpoi_index);
-                hdr = clib_net_to_host_u32(mld->mld_hdr[0].label_exp_s_ttl);
+                hdr = clib_net_to_host_u32(mpls_label_dpo_get_hdr(mld, 0)->label_exp_s_ttl);
 
 		FIB_TEST_LB(1 == mld->mld_n_labels, "label stack size",
 			    mld->mld_n_labels);
@@ -7203,6 +7203,48 @@ fib_test_label (void)
 	     "adj 10.10.11.1");
     fib_table_entry_delete_index(fei, FIB_SOURCE_API);
 
+    /*
+     * the same deep label stack imposed in uniform mode
+     */
+    label_stack = NULL;
+    vec_validate(label_stack, 7);
+    for (ii = 0; ii < 8; ii++)
+    {
+	label_stack[ii] = ii + 200;
+    }
+
+    fei = fib_table_entry_update_one_path(fib_index,
+					  &pfx_2_2_5_5_s_32,
+					  FIB_SOURCE_API,
+					  FIB_ENTRY_FLAG_NONE,
+					  DPO_PROTO_IP4,
+					  &nh_10_10_11_1,
+					  tm->hw[1]->sw_if_index,
+					  ~0, // invalid fib index
+					  1,
+					  label_stack,
+					  FIB_ROUTE_PATH_MPLS_UNIFORM);
+
+    FIB_TEST(fib_test_validate_entry(fei,
+				     FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+				     1,
+				     &ls_eos_o_10_10_10_1),
+	     "2.2.5.5/32 uniform LB 1 buckets via: "
+	     "adj 10.10.11.1");
+    {
+        const dpo_id_t *dpo0, *dpo1;
+        const mpls_label_dpo_t *mld;
+
+        dpo0 = fib_entry_contribute_ip_forwarding(fei);
+        dpo1 = load_balance_get_bucket(dpo0->dpoi_index, 0);
+        FIB_TEST((DPO_MPLS_LABEL == dpo1->dpoi_type),
+                 "2.2.5.5/32 via a label DPO");
+        mld = mpls_label_dpo_get(dpo1->dpoi_index);
+        FIB_TEST((mld->mld_flags & MPLS_LABEL_DPO_FLAG_UNIFORM_MODE),
+                 "2.2.5.5/32 label stack imposed in uniform mode");
+    }
+    fib_table_entry_delete_index(fei, FIB_SOURCE_API);
+
     /*
      * cleanup
      */
@@ -9572,6 +9614,688 @@ fib_test_inherit (void)
     return (0);
 }
 
+/*
+ * Load one batch of BGP-like routes; n recursive /32s each via its own
+ * next-hop /32, those next-hops are then added with one path and given
+ * a second, ECMP, path. Each next-hop is thus updated twice whilst its
+ * children are resolved through it.
+ */
+static void
+fib_test_bulk_load (u32 n, u8 defer)
+{
+    test_main_t *tm = &test_main;
+    u32 ii;
+
+    const ip46_address_t nh_10_10_10_1 = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    const ip46_address_t nh_10_10_10_2 = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a02),
+    };
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+    ip46_address_t nh = {
+        .ip4.as_u32 = 0,
+    };
+
+    if (defer)
+        fib_walk_sync_defer_begin();
+
+    for (ii = 0; ii < n; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000 + ii);
+        nh.ip4.as_u32 = clib_host_to_net_u32(0x1e000000 + ii);
+
+        fib_table_entry_path_add(0, &pfx,
+                                 FIB_SOURCE_API,
+                                 FIB_ENTRY_FLAG_NONE,
+                                 DPO_PROTO_IP4,
+                                 &nh,
+                                 ~0, 0, 1,
+                                 NULL,
+                                 FIB_ROUTE_PATH_FLAG_NONE);
+    }
+    for (ii = 0; ii < n; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x1e000000 + ii);
+
+        fib_table_entry_path_add(0, &pfx,
+                                 FIB_SOURCE_API,
+                                 FIB_ENTRY_FLAG_NONE,
+                                 DPO_PROTO_IP4,
+                                 &nh_10_10_10_1,
+                                 tm->hw[0]->sw_if_index,
+                                 ~0, 1,
+                                 NULL,
+                                 FIB_ROUTE_PATH_FLAG_NONE);
+        fib_table_entry_path_add(0, &pfx,
+                                 FIB_SOURCE_API,
+                                 FIB_ENTRY_FLAG_NONE,
+                                 DPO_PROTO_IP4,
+                                 &nh_10_10_10_2,
+                                 tm->hw[0]->sw_if_index,
+                                 ~0, 1,
+                                 NULL,
+                                 FIB_ROUTE_PATH_FLAG_NONE);
+    }
+
+    if (defer)
+        fib_walk_sync_defer_end();
+}
+
+/*
+ * Withdraw the next-hops first, so the children re-resolve, then the routes
+ */
+static void
+fib_test_bulk_withdraw (u32 n, u8 defer)
+{
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+    u32 ii;
+
+    if (defer)
+        fib_walk_sync_defer_begin();
+
+    for (ii = 0; ii < n; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x1e000000 + ii);
+        fib_table_entry_delete(0, &pfx, FIB_SOURCE_API);
+    }
+    for (ii = 0; ii < n; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000 + ii);
+        fib_table_entry_delete(0, &pfx, FIB_SOURCE_API);
+    }
+
+    if (defer)
+        fib_walk_sync_defer_end();
+}
+
+/*
+ * Full-table load and withdrawal times, with and without the
+ * back-walks deferred to the end of the batch.
+ */
+static int
+fib_test_bulk (vlib_main_t * vm, u32 n)
+{
+    const load_balance_t *lb;
+    fib_node_index_t fei;
+    f64 t[3];
+    int n_feis;
+    u8 defer;
+
+    n_feis = fib_entry_pool_size();
+
+    const fib_prefix_t pfx_20_0_0_0_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x14000000),
+        },
+    };
+    const fib_prefix_t pfx_30_0_0_0_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x1e000000),
+        },
+    };
+
+    for (defer = 0; defer < 2; defer++)
+    {
+        t[0] = vlib_time_now(vm);
+        fib_test_bulk_load(n, defer);
+        t[1] = vlib_time_now(vm);
+
+        /*
+         * the children must be resolved on return, deferred or not
+         */
+        fei = fib_table_lookup_exact_match(0, &pfx_30_0_0_0_s_32);
+        lb = load_balance_get(fib_entry_contribute_ip_forwarding(fei)->dpoi_index);
+        FIB_TEST((2 == lb->lb_n_buckets),
+                 "%U is ECMP", format_fib_prefix, &pfx_30_0_0_0_s_32);
+        fei = fib_table_lookup_exact_match(0, &pfx_20_0_0_0_s_32);
+        FIB_TEST(!load_balance_is_drop(fib_entry_contribute_ip_forwarding(fei)),
+                 "%U resolved", format_fib_prefix, &pfx_20_0_0_0_s_32);
+
+        fib_test_bulk_withdraw(n, defer);
+        t[2] = vlib_time_now(vm);
+
+        vlib_cli_output(vm, "%s: %d routes load %.6fs (%.6e routes/sec), "
+                        "withdraw %.6fs (%.6e routes/sec)",
+                        (defer ? "deferred walks" : "sync walks"), 2 * n,
+                        t[1] - t[0], (2 * n) / (t[1] - t[0]),
+                        t[2] - t[1], (2 * n) / (t[2] - t[1]));
+
+        FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+    }
+
+    FIB_TEST(0 == adj_nbr_db_size(), "All adjacencies removed");
+
+    return (0);
+}
+
+/*
+ * PIC edge with pre-computed backups.
+ * n BGP prefixes recurse via a primary next-hop, with a lower preference
+ * backup next-hop. When the primary fails the data-plane must cut over to
+ * the backup by updating only the shared LB map, before any per-prefix
+ * back-walk has run.
+ */
+static int
+fib_test_pic (vlib_main_t * vm, u32 n)
+{
+    const dpo_id_t *dpo_primary, *dpo_backup;
+    fib_node_index_t fei, *feis;
+    const load_balance_t *lb;
+    test_main_t *tm;
+    index_t *lbis;
+    u32 ii, jj;
+    int n_feis;
+    f64 t[4];
+
+    tm = &test_main;
+    feis = NULL;
+    lbis = NULL;
+    n_feis = fib_entry_pool_size();
+
+    const ip46_address_t nh_10_10_10_1 = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    const ip46_address_t nh_10_10_10_2 = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a02),
+    };
+    const fib_prefix_t pfx_1_1_1_1_s_32 = {
+	.fp_len = 32,
+	.fp_proto = FIB_PROTOCOL_IP4,
+	.fp_addr = {
+	    .ip4.as_u32 = clib_host_to_net_u32(0x01010101),
+	},
+    };
+    const fib_prefix_t pfx_1_1_1_2_s_32 = {
+	.fp_len = 32,
+	.fp_proto = FIB_PROTOCOL_IP4,
+	.fp_addr = {
+	    .ip4.as_u32 = clib_host_to_net_u32(0x01010102),
+	},
+    };
+    fib_route_path_t path_primary = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_addr = pfx_1_1_1_1_s_32.fp_addr,
+        .frp_sw_if_index = ~0,
+        .frp_fib_index = 0,
+        .frp_weight = 1,
+        .frp_preference = 0,
+        .frp_flags = FIB_ROUTE_PATH_RESOLVE_VIA_HOST,
+    };
+    fib_route_path_t path_backup = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_addr = pfx_1_1_1_2_s_32.fp_addr,
+        .frp_sw_if_index = ~0,
+        .frp_fib_index = 0,
+        .frp_weight = 1,
+        .frp_preference = 1,
+        .frp_flags = FIB_ROUTE_PATH_RESOLVE_VIA_HOST,
+    };
+    fib_route_path_t *paths = NULL;
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+
+    vec_add1(paths, path_primary);
+    vec_add1(paths, path_backup);
+
+    /*
+     * the BGP next-hops, resolved via the IGP
+     */
+    fib_table_entry_path_add(0, &pfx_1_1_1_1_s_32,
+                             FIB_SOURCE_API,
+                             FIB_ENTRY_FLAG_NONE,
+                             DPO_PROTO_IP4,
+                             &nh_10_10_10_1,
+                             tm->hw[0]->sw_if_index,
+                             ~0, 1,
+                             NULL,
+                             FIB_ROUTE_PATH_FLAG_NONE);
+    fib_table_entry_path_add(0, &pfx_1_1_1_2_s_32,
+                             FIB_SOURCE_API,
+                             FIB_ENTRY_FLAG_NONE,
+                             DPO_PROTO_IP4,
+                             &nh_10_10_10_2,
+                             tm->hw[0]->sw_if_index,
+                             ~0, 1,
+                             NULL,
+                             FIB_ROUTE_PATH_FLAG_NONE);
+
+    /*
+     * the BGP prefixes; enough to make the path-list popular
+     */
+    for (ii = 0; ii < n; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x4e000000 + ii);
+        vec_add1(feis, fib_table_entry_path_add2(0, &pfx,
+                                                 FIB_SOURCE_API,
+                                                 FIB_ENTRY_FLAG_NONE,
+                                                 paths));
+    }
+
+    fei = fib_table_lookup_exact_match(0, &pfx_1_1_1_1_s_32);
+    dpo_primary = fib_entry_contribute_ip_forwarding(fei);
+    fei = fib_table_lookup_exact_match(0, &pfx_1_1_1_2_s_32);
+    dpo_backup = fib_entry_contribute_ip_forwarding(fei);
+
+    /*
+     * each prefix's LB contains the backup, but the map steers all its
+     * buckets to the primary
+     */
+    for (ii = 0; ii < n; ii++)
+    {
+        lb = load_balance_get(fib_entry_contribute_ip_forwarding(feis[ii])->dpoi_index);
+        vec_add1(lbis, lb - load_balance_pool);
+
+        FIB_TEST((INDEX_INVALID != lb->lb_map),
+                 "prefix %d uses a LB map", ii);
+        FIB_TEST((2 == lb->lb_n_buckets),
+                 "prefix %d has primary and backup buckets", ii);
+        for (jj = 0; jj < lb->lb_n_buckets; jj++)
+        {
+            FIB_TEST(!dpo_cmp(dpo_primary, load_balance_get_fwd_bucket(lb, jj)),
+                     "prefix %d bucket %d forwards via primary", ii, jj);
+        }
+    }
+    FIB_TEST((1 == pool_elts(load_balance_map_pool)),
+             "one shared LB map");
+
+    /*
+     * fail the primary. The back-walk to the popular path-list is async, so
+     * it has not run when the withdraw returns, yet the data-plane must have
+     * cut over to the backup in the same, unmodified, load-balances.
+     */
+    t[0] = vlib_time_now(vm);
+    fib_table_entry_path_remove(0, &pfx_1_1_1_1_s_32,
+                                FIB_SOURCE_API,
+                                DPO_PROTO_IP4,
+                                &nh_10_10_10_1,
+                                tm->hw[0]->sw_if_index,
+                                ~0, 1,
+                                FIB_ROUTE_PATH_FLAG_NONE);
+    t[1] = vlib_time_now(vm);
+
+    for (ii = 0; ii < n; ii++)
+    {
+        FIB_TEST((lbis[ii] ==
+                  fib_entry_contribute_ip_forwarding(feis[ii])->dpoi_index),
+                 "prefix %d LB unchanged", ii);
+        lb = load_balance_get(lbis[ii]);
+        for (jj = 0; jj < lb->lb_n_buckets; jj++)
+        {
+            FIB_TEST(!dpo_cmp(dpo_backup, load_balance_get_fwd_bucket(lb, jj)),
+                     "post PIC prefix %d bucket %d forwards via backup", ii, jj);
+        }
+    }
+
+    /*
+     * let the per-prefix walk complete, the prefixes then use only the backup
+     */
+    t[2] = vlib_time_now(vm);
+    while (0 != fib_walk_queue_get_size(FIB_WALK_PRIORITY_LOW))
+        fib_walk_process_queues(vm, 1);
+    t[3] = vlib_time_now(vm);
+
+    for (ii = 0; ii < n; ii++)
+    {
+        lb = load_balance_get(fib_entry_contribute_ip_forwarding(feis[ii])->dpoi_index);
+        for (jj = 0; jj < lb->lb_n_buckets; jj++)
+        {
+            FIB_TEST(!dpo_cmp(dpo_backup, load_balance_get_fwd_bucket(lb, jj)),
+                     "post walk prefix %d bucket %d forwards via backup", ii, jj);
+        }
+    }
+
+    vlib_cli_output(vm, "PIC edge: %d prefixes, cut-over %.3fus, "
+                    "per-prefix convergence %.3fus",
+                    n, (t[1] - t[0]) * 1e6, (t[3] - t[2]) * 1e6);
+
+    /*
+     * restore the primary. prefixes return to it with the backup in reserve
+     */
+    fib_table_entry_path_add(0, &pfx_1_1_1_1_s_32,
+                             FIB_SOURCE_API,
+                             FIB_ENTRY_FLAG_NONE,
+                             DPO_PROTO_IP4,
+                             &nh_10_10_10_1,
+                             tm->hw[0]->sw_if_index,
+                             ~0, 1,
+                             NULL,
+                             FIB_ROUTE_PATH_FLAG_NONE);
+    while (0 != fib_walk_queue_get_size(FIB_WALK_PRIORITY_LOW))
+        fib_walk_process_queues(vm, 1);
+
+    fei = fib_table_lookup_exact_match(0, &pfx_1_1_1_1_s_32);
+    dpo_primary = fib_entry_contribute_ip_forwarding(fei);
+
+    for (ii = 0; ii < n; ii++)
+    {
+        lb = load_balance_get(fib_entry_contribute_ip_forwarding(feis[ii])->dpoi_index);
+        FIB_TEST((INDEX_INVALID != lb->lb_map),
+                 "post restore prefix %d uses a LB map", ii);
+        for (jj = 0; jj < lb->lb_n_buckets; jj++)
+        {
+            FIB_TEST(!dpo_cmp(dpo_primary, load_balance_get_fwd_bucket(lb, jj)),
+                     "post restore prefix %d bucket %d forwards via primary",
+                     ii, jj);
+        }
+    }
+
+    /*
+     * cleanup
+     */
+    for (ii = 0; ii < n; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x4e000000 + ii);
+        fib_table_entry_delete(0, &pfx, FIB_SOURCE_API);
+    }
+    fib_table_entry_delete(0, &pfx_1_1_1_1_s_32, FIB_SOURCE_API);
+    fib_table_entry_delete(0, &pfx_1_1_1_2_s_32, FIB_SOURCE_API);
+
+    vec_free(paths);
+    vec_free(feis);
+    vec_free(lbis);
+
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+    FIB_TEST((0 == pool_elts(load_balance_map_pool)), "LB-map pool size is %d",
+    	     pool_elts(load_balance_map_pool));
+    FIB_TEST(0 == adj_nbr_db_size(), "All adjacencies removed");
+
+    return (0);
+}
+
+/*
+ * Test resilient hashing: when a path of a resilient ECMP entry is
+ * removed only the buckets that used it are re-assigned, and when the
+ * path returns only the share it is owed moves back.
+ */
+static int
+fib_test_resilient (void)
+{
+    test_main_t *tm = &test_main;
+    fib_node_index_t fei, ai[3];
+    fib_route_path_t *paths, rpath[3];
+    index_t before[LB_RESILIENT_MIN_BUCKETS];
+    const load_balance_t *lb;
+    const dpo_id_t *dpo;
+    u32 n_feis, ii, n_moved, n_on_2;
+    index_t lbi;
+
+    const fib_prefix_t pfx_7_7_7_7_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x07070707),
+        },
+    };
+
+    n_feis = fib_entry_pool_size();
+    paths = NULL;
+
+    for (ii = 0; ii < 3; ii++)
+    {
+        ip46_address_t nh = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01 + ii),
+        };
+
+        memset(&rpath[ii], 0, sizeof(rpath[ii]));
+        rpath[ii].frp_proto = DPO_PROTO_IP4;
+        rpath[ii].frp_sw_if_index = tm->hw[0]->sw_if_index;
+        rpath[ii].frp_fib_index = ~0;
+        rpath[ii].frp_weight = 1;
+        rpath[ii].frp_addr = nh;
+        vec_add1(paths, rpath[ii]);
+
+        ai[ii] = adj_nbr_add_or_lock(FIB_PROTOCOL_IP4, VNET_LINK_IP4,
+                                     &nh, tm->hw[0]->sw_if_index);
+    }
+
+    fei = fib_table_entry_path_add2(0, &pfx_7_7_7_7_s_32,
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_RESILIENT,
+                                    paths);
+    vec_free(paths);
+
+    dpo = fib_entry_contribute_ip_forwarding(fei);
+    lbi = dpo->dpoi_index;
+    lb = load_balance_get(lbi);
+    FIB_TEST((LB_RESILIENT_MIN_BUCKETS == lb->lb_n_buckets),
+             "resilient LB has %d buckets", lb->lb_n_buckets);
+    FIB_TEST((INDEX_INVALID == lb->lb_map), "resilient LB has no map");
+
+    for (ii = 0; ii < LB_RESILIENT_MIN_BUCKETS; ii++)
+    {
+        before[ii] = load_balance_get_bucket_i(lb, ii)->dpoi_index;
+    }
+
+    /*
+     * withdraw the second path. buckets on the survivors must not move.
+     */
+    paths = NULL;
+    vec_add1(paths, rpath[1]);
+    fib_table_entry_path_remove2(0, &pfx_7_7_7_7_s_32,
+                                 FIB_SOURCE_API, paths);
+    vec_free(paths);
+
+    dpo = fib_entry_contribute_ip_forwarding(fei);
+    FIB_TEST((lbi == dpo->dpoi_index), "same LB after path remove");
+    lb = load_balance_get(lbi);
+    FIB_TEST((LB_RESILIENT_MIN_BUCKETS == lb->lb_n_buckets),
+             "resilient LB has %d buckets", lb->lb_n_buckets);
+
+    for (ii = 0; ii < LB_RESILIENT_MIN_BUCKETS; ii++)
+    {
+        index_t now = load_balance_get_bucket_i(lb, ii)->dpoi_index;
+
+        FIB_TEST((now == ai[0] || now == ai[2]),
+                 "bucket %d uses a surviving path", ii);
+        if (before[ii] != ai[1])
+        {
+            FIB_TEST((now == before[ii]),
+                     "bucket %d is unchanged after path remove", ii);
+        }
+        before[ii] = now;
+    }
+
+    /*
+     * restore it. only buckets that move to the restored path change.
+     */
+    paths = NULL;
+    vec_add1(paths, rpath[1]);
+    fib_table_entry_path_add2(0, &pfx_7_7_7_7_s_32,
+                              FIB_SOURCE_API,
+                              FIB_ENTRY_FLAG_RESILIENT,
+                              paths);
+    vec_free(paths);
+
+    lb = load_balance_get(lbi);
+    n_moved = n_on_2 = 0;
+
+    for (ii = 0; ii < LB_RESILIENT_MIN_BUCKETS; ii++)
+    {
+        index_t now = load_balance_get_bucket_i(lb, ii)->dpoi_index;
+
+        if (now != before[ii])
+        {
+            n_moved++;
+            FIB_TEST((now == ai[1]),
+                     "bucket %d moved only to the restored path", ii);
+        }
+        if (now == ai[1])
+        {
+            n_on_2++;
+        }
+    }
+    FIB_TEST((0 != n_on_2), "restored path has %d buckets", n_on_2);
+    FIB_TEST((n_moved == n_on_2), "%d buckets moved, %d on restored path",
+             n_moved, n_on_2);
+
+    /*
+     * cleanup
+     */
+    fib_table_entry_delete(0, &pfx_7_7_7_7_s_32, FIB_SOURCE_API);
+
+    for (ii = 0; ii < 3; ii++)
+    {
+        adj_unlock(ai[ii]);
+    }
+
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+    FIB_TEST(0 == adj_nbr_db_size(), "All adjacencies removed");
+
+    return (0);
+}
+
+static fib_table_walk_rc_t
+fib_test_table_iter_count (fib_node_index_t fei,
+                           void *ctx)
+{
+    u32 *n_visited = ctx;
+
+    (*n_visited)++;
+
+    return (FIB_TABLE_WALK_CONTINUE);
+}
+
+typedef struct fib_test_table_iter_pause_ctx_t_
+{
+    fib_node_index_t *visited;
+    int pause;
+} fib_test_table_iter_pause_ctx_t;
+
+/*
+ * pause before every other entry, as a dump does when the client's
+ * queue is full
+ */
+static fib_table_walk_rc_t
+fib_test_table_iter_pause (fib_node_index_t fei,
+                           void *arg)
+{
+    fib_test_table_iter_pause_ctx_t *ctx = arg;
+
+    ctx->pause = !ctx->pause;
+    if (ctx->pause)
+        return (FIB_TABLE_WALK_PAUSE);
+
+    vec_add1(ctx->visited, fei);
+
+    return (FIB_TABLE_WALK_CONTINUE);
+}
+
+/*
+ * Test the resumable table walk: entries removed from the table
+ * between the steps of the walk are skipped, and are only freed once
+ * the walk completes. A paused walk resumes from the entry it paused on.
+ */
+static int
+fib_test_table_iter (void)
+{
+    fib_table_walk_iter_t iter = {
+        .ftwi_entries = NULL,
+    };
+    u32 n_feis, n_entries, n_visited, fib_index, ii;
+    int more;
+
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+
+    n_feis = fib_entry_pool_size();
+    fib_index = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP4, 20,
+                                                  FIB_SOURCE_API);
+
+    for (ii = 1; ii <= 3; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x08080800 + ii);
+        fib_table_entry_special_add(fib_index, &pfx,
+                                    FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_DROP);
+    }
+
+    fib_table_walk_iter_add(&iter, fib_index, FIB_PROTOCOL_IP4);
+    n_entries = vec_len(iter.ftwi_entries);
+    FIB_TEST((n_entries > 3), "walk collected %d entries", n_entries);
+
+    n_visited = 0;
+    more = fib_table_walk_iter_next(&iter, 1,
+                                    fib_test_table_iter_count,
+                                    &n_visited);
+    FIB_TEST((more && 1 == n_visited), "first step visits 1 entry");
+
+    /*
+     * remove 8.8.8.2/32 mid-walk. the walk's lock keeps it alive
+     */
+    pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x08080802);
+    fib_table_entry_special_remove(fib_index, &pfx, FIB_SOURCE_API);
+    FIB_TEST((FIB_NODE_INDEX_INVALID ==
+              fib_table_lookup_exact_match(fib_index, &pfx)),
+             "8.8.8.2/32 removed");
+    FIB_TEST((n_feis + n_entries == fib_entry_pool_size()),
+             "8.8.8.2/32 held by the walk");
+
+    while (fib_table_walk_iter_next(&iter, 1,
+                                    fib_test_table_iter_count,
+                                    &n_visited))
+        ;
+    FIB_TEST((n_entries - 1 == n_visited),
+             "walk visited %d of %d entries", n_visited, n_entries);
+
+    fib_table_walk_iter_done(&iter);
+    FIB_TEST((n_feis + n_entries - 1 == fib_entry_pool_size()),
+             "8.8.8.2/32 freed when the walk is done");
+
+    /*
+     * a walk that pauses visits every entry once, in order
+     */
+    fib_test_table_iter_pause_ctx_t pctx = {
+        .visited = NULL,
+    };
+    u32 n_steps = 0;
+
+    fib_table_walk_iter_add(&iter, fib_index, FIB_PROTOCOL_IP4);
+    n_entries = vec_len(iter.ftwi_entries);
+
+    while (fib_table_walk_iter_next(&iter, 2,
+                                    fib_test_table_iter_pause,
+                                    &pctx))
+        n_steps++;
+
+    FIB_TEST((n_entries == vec_len(pctx.visited)),
+             "paused walk visited %d of %d entries",
+             vec_len(pctx.visited), n_entries);
+    FIB_TEST((n_steps >= n_entries), "paused walk took %d steps", n_steps);
+    for (ii = 0; ii < vec_len(pctx.visited); ii++)
+    {
+        FIB_TEST((iter.ftwi_entries[ii] == pctx.visited[ii]),
+                 "paused walk visits entry %d in order", ii);
+    }
+    vec_free(pctx.visited);
+    fib_table_walk_iter_done(&iter);
+
+    for (ii = 1; ii <= 3; ii += 2)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x08080800 + ii);
+        fib_table_entry_special_remove(fib_index, &pfx, FIB_SOURCE_API);
+    }
+    fib_table_unlock(fib_index, FIB_PROTOCOL_IP4, FIB_SOURCE_API);
+
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+
+    return (0);
+}
+
 static clib_error_t *
 fib_test (vlib_main_t * vm, 
 	  unformat_input_t * input,
@@ -9620,6 +10344,28 @@ fib_test (vlib_main_t * vm,
     {
 	res += fib_test_inherit();
     }
+    else if (unformat (input, "pic"))
+    {
+        u32 n = 1024;
+
+        unformat (input, "count %d", &n);
+        res += fib_test_pic(vm, n);
+    }
+    else if (unformat (input, "resilient"))
+    {
+        res += fib_test_resilient();
+    }
+    else if (unformat (input, "iter"))
+    {
+        res += fib_test_table_iter();
+    }
+    else if (unformat (input, "bulk"))
+    {
+        u32 n = 10000;
+
+        unformat (input, "count %d", &n);
+        res += fib_test_bulk(vm, n);
+    }
     else
     {
 	res += fib_test_v4();
@@ -9629,6 +10375,10 @@ fib_test (vlib_main_t * vm,
 	res += fib_test_pref();
 	res += fib_test_label();
         res += fib_test_inherit();
+        res += fib_test_pic(vm, 128);
+        res += fib_test_resilient();
+        res += fib_test_table_iter();
+        res += fib_test_bulk(vm, 1000);
 	res += lfib_test();
 
         /*
@@ -478,6 +478,10 @@ unformat_fib_route_path (unformat_input_t * input, va_list * args)
                 vec_add1(rpath->frp_label_stack, out_label);
             }
         }
+        else if (unformat (input, "uniform"))
+        {
+            rpath->frp_flags |= FIB_ROUTE_PATH_MPLS_UNIFORM;
+        }
         else if (unformat (input, "%U",
                            unformat_vnet_sw_interface, vnm,
                            &rpath->frp_sw_if_index))
@@ -348,6 +348,11 @@ typedef enum fib_route_path_flags_t_
      * A path that resolves via a DVR DPO
      */
     FIB_ROUTE_PATH_DVR = (1 << 14),
+    /**
+     * Impose the path's out-labels in uniform mode, i.e. all labels
+     * take the TTL and EXP of the payload
+     */
+    FIB_ROUTE_PATH_MPLS_UNIFORM = (1 << 15),
 } fib_route_path_flags_t;
 
 /**
@@ -481,7 +486,7 @@ extern uword unformat_fib_route_path(unformat_input_t * input, va_list * args);
 /**
  * A help string to list the FIB path options
  */
-#define FIB_ROUTE_PATH_HELP "[next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value>]"
+#define FIB_ROUTE_PATH_HELP "[next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value> [uniform]]"
 
 /**
  * @brief 
@@ -158,6 +158,18 @@ static fib_walk_queues_t fib_walk_queues;
  */
 static const char * const fib_walk_priority_names[] = FIB_WALK_PRIORITIES;
 
+/**
+ * @brief Nesting depth of fib_walk_sync_defer_begin() calls.
+ * While non-zero, synchronous walks are queued as high priority async walks
+ * so that walks on the same parent across a batch of updates merge.
+ */
+static u32 fib_walk_sync_defer_depth;
+
+/**
+ * The number of sync walks that have been deferred
+ */
+static u64 fib_walk_n_sync_deferred;
+
 /**
  * @brief Histogram stats on the lenths of each walk in elemenets visisted.
  * Store upto 1<<23 elements in increments of 1<<10
@@ -732,6 +744,17 @@ fib_walk_sync (fib_node_type_t parent_type,
     fib_node_index_t fwi;
     fib_walk_t *fwalk;
 
+    if (0 != fib_walk_sync_defer_depth &&
+        !(ctx->fnbw_flags & FIB_NODE_BW_FLAG_FORCE_SYNC))
+    {
+        /*
+         * a batch of updates is in progress. queue the walk, it will merge
+         * with any others on the same parent and is run once the batch ends.
+         */
+        fib_walk_n_sync_deferred++;
+        return (fib_walk_async(parent_type, parent_index,
+                               FIB_WALK_PRIORITY_HIGH, ctx));
+    }
     if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
     {
 	/*
@@ -831,6 +854,50 @@ fib_walk_sync (fib_node_type_t parent_type,
     }
 }
 
+void
+fib_walk_sync_defer_begin (void)
+{
+    fib_walk_sync_defer_depth++;
+}
+
+void
+fib_walk_sync_defer_end (void)
+{
+    fib_walk_priority_t prio;
+    fib_walk_advance_rc_t rc;
+    fib_node_index_t fwi;
+    fib_walk_t *fwalk;
+
+    ASSERT(0 != fib_walk_sync_defer_depth);
+
+    if (0 != --fib_walk_sync_defer_depth)
+        return;
+
+    /*
+     * The batch is complete. Run all the walks it queued to completion now,
+     * the client expects the children to be up to date on return, as they
+     * would have been had the walks been synchronous.
+     * Walks spawned whilst draining are synchronous again, though children
+     * that choose async walks still queue them at high priority, hence loop.
+     */
+    prio = FIB_WALK_PRIORITY_HIGH;
+
+    while (0 != fib_walk_queue_get_size(prio))
+    {
+        fwi = fib_walk_queue_get_front(prio);
+        fwalk = fib_walk_get(fwi);
+        fwalk->fw_flags |= FIB_WALK_FLAG_EXECUTING;
+
+        do
+        {
+            rc = fib_walk_advance(fwi);
+        } while (FIB_WALK_ADVANCE_MORE == rc);
+
+        fib_walk_destroy(fwi);
+        fib_walk_queues.fwqs_queues[prio].fwq_stats[FIB_WALK_COMPLETED]++;
+    }
+}
+
 static fib_node_t *
 fib_walk_get_node (fib_node_index_t index)
 {
@@ -956,6 +1023,7 @@ fib_walk_show (vlib_main_t * vm,
 
 #define USEC 1000000
     vlib_cli_output(vm, "FIB Walk Quota = %.2fusec:", quota * USEC);
+    vlib_cli_output(vm, "FIB Walk sync deferred:%lld", fib_walk_n_sync_deferred);
     vlib_cli_output(vm, "FIB Walk queues:");
 
     FOR_EACH_FIB_WALK_PRIORITY(prio)
@@ -1150,6 +1218,7 @@ fib_walk_clear (vlib_main_t * vm,
     memset(fib_walk_work_time_taken, 0, sizeof(fib_walk_work_time_taken));
     memset(fib_walk_work_nodes_visited, 0, sizeof(fib_walk_work_nodes_visited));
     memset(fib_walk_sleep_lengths, 0, sizeof(fib_walk_sleep_lengths));
+    fib_walk_n_sync_deferred = 0;
 
     return (NULL);
 }
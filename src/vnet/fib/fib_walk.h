@@ -52,6 +52,21 @@ extern void fib_walk_sync(fib_node_type_t parent_type,
                           fib_node_index_t parent_index,
                           fib_node_back_walk_ctx_t *ctx);
 
+/**
+ * @brief Start a batch of FIB updates.
+ * Until the matching fib_walk_sync_defer_end(), synchronous walks (that are
+ * not forced sync) are queued as high priority async walks. Walks queued on
+ * the same parent merge, so each child is visited, and e.g. its load-balance
+ * rebuilt, once per batch rather than once per update. Calls nest.
+ */
+extern void fib_walk_sync_defer_begin(void);
+
+/**
+ * @brief End a batch of FIB updates. When the outermost batch ends the
+ * deferred walks are run to completion before returning.
+ */
+extern void fib_walk_sync_defer_end(void);
+
 extern u8* format_fib_walk_priority(u8 *s, va_list *ap);
 
 extern void fib_walk_process_enable(void);
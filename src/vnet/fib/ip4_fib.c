@@ -383,6 +383,17 @@ ip4_fib_table_fwding_dpo_update (ip4_fib_t *fib,
 				 u32 len,
 				 const dpo_id_t *dpo)
 {
+    /*
+     * tables start with a small mtrie root, give them the fast one once
+     * they're big enough that its memory is not a concern.
+     */
+    if (!ip4_mtrie_is_promoted(&fib->mtrie) &&
+        (fib_table_get(fib->index, FIB_PROTOCOL_IP4)->ft_total_route_counts >=
+         ip4_main.mtrie_root_16_threshold))
+    {
+        ip4_mtrie_promote(&fib->mtrie);
+    }
+
     ip4_fib_mtrie_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
 }
 
@@ -496,6 +507,7 @@ ip4_fib_table_sub_tree_walk (ip4_fib_t *fib,
                             break;
                         }
                         case FIB_TABLE_WALK_STOP:
+                        case FIB_TABLE_WALK_PAUSE:
                             goto done;
                         }
                     }
@@ -690,6 +702,11 @@ ip4_show_fib (vlib_main_t * vm,
         }
 	if (! verbose)
 	{
+	    vlib_cli_output (vm, "  mtrie: %s root, %U",
+                             (ip4_mtrie_is_promoted(&fib->mtrie) ?
+                              "16 bit" : "8 bit"),
+                             format_memory_size,
+                             ip4_fib_mtrie_memory_usage(&fib->mtrie));
 	    vlib_cli_output (vm, "%=20s%=16s", "Prefix length", "Count");
 	    for (i = 0; i < ARRAY_LEN (fib->fib_entry_by_dst_address); i++)
 	    {
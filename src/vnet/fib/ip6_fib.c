@@ -77,6 +77,11 @@ create_fib_with_table_id (u32 table_id,
 	    table_id;
     fib_table->ft_flow_hash_config = IP_FLOW_HASH_DEFAULT;
 
+    if (ip6_main.mtrie_by_default)
+    {
+	v6_fib->mtrie = ip6_mtrie_alloc();
+    }
+
     vnet_ip6_fib_init(fib_table->ft_index);
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP6, src);
 
@@ -193,6 +198,7 @@ ip6_fib_table_destroy (u32 fib_index)
     {
 	hash_unset (ip6_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
+    ip6_fib_table_set_mtrie(fib_table->ft_index, 0);
     pool_put_index(ip6_main.v6_fibs, fib_table->ft_index);
     pool_put(ip6_main.fibs, fib_table);
 }
@@ -365,6 +371,107 @@ ip6_fib_table_get_index_for_sw_if_index (u32 sw_if_index)
     return (ip6_main.fib_index_by_sw_if_index[sw_if_index]);
 }
 
+/*
+ * The longest prefix in the forwarding table strictly shorter than len
+ * that covers addr. Returns the LB index and sets the cover's length.
+ */
+static index_t
+ip6_fib_table_fwding_cover (u32 fib_index,
+                            const ip6_address_t *addr,
+                            u32 len,
+                            u32 *cover_len)
+{
+    ip6_fib_table_instance_t *table;
+    BVT(clib_bihash_kv) kv, value;
+    int i, n_p;
+    u64 fib;
+
+    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
+    n_p = vec_len (table->prefix_lengths_in_search_order);
+    fib = ((u64)((fib_index))<<32);
+
+    for (i = 0; i < n_p; i++)
+    {
+	int dst_address_length = table->prefix_lengths_in_search_order[i];
+	ip6_address_t * mask = &ip6_main.fib_masks[dst_address_length];
+
+	if (dst_address_length >= len)
+	    continue;
+
+	kv.key[0] = addr->as_u64[0] & mask->as_u64[0];
+	kv.key[1] = addr->as_u64[1] & mask->as_u64[1];
+	kv.key[2] = fib | dst_address_length;
+
+	if (0 == BV(clib_bihash_search_inline_2)(&table->ip6_hash, &kv, &value))
+	{
+	    *cover_len = dst_address_length;
+	    return (value.value);
+	}
+    }
+
+    /* only the default route itself has no cover */
+    *cover_len = 0;
+    return (0);
+}
+
+typedef struct ip6_fib_mtrie_build_ctx_t_
+{
+    u32 fib_index;
+    ip6_fib_mtrie_t *mtrie;
+} ip6_fib_mtrie_build_ctx_t;
+
+static void
+ip6_fib_mtrie_build_cb (BVT(clib_bihash_kv) * kvp,
+                        void *arg)
+{
+    ip6_fib_mtrie_build_ctx_t *ctx = arg;
+    ip6_address_t addr;
+
+    if ((kvp->key[2] >> 32) != ctx->fib_index)
+	return;
+
+    addr.as_u64[0] = kvp->key[0];
+    addr.as_u64[1] = kvp->key[1];
+
+    ip6_fib_mtrie_route_add(ctx->mtrie, &addr,
+                            kvp->key[2] & 0xffffffff,
+                            kvp->value);
+}
+
+void
+ip6_fib_table_set_mtrie (u32 fib_index,
+                         int enable)
+{
+    ip6_fib_t *v6_fib = ip6_fib_get(fib_index);
+
+    if (enable && NULL == v6_fib->mtrie)
+    {
+	ip6_fib_mtrie_build_ctx_t ctx = {
+	    .fib_index = fib_index,
+	    .mtrie = ip6_mtrie_alloc(),
+	};
+
+	/*
+	 * populate from the forwarding hash before publishing, so lookups
+	 * never see a partial trie
+	 */
+	BV(clib_bihash_foreach_key_value_pair)(
+	    &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].ip6_hash,
+	    ip6_fib_mtrie_build_cb,
+	    &ctx);
+
+	CLIB_MEMORY_BARRIER();
+	v6_fib->mtrie = ctx.mtrie;
+    }
+    else if (!enable && NULL != v6_fib->mtrie)
+    {
+	ip6_fib_mtrie_t *mtrie = v6_fib->mtrie;
+
+	v6_fib->mtrie = NULL;
+	ip6_mtrie_free(mtrie);
+    }
+}
+
 void
 ip6_fib_table_fwding_dpo_update (u32 fib_index,
 				 const ip6_address_t *addr,
@@ -387,6 +494,12 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
 
     BV(clib_bihash_add_del)(&table->ip6_hash, &kv, 1);
 
+    if (NULL != ip6_fib_get(fib_index)->mtrie)
+    {
+	ip6_fib_mtrie_route_add(ip6_fib_get(fib_index)->mtrie,
+                                addr, len, dpo->dpoi_index);
+    }
+
     table->dst_address_length_refcounts[len]++;
 
     table->non_empty_dst_address_length_bitmap =
@@ -417,6 +530,18 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
 
     BV(clib_bihash_add_del)(&table->ip6_hash, &kv, 0);
 
+    if (NULL != ip6_fib_get(fib_index)->mtrie)
+    {
+	index_t cover_lbi;
+	u32 cover_len;
+
+	cover_lbi = ip6_fib_table_fwding_cover(fib_index, addr, len,
+                                               &cover_len);
+	ip6_fib_mtrie_route_del(ip6_fib_get(fib_index)->mtrie,
+                                addr, len, dpo->dpoi_index,
+                                cover_len, cover_lbi);
+    }
+
     /* refcount accounting */
     ASSERT (table->dst_address_length_refcounts[len] > 0);
     if (--table->dst_address_length_refcounts[len] == 0)
@@ -492,6 +617,7 @@ ip6_fib_walk_cb (clib_bihash_kv_24_8_t * kvp,
                     break;
                 }
                 case FIB_TABLE_WALK_STOP:
+                case FIB_TABLE_WALK_PAUSE:
                     goto done;
                 }
             }
@@ -709,6 +835,11 @@ ip6_show_fib (vlib_main_t * vm,
 	    BVT(clib_bihash) * h = &im6->ip6_table[IP6_FIB_TABLE_NON_FWDING].ip6_hash;
 	    int len;
 
+	    if (NULL != fib->mtrie)
+	    {
+		vlib_cli_output (vm, "  lookup: %U", format_ip6_fib_mtrie,
+                                 fib->mtrie);
+	    }
 	    vlib_cli_output (vm, "%=20s%=16s", "Prefix length", "Count");
 
 	    memset (ca, 0, sizeof(*ca));
@@ -840,3 +971,58 @@ VLIB_CLI_COMMAND (ip6_show_fib_command, static) = {
     .function = ip6_show_fib,
 };
 /* *INDENT-ON* */
+
+static clib_error_t *
+ip6_fib_lookup_set (vlib_main_t * vm,
+                    unformat_input_t * input,
+                    vlib_cli_command_t * cmd)
+{
+    u32 table_id = 0, fib_index;
+    int enable = -1;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+	if (unformat (input, "table %d", &table_id))
+	    ;
+	else if (unformat (input, "mtrie"))
+	    enable = 1;
+	else if (unformat (input, "hash"))
+	    enable = 0;
+	else
+	    return (clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input));
+    }
+
+    if (-1 == enable)
+	return (clib_error_return (0, "specify mtrie or hash"));
+
+    fib_index = ip6_fib_index_from_table_id(table_id);
+
+    if (~0 == fib_index)
+	return (clib_error_return (0, "no such table %d", table_id));
+
+    vlib_worker_thread_barrier_sync (vm);
+    ip6_fib_table_set_mtrie(fib_index, enable);
+    vlib_worker_thread_barrier_release (vm);
+
+    return (NULL);
+}
+
+/*?
+ * Select the forwarding lookup algorithm of an IPv6 table. The default
+ * probes a hash once per prefix length present in any table; 'mtrie'
+ * builds a 16-8-8 multi-bit trie whose cost is bounded by the depth of
+ * the longest prefix rather than the number of distinct prefix lengths,
+ * at the expense of memory. Use 'show ip6 fib summary' to see the trie's
+ * size. The 'ip6 { mtrie }' startup option enables it for all tables.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip6 fib-lookup table 0 mtrie}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip6_fib_lookup_set_command, static) = {
+    .path = "set ip6 fib-lookup",
+    .short_help = "set ip6 fib-lookup [table <table-id>] <mtrie|hash>",
+    .function = ip6_fib_lookup_set,
+};
+/* *INDENT-ON* */
@@ -63,17 +63,28 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief Enable or disable the mtrie forwarding lookup for a table.
+ * The caller holds the worker barrier.
+ */
+extern void ip6_fib_table_set_mtrie(u32 fib_index, int enable);
+
 always_inline u32
 ip6_fib_table_fwding_lookup (ip6_main_t * im,
                              u32 fib_index,
                              const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
+    const ip6_fib_mtrie_t *mtrie;
     int i, len;
     int rv;
     BVT(clib_bihash_kv) kv, value;
     u64 fib;
 
+    mtrie = ip6_main.v6_fibs[fib_index].mtrie;
+    if (NULL != mtrie)
+	return (ip6_fib_mtrie_lookup(mtrie, dst));
+
     table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
     len = vec_len (table->prefix_lengths_in_search_order);
 
@@ -102,6 +113,35 @@ ip6_fib_table_fwding_lookup (ip6_main_t * im,
     return 0;
 }
 
+/**
+ * @brief Two forwarding lookups. When both tables use the mtrie the
+ * walks are interleaved so their cache misses overlap.
+ */
+always_inline void
+ip6_fib_table_fwding_lookup_x2 (ip6_main_t * im,
+                                u32 fib_index0,
+                                u32 fib_index1,
+                                const ip6_address_t * dst0,
+                                const ip6_address_t * dst1,
+                                u32 * lbi0,
+                                u32 * lbi1)
+{
+    const ip6_fib_mtrie_t *mtrie0, *mtrie1;
+
+    mtrie0 = ip6_main.v6_fibs[fib_index0].mtrie;
+    mtrie1 = ip6_main.v6_fibs[fib_index1].mtrie;
+
+    if (NULL != mtrie0 && NULL != mtrie1)
+    {
+	ip6_fib_mtrie_lookup_x2(mtrie0, mtrie1, dst0, dst1, lbi0, lbi1);
+    }
+    else
+    {
+	*lbi0 = ip6_fib_table_fwding_lookup(im, fib_index0, dst0);
+	*lbi1 = ip6_fib_table_fwding_lookup(im, fib_index1, dst1);
+    }
+}
+
 /**
  * @brief Walk all entries in a sub-tree of the FIB table
  * N.B: This is NOT safe to deletes. If you need to delete walk the whole
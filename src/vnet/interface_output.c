@@ -43,6 +43,7 @@
 #include <vnet/ip/ip6.h>
 #include <vnet/udp/udp_packet.h>
 #include <vnet/feature/feature.h>
+#include <vnet/unix/pcap_capture.h>
 
 typedef struct
 {
@@ -253,6 +254,9 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 				      VNET_INTERFACE_OUTPUT_ERROR_INTERFACE_DOWN);
     }
 
+  pcap_capture_buffers (vm, from, n_buffers, rt->sw_if_index,
+			PCAP_CAPTURE_TX);
+
   from_end = from + n_buffers;
 
   /* Total byte count of all buffers. */
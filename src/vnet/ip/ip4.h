@@ -152,6 +152,9 @@ typedef struct ip4_main_t
   /** Heapsize for the Mtries */
   uword mtrie_heap_size;
 
+  /** Route count at which a table's mtrie gets the 16 bit root */
+  u32 mtrie_root_16_threshold;
+
   /** The memory heap for the mtries */
   void *mtrie_mheap;
 } ip4_main_t;
@@ -281,6 +284,11 @@ void ip4_punt_redirect_add (u32 rx_sw_if_index,
 			    u32 tx_sw_if_index, ip46_address_t * nh);
 void ip4_punt_redirect_del (u32 rx_sw_if_index);
 
+vnet_feature_fused_function_t ip4_source_check_via_rx_fused;
+vnet_feature_fused_function_t ip4_source_check_via_any_fused;
+vnet_feature_fused_function_t ip4_inacl_fused;
+vnet_feature_fused_function_t ip4_policer_classify_fused;
+
 /* Compute flow hash.  We'll use it to select which adjacency to use for this
    flow.  And other things. */
 always_inline u32
@@ -316,6 +324,30 @@ ip4_compute_flow_hash (const ip4_header_t * ip,
   return c;
 }
 
+/**
+ * Compute the flow hash, or re-use the one cached in the buffer by an
+ * earlier stage (or the NIC). Only the default hash config is cached,
+ * since that is what both the earlier stages and the RSS hash cover.
+ */
+always_inline u32
+ip4_compute_flow_hash_cached (vlib_buffer_t * b,
+			      const ip4_header_t * ip,
+			      flow_hash_config_t flow_hash_config)
+{
+  u32 hash;
+
+  if (PREDICT_FALSE (IP_FLOW_HASH_DEFAULT != flow_hash_config))
+    return (ip4_compute_flow_hash (ip, flow_hash_config));
+
+  if (vnet_buffer_flow_hash_get (b, &hash))
+    return (hash);
+
+  hash = ip4_compute_flow_hash (ip, flow_hash_config);
+  vnet_buffer_flow_hash_set (b, (hash >> 1) | (hash << 31));
+
+  return (hash);
+}
+
 void
 ip4_forward_next_trace (vlib_main_t * vm,
 			vlib_node_runtime_t * node,
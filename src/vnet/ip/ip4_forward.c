@@ -71,11 +71,61 @@ ip4_lookup_inline (vlib_main_t * vm,
   u32 n_left_from, n_left_to_next, *from, *to_next;
   ip_lookup_next_t next;
   u32 thread_index = vlib_get_thread_index ();
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  ip4_fib_mtrie_t *mtries[VLIB_FRAME_SIZE];
+  ip4_address_t dst_addresses[VLIB_FRAME_SIZE];
+  u32 lb_indices[VLIB_FRAME_SIZE], *lbi;
+  u32 i;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next = node->cached_next_index;
 
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+
+  /*
+   * Collect the keys of the whole frame and look them up together, so
+   * the mtrie's cache misses overlap across the frame.
+   */
+  if (lookup_for_responses_to_locally_received_packets)
+    {
+      for (i = 0; i < n_left_from; i++)
+	lb_indices[i] = vnet_buffer (bufs[i])->ip.adj_index[VLIB_RX];
+    }
+  else
+    {
+      for (i = 0; i < n_left_from; i++)
+	{
+	  ip4_header_t *ip0;
+	  u32 fib_index0;
+
+	  if (i + 4 < n_left_from)
+	    {
+	      vlib_prefetch_buffer_header (bufs[i + 4], LOAD);
+	      CLIB_PREFETCH (bufs[i + 4]->data, sizeof (ip0[0]), LOAD);
+	    }
+
+	  ip0 = vlib_buffer_get_current (bufs[i]);
+
+	  fib_index0 =
+	    vec_elt (im->fib_index_by_sw_if_index,
+		     vnet_buffer (bufs[i])->sw_if_index[VLIB_RX]);
+	  fib_index0 =
+	    (vnet_buffer (bufs[i])->sw_if_index[VLIB_TX] ==
+	     (u32) ~ 0) ? fib_index0 : vnet_buffer (bufs[i])->
+	    sw_if_index[VLIB_TX];
+
+	  mtries[i] = &ip4_fib_get (fib_index0)->mtrie;
+	  dst_addresses[i] = ip0->dst_address;
+	}
+
+      ip4_fib_mtrie_lookup_n (mtries, dst_addresses, lb_indices,
+			      n_left_from);
+    }
+
+  b = bufs;
+  lbi = lb_indices;
+
   while (n_left_from > 0)
     {
       vlib_get_next_frame (vm, node, next, to_next, n_left_to_next);
@@ -86,36 +136,25 @@ ip4_lookup_inline (vlib_main_t * vm,
 	  ip4_header_t *ip0, *ip1, *ip2, *ip3;
 	  ip_lookup_next_t next0, next1, next2, next3;
 	  const load_balance_t *lb0, *lb1, *lb2, *lb3;
-	  ip4_fib_mtrie_t *mtrie0, *mtrie1, *mtrie2, *mtrie3;
-	  ip4_fib_mtrie_leaf_t leaf0, leaf1, leaf2, leaf3;
-	  ip4_address_t *dst_addr0, *dst_addr1, *dst_addr2, *dst_addr3;
-	  u32 pi0, fib_index0, lb_index0;
-	  u32 pi1, fib_index1, lb_index1;
-	  u32 pi2, fib_index2, lb_index2;
-	  u32 pi3, fib_index3, lb_index3;
+	  u32 pi0, lb_index0;
+	  u32 pi1, lb_index1;
+	  u32 pi2, lb_index2;
+	  u32 pi3, lb_index3;
 	  flow_hash_config_t flow_hash_config0, flow_hash_config1;
 	  flow_hash_config_t flow_hash_config2, flow_hash_config3;
 	  u32 hash_c0, hash_c1, hash_c2, hash_c3;
 	  const dpo_id_t *dpo0, *dpo1, *dpo2, *dpo3;
 
-	  /* Prefetch next iteration. */
+	  /* Prefetch next iteration's load-balances. */
 	  {
-	    vlib_buffer_t *p4, *p5, *p6, *p7;
-
-	    p4 = vlib_get_buffer (vm, from[4]);
-	    p5 = vlib_get_buffer (vm, from[5]);
-	    p6 = vlib_get_buffer (vm, from[6]);
-	    p7 = vlib_get_buffer (vm, from[7]);
-
-	    vlib_prefetch_buffer_header (p4, LOAD);
-	    vlib_prefetch_buffer_header (p5, LOAD);
-	    vlib_prefetch_buffer_header (p6, LOAD);
-	    vlib_prefetch_buffer_header (p7, LOAD);
-
-	    CLIB_PREFETCH (p4->data, sizeof (ip0[0]), LOAD);
-	    CLIB_PREFETCH (p5->data, sizeof (ip0[0]), LOAD);
-	    CLIB_PREFETCH (p6->data, sizeof (ip0[0]), LOAD);
-	    CLIB_PREFETCH (p7->data, sizeof (ip0[0]), LOAD);
+	    CLIB_PREFETCH (load_balance_get (lbi[4]),
+			   CLIB_CACHE_LINE_BYTES, LOAD);
+	    CLIB_PREFETCH (load_balance_get (lbi[5]),
+			   CLIB_CACHE_LINE_BYTES, LOAD);
+	    CLIB_PREFETCH (load_balance_get (lbi[6]),
+			   CLIB_CACHE_LINE_BYTES, LOAD);
+	    CLIB_PREFETCH (load_balance_get (lbi[7]),
+			   CLIB_CACHE_LINE_BYTES, LOAD);
 	  }
 
 	  pi0 = to_next[0] = from[0];
@@ -123,96 +162,28 @@ ip4_lookup_inline (vlib_main_t * vm,
 	  pi2 = to_next[2] = from[2];
 	  pi3 = to_next[3] = from[3];
 
+	  p0 = b[0];
+	  p1 = b[1];
+	  p2 = b[2];
+	  p3 = b[3];
+
+	  lb_index0 = lbi[0];
+	  lb_index1 = lbi[1];
+	  lb_index2 = lbi[2];
+	  lb_index3 = lbi[3];
+
 	  from += 4;
+	  b += 4;
+	  lbi += 4;
 	  to_next += 4;
 	  n_left_to_next -= 4;
 	  n_left_from -= 4;
 
-	  p0 = vlib_get_buffer (vm, pi0);
-	  p1 = vlib_get_buffer (vm, pi1);
-	  p2 = vlib_get_buffer (vm, pi2);
-	  p3 = vlib_get_buffer (vm, pi3);
-
 	  ip0 = vlib_buffer_get_current (p0);
 	  ip1 = vlib_buffer_get_current (p1);
 	  ip2 = vlib_buffer_get_current (p2);
 	  ip3 = vlib_buffer_get_current (p3);
 
-	  dst_addr0 = &ip0->dst_address;
-	  dst_addr1 = &ip1->dst_address;
-	  dst_addr2 = &ip2->dst_address;
-	  dst_addr3 = &ip3->dst_address;
-
-	  fib_index0 =
-	    vec_elt (im->fib_index_by_sw_if_index,
-		     vnet_buffer (p0)->sw_if_index[VLIB_RX]);
-	  fib_index1 =
-	    vec_elt (im->fib_index_by_sw_if_index,
-		     vnet_buffer (p1)->sw_if_index[VLIB_RX]);
-	  fib_index2 =
-	    vec_elt (im->fib_index_by_sw_if_index,
-		     vnet_buffer (p2)->sw_if_index[VLIB_RX]);
-	  fib_index3 =
-	    vec_elt (im->fib_index_by_sw_if_index,
-		     vnet_buffer (p3)->sw_if_index[VLIB_RX]);
-	  fib_index0 =
-	    (vnet_buffer (p0)->sw_if_index[VLIB_TX] ==
-	     (u32) ~ 0) ? fib_index0 : vnet_buffer (p0)->sw_if_index[VLIB_TX];
-	  fib_index1 =
-	    (vnet_buffer (p1)->sw_if_index[VLIB_TX] ==
-	     (u32) ~ 0) ? fib_index1 : vnet_buffer (p1)->sw_if_index[VLIB_TX];
-	  fib_index2 =
-	    (vnet_buffer (p2)->sw_if_index[VLIB_TX] ==
-	     (u32) ~ 0) ? fib_index2 : vnet_buffer (p2)->sw_if_index[VLIB_TX];
-	  fib_index3 =
-	    (vnet_buffer (p3)->sw_if_index[VLIB_TX] ==
-	     (u32) ~ 0) ? fib_index3 : vnet_buffer (p3)->sw_if_index[VLIB_TX];
-
-
-	  if (!lookup_for_responses_to_locally_received_packets)
-	    {
-	      mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
-	      mtrie1 = &ip4_fib_get (fib_index1)->mtrie;
-	      mtrie2 = &ip4_fib_get (fib_index2)->mtrie;
-	      mtrie3 = &ip4_fib_get (fib_index3)->mtrie;
-
-	      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
-	      leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, dst_addr1);
-	      leaf2 = ip4_fib_mtrie_lookup_step_one (mtrie2, dst_addr2);
-	      leaf3 = ip4_fib_mtrie_lookup_step_one (mtrie3, dst_addr3);
-	    }
-
-	  if (!lookup_for_responses_to_locally_received_packets)
-	    {
-	      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
-	      leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 2);
-	      leaf2 = ip4_fib_mtrie_lookup_step (mtrie2, leaf2, dst_addr2, 2);
-	      leaf3 = ip4_fib_mtrie_lookup_step (mtrie3, leaf3, dst_addr3, 2);
-	    }
-
-	  if (!lookup_for_responses_to_locally_received_packets)
-	    {
-	      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
-	      leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 3);
-	      leaf2 = ip4_fib_mtrie_lookup_step (mtrie2, leaf2, dst_addr2, 3);
-	      leaf3 = ip4_fib_mtrie_lookup_step (mtrie3, leaf3, dst_addr3, 3);
-	    }
-
-	  if (lookup_for_responses_to_locally_received_packets)
-	    {
-	      lb_index0 = vnet_buffer (p0)->ip.adj_index[VLIB_RX];
-	      lb_index1 = vnet_buffer (p1)->ip.adj_index[VLIB_RX];
-	      lb_index2 = vnet_buffer (p2)->ip.adj_index[VLIB_RX];
-	      lb_index3 = vnet_buffer (p3)->ip.adj_index[VLIB_RX];
-	    }
-	  else
-	    {
-	      lb_index0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
-	      lb_index1 = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
-	      lb_index2 = ip4_fib_mtrie_leaf_get_adj_index (leaf2);
-	      lb_index3 = ip4_fib_mtrie_leaf_get_adj_index (leaf3);
-	    }
-
 	  ASSERT (lb_index0 && lb_index1 && lb_index2 && lb_index3);
 	  lb0 = load_balance_get (lb_index0);
 	  lb1 = load_balance_get (lb_index1);
@@ -237,7 +208,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config0 = lb0->lb_hash_config;
 	      hash_c0 = vnet_buffer (p0)->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, flow_hash_config0);
+		ip4_compute_flow_hash_cached (p0, ip0, flow_hash_config0);
 	      dpo0 =
 		load_balance_get_fwd_bucket (lb0,
 					     (hash_c0 &
@@ -251,7 +222,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config1 = lb1->lb_hash_config;
 	      hash_c1 = vnet_buffer (p1)->ip.flow_hash =
-		ip4_compute_flow_hash (ip1, flow_hash_config1);
+		ip4_compute_flow_hash_cached (p1, ip1, flow_hash_config1);
 	      dpo1 =
 		load_balance_get_fwd_bucket (lb1,
 					     (hash_c1 &
@@ -265,7 +236,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config2 = lb2->lb_hash_config;
 	      hash_c2 = vnet_buffer (p2)->ip.flow_hash =
-		ip4_compute_flow_hash (ip2, flow_hash_config2);
+		ip4_compute_flow_hash_cached (p2, ip2, flow_hash_config2);
 	      dpo2 =
 		load_balance_get_fwd_bucket (lb2,
 					     (hash_c2 &
@@ -279,7 +250,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config3 = lb3->lb_hash_config;
 	      hash_c3 = vnet_buffer (p3)->ip.flow_hash =
-		ip4_compute_flow_hash (ip3, flow_hash_config3);
+		ip4_compute_flow_hash_cached (p3, ip3, flow_hash_config3);
 	      dpo3 =
 		load_balance_get_fwd_bucket (lb3,
 					     (hash_c3 &
@@ -324,10 +295,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	  ip4_header_t *ip0;
 	  ip_lookup_next_t next0;
 	  const load_balance_t *lb0;
-	  ip4_fib_mtrie_t *mtrie0;
-	  ip4_fib_mtrie_leaf_t leaf0;
-	  ip4_address_t *dst_addr0;
-	  u32 pi0, fib_index0, lbi0;
+	  u32 pi0, lbi0;
 	  flow_hash_config_t flow_hash_config0;
 	  const dpo_id_t *dpo0;
 	  u32 hash_c0;
@@ -335,40 +303,11 @@ ip4_lookup_inline (vlib_main_t * vm,
 	  pi0 = from[0];
 	  to_next[0] = pi0;
 
-	  p0 = vlib_get_buffer (vm, pi0);
+	  p0 = b[0];
+	  lbi0 = lbi[0];
 
 	  ip0 = vlib_buffer_get_current (p0);
 
-	  dst_addr0 = &ip0->dst_address;
-
-	  fib_index0 =
-	    vec_elt (im->fib_index_by_sw_if_index,
-		     vnet_buffer (p0)->sw_if_index[VLIB_RX]);
-	  fib_index0 =
-	    (vnet_buffer (p0)->sw_if_index[VLIB_TX] ==
-	     (u32) ~ 0) ? fib_index0 : vnet_buffer (p0)->sw_if_index[VLIB_TX];
-
-	  if (!lookup_for_responses_to_locally_received_packets)
-	    {
-	      mtrie0 = &ip4_fib_get (fib_index0)->mtrie;
-
-	      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
-	    }
-
-	  if (!lookup_for_responses_to_locally_received_packets)
-	    leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
-
-	  if (!lookup_for_responses_to_locally_received_packets)
-	    leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
-
-	  if (lookup_for_responses_to_locally_received_packets)
-	    lbi0 = vnet_buffer (p0)->ip.adj_index[VLIB_RX];
-	  else
-	    {
-	      /* Handle default route. */
-	      lbi0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
-	    }
-
 	  ASSERT (lbi0);
 	  lb0 = load_balance_get (lbi0);
 
@@ -382,7 +321,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	      flow_hash_config0 = lb0->lb_hash_config;
 
 	      hash_c0 = vnet_buffer (p0)->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, flow_hash_config0);
+		ip4_compute_flow_hash_cached (p0, ip0, flow_hash_config0);
 	      dpo0 =
 		load_balance_get_fwd_bucket (lb0,
 					     (hash_c0 &
@@ -401,6 +340,8 @@ ip4_lookup_inline (vlib_main_t * vm,
 									p0));
 
 	  from += 1;
+	  b += 1;
+	  lbi += 1;
 	  to_next += 1;
 	  n_left_to_next -= 1;
 	  n_left_from -= 1;
@@ -565,7 +506,7 @@ ip4_load_balance (vlib_main_t * vm,
 	      else
 		{
 		  hc0 = vnet_buffer (p0)->ip.flow_hash =
-		    ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+		    ip4_compute_flow_hash_cached (p0, ip0, lb0->lb_hash_config);
 		}
 	      dpo0 = load_balance_get_fwd_bucket
 		(lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -584,7 +525,7 @@ ip4_load_balance (vlib_main_t * vm,
 	      else
 		{
 		  hc1 = vnet_buffer (p1)->ip.flow_hash =
-		    ip4_compute_flow_hash (ip1, lb1->lb_hash_config);
+		    ip4_compute_flow_hash_cached (p1, ip1, lb1->lb_hash_config);
 		}
 	      dpo1 = load_balance_get_fwd_bucket
 		(lb1, (hc1 & (lb1->lb_n_buckets_minus_1)));
@@ -644,7 +585,7 @@ ip4_load_balance (vlib_main_t * vm,
 	      else
 		{
 		  hc0 = vnet_buffer (p0)->ip.flow_hash =
-		    ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+		    ip4_compute_flow_hash_cached (p0, ip0, lb0->lb_hash_config);
 		}
 	      dpo0 = load_balance_get_fwd_bucket
 		(lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -1015,6 +956,7 @@ VNET_FEATURE_INIT (ip4_inacl, static) =
   .arc_name = "ip4-unicast",
   .node_name = "ip4-inacl",
   .runs_before = VNET_FEATURES ("ip4-source-check-via-rx"),
+  .fused_function = ip4_inacl_fused,
 };
 
 VNET_FEATURE_INIT (ip4_source_check_1, static) =
@@ -1022,6 +964,7 @@ VNET_FEATURE_INIT (ip4_source_check_1, static) =
   .arc_name = "ip4-unicast",
   .node_name = "ip4-source-check-via-rx",
   .runs_before = VNET_FEATURES ("ip4-source-check-via-any"),
+  .fused_function = ip4_source_check_via_rx_fused,
 };
 
 VNET_FEATURE_INIT (ip4_source_check_2, static) =
@@ -1029,6 +972,7 @@ VNET_FEATURE_INIT (ip4_source_check_2, static) =
   .arc_name = "ip4-unicast",
   .node_name = "ip4-source-check-via-any",
   .runs_before = VNET_FEATURES ("ip4-policer-classify"),
+  .fused_function = ip4_source_check_via_any_fused,
 };
 
 VNET_FEATURE_INIT (ip4_source_and_port_range_check_rx, static) =
@@ -1043,6 +987,7 @@ VNET_FEATURE_INIT (ip4_policer_classify, static) =
   .arc_name = "ip4-unicast",
   .node_name = "ip4-policer-classify",
   .runs_before = VNET_FEATURES ("ipsec-input-ip4"),
+  .fused_function = ip4_policer_classify_fused,
 };
 
 VNET_FEATURE_INIT (ip4_ipsec, static) =
@@ -3197,6 +3142,9 @@ ip4_config (vlib_main_t * vm, unformat_input_t * input)
     {
       if (unformat (input, "heap-size %U", unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "mtrie-root-16-threshold %d",
+			 &im->mtrie_root_16_threshold))
+	;
       else
 	return clib_error_return (0,
 				  "invalid heap-size parameter `%U'",
@@ -161,15 +161,6 @@ ply_8_init (ip4_fib_mtrie_8_ply_t * p,
   PLY_INIT (p, init, prefix_len, ply_base_len);
 }
 
-static void
-ply_16_init (ip4_fib_mtrie_16_ply_t * p,
-	     ip4_fib_mtrie_leaf_t init, uword prefix_len)
-{
-  memset (p->dst_address_bits_of_leaves, prefix_len,
-	  sizeof (p->dst_address_bits_of_leaves));
-  PLY_INIT_LEAVES (p);
-}
-
 static ip4_fib_mtrie_leaf_t
 ply_create (ip4_fib_mtrie_t * m,
 	    ip4_fib_mtrie_leaf_t init_leaf,
@@ -198,23 +189,109 @@ get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
 void
 ip4_mtrie_free (ip4_fib_mtrie_t * m)
 {
-  /* the root ply is embedded so the is nothing to do,
-   * the assumption being that the IP4 FIB table has emptied the trie
-   * before deletion.
+  /* the assumption being that the IP4 FIB table has emptied the trie
+   * before deletion, so only the root remains.
    */
+  if (ip4_mtrie_is_promoted (m))
+    {
 #if CLIB_DEBUG > 0
-  int i;
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+      int i;
+      for (i = 0; i < ARRAY_LEN (m->root_ply->leaves); i++)
+	{
+	  ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (m->root_ply->leaves[i]));
+	}
+#endif
+      clib_mem_free (m->root_ply);
+      m->root_ply = NULL;
+    }
+  else
     {
-      ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]));
+      ip4_fib_mtrie_8_ply_t *root = get_next_ply_for_leaf (m,
+							   m->root_8_leaf);
+      void *old_heap;
+
+      ASSERT (0 == root->n_non_empty_leafs);
+
+      old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+      pool_put (ip4_ply_pool, root);
+      clib_mem_set_heap (old_heap);
     }
-#endif
+  m->root_8_leaf = IP4_FIB_MTRIE_LEAF_EMPTY;
 }
 
 void
 ip4_mtrie_init (ip4_fib_mtrie_t * m)
 {
-  ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+  m->root_ply = NULL;
+  m->root_8_leaf = ply_create (m, IP4_FIB_MTRIE_LEAF_EMPTY, 0, 0);
+}
+
+void
+ip4_mtrie_promote (ip4_fib_mtrie_t * m)
+{
+  ip4_fib_mtrie_8_ply_t *root_8, *ply;
+  ip4_fib_mtrie_16_ply_t *root;
+  ip4_fib_mtrie_leaf_t leaf;
+  u32 *ply_indices = NULL, *ply_index;
+  ip4_address_t slot;
+  void *old_heap;
+  u32 i, j;
+
+  if (ip4_mtrie_is_promoted (m))
+    return;
+
+  /* like the embedded root it replaces, it comes from the main heap */
+  root = clib_mem_alloc_aligned (sizeof (*root), CLIB_CACHE_LINE_BYTES);
+  root_8 = get_next_ply_for_leaf (m, m->root_8_leaf);
+
+  /*
+   * Each slot of the 16 bit root is what the walk through the first two
+   * 8 bit plies gives for its 2 bytes. The plies for the 2nd byte are
+   * subsumed, those below them have the same base length as they
+   * would have had under a 16 bit root and are kept.
+   */
+  slot.as_u32 = 0;
+  for (i = 0; i < ARRAY_LEN (root_8->leaves); i++)
+    {
+      slot.as_u8[0] = i;
+      leaf = root_8->leaves[i];
+
+      if (ip4_fib_mtrie_leaf_is_terminal (leaf))
+	{
+	  for (j = 0; j < 256; j++)
+	    {
+	      slot.as_u8[1] = j;
+	      root->leaves[slot.as_u16[0]] = leaf;
+	      root->dst_address_bits_of_leaves[slot.as_u16[0]] =
+		root_8->dst_address_bits_of_leaves[i];
+	    }
+	}
+      else
+	{
+	  ply = get_next_ply_for_leaf (m, leaf);
+	  for (j = 0; j < ARRAY_LEN (ply->leaves); j++)
+	    {
+	      slot.as_u8[1] = j;
+	      root->leaves[slot.as_u16[0]] = ply->leaves[j];
+	      root->dst_address_bits_of_leaves[slot.as_u16[0]] =
+		ply->dst_address_bits_of_leaves[j];
+	    }
+	  vec_add1 (ply_indices, ip4_fib_mtrie_leaf_get_next_ply_index (leaf));
+	}
+    }
+
+  /* publish the complete root before the old plies go */
+  CLIB_MEMORY_BARRIER ();
+  m->root_ply = root;
+
+  old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
+  vec_foreach (ply_index, ply_indices)
+    pool_put_index (ip4_ply_pool, *ply_index);
+  pool_put (ip4_ply_pool, root_8);
+  clib_mem_set_heap (old_heap);
+
+  m->root_8_leaf = IP4_FIB_MTRIE_LEAF_EMPTY;
+  vec_free (ply_indices);
 }
 
 typedef struct
@@ -403,7 +480,15 @@ set_root_leaf (ip4_fib_mtrie_t * m,
   i32 n_dst_bits_next_plies;
   u16 dst_byte;
 
-  old_ply = &m->root_ply;
+  if (!ip4_mtrie_is_promoted (m))
+    {
+      /* a sparse root is just another 8 bit ply */
+      set_leaf (m, a, ip4_fib_mtrie_leaf_get_next_ply_index (m->root_8_leaf),
+		0);
+      return;
+    }
+
+  old_ply = m->root_ply;
 
   ASSERT (a->dst_address_length <= 32);
 
@@ -595,7 +680,14 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
 
   ASSERT (a->dst_address_length <= 32);
 
-  old_ply = &m->root_ply;
+  if (!ip4_mtrie_is_promoted (m))
+    {
+      /* the sparse root ply is never removed; byte index 0 */
+      unset_leaf (m, a, get_next_ply_for_leaf (m, m->root_8_leaf), 0);
+      return;
+    }
+
+  old_ply = m->root_ply;
   n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
 
   dst_byte = a->dst_address.as_u16[0];
@@ -692,9 +784,16 @@ ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m)
   uword bytes, i;
 
   bytes = sizeof (*m);
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+  if (!ip4_mtrie_is_promoted (m))
+    return (bytes +
+	    mtrie_ply_memory_usage (m,
+				    get_next_ply_for_leaf (m,
+							   m->root_8_leaf)));
+
+  bytes += sizeof (*m->root_ply);
+  for (i = 0; i < ARRAY_LEN (m->root_ply->leaves); i++)
     {
-      ip4_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
+      ip4_fib_mtrie_leaf_t l = m->root_ply->leaves[i];
       if (ip4_fib_mtrie_leaf_is_next_ply (l))
 	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
     }
@@ -775,14 +874,21 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   s = format (s, "%d plies, memory usage %U\n",
 	      pool_elts (ip4_ply_pool),
 	      format_memory_size, ip4_fib_mtrie_memory_usage (m));
-  s = format (s, "root-ply");
-  p = &m->root_ply;
 
-  if (verbose)
+  if (!ip4_mtrie_is_promoted (m))
     {
-      s = format (s, "root-ply");
-      p = &m->root_ply;
+      s = format (s, "root-ply 8 bit");
+      if (verbose)
+	s = format (s, "\n  %U", format_ip4_fib_mtrie_ply, m, base_address,
+		    ip4_fib_mtrie_leaf_get_next_ply_index (m->root_8_leaf));
+      return s;
+    }
+
+  s = format (s, "root-ply 16 bit");
+  p = m->root_ply;
 
+  if (verbose)
+    {
       for (i = 0; i < ARRAY_LEN (p->leaves); i++)
 	{
 	  u16 slot;
@@ -802,6 +908,12 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
 /** Default heap size for the IPv4 mtries */
 #define IP4_FIB_DEFAULT_MTRIE_HEAP_SIZE (32<<20)
 
+/**
+ * Default route count for the 16 bit root. The root costs as much as
+ * ~240 8 bit plies, below this the sparse root is the better trade.
+ */
+#define IP4_FIB_DEFAULT_MTRIE_ROOT_16_THRESHOLD 1024
+
 static clib_error_t *
 ip4_mtrie_module_init (vlib_main_t * vm)
 {
@@ -813,6 +925,8 @@ ip4_mtrie_module_init (vlib_main_t * vm)
   if (0 == im->mtrie_heap_size)
     im->mtrie_heap_size = IP4_FIB_DEFAULT_MTRIE_HEAP_SIZE;
   im->mtrie_mheap = mheap_alloc (0, im->mtrie_heap_size);
+  if (0 == im->mtrie_root_16_threshold)
+    im->mtrie_root_16_threshold = IP4_FIB_DEFAULT_MTRIE_ROOT_16_THRESHOLD;
 
   /* Burn one ply so index 0 is taken */
   old_heap = clib_mem_set_heap (ip4_main.mtrie_mheap);
@@ -824,6 +938,132 @@ ip4_mtrie_module_init (vlib_main_t * vm)
 
 VLIB_INIT_FUNCTION (ip4_mtrie_module_init);
 
+static clib_error_t *
+ip4_mtrie_lookup_test (vlib_main_t * vm,
+		       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  ip4_fib_mtrie_t *mtries[VLIB_FRAME_SIZE];
+  ip4_address_t *destinations = 0;
+  u32 *results_batched = 0, *results_per_packet = 0;
+  u32 table_id = 0, n_lookups = 1 << 20, seed = 0xdeadbeef;
+  u32 fib_index, i, n_mismatches = 0;
+  u64 c0, batched_clocks, per_packet_clocks;
+  ip4_fib_mtrie_t *m;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "table %d", &table_id))
+	;
+      else if (unformat (input, "lookups %d", &n_lookups))
+	;
+      else if (unformat (input, "seed %d", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  fib_index = ip4_fib_index_from_table_id (table_id);
+  if (~0 == fib_index)
+    return clib_error_return (0, "no such table %d", table_id);
+  if (0 == n_lookups)
+    return clib_error_return (0, "lookups must be non-zero");
+
+  m = &ip4_fib_get (fib_index)->mtrie;
+  for (i = 0; i < VLIB_FRAME_SIZE; i++)
+    mtries[i] = m;
+
+  vec_validate (destinations, n_lookups - 1);
+  vec_validate (results_batched, n_lookups - 1);
+  vec_validate (results_per_packet, n_lookups - 1);
+  for (i = 0; i < n_lookups; i++)
+    destinations[i].as_u32 = random_u32 (&seed);
+
+  /* as ip4-lookup did before: four packets walked in lock-step */
+  c0 = clib_cpu_time_now ();
+  for (i = 0; i + 4 <= n_lookups; i += 4)
+    {
+      ip4_fib_mtrie_leaf_t leaf0, leaf1, leaf2, leaf3;
+
+      leaf0 = ip4_fib_mtrie_lookup_step_one (m, destinations + i + 0);
+      leaf1 = ip4_fib_mtrie_lookup_step_one (m, destinations + i + 1);
+      leaf2 = ip4_fib_mtrie_lookup_step_one (m, destinations + i + 2);
+      leaf3 = ip4_fib_mtrie_lookup_step_one (m, destinations + i + 3);
+
+      leaf0 = ip4_fib_mtrie_lookup_step (m, leaf0, destinations + i + 0, 2);
+      leaf1 = ip4_fib_mtrie_lookup_step (m, leaf1, destinations + i + 1, 2);
+      leaf2 = ip4_fib_mtrie_lookup_step (m, leaf2, destinations + i + 2, 2);
+      leaf3 = ip4_fib_mtrie_lookup_step (m, leaf3, destinations + i + 3, 2);
+
+      leaf0 = ip4_fib_mtrie_lookup_step (m, leaf0, destinations + i + 0, 3);
+      leaf1 = ip4_fib_mtrie_lookup_step (m, leaf1, destinations + i + 1, 3);
+      leaf2 = ip4_fib_mtrie_lookup_step (m, leaf2, destinations + i + 2, 3);
+      leaf3 = ip4_fib_mtrie_lookup_step (m, leaf3, destinations + i + 3, 3);
+
+      results_per_packet[i + 0] = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
+      results_per_packet[i + 1] = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
+      results_per_packet[i + 2] = ip4_fib_mtrie_leaf_get_adj_index (leaf2);
+      results_per_packet[i + 3] = ip4_fib_mtrie_leaf_get_adj_index (leaf3);
+    }
+  for (; i < n_lookups; i++)
+    {
+      ip4_fib_mtrie_leaf_t leaf0;
+
+      leaf0 = ip4_fib_mtrie_lookup_step_one (m, destinations + i);
+      leaf0 = ip4_fib_mtrie_lookup_step (m, leaf0, destinations + i, 2);
+      leaf0 = ip4_fib_mtrie_lookup_step (m, leaf0, destinations + i, 3);
+      results_per_packet[i] = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
+    }
+  per_packet_clocks = clib_cpu_time_now () - c0;
+
+  /* a frame's worth at a time, as ip4-lookup does now */
+  c0 = clib_cpu_time_now ();
+  for (i = 0; i < n_lookups; i += VLIB_FRAME_SIZE)
+    ip4_fib_mtrie_lookup_n (mtries, destinations + i, results_batched + i,
+			    clib_min (VLIB_FRAME_SIZE, n_lookups - i));
+  batched_clocks = clib_cpu_time_now () - c0;
+
+  for (i = 0; i < n_lookups; i++)
+    n_mismatches += results_batched[i] != results_per_packet[i];
+
+  vlib_cli_output (vm, "table %d, %d plies, %d random lookups", table_id,
+		   pool_elts (ip4_ply_pool), n_lookups);
+  vlib_cli_output (vm, "  per-packet x4: %.2f clocks/lookup",
+		   (f64) per_packet_clocks / n_lookups);
+  vlib_cli_output (vm, "  frame batched: %.2f clocks/lookup%s",
+		   (f64) batched_clocks / n_lookups,
+#if defined (__AVX2__)
+		   " (avx2 gather)"
+#else
+		   ""
+#endif
+    );
+  if (n_mismatches)
+    vlib_cli_output (vm, "  %d MISMATCHES", n_mismatches);
+
+  vec_free (destinations);
+  vec_free (results_batched);
+  vec_free (results_per_packet);
+
+  return 0;
+}
+
+/*?
+ * Compare the cost of the per-packet and the frame batched mtrie lookups
+ * on an existing table, e.g. one loaded with a full routing table, using
+ * random destinations. Results of the two must agree.
+ *
+ * @cliexpar
+ * @cliexcmd{test ip4 mtrie lookup table 0 lookups 4000000}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip4_mtrie_lookup_test_command, static) = {
+  .path = "test ip4 mtrie lookup",
+  .short_help = "test ip4 mtrie lookup [table <id>] [lookups <n>] [seed <n>]",
+  .function = ip4_mtrie_lookup_test,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
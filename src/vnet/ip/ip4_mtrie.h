@@ -129,15 +129,21 @@ STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
 typedef struct
 {
   /**
-   * Embed the PLY with the mtrie struct. This means that the Data-plane
-   * 'get me the mtrie' returns the first ply, and not an indirect 'pointer'
-   * to it. therefore no cachline misses in the data-path.
+   * The 16 bit stride root PLY. A table starts sparse, with this NULL and
+   * an 8 bit root PLY from the pool, so it costs ~1KB rather than ~320KB.
+   * It is promoted once it holds enough routes, after which lookups take
+   * one dependent read fewer.
    */
-  ip4_fib_mtrie_16_ply_t root_ply;
+  ip4_fib_mtrie_16_ply_t *root_ply;
+
+  /**
+   * While sparse, the (next-ply) leaf of the 8 bit root PLY
+   */
+  ip4_fib_mtrie_leaf_t root_8_leaf;
 } ip4_fib_mtrie_t;
 
 /**
- * @brief Initialise an mtrie
+ * @brief Initialise an mtrie, with a sparse root
  */
 void ip4_mtrie_init (ip4_fib_mtrie_t * m);
 
@@ -146,6 +152,21 @@ void ip4_mtrie_init (ip4_fib_mtrie_t * m);
  */
 void ip4_mtrie_free (ip4_fib_mtrie_t * m);
 
+/**
+ * @brief Replace the sparse 8 bit root of an mtrie with the 16 bit one.
+ * The mtrie is fully usable by readers throughout.
+ */
+void ip4_mtrie_promote (ip4_fib_mtrie_t * m);
+
+/**
+ * @brief Is the mtrie's root the 16 bit PLY
+ */
+always_inline int
+ip4_mtrie_is_promoted (const ip4_fib_mtrie_t * m)
+{
+  return (NULL != m->root_ply);
+}
+
 /**
  * @brief Add a route/rntry to the mtrie
  */
@@ -219,6 +240,7 @@ ip4_fib_mtrie_lookup_step (const ip4_fib_mtrie_t * m,
 
 /**
  * @brief Lookup step number 1.  Processes 2 bytes of 4 byte ip4 address.
+ * A sparse root takes the 2 bytes one at a time.
  */
 always_inline ip4_fib_mtrie_leaf_t
 ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
@@ -226,11 +248,144 @@ ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
 {
   ip4_fib_mtrie_leaf_t next_leaf;
 
-  next_leaf = m->root_ply.leaves[dst_address->as_u16[0]];
+  if (ip4_mtrie_is_promoted (m))
+    return (m->root_ply->leaves[dst_address->as_u16[0]]);
+
+  next_leaf = ip4_fib_mtrie_lookup_step (m, m->root_8_leaf, dst_address, 0);
+  next_leaf = ip4_fib_mtrie_lookup_step (m, next_leaf, dst_address, 1);
 
   return next_leaf;
 }
 
+/**
+ * @brief Prefetch the slot the next lookup step will read, if any.
+ */
+always_inline void
+ip4_fib_mtrie_lookup_prefetch_step (ip4_fib_mtrie_leaf_t current_leaf,
+				    const ip4_address_t * dst_address,
+				    u32 dst_address_byte_index)
+{
+  ip4_fib_mtrie_8_ply_t *ply;
+
+  if (!ip4_fib_mtrie_leaf_is_terminal (current_leaf))
+    {
+      ply = ip4_ply_pool + (current_leaf >> 1);
+      CLIB_PREFETCH (&ply->leaves[dst_address->as_u8[dst_address_byte_index]],
+		     sizeof (ip4_fib_mtrie_leaf_t), LOAD);
+    }
+}
+
+#if defined (__AVX2__)
+#include <x86intrin.h>
+
+/**
+ * Size of a ply in leaves, the gather index of a slot is
+ * ply_index * IP4_FIB_MTRIE_PLY_N_LEAVES_STRIDE + byte
+ */
+#define IP4_FIB_MTRIE_PLY_N_LEAVES_STRIDE \
+  (sizeof (ip4_fib_mtrie_8_ply_t) / sizeof (ip4_fib_mtrie_leaf_t))
+
+/**
+ * @brief Lookup step for 8 leaves at once. Non-terminal lanes gather the
+ * slot from their ply, terminal lanes keep their leaf.
+ */
+always_inline __m256i
+ip4_fib_mtrie_lookup_step_x8 (__m256i leaves, __m256i bytes)
+{
+  __m256i is_ply, index;
+
+  is_ply = _mm256_cmpeq_epi32 (_mm256_and_si256 (leaves,
+						 _mm256_set1_epi32 (1)),
+			       _mm256_setzero_si256 ());
+  index = _mm256_mullo_epi32 (_mm256_srli_epi32 (leaves, 1),
+			      _mm256_set1_epi32
+			      (IP4_FIB_MTRIE_PLY_N_LEAVES_STRIDE));
+  index = _mm256_add_epi32 (index, bytes);
+
+  return (_mm256_mask_i32gather_epi32 (leaves, (const int *) ip4_ply_pool,
+				       index, is_ply, 4));
+}
+#endif
+
+/**
+ * @brief Longest prefix match for a vector of addresses.
+ *
+ * Each step of the walk is applied to every address before the next
+ * step starts: the root slots are prefetched then read for all, which
+ * prefetches all the second plies, and so on. The misses of the whole
+ * batch overlap rather than those of the two or four addresses a
+ * per-packet loop has in flight. lb_indices is used as scratch for the
+ * leaves before it is written with the results.
+ */
+always_inline void
+ip4_fib_mtrie_lookup_n (ip4_fib_mtrie_t ** mtries,
+			const ip4_address_t * dst_addresses,
+			u32 * lb_indices, u32 n_addresses)
+{
+  ip4_fib_mtrie_leaf_t *leaves = lb_indices;
+  u32 i;
+
+  for (i = 0; i < n_addresses; i++)
+    {
+      if (ip4_mtrie_is_promoted (mtries[i]))
+	CLIB_PREFETCH (&mtries[i]->root_ply->
+		       leaves[dst_addresses[i].as_u16[0]],
+		       sizeof (ip4_fib_mtrie_leaf_t), LOAD);
+      else
+	ip4_fib_mtrie_lookup_prefetch_step (mtries[i]->root_8_leaf,
+					    &dst_addresses[i], 0);
+    }
+
+  for (i = 0; i < n_addresses; i++)
+    {
+      leaves[i] = ip4_fib_mtrie_lookup_step_one (mtries[i], &dst_addresses[i]);
+      ip4_fib_mtrie_lookup_prefetch_step (leaves[i], &dst_addresses[i], 2);
+    }
+
+  i = 0;
+#if defined (__AVX2__)
+  for (; i + 8 <= n_addresses; i += 8)
+    {
+      __m256i l, a;
+
+      l = _mm256_loadu_si256 ((__m256i *) (leaves + i));
+      a = _mm256_loadu_si256 ((__m256i *) (dst_addresses + i));
+      l = ip4_fib_mtrie_lookup_step_x8 (l,
+					_mm256_and_si256 (_mm256_srli_epi32
+							  (a, 16),
+							  _mm256_set1_epi32
+							  (0xff)));
+      _mm256_storeu_si256 ((__m256i *) (leaves + i), l);
+    }
+#endif
+  for (; i < n_addresses; i++)
+    {
+      leaves[i] = ip4_fib_mtrie_lookup_step (mtries[i], leaves[i],
+					     &dst_addresses[i], 2);
+      ip4_fib_mtrie_lookup_prefetch_step (leaves[i], &dst_addresses[i], 3);
+    }
+
+  i = 0;
+#if defined (__AVX2__)
+  for (; i + 8 <= n_addresses; i += 8)
+    {
+      __m256i l, a;
+
+      l = _mm256_loadu_si256 ((__m256i *) (leaves + i));
+      a = _mm256_loadu_si256 ((__m256i *) (dst_addresses + i));
+      l = ip4_fib_mtrie_lookup_step_x8 (l, _mm256_srli_epi32 (a, 24));
+      _mm256_storeu_si256 ((__m256i *) (lb_indices + i),
+			   _mm256_srli_epi32 (l, 1));
+    }
+#endif
+  for (; i < n_addresses; i++)
+    {
+      leaves[i] = ip4_fib_mtrie_lookup_step (mtries[i], leaves[i],
+					     &dst_addresses[i], 3);
+      lb_indices[i] = ip4_fib_mtrie_leaf_get_adj_index (leaves[i]);
+    }
+}
+
 #endif /* included_ip_ip4_fib_h */
 
 /*
@@ -86,6 +86,27 @@ typedef union
   u32 fib_index;
 } ip4_source_check_config_t;
 
+/* Whether a packet passes, given the load balance its source resolves to */
+always_inline u32
+ip4_source_check_pass (vlib_buffer_t * p0, ip4_header_t * ip0,
+		       const load_balance_t * lb0,
+		       ip4_source_check_type_t source_check_type)
+{
+  u32 pass0;
+
+  /* Pass multicast. */
+  pass0 = ip4_address_is_multicast (&ip0->src_address)
+    || ip0->src_address.as_u32 == clib_host_to_net_u32 (0xFFFFFFFF);
+
+  if (IP4_SOURCE_CHECK_REACHABLE_VIA_RX == source_check_type)
+    pass0 |= fib_urpf_check (lb0->lb_urpf,
+			     vnet_buffer (p0)->sw_if_index[VLIB_RX]);
+  else
+    pass0 |= fib_urpf_check_size (lb0->lb_urpf);
+
+  return pass0;
+}
+
 always_inline uword
 ip4_source_check_inline (vlib_main_t * vm,
 			 vlib_node_runtime_t * node,
@@ -181,26 +202,9 @@ ip4_source_check_inline (vlib_main_t * vm,
 	  lb0 = load_balance_get (lb_index0);
 	  lb1 = load_balance_get (lb_index1);
 
-	  /* Pass multicast. */
-	  pass0 = ip4_address_is_multicast (&ip0->src_address)
-	    || ip0->src_address.as_u32 == clib_host_to_net_u32 (0xFFFFFFFF);
-	  pass1 = ip4_address_is_multicast (&ip1->src_address)
-	    || ip1->src_address.as_u32 == clib_host_to_net_u32 (0xFFFFFFFF);
-
-	  if (IP4_SOURCE_CHECK_REACHABLE_VIA_RX == source_check_type)
-	    {
-	      pass0 |= fib_urpf_check (lb0->lb_urpf,
-				       vnet_buffer (p0)->sw_if_index
-				       [VLIB_RX]);
-	      pass1 |=
-		fib_urpf_check (lb1->lb_urpf,
-				vnet_buffer (p1)->sw_if_index[VLIB_RX]);
-	    }
-	  else
-	    {
-	      pass0 |= fib_urpf_check_size (lb0->lb_urpf);
-	      pass1 |= fib_urpf_check_size (lb1->lb_urpf);
-	    }
+	  pass0 = ip4_source_check_pass (p0, ip0, lb0, source_check_type);
+	  pass1 = ip4_source_check_pass (p1, ip1, lb1, source_check_type);
+
 	  next0 = (pass0 ? next0 : IP4_SOURCE_CHECK_NEXT_DROP);
 	  next1 = (pass1 ? next1 : IP4_SOURCE_CHECK_NEXT_DROP);
 
@@ -253,20 +257,7 @@ ip4_source_check_inline (vlib_main_t * vm,
 
 	  lb0 = load_balance_get (lb_index0);
 
-	  /* Pass multicast. */
-	  pass0 = ip4_address_is_multicast (&ip0->src_address)
-	    || ip0->src_address.as_u32 == clib_host_to_net_u32 (0xFFFFFFFF);
-
-	  if (IP4_SOURCE_CHECK_REACHABLE_VIA_RX == source_check_type)
-	    {
-	      pass0 |= fib_urpf_check (lb0->lb_urpf,
-				       vnet_buffer (p0)->sw_if_index
-				       [VLIB_RX]);
-	    }
-	  else
-	    {
-	      pass0 |= fib_urpf_check_size (lb0->lb_urpf);
-	    }
+	  pass0 = ip4_source_check_pass (p0, ip0, lb0, source_check_type);
 
 	  next0 = (pass0 ? next0 : IP4_SOURCE_CHECK_NEXT_DROP);
 	  p0->error =
@@ -283,6 +274,42 @@ ip4_source_check_inline (vlib_main_t * vm,
   return frame->n_vectors;
 }
 
+always_inline u32
+ip4_source_check_fused_inline (vlib_main_t * vm,
+			       vlib_buffer_t * p0,
+			       ip4_source_check_config_t * c0,
+			       ip4_source_check_type_t source_check_type)
+{
+  ip4_header_t *ip0 = vlib_buffer_get_current (p0);
+  const load_balance_t *lb0;
+
+  lb0 = load_balance_get (ip4_fib_forwarding_lookup (c0->fib_index,
+						     &ip0->src_address));
+
+  if (ip4_source_check_pass (p0, ip0, lb0, source_check_type))
+    return VNET_FEATURE_FUSED_CONTINUE;
+
+  p0->error = vlib_node_get_runtime (vm, ip4_input_node.index)->errors
+    [IP4_ERROR_UNICAST_SOURCE_CHECK_FAILS];
+  return IP4_SOURCE_CHECK_NEXT_DROP;
+}
+
+u32
+ip4_source_check_via_any_fused (vlib_main_t * vm, vlib_buffer_t * b,
+				void *feature_config)
+{
+  return ip4_source_check_fused_inline (vm, b, feature_config,
+				       IP4_SOURCE_CHECK_REACHABLE_VIA_ANY);
+}
+
+u32
+ip4_source_check_via_rx_fused (vlib_main_t * vm, vlib_buffer_t * b,
+			       void *feature_config)
+{
+  return ip4_source_check_fused_inline (vm, b, feature_config,
+				       IP4_SOURCE_CHECK_REACHABLE_VIA_RX);
+}
+
 static uword
 ip4_source_check_reachable_via_any (vlib_main_t * vm,
 				    vlib_node_runtime_t * node,
@@ -50,6 +50,7 @@
 #include <vppinfra/bihash_24_8.h>
 #include <vppinfra/bihash_template.h>
 #include <vnet/util/radix.h>
+#include <vnet/ip/ip6_mtrie.h>
 
 /*
  * Default size of the ip6 fib hash table
@@ -71,6 +72,9 @@ typedef struct
 
   /* Index into FIB vector. */
   u32 index;
+
+  /* Forwarding mtrie, null when the table uses the shared hash */
+  ip6_fib_mtrie_t *mtrie;
 } ip6_fib_t;
 
 typedef struct ip6_mfib_t
@@ -203,6 +207,15 @@ typedef struct ip6_main_t
   u32 lookup_table_nbuckets;
   uword lookup_table_size;
 
+  /** Create new tables with an mtrie for forwarding lookups */
+  u8 mtrie_by_default;
+
+  /** Heapsize for the Mtries */
+  uword mtrie_heap_size;
+
+  /** The memory heap for the mtries */
+  void *mtrie_mheap;
+
   /* Seed for Jenkins hash used to compute ip6 flow hash. */
   u32 flow_hash_seed;
 
@@ -404,6 +417,9 @@ void ip6_punt_redirect_add (u32 rx_sw_if_index,
 			    u32 tx_sw_if_index, ip46_address_t * nh);
 void ip6_punt_redirect_del (u32 rx_sw_if_index);
 
+vnet_feature_fused_function_t ip6_inacl_fused;
+vnet_feature_fused_function_t ip6_policer_classify_fused;
+
 int vnet_set_ip6_classify_intfc (vlib_main_t * vm, u32 sw_if_index,
 				 u32 table_index);
 extern vlib_node_registration_t ip6_lookup_node;
@@ -462,6 +478,29 @@ ip6_compute_flow_hash (const ip6_header_t * ip,
   return (u32) c;
 }
 
+/**
+ * Compute the flow hash, or re-use the one cached in the buffer by an
+ * earlier stage (or the NIC). See ip4_compute_flow_hash_cached.
+ */
+always_inline u32
+ip6_compute_flow_hash_cached (vlib_buffer_t * b,
+			      const ip6_header_t * ip,
+			      flow_hash_config_t flow_hash_config)
+{
+  u32 hash;
+
+  if (PREDICT_FALSE (IP_FLOW_HASH_DEFAULT != flow_hash_config))
+    return (ip6_compute_flow_hash (ip, flow_hash_config));
+
+  if (vnet_buffer_flow_hash_get (b, &hash))
+    return (hash);
+
+  hash = ip6_compute_flow_hash (ip, flow_hash_config);
+  vnet_buffer_flow_hash_set (b, (hash >> 1) | (hash << 31));
+
+  return (hash);
+}
+
 /* ip6_locate_header
  *
  * This function is to search for the header specified by the protocol number
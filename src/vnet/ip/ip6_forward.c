@@ -129,8 +129,8 @@ ip6_lookup_inline (vlib_main_t * vm,
 	  fib_index1 = (vnet_buffer (p1)->sw_if_index[VLIB_TX] == (u32) ~ 0) ?
 	    fib_index1 : vnet_buffer (p1)->sw_if_index[VLIB_TX];
 
-	  lbi0 = ip6_fib_table_fwding_lookup (im, fib_index0, dst_addr0);
-	  lbi1 = ip6_fib_table_fwding_lookup (im, fib_index1, dst_addr1);
+	  ip6_fib_table_fwding_lookup_x2 (im, fib_index0, fib_index1,
+					  dst_addr0, dst_addr1, &lbi0, &lbi1);
 
 	  lb0 = load_balance_get (lbi0);
 	  lb1 = load_balance_get (lbi1);
@@ -145,7 +145,7 @@ ip6_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config0 = lb0->lb_hash_config;
 	      vnet_buffer (p0)->ip.flow_hash =
-		ip6_compute_flow_hash (ip0, flow_hash_config0);
+		ip6_compute_flow_hash_cached (p0, ip0, flow_hash_config0);
 	      dpo0 =
 		load_balance_get_fwd_bucket (lb0,
 					     (vnet_buffer (p0)->ip.flow_hash &
@@ -159,7 +159,7 @@ ip6_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config1 = lb1->lb_hash_config;
 	      vnet_buffer (p1)->ip.flow_hash =
-		ip6_compute_flow_hash (ip1, flow_hash_config1);
+		ip6_compute_flow_hash_cached (p1, ip1, flow_hash_config1);
 	      dpo1 =
 		load_balance_get_fwd_bucket (lb1,
 					     (vnet_buffer (p1)->ip.flow_hash &
@@ -276,7 +276,7 @@ ip6_lookup_inline (vlib_main_t * vm,
 	    {
 	      flow_hash_config0 = lb0->lb_hash_config;
 	      vnet_buffer (p0)->ip.flow_hash =
-		ip6_compute_flow_hash (ip0, flow_hash_config0);
+		ip6_compute_flow_hash_cached (p0, ip0, flow_hash_config0);
 	      dpo0 =
 		load_balance_get_fwd_bucket (lb0,
 					     (vnet_buffer (p0)->ip.flow_hash &
@@ -585,6 +585,7 @@ VNET_FEATURE_INIT (ip6_inacl, static) =
   .arc_name = "ip6-unicast",
   .node_name = "ip6-inacl",
   .runs_before = VNET_FEATURES ("ip6-policer-classify"),
+  .fused_function = ip6_inacl_fused,
 };
 
 VNET_FEATURE_INIT (ip6_policer_classify, static) =
@@ -592,6 +593,7 @@ VNET_FEATURE_INIT (ip6_policer_classify, static) =
   .arc_name = "ip6-unicast",
   .node_name = "ip6-policer-classify",
   .runs_before = VNET_FEATURES ("ipsec-input-ip6"),
+  .fused_function = ip6_policer_classify_fused,
 };
 
 VNET_FEATURE_INIT (ip6_ipsec, static) =
@@ -827,7 +829,7 @@ ip6_load_balance (vlib_main_t * vm,
 	      else
 		{
 		  hc0 = vnet_buffer (p0)->ip.flow_hash =
-		    ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+		    ip6_compute_flow_hash_cached (p0, ip0, lb0->lb_hash_config);
 		}
 	      dpo0 =
 		load_balance_get_fwd_bucket (lb0,
@@ -848,7 +850,7 @@ ip6_load_balance (vlib_main_t * vm,
 	      else
 		{
 		  hc1 = vnet_buffer (p1)->ip.flow_hash =
-		    ip6_compute_flow_hash (ip1, lb1->lb_hash_config);
+		    ip6_compute_flow_hash_cached (p1, ip1, lb1->lb_hash_config);
 		}
 	      dpo1 =
 		load_balance_get_fwd_bucket (lb1,
@@ -925,7 +927,7 @@ ip6_load_balance (vlib_main_t * vm,
 	      else
 		{
 		  hc0 = vnet_buffer (p0)->ip.flow_hash =
-		    ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+		    ip6_compute_flow_hash_cached (p0, ip0, lb0->lb_hash_config);
 		}
 	      dpo0 =
 		load_balance_get_fwd_bucket (lb0,
@@ -3497,6 +3499,11 @@ ip6_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "heap-size %U",
 			 unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "mtrie-heap-size %U",
+			 unformat_memory_size, &im->mtrie_heap_size))
+	;
+      else if (unformat (input, "mtrie"))
+	im->mtrie_by_default = 1;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, input);
@@ -0,0 +1,1015 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * ip6_mtrie.c: ip6 multi-bit trie forwarding lookup
+ *
+ * The same controlled prefix expansion as the ip4 mtrie: a 16 bit root
+ * ply followed by up to 14 8 bit plies. A lookup costs one memory access
+ * per ply visited, i.e. 1 + (prefix length - 16) / 8 for the matching
+ * prefix, independent of how many distinct prefix lengths the table has.
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip6_mtrie.h>
+#include <sys/fcntl.h>
+
+/**
+ * Global pool of IPv6 8bit PLYs
+ */
+ip6_fib_mtrie_8_ply_t *ip6_ply_pool;
+
+always_inline u32
+ip6_fib_mtrie_leaf_is_non_empty (ip6_fib_mtrie_8_ply_t * p, u8 dst_byte)
+{
+  /*
+   * It's 'non-empty' if the length of the leaf stored is greater than the
+   * length of a leaf in the covering ply. i.e. the leaf is more specific
+   * than it's would be cover in the covering ply
+   */
+  if (p->dst_address_bits_of_leaves[dst_byte] > p->dst_address_bits_base)
+    return (1);
+  return (0);
+}
+
+always_inline ip6_fib_mtrie_leaf_t
+ip6_fib_mtrie_leaf_set_lb_index (u32 lb_index)
+{
+  ip6_fib_mtrie_leaf_t l;
+  l = 1 + 2 * lb_index;
+  ASSERT (ip6_fib_mtrie_leaf_get_lb_index (l) == lb_index);
+  return l;
+}
+
+always_inline u32
+ip6_fib_mtrie_leaf_is_next_ply (ip6_fib_mtrie_leaf_t n)
+{
+  return (n & 1) == 0;
+}
+
+always_inline u32
+ip6_fib_mtrie_leaf_get_next_ply_index (ip6_fib_mtrie_leaf_t n)
+{
+  ASSERT (ip6_fib_mtrie_leaf_is_next_ply (n));
+  return n >> 1;
+}
+
+always_inline ip6_fib_mtrie_leaf_t
+ip6_fib_mtrie_leaf_set_next_ply_index (u32 i)
+{
+  ip6_fib_mtrie_leaf_t l;
+  l = 0 + 2 * i;
+  ASSERT (ip6_fib_mtrie_leaf_get_next_ply_index (l) == i);
+  return l;
+}
+
+static void
+ply_leaves_init (ip6_fib_mtrie_leaf_t * leaves, u32 n_leaves,
+		 ip6_fib_mtrie_leaf_t init)
+{
+  u32 i;
+
+  for (i = 0; i < n_leaves; i++)
+    leaves[i] = init;
+}
+
+static void
+ply_8_init (ip6_fib_mtrie_8_ply_t * p,
+	    ip6_fib_mtrie_leaf_t init, uword prefix_len, u32 ply_base_len)
+{
+  /*
+   * A leaf is 'empty' if it represents a leaf from the covering PLY
+   * i.e. if the prefix length of the leaf is less than or equal to
+   * the prefix length of the PLY
+   */
+  p->n_non_empty_leafs = (prefix_len > ply_base_len ?
+			  ARRAY_LEN (p->leaves) : 0);
+  memset (p->dst_address_bits_of_leaves, prefix_len,
+	  sizeof (p->dst_address_bits_of_leaves));
+  p->dst_address_bits_base = ply_base_len;
+  ply_leaves_init (p->leaves, ARRAY_LEN (p->leaves), init);
+}
+
+static void
+ply_16_init (ip6_fib_mtrie_16_ply_t * p,
+	     ip6_fib_mtrie_leaf_t init, uword prefix_len)
+{
+  memset (p->dst_address_bits_of_leaves, prefix_len,
+	  sizeof (p->dst_address_bits_of_leaves));
+  ply_leaves_init (p->leaves, ARRAY_LEN (p->leaves), init);
+}
+
+/** Default heap size for the IPv6 mtries */
+#define IP6_FIB_DEFAULT_MTRIE_HEAP_SIZE (256<<20)
+
+static void *
+ip6_mtrie_heap (void)
+{
+  ip6_main_t *im = &ip6_main;
+  CLIB_UNUSED (ip6_fib_mtrie_8_ply_t * p);
+  void *old_heap;
+
+  if (PREDICT_TRUE (im->mtrie_mheap != 0))
+    return im->mtrie_mheap;
+
+  /* Created on first use, most tables never enable the mtrie */
+  if (0 == im->mtrie_heap_size)
+    im->mtrie_heap_size = IP6_FIB_DEFAULT_MTRIE_HEAP_SIZE;
+  im->mtrie_mheap = mheap_alloc (0, im->mtrie_heap_size);
+
+  /* Burn one ply so index 0 is taken */
+  old_heap = clib_mem_set_heap (im->mtrie_mheap);
+  pool_get (ip6_ply_pool, p);
+  clib_mem_set_heap (old_heap);
+
+  return im->mtrie_mheap;
+}
+
+static ip6_fib_mtrie_leaf_t
+ply_create (ip6_fib_mtrie_t * m,
+	    ip6_fib_mtrie_leaf_t init_leaf,
+	    u32 leaf_prefix_len, u32 ply_base_len)
+{
+  ip6_fib_mtrie_8_ply_t *p;
+  void *old_heap;
+  /* Get cache aligned ply. */
+
+  old_heap = clib_mem_set_heap (ip6_mtrie_heap ());
+  pool_get_aligned (ip6_ply_pool, p, CLIB_CACHE_LINE_BYTES);
+  clib_mem_set_heap (old_heap);
+
+  ply_8_init (p, init_leaf, leaf_prefix_len, ply_base_len);
+  return ip6_fib_mtrie_leaf_set_next_ply_index (p - ip6_ply_pool);
+}
+
+static void
+ply_free (ip6_fib_mtrie_8_ply_t * p)
+{
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip6_mtrie_heap ());
+  pool_put (ip6_ply_pool, p);
+  clib_mem_set_heap (old_heap);
+}
+
+always_inline ip6_fib_mtrie_8_ply_t *
+get_next_ply_for_leaf (ip6_fib_mtrie_t * m, ip6_fib_mtrie_leaf_t l)
+{
+  uword n = ip6_fib_mtrie_leaf_get_next_ply_index (l);
+
+  return pool_elt_at_index (ip6_ply_pool, n);
+}
+
+ip6_fib_mtrie_t *
+ip6_mtrie_alloc (void)
+{
+  ip6_fib_mtrie_t *m;
+  void *old_heap;
+
+  old_heap = clib_mem_set_heap (ip6_mtrie_heap ());
+  m = clib_mem_alloc_aligned (sizeof (*m), CLIB_CACHE_LINE_BYTES);
+  clib_mem_set_heap (old_heap);
+
+  ply_16_init (&m->root_ply, IP6_FIB_MTRIE_LEAF_EMPTY, 0);
+
+  return m;
+}
+
+static void
+ply_free_recursive (ip6_fib_mtrie_t * m, ip6_fib_mtrie_8_ply_t * p)
+{
+  uword i;
+
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    if (ip6_fib_mtrie_leaf_is_next_ply (p->leaves[i]))
+      ply_free_recursive (m, get_next_ply_for_leaf (m, p->leaves[i]));
+  ply_free (p);
+}
+
+void
+ip6_mtrie_free (ip6_fib_mtrie_t * m)
+{
+  void *old_heap;
+  uword i;
+
+  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+    if (ip6_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]))
+      ply_free_recursive (m, get_next_ply_for_leaf (m,
+						    m->root_ply.leaves[i]));
+
+  old_heap = clib_mem_set_heap (ip6_mtrie_heap ());
+  clib_mem_free (m);
+  clib_mem_set_heap (old_heap);
+}
+
+typedef struct
+{
+  ip6_address_t dst_address;
+  u32 dst_address_length;
+  u32 lb_index;
+  u32 cover_address_length;
+  u32 cover_lb_index;
+} ip6_fib_mtrie_set_unset_leaf_args_t;
+
+static void
+set_ply_with_more_specific_leaf (ip6_fib_mtrie_t * m,
+				 ip6_fib_mtrie_8_ply_t * ply,
+				 ip6_fib_mtrie_leaf_t new_leaf,
+				 uword new_leaf_dst_address_bits)
+{
+  ip6_fib_mtrie_leaf_t old_leaf;
+  uword i;
+
+  ASSERT (ip6_fib_mtrie_leaf_is_terminal (new_leaf));
+
+  for (i = 0; i < ARRAY_LEN (ply->leaves); i++)
+    {
+      old_leaf = ply->leaves[i];
+
+      /* Recurse into sub plies. */
+      if (!ip6_fib_mtrie_leaf_is_terminal (old_leaf))
+	{
+	  ip6_fib_mtrie_8_ply_t *sub_ply =
+	    get_next_ply_for_leaf (m, old_leaf);
+	  set_ply_with_more_specific_leaf (m, sub_ply, new_leaf,
+					   new_leaf_dst_address_bits);
+	}
+
+      /* Replace less specific terminal leaves with new leaf. */
+      else if (new_leaf_dst_address_bits >=
+	       ply->dst_address_bits_of_leaves[i])
+	{
+	  __sync_val_compare_and_swap (&ply->leaves[i], old_leaf, new_leaf);
+	  ASSERT (ply->leaves[i] == new_leaf);
+	  ply->dst_address_bits_of_leaves[i] = new_leaf_dst_address_bits;
+	  ply->n_non_empty_leafs += ip6_fib_mtrie_leaf_is_non_empty (ply, i);
+	}
+    }
+}
+
+static void
+set_leaf (ip6_fib_mtrie_t * m,
+	  const ip6_fib_mtrie_set_unset_leaf_args_t * a,
+	  u32 old_ply_index, u32 dst_address_byte_index)
+{
+  ip6_fib_mtrie_leaf_t old_leaf, new_leaf;
+  i32 n_dst_bits_next_plies;
+  u8 dst_byte;
+  ip6_fib_mtrie_8_ply_t *old_ply;
+
+  old_ply = pool_elt_at_index (ip6_ply_pool, old_ply_index);
+
+  ASSERT (a->dst_address_length <= 128);
+  ASSERT (dst_address_byte_index < ARRAY_LEN (a->dst_address.as_u8));
+
+  /* how many bits of the destination address are in the next PLY */
+  n_dst_bits_next_plies =
+    a->dst_address_length - BITS (u8) * (dst_address_byte_index + 1);
+
+  dst_byte = a->dst_address.as_u8[dst_address_byte_index];
+
+  /* Number of bits next plies <= 0 => insert leaves this ply. */
+  if (n_dst_bits_next_plies <= 0)
+    {
+      /* The mask length of the address to insert maps to this ply */
+      uword old_leaf_is_terminal;
+      u32 i, n_dst_bits_this_ply;
+
+      /* The number of bits, and hence slots/buckets, we will fill */
+      n_dst_bits_this_ply = clib_min (8, -n_dst_bits_next_plies);
+      ASSERT ((a->dst_address.as_u8[dst_address_byte_index] &
+	       pow2_mask (n_dst_bits_this_ply)) == 0);
+
+      /* Starting at the value of the byte at this section of the v6 address
+       * fill the buckets/slots of the ply */
+      for (i = dst_byte; i < dst_byte + (1 << n_dst_bits_this_ply); i++)
+	{
+	  ip6_fib_mtrie_8_ply_t *new_ply;
+
+	  old_leaf = old_ply->leaves[i];
+	  old_leaf_is_terminal = ip6_fib_mtrie_leaf_is_terminal (old_leaf);
+
+	  if (a->dst_address_length >= old_ply->dst_address_bits_of_leaves[i])
+	    {
+	      /* The new leaf is more or equally specific than the one currently
+	       * occupying the slot */
+	      new_leaf = ip6_fib_mtrie_leaf_set_lb_index (a->lb_index);
+
+	      if (old_leaf_is_terminal)
+		{
+		  /* The current leaf is terminal, we can replace it with
+		   * the new one */
+		  old_ply->n_non_empty_leafs -=
+		    ip6_fib_mtrie_leaf_is_non_empty (old_ply, i);
+
+		  old_ply->dst_address_bits_of_leaves[i] =
+		    a->dst_address_length;
+		  __sync_val_compare_and_swap (&old_ply->leaves[i], old_leaf,
+					       new_leaf);
+		  ASSERT (old_ply->leaves[i] == new_leaf);
+
+		  old_ply->n_non_empty_leafs +=
+		    ip6_fib_mtrie_leaf_is_non_empty (old_ply, i);
+		  ASSERT (old_ply->n_non_empty_leafs <=
+			  ARRAY_LEN (old_ply->leaves));
+		}
+	      else
+		{
+		  /* Existing leaf points to another ply.  We need to place
+		   * new_leaf into all more specific slots. */
+		  new_ply = get_next_ply_for_leaf (m, old_leaf);
+		  set_ply_with_more_specific_leaf (m, new_ply, new_leaf,
+						   a->dst_address_length);
+		}
+	    }
+	  else if (!old_leaf_is_terminal)
+	    {
+	      /* The current leaf is less specific and not terminal (i.e. a
+	       * ply), recurse on down the trie */
+	      new_ply = get_next_ply_for_leaf (m, old_leaf);
+	      set_leaf (m, a, new_ply - ip6_ply_pool,
+			dst_address_byte_index + 1);
+	    }
+	  /*
+	   * else
+	   *  the route we are adding is less specific than the leaf currently
+	   *  occupying this slot. leave it there
+	   */
+	}
+    }
+  else
+    {
+      /* The address to insert requires us to move down at a lower level of
+       * the trie - recurse on down */
+      ip6_fib_mtrie_8_ply_t *new_ply;
+      u8 ply_base_len;
+
+      ply_base_len = 8 * (dst_address_byte_index + 1);
+
+      old_leaf = old_ply->leaves[dst_byte];
+
+      if (ip6_fib_mtrie_leaf_is_terminal (old_leaf))
+	{
+	  /* There is a leaf occupying the slot. Replace it with a new ply */
+	  old_ply->n_non_empty_leafs -=
+	    ip6_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
+
+	  new_leaf = ply_create (m, old_leaf,
+				 clib_max (old_ply->dst_address_bits_of_leaves
+					   [dst_byte], ply_base_len),
+				 ply_base_len);
+	  new_ply = get_next_ply_for_leaf (m, new_leaf);
+
+	  /* Refetch since ply_create may move pool. */
+	  old_ply = pool_elt_at_index (ip6_ply_pool, old_ply_index);
+
+	  __sync_val_compare_and_swap (&old_ply->leaves[dst_byte], old_leaf,
+				       new_leaf);
+	  ASSERT (old_ply->leaves[dst_byte] == new_leaf);
+	  old_ply->dst_address_bits_of_leaves[dst_byte] = ply_base_len;
+
+	  old_ply->n_non_empty_leafs +=
+	    ip6_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
+	  ASSERT (old_ply->n_non_empty_leafs >= 0);
+	}
+      else
+	new_ply = get_next_ply_for_leaf (m, old_leaf);
+
+      set_leaf (m, a, new_ply - ip6_ply_pool, dst_address_byte_index + 1);
+    }
+}
+
+static void
+set_root_leaf (ip6_fib_mtrie_t * m,
+	       const ip6_fib_mtrie_set_unset_leaf_args_t * a)
+{
+  ip6_fib_mtrie_leaf_t old_leaf, new_leaf;
+  ip6_fib_mtrie_16_ply_t *old_ply;
+  i32 n_dst_bits_next_plies;
+  u16 dst_byte;
+
+  old_ply = &m->root_ply;
+
+  ASSERT (a->dst_address_length <= 128);
+
+  /* how many bits of the destination address are in the next PLY */
+  n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
+
+  dst_byte = a->dst_address.as_u16[0];
+
+  /* Number of bits next plies <= 0 => insert leaves this ply. */
+  if (n_dst_bits_next_plies <= 0)
+    {
+      /* The mask length of the address to insert maps to this ply */
+      uword old_leaf_is_terminal;
+      u32 i, n_dst_bits_this_ply;
+
+      /* The number of bits, and hence slots/buckets, we will fill */
+      n_dst_bits_this_ply = 16 - a->dst_address_length;
+      ASSERT ((clib_host_to_net_u16 (a->dst_address.as_u16[0]) &
+	       pow2_mask (n_dst_bits_this_ply)) == 0);
+
+      /* Starting at the value of the first 2 bytes of the v6 address
+       * fill the buckets/slots of the ply */
+      for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
+	{
+	  ip6_fib_mtrie_8_ply_t *new_ply;
+	  u16 slot;
+
+	  slot = clib_net_to_host_u16 (dst_byte);
+	  slot += i;
+	  slot = clib_host_to_net_u16 (slot);
+
+	  old_leaf = old_ply->leaves[slot];
+	  old_leaf_is_terminal = ip6_fib_mtrie_leaf_is_terminal (old_leaf);
+
+	  if (a->dst_address_length >=
+	      old_ply->dst_address_bits_of_leaves[slot])
+	    {
+	      /* The new leaf is more or equally specific than the one currently
+	       * occupying the slot */
+	      new_leaf = ip6_fib_mtrie_leaf_set_lb_index (a->lb_index);
+
+	      if (old_leaf_is_terminal)
+		{
+		  /* The current leaf is terminal, we can replace it with
+		   * the new one */
+		  old_ply->dst_address_bits_of_leaves[slot] =
+		    a->dst_address_length;
+		  __sync_val_compare_and_swap (&old_ply->leaves[slot],
+					       old_leaf, new_leaf);
+		  ASSERT (old_ply->leaves[slot] == new_leaf);
+		}
+	      else
+		{
+		  /* Existing leaf points to another ply.  We need to place
+		   * new_leaf into all more specific slots. */
+		  new_ply = get_next_ply_for_leaf (m, old_leaf);
+		  set_ply_with_more_specific_leaf (m, new_ply, new_leaf,
+						   a->dst_address_length);
+		}
+	    }
+	  else if (!old_leaf_is_terminal)
+	    {
+	      /* The current leaf is less specific and not terminal (i.e. a
+	       * ply), recurse on down the trie */
+	      new_ply = get_next_ply_for_leaf (m, old_leaf);
+	      set_leaf (m, a, new_ply - ip6_ply_pool, 2);
+	    }
+	  /*
+	   * else
+	   *  the route we are adding is less specific than the leaf currently
+	   *  occupying this slot. leave it there
+	   */
+	}
+    }
+  else
+    {
+      /* The address to insert requires us to move down at a lower level of
+       * the trie - recurse on down */
+      ip6_fib_mtrie_8_ply_t *new_ply;
+      u8 ply_base_len;
+
+      ply_base_len = 16;
+
+      old_leaf = old_ply->leaves[dst_byte];
+
+      if (ip6_fib_mtrie_leaf_is_terminal (old_leaf))
+	{
+	  /* There is a leaf occupying the slot. Replace it with a new ply */
+	  new_leaf = ply_create (m, old_leaf,
+				 clib_max (old_ply->dst_address_bits_of_leaves
+					   [dst_byte], ply_base_len),
+				 ply_base_len);
+	  new_ply = get_next_ply_for_leaf (m, new_leaf);
+
+	  __sync_val_compare_and_swap (&old_ply->leaves[dst_byte], old_leaf,
+				       new_leaf);
+	  ASSERT (old_ply->leaves[dst_byte] == new_leaf);
+	  old_ply->dst_address_bits_of_leaves[dst_byte] = ply_base_len;
+	}
+      else
+	new_ply = get_next_ply_for_leaf (m, old_leaf);
+
+      set_leaf (m, a, new_ply - ip6_ply_pool, 2);
+    }
+}
+
+static uword
+unset_leaf (ip6_fib_mtrie_t * m,
+	    const ip6_fib_mtrie_set_unset_leaf_args_t * a,
+	    ip6_fib_mtrie_8_ply_t * old_ply, u32 dst_address_byte_index)
+{
+  ip6_fib_mtrie_leaf_t old_leaf, del_leaf;
+  i32 n_dst_bits_next_plies;
+  i32 i, n_dst_bits_this_ply, old_leaf_is_terminal;
+  u8 dst_byte;
+
+  ASSERT (a->dst_address_length <= 128);
+  ASSERT (dst_address_byte_index < ARRAY_LEN (a->dst_address.as_u8));
+
+  n_dst_bits_next_plies =
+    a->dst_address_length - BITS (u8) * (dst_address_byte_index + 1);
+
+  dst_byte = a->dst_address.as_u8[dst_address_byte_index];
+  if (n_dst_bits_next_plies < 0)
+    dst_byte &= ~pow2_mask (-n_dst_bits_next_plies);
+
+  n_dst_bits_this_ply =
+    n_dst_bits_next_plies <= 0 ? -n_dst_bits_next_plies : 0;
+  n_dst_bits_this_ply = clib_min (8, n_dst_bits_this_ply);
+
+  del_leaf = ip6_fib_mtrie_leaf_set_lb_index (a->lb_index);
+
+  for (i = dst_byte; i < dst_byte + (1 << n_dst_bits_this_ply); i++)
+    {
+      old_leaf = old_ply->leaves[i];
+      old_leaf_is_terminal = ip6_fib_mtrie_leaf_is_terminal (old_leaf);
+
+      if (old_leaf == del_leaf
+	  || (!old_leaf_is_terminal
+	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf),
+			     dst_address_byte_index + 1)))
+	{
+	  old_ply->n_non_empty_leafs -=
+	    ip6_fib_mtrie_leaf_is_non_empty (old_ply, i);
+
+	  old_ply->leaves[i] =
+	    ip6_fib_mtrie_leaf_set_lb_index (a->cover_lb_index);
+	  old_ply->dst_address_bits_of_leaves[i] =
+	    clib_max (old_ply->dst_address_bits_base,
+		      a->cover_address_length);
+
+	  old_ply->n_non_empty_leafs +=
+	    ip6_fib_mtrie_leaf_is_non_empty (old_ply, i);
+
+	  ASSERT (old_ply->n_non_empty_leafs >= 0);
+	  if (old_ply->n_non_empty_leafs == 0 && dst_address_byte_index > 0)
+	    {
+	      ply_free (old_ply);
+	      /* Old ply was deleted. */
+	      return 1;
+	    }
+	}
+    }
+
+  /* Old ply was not deleted. */
+  return 0;
+}
+
+static void
+unset_root_leaf (ip6_fib_mtrie_t * m,
+		 const ip6_fib_mtrie_set_unset_leaf_args_t * a)
+{
+  ip6_fib_mtrie_leaf_t old_leaf, del_leaf;
+  i32 n_dst_bits_next_plies;
+  i32 i, n_dst_bits_this_ply, old_leaf_is_terminal;
+  u16 dst_byte;
+  ip6_fib_mtrie_16_ply_t *old_ply;
+
+  ASSERT (a->dst_address_length <= 128);
+
+  old_ply = &m->root_ply;
+  n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
+
+  dst_byte = a->dst_address.as_u16[0];
+
+  n_dst_bits_this_ply = (n_dst_bits_next_plies <= 0 ?
+			 (16 - a->dst_address_length) : 0);
+
+  del_leaf = ip6_fib_mtrie_leaf_set_lb_index (a->lb_index);
+
+  /* Starting at the value of the first 2 bytes of the v6 address
+   * fill the buckets/slots of the ply */
+  for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
+    {
+      u16 slot;
+
+      slot = clib_net_to_host_u16 (dst_byte);
+      slot += i;
+      slot = clib_host_to_net_u16 (slot);
+
+      old_leaf = old_ply->leaves[slot];
+      old_leaf_is_terminal = ip6_fib_mtrie_leaf_is_terminal (old_leaf);
+
+      if (old_leaf == del_leaf
+	  || (!old_leaf_is_terminal
+	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf), 2)))
+	{
+	  old_ply->leaves[slot] =
+	    ip6_fib_mtrie_leaf_set_lb_index (a->cover_lb_index);
+	  old_ply->dst_address_bits_of_leaves[slot] = a->cover_address_length;
+	}
+    }
+}
+
+static void
+ip6_fib_mtrie_address_mask (ip6_address_t * dst,
+			    const ip6_address_t * src, u32 len)
+{
+  ip6_address_t *mask = &ip6_main.fib_masks[len];
+
+  dst->as_u64[0] = src->as_u64[0] & mask->as_u64[0];
+  dst->as_u64[1] = src->as_u64[1] & mask->as_u64[1];
+}
+
+void
+ip6_fib_mtrie_route_add (ip6_fib_mtrie_t * m,
+			 const ip6_address_t * dst_address,
+			 u32 dst_address_length, u32 lb_index)
+{
+  ip6_fib_mtrie_set_unset_leaf_args_t a;
+
+  /* Honor dst_address_length. Fib masks are in network byte order */
+  ip6_fib_mtrie_address_mask (&a.dst_address, dst_address,
+			      dst_address_length);
+  a.dst_address_length = dst_address_length;
+  a.lb_index = lb_index;
+
+  set_root_leaf (m, &a);
+}
+
+void
+ip6_fib_mtrie_route_del (ip6_fib_mtrie_t * m,
+			 const ip6_address_t * dst_address,
+			 u32 dst_address_length,
+			 u32 lb_index,
+			 u32 cover_address_length, u32 cover_lb_index)
+{
+  ip6_fib_mtrie_set_unset_leaf_args_t a;
+
+  /* Honor dst_address_length. Fib masks are in network byte order */
+  ip6_fib_mtrie_address_mask (&a.dst_address, dst_address,
+			      dst_address_length);
+  a.dst_address_length = dst_address_length;
+  a.lb_index = lb_index;
+  a.cover_lb_index = cover_lb_index;
+  a.cover_address_length = cover_address_length;
+
+  /* the top level ply is never removed */
+  unset_root_leaf (m, &a);
+}
+
+/* Returns number of bytes of memory used by mtrie. */
+static uword
+mtrie_ply_memory_usage (ip6_fib_mtrie_t * m, ip6_fib_mtrie_8_ply_t * p)
+{
+  uword bytes, i;
+
+  bytes = sizeof (p[0]);
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    {
+      ip6_fib_mtrie_leaf_t l = p->leaves[i];
+      if (ip6_fib_mtrie_leaf_is_next_ply (l))
+	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
+    }
+
+  return bytes;
+}
+
+/* Returns number of bytes of memory used by mtrie. */
+uword
+ip6_fib_mtrie_memory_usage (ip6_fib_mtrie_t * m)
+{
+  uword bytes, i;
+
+  bytes = sizeof (*m);
+  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+    {
+      ip6_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
+      if (ip6_fib_mtrie_leaf_is_next_ply (l))
+	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
+    }
+
+  return bytes;
+}
+
+u8 *
+format_ip6_fib_mtrie (u8 * s, va_list * va)
+{
+  ip6_fib_mtrie_t *m = va_arg (*va, ip6_fib_mtrie_t *);
+
+  s = format (s, "mtrie %U (%d plies in all tables)",
+	      format_memory_size, ip6_fib_mtrie_memory_usage (m),
+	      pool_elts (ip6_ply_pool));
+
+  return s;
+}
+
+/*
+ * Lookup benchmark: build a standalone mtrie and, for comparison, a
+ * bihash probed per prefix length the way the default ip6 FIB does,
+ * then time both on the same destinations and check they agree.
+ */
+
+typedef struct
+{
+  ip6_address_t address;
+  u32 length;
+} ip6_mtrie_test_prefix_t;
+
+static u32
+ip6_mtrie_test_random_length (u32 * seed)
+{
+  /* Roughly the shape of the IPv6 Internet table */
+  u32 r = random_u32 (seed) % 100;
+
+  if (r < 50)
+    return 48;
+  if (r < 65)
+    return 32;
+  if (r < 90)
+    return 33 + random_u32 (seed) % 15;
+  return 19 + random_u32 (seed) % 46;
+}
+
+static void
+ip6_mtrie_test_add_prefix (ip6_mtrie_test_prefix_t ** prefixes,
+			   ip6_address_t * address, u32 length)
+{
+  ip6_mtrie_test_prefix_t *p;
+
+  vec_add2 (*prefixes, p, 1);
+  ip6_fib_mtrie_address_mask (&p->address, address, length);
+  p->length = length;
+}
+
+static int
+ip6_mtrie_test_prefix_cmp (void *a1, void *a2)
+{
+  ip6_mtrie_test_prefix_t *p1 = a1, *p2 = a2;
+  int cmp;
+
+  cmp = memcmp (&p1->address, &p2->address, sizeof (p1->address));
+  if (cmp)
+    return cmp;
+  return (int) p1->length - (int) p2->length;
+}
+
+/* Duplicates would make the results ambiguous */
+static void
+ip6_mtrie_test_uniq (ip6_mtrie_test_prefix_t ** prefixes)
+{
+  ip6_mtrie_test_prefix_t *p, *q;
+
+  vec_sort_with_function (*prefixes, ip6_mtrie_test_prefix_cmp);
+
+  q = *prefixes;
+  vec_foreach (p, *prefixes)
+  {
+    if (p > *prefixes && 0 == ip6_mtrie_test_prefix_cmp (p, q - 1))
+      continue;
+    *q++ = *p;
+  }
+  _vec_len (*prefixes) = q - *prefixes;
+}
+
+static clib_error_t *
+ip6_mtrie_test_load (ip6_mtrie_test_prefix_t ** prefixes, char *file_name)
+{
+  unformat_input_t input, line_input;
+  ip6_address_t address;
+  u32 length;
+  u8 *token;
+  int fd;
+
+  fd = open (file_name, O_RDONLY);
+  if (fd < 0)
+    return clib_error_return_unix (0, "open `%s'", file_name);
+
+  /* One route per line, the first a/b token is the prefix. Pipes are
+     treated as blanks so 'bgpdump -m' output works as-is */
+  unformat_init_clib_file (&input, fd);
+  while (unformat_user (&input, unformat_line_input, &line_input))
+    {
+      u8 *c;
+
+      vec_foreach (c, line_input.buffer) if (*c == '|')
+	*c = ' ';
+
+      while (unformat_check_input (&line_input) != UNFORMAT_END_OF_INPUT)
+	{
+	  if (unformat (&line_input, "%U/%d", unformat_ip6_address,
+			&address, &length))
+	    {
+	      if (length <= 128)
+		ip6_mtrie_test_add_prefix (prefixes, &address, length);
+	      break;
+	    }
+	  else if (unformat (&line_input, "%s", &token))
+	    vec_free (token);
+	  else
+	    break;
+	}
+      unformat_free (&line_input);
+    }
+  unformat_free (&input);
+  close (fd);
+
+  return 0;
+}
+
+static clib_error_t *
+ip6_mtrie_test_command_fn (vlib_main_t * vm,
+			   unformat_input_t * input,
+			   vlib_cli_command_t * cmd_arg)
+{
+  ip6_mtrie_test_prefix_t *prefixes = 0, *p;
+  BVT (clib_bihash) hash;
+  BVT (clib_bihash_kv) kv, value;
+  uword *lengths_bitmap = 0;
+  u8 *lengths_in_search_order = 0;
+  ip6_address_t *destinations = 0;
+  u32 *results_mtrie = 0, *results_hash = 0;
+  u32 n_random = 0, n_lookups = 1 << 20, seed = 0xdeadbeef;
+  u32 i, j, n_mismatches = 0;
+  char *file_name = 0;
+  clib_error_t *error = 0;
+  ip6_fib_mtrie_t *m;
+  f64 t0, build_time;
+  u64 c0, mtrie_clocks, hash_clocks;
+  int len;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "file %s", &file_name))
+	;
+      else if (unformat (input, "random %d", &n_random))
+	;
+      else if (unformat (input, "lookups %d", &n_lookups))
+	;
+      else if (unformat (input, "seed %d", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (file_name)
+    {
+      vec_add1 (file_name, 0);
+      error = ip6_mtrie_test_load (&prefixes, file_name);
+      if (error)
+	goto done;
+    }
+
+  for (i = 0; i < n_random; i++)
+    {
+      ip6_address_t address;
+
+      /* Global unicast, 2000::/3 */
+      address.as_u32[0] = random_u32 (&seed);
+      address.as_u32[1] = random_u32 (&seed);
+      address.as_u32[2] = random_u32 (&seed);
+      address.as_u32[3] = random_u32 (&seed);
+      address.as_u8[0] = 0x20 | (address.as_u8[0] & 0x1f);
+      ip6_mtrie_test_add_prefix (&prefixes, &address,
+				 ip6_mtrie_test_random_length (&seed));
+    }
+
+  if (vec_len (prefixes) == 0 || n_lookups == 0)
+    {
+      error = clib_error_return (0, "specify a prefix file or random <n>");
+      goto done;
+    }
+
+  /* The default route gives every lookup a result */
+  {
+    ip6_address_t zero = { };
+    ip6_mtrie_test_add_prefix (&prefixes, &zero, 0);
+  }
+  ip6_mtrie_test_uniq (&prefixes);
+
+  /* Build; leaf value is the prefix index */
+  t0 = vlib_time_now (vm);
+  m = ip6_mtrie_alloc ();
+  vec_foreach (p, prefixes)
+    ip6_fib_mtrie_route_add (m, &p->address, p->length, p - prefixes);
+  build_time = vlib_time_now (vm) - t0;
+
+  BV (clib_bihash_init) (&hash, "ip6 mtrie test",
+			 max_pow2 (vec_len (prefixes)) / 2 + 1,
+			 clib_max (64 << 10, vec_len (prefixes) * 128));
+  vec_foreach (p, prefixes)
+  {
+    kv.key[0] = p->address.as_u64[0];
+    kv.key[1] = p->address.as_u64[1];
+    kv.key[2] = p->length;
+    kv.value = p - prefixes;
+    BV (clib_bihash_add_del) (&hash, &kv, 1);
+    lengths_bitmap = clib_bitmap_set (lengths_bitmap, 128 - p->length, 1);
+  }
+  /* *INDENT-OFF* */
+  clib_bitmap_foreach (i, lengths_bitmap,
+  ({
+    vec_add1 (lengths_in_search_order, 128 - i);
+  }));
+  /* *INDENT-ON* */
+
+  /* Destinations are random hosts inside random prefixes */
+  vec_validate (destinations, n_lookups - 1);
+  for (i = 0; i < n_lookups; i++)
+    {
+      p = prefixes + random_u32 (&seed) % vec_len (prefixes);
+      for (j = 0; j < 4; j++)
+	destinations[i].as_u32[j] = random_u32 (&seed);
+      for (j = 0; j < 2; j++)
+	destinations[i].as_u64[j] =
+	  (destinations[i].as_u64[j] & ~ip6_main.fib_masks[p->length].as_u64[j])
+	  | p->address.as_u64[j];
+    }
+  vec_validate (results_mtrie, n_lookups - 1);
+  vec_validate (results_hash, n_lookups - 1);
+
+  c0 = clib_cpu_time_now ();
+  for (i = 0; i + 2 <= n_lookups; i += 2)
+    ip6_fib_mtrie_lookup_x2 (m, m, destinations + i, destinations + i + 1,
+			     results_mtrie + i, results_mtrie + i + 1);
+  for (; i < n_lookups; i++)
+    results_mtrie[i] = ip6_fib_mtrie_lookup (m, destinations + i);
+  mtrie_clocks = clib_cpu_time_now () - c0;
+
+  c0 = clib_cpu_time_now ();
+  for (i = 0; i < n_lookups; i++)
+    {
+      kv.key[0] = destinations[i].as_u64[0];
+      kv.key[1] = destinations[i].as_u64[1];
+      value.value = 0;
+      for (j = 0; j < vec_len (lengths_in_search_order); j++)
+	{
+	  len = lengths_in_search_order[j];
+	  kv.key[0] &= ip6_main.fib_masks[len].as_u64[0];
+	  kv.key[1] &= ip6_main.fib_masks[len].as_u64[1];
+	  kv.key[2] = len;
+	  if (BV (clib_bihash_search_inline_2) (&hash, &kv, &value) == 0)
+	    break;
+	}
+      results_hash[i] = value.value;
+    }
+  hash_clocks = clib_cpu_time_now () - c0;
+
+  for (i = 0; i < n_lookups; i++)
+    n_mismatches += results_mtrie[i] != results_hash[i];
+
+  vlib_cli_output (vm, "%d prefixes, %d distinct lengths, mtrie built in "
+		   "%.3f sec, %U", vec_len (prefixes),
+		   vec_len (lengths_in_search_order), build_time,
+		   format_ip6_fib_mtrie, m);
+  vlib_cli_output (vm, "%d lookups: mtrie %.2f clocks/lookup, "
+		   "hash %.2f clocks/lookup, %d mismatches",
+		   n_lookups, (f64) mtrie_clocks / n_lookups,
+		   (f64) hash_clocks / n_lookups, n_mismatches);
+
+  ip6_mtrie_free (m);
+  BV (clib_bihash_free) (&hash);
+
+done:
+  vec_free (file_name);
+  vec_free (prefixes);
+  clib_bitmap_free (lengths_bitmap);
+  vec_free (lengths_in_search_order);
+  vec_free (destinations);
+  vec_free (results_mtrie);
+  vec_free (results_hash);
+
+  return error;
+}
+
+/*?
+ * Benchmark the ip6 mtrie against per-prefix-length hash probing, the
+ * default ip6 FIB lookup, on the same table and destinations. Prefixes
+ * come from a file with one route per line (e.g. the output of
+ * 'bgpdump -m' on a RIB dump, the first a/b field is used) and/or are
+ * generated at random with an Internet-like length distribution.
+ *
+ * @cliexpar
+ * @cliexcmd{test ip6 mtrie file /tmp/rib.txt lookups 4000000}
+ * @cliexcmd{test ip6 mtrie random 100000}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip6_mtrie_test_command, static) = {
+  .path = "test ip6 mtrie",
+  .short_help = "test ip6 mtrie [file <prefix-file>] [random <n>] "
+  "[lookups <n>] [seed <n>]",
+  .function = ip6_mtrie_test_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
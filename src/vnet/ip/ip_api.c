@@ -28,6 +28,7 @@
 #include <vnet/ip/ip6_neighbor.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_api.h>
+#include <vnet/fib/fib_walk.h>
 #include <vnet/dpo/drop_dpo.h>
 #include <vnet/dpo/receive_dpo.h>
 #include <vnet/dpo/lookup_dpo.h>
@@ -80,6 +81,7 @@ _(PROXY_ARP_ADD_DEL, proxy_arp_add_del)                                 \
 _(PROXY_ARP_INTFC_ENABLE_DISABLE, proxy_arp_intfc_enable_disable)       \
 _(RESET_FIB, reset_fib)							\
 _(IP_ADD_DEL_ROUTE, ip_add_del_route)                                   \
+_(IP_ROUTE_BULK_ADD_DEL, ip_route_bulk_add_del)                         \
 _(IP_TABLE_ADD_DEL, ip_table_add_del)                                   \
 _(IP_PUNT_POLICE, ip_punt_police)                                       \
 _(IP_PUNT_REDIRECT, ip_punt_redirect)                                   \
@@ -200,6 +202,114 @@ copy_fib_next_hop (fib_route_path_encode_t * api_rpath, void *fp_arg)
 	    sizeof (api_rpath->rpath.frp_addr.ip6));
 }
 
+/**
+ * The number of entries a FIB dump sends to the client before it yields
+ * the main thread. ~0 sends each table in one go, so the client sees a
+ * consistent snapshot at the cost of stalling the control plane.
+ */
+static u32 fib_api_dump_batch = 1024;
+
+/**
+ * How long a yielding dump suspends for between batches
+ */
+#define FIB_API_DUMP_YIELD_TIME 1e-4
+
+u32
+fib_api_dump_batch_size (void)
+{
+  return (fib_api_dump_batch);
+}
+
+int
+fib_api_dump_should_pause (vl_api_registration_t * reg)
+{
+  /*
+   * A full queue would block the main thread in the middle of the dump,
+   * so pause and let the client drain it. Only a dump that yields, to a
+   * shared memory client, can wait; any other blocks as it always has.
+   */
+  return (fib_api_dump_batch != ~0 &&
+	  reg->registration_type <= REGISTRATION_TYPE_SHMEM &&
+	  vlib_in_process_context (vlib_get_main ()) &&
+	  !vl_api_can_send_msg (reg));
+}
+
+vl_api_registration_t *
+fib_api_dump_yield (u32 client_index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vl_api_registration_t *reg;
+
+  reg = vl_api_client_index_to_registration (client_index);
+
+  /*
+   * Only handlers for shared memory clients run in the API process and
+   * can suspend. The socket transport's registration is only valid for
+   * the duration of the handler.
+   */
+  if (!reg ||
+      !vlib_in_process_context (vm) ||
+      reg->registration_type > REGISTRATION_TYPE_SHMEM)
+    return (reg);
+
+  /*
+   * let the rest of the main thread run and wait for the client to drain
+   * its queue, rather than blocking on a full queue.
+   */
+  do
+    {
+      vlib_process_suspend (vm, FIB_API_DUMP_YIELD_TIME);
+      reg = vl_api_client_index_to_registration (client_index);
+    }
+  while (reg && !vl_api_can_send_msg (reg));
+
+  return (reg);
+}
+
+static clib_error_t *
+fib_api_dump_config (vlib_main_t * vm,
+		     unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  u32 batch;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "batch %d", &batch))
+	{
+	  if (0 == batch)
+	    return clib_error_return (0, "batch must be > 0");
+	  fib_api_dump_batch = batch;
+	}
+      else if (unformat (input, "snapshot"))
+	fib_api_dump_batch = ~0;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  return (NULL);
+}
+
+/*?
+ * Control how FIB and MFIB dumps are sent over the API. By default
+ * routes are sent in batches, between which the main thread is yielded
+ * and the dump waits for the client to read its queue. Routes added or
+ * removed during the dump may or may not be seen. With the '<em>snapshot</em>'
+ * option each table is sent in one go, giving the client a consistent
+ * view at the cost of stalling the main thread for large tables.
+ *
+ * @cliexpar
+ * @cliexcmd{set fib dump batch 512}
+ * @cliexcmd{set fib dump snapshot}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (fib_api_dump_config_command, static) = {
+  .path = "set fib dump",
+  .short_help = "set fib dump [batch <n>] [snapshot]",
+  .function = fib_api_dump_config,
+};
+/* *INDENT-ON* */
+
 static void
 send_ip_fib_details (vpe_api_main_t * am,
 		     vl_api_registration_t * reg,
@@ -270,15 +380,27 @@ send_ip_fib_details (vpe_api_main_t * am,
 
 typedef struct vl_api_ip_fib_dump_walk_ctx_t_
 {
-  fib_node_index_t *feis;
+  vl_api_registration_t *reg;
+  u32 context;
 } vl_api_ip_fib_dump_walk_ctx_t;
 
 static fib_table_walk_rc_t
 vl_api_ip_fib_dump_walk (fib_node_index_t fei, void *arg)
 {
   vl_api_ip_fib_dump_walk_ctx_t *ctx = arg;
+  fib_route_path_encode_t *api_rpaths = NULL;
+  fib_table_t *fib_table;
+  fib_prefix_t pfx;
 
-  vec_add1 (ctx->feis, fei);
+  if (fib_api_dump_should_pause (ctx->reg))
+    return (FIB_TABLE_WALK_PAUSE);
+
+  fib_entry_get_prefix (fei, &pfx);
+  fib_table = fib_table_get (fib_entry_get_fib_index (fei), pfx.fp_proto);
+  fib_entry_encode (fei, &api_rpaths);
+  send_ip_fib_details (&vpe_api_main, ctx->reg, fib_table, &pfx,
+		       api_rpaths, ctx->context);
+  vec_free (api_rpaths);
 
   return (FIB_TABLE_WALK_CONTINUE);
 }
@@ -286,46 +408,35 @@ vl_api_ip_fib_dump_walk (fib_node_index_t fei, void *arg)
 static void
 vl_api_ip_fib_dump_t_handler (vl_api_ip_fib_dump_t * mp)
 {
-  vpe_api_main_t *am = &vpe_api_main;
-  vl_api_registration_t *reg;
   ip4_main_t *im = &ip4_main;
   fib_table_t *fib_table;
-  fib_node_index_t *lfeip;
-  fib_prefix_t pfx;
-  u32 fib_index;
-  fib_route_path_encode_t *api_rpaths;
+  fib_table_walk_iter_t iter = {
+    .ftwi_entries = NULL,
+  };
   vl_api_ip_fib_dump_walk_ctx_t ctx = {
-    .feis = NULL,
+    .context = mp->context,
   };
 
-  reg = vl_api_client_index_to_registration (mp->client_index);
-  if (!reg)
+  ctx.reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!ctx.reg)
     return;
 
   /* *INDENT-OFF* */
   pool_foreach (fib_table, im->fibs,
   ({
-    fib_table_walk(fib_table->ft_index,
-                   FIB_PROTOCOL_IP4,
-                   vl_api_ip_fib_dump_walk,
-                   &ctx);
+    fib_table_walk_iter_add (&iter, fib_table->ft_index, FIB_PROTOCOL_IP4);
   }));
   /* *INDENT-ON* */
 
-  vec_sort_with_function (ctx.feis, fib_entry_cmp_for_sort);
-
-  vec_foreach (lfeip, ctx.feis)
-  {
-    fib_entry_get_prefix (*lfeip, &pfx);
-    fib_index = fib_entry_get_fib_index (*lfeip);
-    fib_table = fib_table_get (fib_index, pfx.fp_proto);
-    api_rpaths = NULL;
-    fib_entry_encode (*lfeip, &api_rpaths);
-    send_ip_fib_details (am, reg, fib_table, &pfx, api_rpaths, mp->context);
-    vec_free (api_rpaths);
-  }
+  while (fib_table_walk_iter_next (&iter, fib_api_dump_batch_size (),
+				   vl_api_ip_fib_dump_walk, &ctx))
+    {
+      ctx.reg = fib_api_dump_yield (mp->client_index);
+      if (!ctx.reg)
+	break;
+    }
 
-  vec_free (ctx.feis);
+  fib_table_walk_iter_done (&iter);
 }
 
 static void
@@ -396,73 +507,65 @@ send_ip6_fib_details (vpe_api_main_t * am,
   vl_api_send_msg (reg, (u8 *) mp);
 }
 
-typedef struct apt_ip6_fib_show_ctx_t_
-{
-  u32 fib_index;
-  fib_node_index_t *entries;
-} api_ip6_fib_show_ctx_t;
-
-static void
-api_ip6_fib_table_put_entries (clib_bihash_kv_24_8_t * kvp, void *arg)
+typedef struct vl_api_ip6_fib_dump_walk_ctx_t_
 {
-  api_ip6_fib_show_ctx_t *ctx = arg;
-
-  if ((kvp->key[2] >> 32) == ctx->fib_index)
-    {
-      vec_add1 (ctx->entries, kvp->value);
-    }
-}
+  vl_api_registration_t *reg;
+  u32 context;
+} vl_api_ip6_fib_dump_walk_ctx_t;
 
-static void
-api_ip6_fib_table_get_all (vl_api_registration_t * reg,
-			   vl_api_ip6_fib_dump_t * mp,
-			   fib_table_t * fib_table)
+static fib_table_walk_rc_t
+vl_api_ip6_fib_dump_walk (fib_node_index_t fei, void *arg)
 {
-  vpe_api_main_t *am = &vpe_api_main;
-  ip6_main_t *im6 = &ip6_main;
-  fib_node_index_t *fib_entry_index;
-  api_ip6_fib_show_ctx_t ctx = {
-    .fib_index = fib_table->ft_index,
-    .entries = NULL,
-  };
-  fib_route_path_encode_t *api_rpaths;
+  vl_api_ip6_fib_dump_walk_ctx_t *ctx = arg;
+  fib_route_path_encode_t *api_rpaths = NULL;
+  fib_table_t *fib_table;
   fib_prefix_t pfx;
 
-  BV (clib_bihash_foreach_key_value_pair)
-    ((BVT (clib_bihash) *) & im6->ip6_table[IP6_FIB_TABLE_NON_FWDING].
-     ip6_hash, api_ip6_fib_table_put_entries, &ctx);
+  if (fib_api_dump_should_pause (ctx->reg))
+    return (FIB_TABLE_WALK_PAUSE);
 
-  vec_sort_with_function (ctx.entries, fib_entry_cmp_for_sort);
-
-  vec_foreach (fib_entry_index, ctx.entries)
-  {
-    fib_entry_get_prefix (*fib_entry_index, &pfx);
-    api_rpaths = NULL;
-    fib_entry_encode (*fib_entry_index, &api_rpaths);
-    send_ip6_fib_details (am, reg, fib_table, &pfx, api_rpaths, mp->context);
-    vec_free (api_rpaths);
-  }
+  fib_entry_get_prefix (fei, &pfx);
+  fib_table = fib_table_get (fib_entry_get_fib_index (fei), pfx.fp_proto);
+  fib_entry_encode (fei, &api_rpaths);
+  send_ip6_fib_details (&vpe_api_main, ctx->reg, fib_table, &pfx,
+			api_rpaths, ctx->context);
+  vec_free (api_rpaths);
 
-  vec_free (ctx.entries);
+  return (FIB_TABLE_WALK_CONTINUE);
 }
 
 static void
 vl_api_ip6_fib_dump_t_handler (vl_api_ip6_fib_dump_t * mp)
 {
-  vl_api_registration_t *reg;
   ip6_main_t *im6 = &ip6_main;
   fib_table_t *fib_table;
+  fib_table_walk_iter_t iter = {
+    .ftwi_entries = NULL,
+  };
+  vl_api_ip6_fib_dump_walk_ctx_t ctx = {
+    .context = mp->context,
+  };
 
-  reg = vl_api_client_index_to_registration (mp->client_index);
-  if (!reg)
+  ctx.reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!ctx.reg)
     return;
 
   /* *INDENT-OFF* */
   pool_foreach (fib_table, im6->fibs,
   ({
-    api_ip6_fib_table_get_all(reg, mp, fib_table);
+    fib_table_walk_iter_add (&iter, fib_table->ft_index, FIB_PROTOCOL_IP6);
   }));
   /* *INDENT-ON* */
+
+  while (fib_table_walk_iter_next (&iter, fib_api_dump_batch_size (),
+				   vl_api_ip6_fib_dump_walk, &ctx))
+    {
+      ctx.reg = fib_api_dump_yield (mp->client_index);
+      if (!ctx.reg)
+	break;
+    }
+
+  fib_table_walk_iter_done (&iter);
 }
 
 static void
@@ -515,15 +618,23 @@ send_ip_mfib_details (vl_api_registration_t * reg,
 
 typedef struct vl_api_ip_mfib_dump_ctc_t_
 {
-  fib_node_index_t *entries;
+  vl_api_registration_t *reg;
+  u32 context;
 } vl_api_ip_mfib_dump_ctc_t;
 
 static int
 vl_api_ip_mfib_table_dump_walk (fib_node_index_t fei, void *arg)
 {
   vl_api_ip_mfib_dump_ctc_t *ctx = arg;
+  mfib_table_t *mfib_table;
+
+  if (fib_api_dump_should_pause (ctx->reg))
+    return (MFIB_TABLE_WALK_PAUSE);
 
-  vec_add1 (ctx->entries, fei);
+  mfib_table = mfib_table_get (mfib_entry_get_fib_index (fei),
+			       FIB_PROTOCOL_IP4);
+  send_ip_mfib_details (ctx->reg, ctx->context,
+			mfib_table->mft_table_id, fei);
 
   return (0);
 }
@@ -531,39 +642,36 @@ vl_api_ip_mfib_table_dump_walk (fib_node_index_t fei, void *arg)
 static void
 vl_api_ip_mfib_dump_t_handler (vl_api_ip_mfib_dump_t * mp)
 {
-  vl_api_registration_t *reg;
   ip4_main_t *im = &ip4_main;
   mfib_table_t *mfib_table;
-  fib_node_index_t *mfeip;
+  mfib_table_walk_iter_t iter = {
+    .mtwi_entries = NULL,
+  };
   vl_api_ip_mfib_dump_ctc_t ctx = {
-    .entries = NULL,
+    .context = mp->context,
   };
 
-  reg = vl_api_client_index_to_registration (mp->client_index);
-  if (!reg)
+  ctx.reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!ctx.reg)
     return;
 
   /* *INDENT-OFF* */
   pool_foreach (mfib_table, im->mfibs,
   ({
-    ip4_mfib_table_walk(&mfib_table->v4,
-                        vl_api_ip_mfib_table_dump_walk,
-                        &ctx);
-
-    vec_sort_with_function (ctx.entries, mfib_entry_cmp_for_sort);
+    mfib_table_walk_iter_add (&iter, mfib_table->mft_index,
+                              FIB_PROTOCOL_IP4);
+  }));
+  /* *INDENT-ON* */
 
-    vec_foreach (mfeip, ctx.entries)
+  while (mfib_table_walk_iter_next (&iter, fib_api_dump_batch_size (),
+				    vl_api_ip_mfib_table_dump_walk, &ctx))
     {
-      send_ip_mfib_details (reg, mp->context,
-                            mfib_table->mft_table_id,
-                            *mfeip);
+      ctx.reg = fib_api_dump_yield (mp->client_index);
+      if (!ctx.reg)
+	break;
     }
-    vec_reset_length (ctx.entries);
-
-  }));
-  /* *INDENT-ON* */
 
-  vec_free (ctx.entries);
+  mfib_table_walk_iter_done (&iter);
 }
 
 static void
@@ -610,15 +718,29 @@ send_ip6_mfib_details (vpe_api_main_t * am,
 
 typedef struct vl_api_ip6_mfib_dump_ctc_t_
 {
-  fib_node_index_t *entries;
+  vl_api_registration_t *reg;
+  u32 context;
 } vl_api_ip6_mfib_dump_ctc_t;
 
 static int
 vl_api_ip6_mfib_table_dump_walk (fib_node_index_t fei, void *arg)
 {
   vl_api_ip6_mfib_dump_ctc_t *ctx = arg;
+  fib_route_path_encode_t *api_rpaths = NULL;
+  mfib_table_t *mfib_table;
+  mfib_prefix_t pfx;
 
-  vec_add1 (ctx->entries, fei);
+  if (fib_api_dump_should_pause (ctx->reg))
+    return (MFIB_TABLE_WALK_PAUSE);
+
+  mfib_table = mfib_table_get (mfib_entry_get_fib_index (fei),
+			       FIB_PROTOCOL_IP6);
+  mfib_entry_get_prefix (fei, &pfx);
+  mfib_entry_encode (fei, &api_rpaths);
+  send_ip6_mfib_details (&vpe_api_main, ctx->reg,
+			 mfib_table->mft_table_id,
+			 &pfx, api_rpaths, ctx->context);
+  vec_free (api_rpaths);
 
   return (0);
 }
@@ -626,48 +748,36 @@ vl_api_ip6_mfib_table_dump_walk (fib_node_index_t fei, void *arg)
 static void
 vl_api_ip6_mfib_dump_t_handler (vl_api_ip6_mfib_dump_t * mp)
 {
-  vpe_api_main_t *am = &vpe_api_main;
-  vl_api_registration_t *reg;
   ip6_main_t *im = &ip6_main;
   mfib_table_t *mfib_table;
-  fib_node_index_t *mfeip;
-  mfib_prefix_t pfx;
-  fib_route_path_encode_t *api_rpaths = NULL;
+  mfib_table_walk_iter_t iter = {
+    .mtwi_entries = NULL,
+  };
   vl_api_ip6_mfib_dump_ctc_t ctx = {
-    .entries = NULL,
+    .context = mp->context,
   };
 
-  reg = vl_api_client_index_to_registration (mp->client_index);
-  if (!reg)
+  ctx.reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!ctx.reg)
     return;
 
-
   /* *INDENT-OFF* */
   pool_foreach (mfib_table, im->mfibs,
   ({
-    ip6_mfib_table_walk(&mfib_table->v6,
-                        vl_api_ip6_mfib_table_dump_walk,
-                        &ctx);
-
-    vec_sort_with_function (ctx.entries, mfib_entry_cmp_for_sort);
+    mfib_table_walk_iter_add (&iter, mfib_table->mft_index,
+                              FIB_PROTOCOL_IP6);
+  }));
+  /* *INDENT-ON* */
 
-    vec_foreach(mfeip, ctx.entries)
+  while (mfib_table_walk_iter_next (&iter, fib_api_dump_batch_size (),
+				    vl_api_ip6_mfib_table_dump_walk, &ctx))
     {
-      mfib_entry_get_prefix (*mfeip, &pfx);
-      mfib_entry_encode (*mfeip, &api_rpaths);
-      send_ip6_mfib_details (am, reg,
-                             mfib_table->mft_table_id,
-                             &pfx, api_rpaths,
-                             mp->context);
+      ctx.reg = fib_api_dump_yield (mp->client_index);
+      if (!ctx.reg)
+	break;
     }
-    vec_reset_length (api_rpaths);
-    vec_reset_length (ctx.entries);
-
-  }));
-  /* *INDENT-ON* */
 
-  vec_free (ctx.entries);
-  vec_free (api_rpaths);
+  mfib_table_walk_iter_done (&iter);
 }
 
 static void
@@ -853,6 +963,8 @@ add_del_route_t_handler (u8 is_multipath,
 			 u8 is_dvr,
 			 u8 is_source_lookup,
 			 u8 is_udp_encap,
+			 u8 is_resilient,
+			 u8 is_uniform,
 			 u32 fib_index,
 			 const fib_prefix_t * prefix,
 			 dpo_proto_t next_hop_proto,
@@ -905,6 +1017,10 @@ add_del_route_t_handler (u8 is_multipath,
     path_flags |= FIB_ROUTE_PATH_SOURCE_LOOKUP;
   if (is_multicast)
     entry_flags |= FIB_ENTRY_FLAG_MULTICAST;
+  if (is_resilient)
+    entry_flags |= FIB_ENTRY_FLAG_RESILIENT;
+  if (is_uniform)
+    path_flags |= FIB_ROUTE_PATH_MPLS_UNIFORM;
   if (is_udp_encap)
     {
       path_flags |= FIB_ROUTE_PATH_UDP_ENCAP;
@@ -1145,6 +1261,8 @@ ip4_add_del_route_t_handler (vl_api_ip_add_del_route_t * mp)
 				   mp->is_dvr,
 				   mp->is_source_lookup,
 				   mp->is_udp_encap,
+				   mp->is_resilient,
+				   mp->is_uniform,
 				   fib_index, &pfx, DPO_PROTO_IP4,
 				   &nh,
 				   ntohl (mp->next_hop_id),
@@ -1208,6 +1326,8 @@ ip6_add_del_route_t_handler (vl_api_ip_add_del_route_t * mp)
 				   mp->is_dvr,
 				   mp->is_source_lookup,
 				   mp->is_udp_encap,
+				   mp->is_resilient,
+				   mp->is_uniform,
 				   fib_index, &pfx, DPO_PROTO_IP6,
 				   &nh, ntohl (mp->next_hop_id),
 				   ntohl (mp->next_hop_sw_if_index),
@@ -1237,6 +1357,109 @@ vl_api_ip_add_del_route_t_handler (vl_api_ip_add_del_route_t * mp)
   REPLY_MACRO (VL_API_IP_ADD_DEL_ROUTE_REPLY);
 }
 
+static int
+ip_route_bulk_entry_handler (vl_api_ip_route_bulk_entry_t * e,
+			     fib_protocol_t fproto, u32 table_id)
+{
+  u32 fib_index, next_hop_fib_index;
+  dpo_proto_t dproto;
+  fib_prefix_t pfx;
+  ip46_address_t nh;
+  int rv;
+
+  dproto = fib_proto_to_dpo (fproto);
+
+  rv = add_del_route_check (fproto,
+			    table_id,
+			    e->next_hop_sw_if_index,
+			    dproto,
+			    e->next_hop_table_id,
+			    0, &fib_index, &next_hop_fib_index);
+
+  if (0 != rv)
+    return (rv);
+
+  memset (&pfx, 0, sizeof (pfx));
+  memset (&nh, 0, sizeof (nh));
+  pfx.fp_len = e->dst_address_length;
+  pfx.fp_proto = fproto;
+
+  if (FIB_PROTOCOL_IP6 == fproto)
+    {
+      clib_memcpy (&pfx.fp_addr.ip6, e->dst_address, sizeof (ip6_address_t));
+      clib_memcpy (&nh.ip6, e->next_hop_address, sizeof (ip6_address_t));
+    }
+  else
+    {
+      clib_memcpy (&pfx.fp_addr.ip4, e->dst_address, sizeof (ip4_address_t));
+      clib_memcpy (&nh.ip4, e->next_hop_address, sizeof (ip4_address_t));
+    }
+
+  return (add_del_route_t_handler (e->is_multipath, e->is_add,
+				   0, 0, 0, 0, 0, 0, ~0, 0, 0, 0, 0, 0, 0, 0,
+				   e->is_resilient, 0,
+				   fib_index, &pfx, dproto,
+				   &nh, ~0,
+				   ntohl (e->next_hop_sw_if_index),
+				   next_hop_fib_index,
+				   e->next_hop_weight,
+				   e->next_hop_preference,
+				   MPLS_LABEL_INVALID, NULL));
+}
+
+void
+vl_api_ip_route_bulk_add_del_t_handler (vl_api_ip_route_bulk_add_del_t * mp)
+{
+  vl_api_ip_route_bulk_add_del_reply_t *rmp;
+  vnet_main_t *vnm = vnet_get_main ();
+  fib_protocol_t fproto;
+  u32 ii, count, n_done;
+  int rv = 0;
+
+  vnm->api_errno = 0;
+  fproto = (mp->is_ipv6 ? FIB_PROTOCOL_IP6 : FIB_PROTOCOL_IP4);
+  count = ntohl (mp->count);
+  n_done = 0;
+
+  /* the routes must all be in the message */
+  if (vl_msg_api_get_msg_length (mp) <
+      sizeof (*mp) + (u64) count * sizeof (mp->routes[0]))
+    {
+      rv = VNET_API_ERROR_INVALID_VALUE;
+      goto done;
+    }
+
+  /*
+   * hold the stats lock for the whole batch and defer the back-walks
+   * so that children shared by many of the routes, e.g. the path-lists
+   * of recursive routes, are re-resolved once at the end.
+   */
+  stats_dslock_with_hint (1 /* release hint */ , 2 /* tag */ );
+  fib_walk_sync_defer_begin ();
+
+  for (ii = 0; ii < count; ii++)
+    {
+      rv = ip_route_bulk_entry_handler (&mp->routes[ii], fproto,
+					mp->table_id);
+      rv = (rv == 0) ? vnm->api_errno : rv;
+
+      if (0 != rv)
+	break;
+      n_done++;
+    }
+
+  fib_walk_sync_defer_end ();
+  stats_dsunlock ();
+
+done:
+  /* *INDENT-OFF* */
+  REPLY_MACRO2 (VL_API_IP_ROUTE_BULK_ADD_DEL_REPLY,
+  ({
+    rmp->n_done = htonl (n_done);
+  }));
+  /* *INDENT-ON* */
+}
+
 void
 ip_table_create (fib_protocol_t fproto,
 		 u32 table_id, u8 is_api, const u8 * name)
@@ -2843,6 +3066,15 @@ ip_api_hookup (vlib_main_t * vm)
   foreach_ip_api_msg;
 #undef _
 
+  /*
+   * The (m)FIB dumps only read the tables and yield between batches;
+   * they must not hold the worker barrier while they do so.
+   */
+  am->is_mp_safe[VL_API_IP_FIB_DUMP] = 1;
+  am->is_mp_safe[VL_API_IP6_FIB_DUMP] = 1;
+  am->is_mp_safe[VL_API_IP_MFIB_DUMP] = 1;
+  am->is_mp_safe[VL_API_IP6_MFIB_DUMP] = 1;
+
   /*
    * Set up the (msg_name, crc, message-id) table
    */
@@ -59,6 +59,87 @@ static char *ip_inacl_error_strings[] = {
 #undef _
 };
 
+/*
+ * Look a packet up the chain of tables from *t0p, hash0 being its hash
+ * in that first table, and act on the entry found or on the miss: set
+ * the packet's error and count it, and return the next, or next0 when
+ * the entry or the miss names none of the node's nexts. *t0p and *e0p
+ * are left at the last table looked in and the entry found.
+ */
+always_inline u32
+ip_inacl_lookup (vlib_main_t * vm, vlib_buffer_t * b0,
+		 vnet_classify_table_t ** t0p, vnet_classify_entry_t ** e0p,
+		 u64 hash0, f64 now, u32 n_next_nodes, u32 next0,
+		 vlib_node_runtime_t * error_node, u32 * hits, u32 * misses,
+		 u32 * chain_hits, int is_ip4)
+{
+  vnet_classify_main_t *vcm = input_acl_main.vnet_classify_main;
+  vnet_classify_table_t *t0 = *t0p;
+  vnet_classify_entry_t *e0;
+  int chained = 0;
+  u8 *h0;
+  u8 error0;
+
+  while (1)
+    {
+      if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
+	h0 = (void *) vlib_buffer_get_current (b0) + t0->current_data_offset;
+      else
+	h0 = b0->data;
+
+      if (chained)
+	hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
+      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+      if (e0)
+	{
+	  vnet_buffer (b0)->l2_classify.opaque_index = e0->opaque_index;
+	  vlib_buffer_advance (b0, e0->advance);
+	  next0 = (e0->next_index < n_next_nodes) ? e0->next_index : next0;
+
+	  *hits += 1;
+	  *chain_hits += chained;
+
+	  if (is_ip4)
+	    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+	      IP4_ERROR_INACL_SESSION_DENY : IP4_ERROR_NONE;
+	  else
+	    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+	      IP6_ERROR_INACL_SESSION_DENY : IP6_ERROR_NONE;
+
+	  if (e0->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
+	      e0->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
+	    vnet_buffer (b0)->sw_if_index[VLIB_TX] = e0->metadata;
+	  else if (!chained && e0->action == CLASSIFY_ACTION_SET_METADATA)
+	    vnet_buffer (b0)->ip.adj_index[VLIB_TX] = e0->metadata;
+	  break;
+	}
+
+      if (t0->next_table_index == ~0)
+	{
+	  next0 = (t0->miss_next_index < n_next_nodes) ?
+	    t0->miss_next_index : next0;
+
+	  *misses += 1;
+
+	  if (is_ip4)
+	    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+	      IP4_ERROR_INACL_TABLE_MISS : IP4_ERROR_NONE;
+	  else
+	    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
+	      IP6_ERROR_INACL_TABLE_MISS : IP6_ERROR_NONE;
+	  break;
+	}
+
+      t0 = pool_elt_at_index (vcm->tables, t0->next_table_index);
+      chained = 1;
+    }
+
+  b0->error = error_node->errors[error0];
+  *t0p = t0;
+  *e0p = e0;
+  return next0;
+}
+
 static inline uword
 ip_inacl_inline (vlib_main_t * vm,
 		 vlib_node_runtime_t * node, vlib_frame_t * frame, int is_ip4)
@@ -213,9 +294,6 @@ ip_inacl_inline (vlib_main_t * vm,
 	  u32 table_index0;
 	  vnet_classify_table_t *t0;
 	  vnet_classify_entry_t *e0;
-	  u64 hash0;
-	  u8 *h0;
-	  u8 error0;
 
 	  /* Stride 3 seems to work best */
 	  if (PREDICT_TRUE (n_left_from > 3))
@@ -255,104 +333,11 @@ ip_inacl_inline (vlib_main_t * vm,
 
 	  if (PREDICT_TRUE (table_index0 != ~0))
 	    {
-	      hash0 = vnet_buffer (b0)->l2_classify.hash;
 	      t0 = pool_elt_at_index (vcm->tables, table_index0);
-
-	      if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		h0 =
-		  (void *) vlib_buffer_get_current (b0) +
-		  t0->current_data_offset;
-	      else
-		h0 = b0->data;
-
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-	      if (e0)
-		{
-		  vnet_buffer (b0)->l2_classify.opaque_index
-		    = e0->opaque_index;
-		  vlib_buffer_advance (b0, e0->advance);
-
-		  next0 = (e0->next_index < n_next_nodes) ?
-		    e0->next_index : next0;
-
-		  hits++;
-
-		  if (is_ip4)
-		    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-		      IP4_ERROR_INACL_SESSION_DENY : IP4_ERROR_NONE;
-		  else
-		    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-		      IP6_ERROR_INACL_SESSION_DENY : IP6_ERROR_NONE;
-		  b0->error = error_node->errors[error0];
-
-		  if (e0->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
-		      e0->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-		    vnet_buffer (b0)->sw_if_index[VLIB_TX] = e0->metadata;
-		  else if (e0->action == CLASSIFY_ACTION_SET_METADATA)
-		    vnet_buffer (b0)->ip.adj_index[VLIB_TX] = e0->metadata;
-		}
-	      else
-		{
-		  while (1)
-		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-
-			  misses++;
-
-			  if (is_ip4)
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      IP4_ERROR_INACL_TABLE_MISS : IP4_ERROR_NONE;
-			  else
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      IP6_ERROR_INACL_TABLE_MISS : IP6_ERROR_NONE;
-			  b0->error = error_node->errors[error0];
-			  break;
-			}
-
-		      if (t0->current_data_flag ==
-			  CLASSIFY_FLAG_USE_CURR_DATA)
-			h0 =
-			  (void *) vlib_buffer_get_current (b0) +
-			  t0->current_data_offset;
-		      else
-			h0 = b0->data;
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 = vnet_classify_find_entry
-			(t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-
-			  if (is_ip4)
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      IP4_ERROR_INACL_SESSION_DENY : IP4_ERROR_NONE;
-			  else
-			    error0 = (next0 == ACL_NEXT_INDEX_DENY) ?
-			      IP6_ERROR_INACL_SESSION_DENY : IP6_ERROR_NONE;
-			  b0->error = error_node->errors[error0];
-
-			  if (e0->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e0->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b0)->sw_if_index[VLIB_TX] =
-			      e0->metadata;
-			  break;
-			}
-		    }
-		}
+	      next0 = ip_inacl_lookup (vm, b0, &t0, &e0,
+				       vnet_buffer (b0)->l2_classify.hash,
+				       now, n_next_nodes, next0, error_node,
+				       &hits, &misses, &chain_hits, is_ip4);
 	    }
 
 	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
@@ -384,6 +369,74 @@ ip_inacl_inline (vlib_main_t * vm,
   return frame->n_vectors;
 }
 
+always_inline u32
+ip_inacl_fused_inline (vlib_main_t * vm, vlib_buffer_t * b0, int is_ip4)
+{
+  input_acl_main_t *am = &input_acl_main;
+  vnet_classify_main_t *vcm = am->vnet_classify_main;
+  vlib_node_runtime_t *error_node;
+  vnet_classify_table_t *t0;
+  vnet_classify_entry_t *e0;
+  input_acl_table_id_t tid;
+  u32 table_index0, node_index, n_next_nodes, next0;
+  u32 hits = 0, misses = 0, chain_hits = 0;
+  f64 now;
+  u8 *h0;
+
+  if (is_ip4)
+    {
+      tid = INPUT_ACL_TABLE_IP4;
+      node_index = ip4_inacl_node.index;
+      error_node = vlib_node_get_runtime (vm, ip4_input_node.index);
+    }
+  else
+    {
+      tid = INPUT_ACL_TABLE_IP6;
+      node_index = ip6_inacl_node.index;
+      error_node = vlib_node_get_runtime (vm, ip6_input_node.index);
+    }
+  n_next_nodes = vlib_node_get_runtime (vm, node_index)->n_next_nodes;
+
+  vnet_buffer (b0)->l2_classify.opaque_index = ~0;
+  table_index0 = am->classify_table_index_by_sw_if_index[tid]
+    [vnet_buffer (b0)->sw_if_index[VLIB_RX]];
+
+  if (PREDICT_FALSE (table_index0 == ~0))
+    return VNET_FEATURE_FUSED_CONTINUE;
+
+  t0 = pool_elt_at_index (vcm->tables, table_index0);
+  if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
+    h0 = (void *) vlib_buffer_get_current (b0) + t0->current_data_offset;
+  else
+    h0 = b0->data;
+  now = vlib_time_now_ticks (vm, vnet_feature_fused_cpu_time (vm));
+
+  next0 = ip_inacl_lookup (vm, b0, &t0, &e0,
+			   vnet_classify_hash_packet (t0, h0),
+			   now, n_next_nodes,
+			   VNET_FEATURE_FUSED_CONTINUE, error_node, &hits,
+			   &misses, &chain_hits, is_ip4);
+
+  vlib_node_increment_counter (vm, node_index, hits ? IP_INACL_ERROR_HIT :
+			       IP_INACL_ERROR_MISS, 1);
+  if (chain_hits)
+    vlib_node_increment_counter (vm, node_index, IP_INACL_ERROR_CHAIN_HIT,
+				 1);
+  return next0;
+}
+
+u32
+ip4_inacl_fused (vlib_main_t * vm, vlib_buffer_t * b, void *feature_config)
+{
+  return ip_inacl_fused_inline (vm, b, 1 /* is_ip4 */ );
+}
+
+u32
+ip6_inacl_fused (vlib_main_t * vm, vlib_buffer_t * b, void *feature_config)
+{
+  return ip_inacl_fused_inline (vm, b, 0 /* is_ip4 */ );
+}
+
 static uword
 ip4_inacl (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
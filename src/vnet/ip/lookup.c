@@ -40,6 +40,7 @@
 #include <vnet/ip/ip.h>
 #include <vnet/adj/adj.h>
 #include <vnet/fib/fib_table.h>
+#include <vnet/fib/fib_walk.h>
 #include <vnet/fib/ip4_fib.h>
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/mpls/mpls.h>
@@ -370,10 +371,12 @@ vnet_ip_route_cmd (vlib_main_t * vm,
   dpo_id_t dpo = DPO_INVALID, *dpos = NULL;
   fib_route_path_t *rpaths = NULL, rpath;
   fib_prefix_t *prefixs = NULL, pfx;
+  fib_entry_flag_t entry_flags;
   clib_error_t *error = NULL;
   f64 count;
   int i;
 
+  entry_flags = FIB_ENTRY_FLAG_NONE;
   is_del = 0;
   table_id = 0;
   count = 1;
@@ -419,6 +422,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	is_del = 1;
       else if (unformat (line_input, "add"))
 	is_del = 0;
+      else if (unformat (line_input, "resilient"))
+	entry_flags |= FIB_ENTRY_FLAG_RESILIENT;
       else
 	{
 	  error = unformat_parse_error (line_input);
@@ -489,6 +494,10 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	  incr = 1 << ((FIB_PROTOCOL_IP4 == prefixs[0].fp_proto ? 32 : 128) -
 		       prefixs[i].fp_len);
 
+	  /* coalesce the back-walks across the whole batch */
+	  if (n > 1)
+	    fib_walk_sync_defer_begin ();
+
 	  for (k = 0; k < n; k++)
 	    {
 	      for (j = 0; j < vec_len (rpaths); j++)
@@ -505,6 +514,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 		      error =
 			clib_error_return (0, "Via table %d does not exist",
 					   rpaths[i].frp_fib_index);
+		      if (n > 1)
+			fib_walk_sync_defer_end ();
 		      goto done;
 		    }
 		  rpaths[i].frp_fib_index = fi;
@@ -523,7 +534,7 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 		    fib_table_entry_path_add2 (fib_index,
 					       &rpfx,
 					       FIB_SOURCE_CLI,
-					       FIB_ENTRY_FLAG_NONE,
+					       entry_flags,
 					       &rpaths[j]);
 		}
 
@@ -544,6 +555,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 		}
 	    }
+	  if (n > 1)
+	    fib_walk_sync_defer_end ();
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
 	    vlib_cli_output (vm, "%.6e routes/sec", count / (t[1] - t[0]));
@@ -691,13 +704,16 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
  * second path, 1/4 following the first path:
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.1 GigabitEthernet2/0/0 weight 1}
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.2 GigabitEthernet2/0/0 weight 3}
+ * With 'resilient' the flows of a multipath route stay on their path when
+ * other paths are added or removed, only the flows of a removed path move:
+ * @cliexcmd{ip route add resilient 7.0.0.2/32 via 6.0.0.1 GigabitEthernet2/0/0}
  * To add a route to a particular FIB table (VRF), use:
  * @cliexcmd{ip route add 172.16.24.0/24 table 7 via GigabitEthernet2/0/0}
  ?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip_route_command, static) = {
   .path = "ip route",
-  .short_help = "ip route [add|del] [count <n>] <dst-ip-addr>/<width> [table <table-id>] via [next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value>]",
+  .short_help = "ip route [add|del] [count <n>] [resilient] <dst-ip-addr>/<width> [table <table-id>] via [next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value> [uniform]]",
   .function = vnet_ip_route_cmd,
   .is_mp_safe = 1,
 };
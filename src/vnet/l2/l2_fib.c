@@ -253,6 +253,20 @@ show_l2fib (vlib_main_t * vm,
 			 "Max macs in event: %d",
 			 lm->client_pid, msm->evt_scan_duration,
 			 msm->event_scan_delay, msm->max_macs_in_event);
+      vlib_cli_output (vm, "Aging: %s  Slice budget: %.2f usec",
+		       msm->age_by_wheel ? "by wheel" : "by scan",
+		       msm->scan_slice_budget * 1e6);
+      vlib_cli_output (vm, "  age scan: %d entries in %d slices, "
+		       "max %d per slice",
+		       msm->age_scan_stats.n_entries,
+		       msm->age_scan_stats.n_slices,
+		       msm->age_scan_stats.max_slice_entries);
+      if (lm->client_pid)
+	vlib_cli_output (vm, "  e-scan: %d entries in %d slices, "
+			 "max %d per slice",
+			 msm->evt_scan_stats.n_entries,
+			 msm->evt_scan_stats.n_slices,
+			 msm->evt_scan_stats.max_slice_entries);
     }
 
   if (raw)
@@ -292,6 +306,36 @@ VLIB_CLI_COMMAND (show_l2fib_cli, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+l2fib_set_scan_budget (vlib_main_t * vm,
+		       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  u32 usec;
+
+  if (!unformat (input, "%u", &usec) || usec == 0)
+    return clib_error_return (0, "expected slice budget in usec, got `%U'",
+			      format_unformat_error, input);
+
+  fm->scan_slice_budget = usec * 1e-6;
+  return 0;
+}
+
+/*?
+ * Set how long the MAC aging and event scans may run before yielding
+ * to the packet path. A longer slice finishes a scan of a large table
+ * in fewer slices at the cost of longer pauses for the main thread.
+ *
+ * @cliexpar
+ * @cliexcmd{set l2fib scan-budget 50}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (l2fib_set_scan_budget_cli, static) = {
+  .path = "set l2fib scan-budget",
+  .short_help = "set l2fib scan-budget <usec>",
+  .function = l2fib_set_scan_budget,
+};
+/* *INDENT-ON* */
 
 /* Remove all entries from the l2fib */
 void
@@ -946,40 +990,143 @@ allocate_mac_evt_buf (u32 client, u32 client_index)
   return mp;
 }
 
-static_always_inline f64
-l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
+/* A mac event message being filled for the client */
+typedef struct
+{
+  vl_api_l2_macs_event_t *mp;
+  vl_api_registration_t *reg;
+  u32 client;
+  u32 client_index;
+  u32 evt_idx;
+} l2fib_mac_evt_ctx_t;
+
+static void
+l2fib_mac_evt_begin (l2fib_mac_evt_ctx_t * ctx)
 {
-  l2fib_main_t *fm = &l2fib_main;
   l2learn_main_t *lm = &l2learn_main;
 
-  BVT (clib_bihash) * h = &fm->mac_table;
-  int i, j, k;
-  f64 last_start = start_time;
-  f64 accum_t = 0;
-  f64 delta_t = 0;
-  u32 evt_idx = 0;
-  u32 learn_count = 0;
-  u32 client = lm->client_pid;
-  u32 cl_idx = lm->client_index;
-  vl_api_l2_macs_event_t *mp = 0;
-  vl_api_registration_t *reg = 0;
+  memset (ctx, 0, sizeof (*ctx));
+  ctx->client = lm->client_pid;
+  ctx->client_index = lm->client_index;
+  if (ctx->client)
+    {
+      ctx->mp = allocate_mac_evt_buf (ctx->client, ctx->client_index);
+      ctx->reg = vl_api_client_index_to_registration (ctx->client_index);
+    }
+}
+
+static void
+l2fib_mac_evt_add (l2fib_mac_evt_ctx_t * ctx, l2fib_entry_key_t * key,
+		   u32 sw_if_index, u8 is_del)
+{
+  l2fib_main_t *fm = &l2fib_main;
 
-  if (client)
+  if (PREDICT_FALSE (ctx->evt_idx >= fm->max_macs_in_event))
     {
-      mp = allocate_mac_evt_buf (client, cl_idx);
-      reg = vl_api_client_index_to_registration (lm->client_index);
+      /* event message full, send it and start a new one */
+      if (ctx->reg && vl_api_can_send_msg (ctx->reg))
+	{
+	  ctx->mp->n_macs = htonl (ctx->evt_idx);
+	  vl_api_send_msg (ctx->reg, (u8 *) ctx->mp);
+	  ctx->mp = allocate_mac_evt_buf (ctx->client, ctx->client_index);
+	}
+      else
+	{
+	  if (ctx->reg)
+	    clib_warning ("MAC event to pid %d queue stuffed!"
+			  " %d MAC entries lost", ctx->client, ctx->evt_idx);
+	}
+      ctx->evt_idx = 0;
     }
 
-  for (i = 0; i < h->nbuckets; i++)
+  clib_memcpy (ctx->mp->mac[ctx->evt_idx].mac_addr, key->fields.mac, 6);
+  ctx->mp->mac[ctx->evt_idx].is_del = is_del;
+  ctx->mp->mac[ctx->evt_idx].sw_if_index = htonl (sw_if_index);
+  ctx->evt_idx++;
+}
+
+static void
+l2fib_mac_evt_end (l2fib_mac_evt_ctx_t * ctx)
+{
+  if (ctx->mp == 0)
+    return;
+
+  /*  send any outstanding mac event message else free message buffer */
+  if (ctx->evt_idx)
     {
-      /* allow no more than 20us without a pause */
-      delta_t = vlib_time_now (vm) - last_start;
-      if (delta_t > 20e-6)
+      if (ctx->reg && vl_api_can_send_msg (ctx->reg))
 	{
-	  vlib_process_suspend (vm, 100e-6);	/* suspend for 100 us */
-	  last_start = vlib_time_now (vm);
-	  accum_t += delta_t;
+	  ctx->mp->n_macs = htonl (ctx->evt_idx);
+	  vl_api_send_msg (ctx->reg, (u8 *) ctx->mp);
 	}
+      else
+	{
+	  if (ctx->reg)
+	    clib_warning ("MAC event to pid %d queue stuffed!"
+			  " %d MAC entries lost", ctx->client, ctx->evt_idx);
+	  vl_msg_api_free (ctx->mp);
+	}
+    }
+  else
+    vl_msg_api_free (ctx->mp);
+}
+
+static void
+l2fib_scan_begin (vlib_main_t * vm, l2fib_scan_stats_t * st)
+{
+  memset (st, 0, sizeof (*st));
+  st->slice_start = vlib_time_now (vm);
+}
+
+static void
+l2fib_scan_end_slice (l2fib_scan_stats_t * st, f64 now)
+{
+  st->duration += now - st->slice_start;
+  st->n_slices++;
+  st->n_entries += st->slice_entries;
+  st->max_slice_entries = clib_max (st->max_slice_entries,
+				    st->slice_entries);
+  st->slice_entries = 0;
+}
+
+/* Suspend the scan once it has used up its slice budget */
+static_always_inline void
+l2fib_scan_check_slice (vlib_main_t * vm, l2fib_scan_stats_t * st)
+{
+  f64 now = vlib_time_now (vm);
+
+  if (now - st->slice_start > l2fib_main.scan_slice_budget)
+    {
+      l2fib_scan_end_slice (st, now);
+      vlib_process_suspend (vm, 100e-6);	/* suspend for 100 us */
+      st->slice_start = vlib_time_now (vm);
+    }
+}
+
+static void
+l2fib_scan_end (vlib_main_t * vm, l2fib_scan_stats_t * st)
+{
+  l2fib_scan_end_slice (st, vlib_time_now (vm));
+}
+
+static_always_inline void
+l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only,
+	    l2fib_scan_stats_t * st)
+{
+  l2fib_main_t *fm = &l2fib_main;
+
+  BVT (clib_bihash) * h = &fm->mac_table;
+  int i, j, k;
+  u32 learn_count = 0;
+  l2fib_mac_evt_ctx_t ctx;
+
+  l2fib_mac_evt_begin (&ctx);
+  l2fib_scan_begin (vm, st);
+
+  for (i = 0; i < h->nbuckets; i++)
+    {
+      /* allow no more than the slice budget without a pause */
+      l2fib_scan_check_slice (vm, st);
 
       if (i < (h->nbuckets - 3))
 	{
@@ -1008,47 +1155,23 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      l2fib_entry_key_t key = {.raw = v->kvp[k].key };
 	      l2fib_entry_result_t result = {.raw = v->kvp[k].value };
 
+	      st->slice_entries++;
+
 	      if (result.fields.age_not == 0)
 		learn_count++;
 
-	      if (client)
+	      if (ctx.client && result.fields.lrn_evt)
 		{
-		  if (PREDICT_FALSE (evt_idx >= fm->max_macs_in_event))
-		    {
-		      /* event message full, send it and start a new one */
-		      if (reg && vl_api_can_send_msg (reg))
-			{
-			  mp->n_macs = htonl (evt_idx);
-			  vl_api_send_msg (reg, (u8 *) mp);
-			  mp = allocate_mac_evt_buf (client, cl_idx);
-			}
-		      else
-			{
-			  if (reg)
-			    clib_warning ("MAC event to pid %d queue stuffed!"
-					  " %d MAC entries lost", client,
-					  evt_idx);
-			}
-		      evt_idx = 0;
-		    }
-
-		  if (result.fields.lrn_evt)
-		    {
-		      /* copy mac entry to event msg */
-		      clib_memcpy (mp->mac[evt_idx].mac_addr, key.fields.mac,
-				   6);
-		      mp->mac[evt_idx].is_del = 0;
-		      mp->mac[evt_idx].sw_if_index =
-			htonl (result.fields.sw_if_index);
-		      /* clear event bit and update mac entry */
-		      result.fields.lrn_evt = 0;
-		      BVT (clib_bihash_kv) kv;
-		      kv.key = key.raw;
-		      kv.value = result.raw;
-		      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1);
-		      evt_idx++;
-		      continue;	/* skip aging */
-		    }
+		  /* copy mac entry to event msg */
+		  l2fib_mac_evt_add (&ctx, &key, result.fields.sw_if_index,
+				     0 /* is_del */ );
+		  /* clear event bit and update mac entry */
+		  result.fields.lrn_evt = 0;
+		  BVT (clib_bihash_kv) kv;
+		  kv.key = key.raw;
+		  kv.value = result.raw;
+		  BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1);
+		  continue;	/* skip aging */
 		}
 
 	      if (event_only || result.fields.age_not)
@@ -1074,15 +1197,9 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 		continue;	/* still valid */
 
 	    age_out:
-	      if (client)
-		{
-		  /* copy mac entry to event msg */
-		  clib_memcpy (mp->mac[evt_idx].mac_addr, key.fields.mac, 6);
-		  mp->mac[evt_idx].is_del = 1;
-		  mp->mac[evt_idx].sw_if_index =
-		    htonl (result.fields.sw_if_index);
-		  evt_idx++;
-		}
+	      if (ctx.client)
+		l2fib_mac_evt_add (&ctx, &key, result.fields.sw_if_index,
+				   1 /* is_del */ );
 	      /* delete mac entry */
 	      BVT (clib_bihash_kv) kv;
 	      kv.key = key.raw;
@@ -1096,30 +1213,420 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
   /* keep learn count consistent */
   l2learn_main.global_learn_count = learn_count;
 
-  if (mp)
+  l2fib_mac_evt_end (&ctx);
+  l2fib_scan_end (vm, st);
+}
+
+/**
+ * Track a mac the main thread has just learned or moved: file it on its
+ * bridge domain's aging wheel, and note it for the mac event client.
+ * Only called when all learning happens on the main thread.
+ */
+void
+l2fib_learn_notify (l2fib_entry_key_t * key, l2fib_entry_result_t * result)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  l2fib_age_wheel_t *w;
+  u32 bd_index = key->fields.bd_index;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (!fm->age_by_wheel)
+    return;
+
+  if (result->fields.lrn_evt)
+    vec_add1 (fm->pending_mac_events, key->raw);
+
+  /* a mac is filed once, it is refiled as it comes of age */
+  if (hash_get (fm->age_wheel_keys, key->raw))
+    return;
+
+  if (bd_index >= vec_len (fm->age_wheels))
+    {
+      u32 i, old_len = vec_len (fm->age_wheels);
+      u32 minute = vlib_time_now (fm->vlib_main) / 60;
+
+      vec_validate (fm->age_wheels, bd_index);
+      for (i = old_len; i < vec_len (fm->age_wheels); i++)
+	fm->age_wheels[i].next_minute = minute;
+    }
+
+  w = vec_elt_at_index (fm->age_wheels, bd_index);
+  vec_add1 (w->slots[result->fields.timestamp], key->raw);
+  hash_set (fm->age_wheel_keys, key->raw, 1);
+}
+
+/**
+ * Age the macs filed under one minute of a bridge domain's wheel:
+ * delete those that have not been refreshed within mac_age, and those
+ * of a flushed interface or bd, and refile the others under their
+ * current timestamp. The slot is taken off the wheel first, so macs
+ * learned while the scan is suspended are filed afresh.
+ */
+static void
+l2fib_age_wheel_slot (vlib_main_t * vm, l2fib_mac_evt_ctx_t * ctx,
+		      l2fib_scan_stats_t * st, u32 bd_index, u32 slot,
+		      f64 start_time)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  l2fib_age_wheel_t *w = vec_elt_at_index (fm->age_wheels, bd_index);
+  l2_bridge_domain_t *bd_config;
+  u64 *keys, *kp;
+  BVT (clib_bihash_kv) kv;
+
+  keys = w->slots[slot];
+  w->slots[slot] = 0;
+
+  vec_foreach (kp, keys)
+  {
+    l2fib_scan_check_slice (vm, st);
+    st->slice_entries++;
+
+    kv.key = kp[0];
+    if (BV (clib_bihash_search) (&fm->mac_table, &kv, &kv))
+      {
+	/* deleted since, forget it */
+	hash_unset (fm->age_wheel_keys, kp[0]);
+	continue;
+      }
+
+    l2fib_entry_key_t key = {.raw = kv.key };
+    l2fib_entry_result_t result = {.raw = kv.value };
+
+    if (result.fields.age_not)
+      {
+	/* made static since */
+	hash_unset (fm->age_wheel_keys, kp[0]);
+	continue;
+      }
+
+    u16 sn = l2fib_cur_seq_num (bd_index, result.fields.sw_if_index).as_u16;
+    if (result.fields.sn.as_u16 != sn)
+      goto age_out;		/* stale mac */
+
+    bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+
+    i16 delta = (u8) (start_time / 60) - result.fields.timestamp;
+    delta += delta < 0 ? 256 : 0;
+
+    if (bd_config->mac_age == 0 || delta < bd_config->mac_age)
+      {
+	/* still valid, refile under its latest timestamp */
+	w = vec_elt_at_index (fm->age_wheels, bd_index);
+	vec_add1 (w->slots[result.fields.timestamp], kp[0]);
+	continue;
+      }
+
+  age_out:
+    if (ctx->client)
+      l2fib_mac_evt_add (ctx, &key, result.fields.sw_if_index,
+			 1 /* is_del */ );
+    kv.key = key.raw;
+    BV (clib_bihash_add_del) (&fm->mac_table, &kv, 0);
+    hash_unset (fm->age_wheel_keys, kp[0]);
+    if (l2learn_main.global_learn_count)
+      l2learn_main.global_learn_count--;
+  }
+
+  vec_free (keys);
+}
+
+/**
+ * Age every bridge domain by its wheel, from the last minute aged up to
+ * the one mac_age minutes back. Only the macs filed under those minutes
+ * are looked at.
+ */
+static void
+l2fib_age_wheels (vlib_main_t * vm, f64 start_time, l2fib_scan_stats_t * st)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  l2fib_mac_evt_ctx_t ctx;
+  l2_bridge_domain_t *bd_config;
+  u32 bd_index, minute, last_minute;
+
+  l2fib_mac_evt_begin (&ctx);
+  l2fib_scan_begin (vm, st);
+
+  minute = start_time / 60;
+
+  for (bd_index = 0; bd_index < vec_len (fm->age_wheels); bd_index++)
     {
-      /*  send any outstanding mac event message else free message buffer */
-      if (evt_idx)
+      if (bd_index >= vec_len (l2input_main.bd_configs))
+	break;
+      bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+      if (bd_config->mac_age == 0 || minute < bd_config->mac_age)
+	continue;
+
+      last_minute = minute - bd_config->mac_age;
+
+      /* a slot is a minute mod 256, so no more than a full turn */
+      if ((i32) (last_minute - fm->age_wheels[bd_index].next_minute) >= 256)
+	fm->age_wheels[bd_index].next_minute = last_minute - 255;
+
+      while ((i32) (last_minute - fm->age_wheels[bd_index].next_minute) >= 0)
 	{
-	  if (reg && vl_api_can_send_msg (reg))
-	    {
-	      mp->n_macs = htonl (evt_idx);
-	      vl_api_send_msg (reg, (u8 *) mp);
-	    }
-	  else
-	    {
-	      if (reg)
-		clib_warning ("MAC event to pid %d queue stuffed!"
-			      " %d MAC entries lost", client, evt_idx);
-	      vl_msg_api_free (mp);
-	    }
+	  u32 slot = fm->age_wheels[bd_index].next_minute & 0xff;
+	  fm->age_wheels[bd_index].next_minute++;
+	  l2fib_age_wheel_slot (vm, &ctx, st, bd_index, slot, start_time);
 	}
+    }
+
+  l2fib_mac_evt_end (&ctx);
+  l2fib_scan_end (vm, st);
+}
+
+/**
+ * Report the macs learned or moved since the last call to the mac event
+ * client, from the pending list rather than a table scan.
+ */
+static void
+l2fib_report_pending (vlib_main_t * vm, l2fib_scan_stats_t * st)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  l2fib_mac_evt_ctx_t ctx;
+  BVT (clib_bihash_kv) kv;
+  u64 *keys, *kp;
+
+  l2fib_mac_evt_begin (&ctx);
+  l2fib_scan_begin (vm, st);
+
+  /* take the list, macs learned while suspended go on a new one */
+  keys = fm->pending_mac_events;
+  fm->pending_mac_events = 0;
+
+  vec_foreach (kp, keys)
+  {
+    l2fib_scan_check_slice (vm, st);
+    st->slice_entries++;
+
+    kv.key = kp[0];
+    if (BV (clib_bihash_search) (&fm->mac_table, &kv, &kv))
+      continue;
+
+    l2fib_entry_key_t key = {.raw = kv.key };
+    l2fib_entry_result_t result = {.raw = kv.value };
+
+    if (!result.fields.lrn_evt)
+      continue;			/* reported already */
+
+    if (ctx.client)
+      l2fib_mac_evt_add (&ctx, &key, result.fields.sw_if_index,
+			 0 /* is_del */ );
+    result.fields.lrn_evt = 0;
+    kv.value = result.raw;
+    BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1);
+  }
+
+  vec_free (keys);
+  l2fib_mac_evt_end (&ctx);
+  l2fib_scan_end (vm, st);
+}
+
+static int
+l2fib_test_age_lookup (u64 raw_key, l2fib_entry_result_t * result)
+{
+  BVT (clib_bihash_kv) kv;
+
+  kv.key = raw_key;
+  if (BV (clib_bihash_search) (&l2fib_main.mac_table, &kv, &kv))
+    return 0;
+  result->raw = kv.value;
+  return 1;
+}
+
+static int
+l2fib_test_age_is_filed (l2fib_age_wheel_t * w, u32 slot, u64 raw_key)
+{
+  u64 *kp;
+
+  vec_foreach (kp, w->slots[slot])
+  {
+    if (kp[0] == raw_key)
+      return 1;
+  }
+  return 0;
+}
+
+static clib_error_t *
+l2fib_test_age_command_fn (vlib_main_t * vm,
+			   unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  l2_bridge_domain_t *bd_config;
+  l2fib_age_wheel_t *w;
+  l2fib_mac_evt_ctx_t ctx;
+  l2fib_scan_stats_t st;
+  l2fib_entry_result_t result;
+  BVT (clib_bihash_kv) kv;
+  u8 mac[6] = { 0x52, 0x54, 0x00, 0xa9, 0x00, 0x00 };
+  u8 macs[3][6];
+  u64 keys[3];
+  u32 bd_id = ~0, bd_index, sw_if_index = 0, minute, slot, i;
+  u8 saved_mac_age;
+  int failed = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "bd %u", &bd_id))
+	;
+      else if (unformat (input, "mac %U", unformat_ethernet_address, mac))
+	;
       else
-	vl_msg_api_free (mp);
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!fm->age_by_wheel)
+    return clib_error_return (0, "macs are aged by table scan, "
+			      "as learning is not all on the main thread");
+  if (bd_id == ~0)
+    return clib_error_return (0, "bd not set");
+  bd_index = bd_find_index (&bd_main, bd_id);
+  if (bd_index == ~0)
+    return clib_error_return (0, "bd %u does not exist", bd_id);
+
+  /* the test ages the wheel of the bd, which must have nothing else on it */
+  if (bd_index < vec_len (fm->age_wheels))
+    for (slot = 0; slot < ARRAY_LEN (fm->age_wheels[bd_index].slots); slot++)
+      if (vec_len (fm->age_wheels[bd_index].slots[slot]))
+	return clib_error_return (0, "bd %u has learned macs, "
+				  "pick an idle bd", bd_id);
+
+  /*
+   * Learn three macs at the current minute: the first is refreshed a
+   * minute later, the second made static, and the third left to age.
+   * They are learned on local0, which has no sequence number until then.
+   */
+  l2fib_valid_swif_seq_num (sw_if_index);
+  minute = vlib_time_now (vm) / 60;
+  for (i = 0; i < ARRAY_LEN (keys); i++)
+    {
+      clib_memcpy (macs[i], mac, 6);
+      macs[i][5] += i;
+      keys[i] = l2fib_make_key (macs[i], bd_index);
+
+      l2fib_entry_key_t key = {.raw = keys[i] };
+      result.raw = 0;
+      result.fields.sw_if_index = sw_if_index;
+      result.fields.timestamp = minute & 0xff;
+      result.fields.sn = l2fib_cur_seq_num (bd_index, sw_if_index);
+      result.fields.lrn_evt = 1;
+      kv.key = key.raw;
+      kv.value = result.raw;
+      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1 /* is_add */ );
+      l2learn_main.global_learn_count++;
+      l2fib_learn_notify (&key, &result);
     }
-  return delta_t + accum_t;
+
+  w = vec_elt_at_index (fm->age_wheels, bd_index);
+  for (i = 0; i < ARRAY_LEN (keys); i++)
+    if (!hash_get (fm->age_wheel_keys, keys[i])
+	|| !l2fib_test_age_is_filed (w, minute & 0xff, keys[i]))
+      {
+	vlib_cli_output (vm, "FAIL: %U not filed at learn",
+			 format_ethernet_address, macs[i]);
+	failed = 1;
+      }
+
+  l2fib_report_pending (vm, &st);
+  for (i = 0; i < ARRAY_LEN (keys); i++)
+    if (!l2fib_test_age_lookup (keys[i], &result) || result.fields.lrn_evt)
+      {
+	vlib_cli_output (vm, "FAIL: %U not reported as learned",
+			 format_ethernet_address, macs[i]);
+	failed = 1;
+      }
+
+  if (l2fib_test_age_lookup (keys[0], &result))
+    {
+      result.fields.timestamp = (minute + 1) & 0xff;
+      kv.key = keys[0];
+      kv.value = result.raw;
+      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1 /* is_add */ );
+    }
+  l2fib_add_entry (macs[1], bd_index, sw_if_index, 1 /* static */ , 0, 0);
+
+  /* age the learn minute, then the refresh minute, two minutes on */
+  bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+  saved_mac_age = bd_config->mac_age;
+  bd_config->mac_age = 2;
+
+  l2fib_mac_evt_begin (&ctx);
+  l2fib_scan_begin (vm, &st);
+  l2fib_age_wheel_slot (vm, &ctx, &st, bd_index, minute & 0xff,
+			(minute + 2) * 60);
+  l2fib_mac_evt_end (&ctx);
+  l2fib_scan_end (vm, &st);
+
+  w = vec_elt_at_index (fm->age_wheels, bd_index);
+  if (!l2fib_test_age_lookup (keys[0], &result)
+      || !l2fib_test_age_is_filed (w, (minute + 1) & 0xff, keys[0]))
+    {
+      vlib_cli_output (vm, "FAIL: refreshed mac not refiled");
+      failed = 1;
+    }
+  if (!l2fib_test_age_lookup (keys[1], &result)
+      || hash_get (fm->age_wheel_keys, keys[1]))
+    {
+      vlib_cli_output (vm, "FAIL: static mac aged or left on the wheel");
+      failed = 1;
+    }
+  if (l2fib_test_age_lookup (keys[2], &result)
+      || hash_get (fm->age_wheel_keys, keys[2]))
+    {
+      vlib_cli_output (vm, "FAIL: idle mac not aged out");
+      failed = 1;
+    }
+  if (vec_len (w->slots[minute & 0xff]))
+    {
+      vlib_cli_output (vm, "FAIL: %u macs left under the aged minute",
+		       vec_len (w->slots[minute & 0xff]));
+      failed = 1;
+    }
+
+  l2fib_mac_evt_begin (&ctx);
+  l2fib_scan_begin (vm, &st);
+  l2fib_age_wheel_slot (vm, &ctx, &st, bd_index, (minute + 1) & 0xff,
+			(minute + 3) * 60);
+  l2fib_mac_evt_end (&ctx);
+  l2fib_scan_end (vm, &st);
+
+  if (l2fib_test_age_lookup (keys[0], &result)
+      || hash_get (fm->age_wheel_keys, keys[0]))
+    {
+      vlib_cli_output (vm, "FAIL: refreshed mac not aged out");
+      failed = 1;
+    }
+
+  bd_config->mac_age = saved_mac_age;
+  for (i = 0; i < ARRAY_LEN (keys); i++)
+    l2fib_del_entry (macs[i], bd_index);
+
+  if (failed)
+    return clib_error_return (0, "l2fib age test failed");
+  vlib_cli_output (vm, "l2fib age test passed");
+  return 0;
 }
 
+/*?
+ * Exercise the aging wheel of an idle bridge domain on a simulated
+ * clock, with a mac age of 2 minutes: learn three macs, refresh one a
+ * minute later and make one static, then age the minutes they were
+ * filed under and check which macs are refiled, dropped off the wheel
+ * or aged out. A mac event client sees the test
+ * macs come and go.
+ *
+ * @cliexpar
+ * @cliexcmd{test l2fib age bd 13}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (l2fib_test_age_command, static) = {
+  .path = "test l2fib age",
+  .short_help = "test l2fib age bd <bd-id> [mac <base-addr>]",
+  .function = l2fib_test_age_command_fn,
+};
+/* *INDENT-ON* */
+
 /* Maximum f64 value */
 #define TIME_MAX (1.7976931348623157e+308)
 
@@ -1132,6 +1639,14 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
   l2learn_main_t *lm = &l2learn_main;
   bool enabled = 0;
   f64 start_time, next_age_scan_time = TIME_MAX;
+  l2fib_scan_stats_t evt_stats, age_stats;
+
+  /*
+   * Learned macs can be tracked as they are learned only if the main
+   * thread does all the learning; otherwise scan the table.
+   */
+  fm->age_by_wheel = (vlib_get_thread_main ()->n_vlib_mains == 1
+		      || lm->async_learn);
 
   while (1)
     {
@@ -1151,12 +1666,14 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
       start_time = vlib_time_now (vm);
       enum
       { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_DISABLE } scan = SCAN_MAC_AGE;
+      u8 by_wheel = 0;
 
       switch (event_type)
 	{
 	case ~0:		/* timer expired */
 	  if (lm->client_pid != 0 && start_time < next_age_scan_time)
 	    scan = SCAN_MAC_EVENT;
+	  by_wheel = fm->age_by_wheel;
 	  break;
 
 	case L2_MAC_AGE_PROCESS_EVENT_START:
@@ -1175,16 +1692,40 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	  ASSERT (0);
 	}
 
+      /*
+       * Periodic scans go by the wheels and the pending list when they
+       * can. Starting aging and flushes still scan the whole table,
+       * as they affect macs of any age. A scan suspends between slices,
+       * so it fills in its own stats, published only once it is done.
+       */
       if (scan == SCAN_MAC_EVENT)
-	l2fib_main.evt_scan_duration = l2fib_scan (vm, start_time, 1);
+	{
+	  if (by_wheel)
+	    l2fib_report_pending (vm, &evt_stats);
+	  else
+	    l2fib_scan (vm, start_time, 1, &evt_stats);
+	  fm->evt_scan_stats = evt_stats;
+	  fm->evt_scan_duration = evt_stats.duration;
+	}
       else
 	{
 	  if (scan == SCAN_MAC_AGE)
-	    l2fib_main.age_scan_duration = l2fib_scan (vm, start_time, 0);
+	    {
+	      if (by_wheel)
+		{
+		  l2fib_report_pending (vm, &evt_stats);
+		  fm->evt_scan_stats = evt_stats;
+		  l2fib_age_wheels (vm, start_time, &age_stats);
+		}
+	      else
+		l2fib_scan (vm, start_time, 0, &age_stats);
+	      fm->age_scan_stats = age_stats;
+	      fm->age_scan_duration = age_stats.duration;
+	    }
 	  if (scan == SCAN_DISABLE)
 	    {
-	      l2fib_main.age_scan_duration = 0;
-	      l2fib_main.evt_scan_duration = 0;
+	      fm->age_scan_duration = 0;
+	      fm->evt_scan_duration = 0;
 	    }
 	  /* schedule next scan */
 	  if (enabled)
@@ -1213,6 +1754,8 @@ l2fib_init (vlib_main_t * vm)
 
   mp->vlib_main = vm;
   mp->vnet_main = vnet_get_main ();
+  mp->scan_slice_budget = L2FIB_SCAN_SLICE_BUDGET_DEFAULT;
+  mp->age_wheel_keys = hash_create (0, sizeof (uword));
 
   /* Create the hash table  */
   BV (clib_bihash_init) (&mp->mac_table, "l2fib mac table",
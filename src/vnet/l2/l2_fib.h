@@ -39,6 +39,37 @@
 /* MAC event learn limit is 1000 unless specified by MAC event client */
 #define L2FIB_EVENT_LEARN_LIMIT_DEFAULT	(1000)
 
+/* Ager scan slice budget is 20 usec unless configured */
+#define L2FIB_SCAN_SLICE_BUDGET_DEFAULT	(20e-6)
+
+/*
+ * Aging wheel of a bridge domain: the keys of its learned macs, filed
+ * under the minute of their timestamp. Each minute only the slot that
+ * has come of age is looked at; a mac refreshed since it was filed is
+ * filed again under its new timestamp.
+ */
+typedef struct
+{
+  u64 *slots[256];
+
+  /* the next minute, since boot, to age */
+  u32 next_minute;
+} l2fib_age_wheel_t;
+
+/* Cost of the last event or ager scan */
+typedef struct
+{
+  /* busy time, excluding suspends */
+  f64 duration;
+  u32 n_slices;
+  u32 n_entries;
+  u32 max_slice_entries;
+
+  /* while scanning */
+  f64 slice_start;
+  u32 slice_entries;
+} l2fib_scan_stats_t;
+
 typedef struct
 {
 
@@ -52,6 +83,28 @@ typedef struct
   f64 evt_scan_duration;
   f64 age_scan_duration;
 
+  /* last event or ager scan slicing */
+  l2fib_scan_stats_t evt_scan_stats;
+  l2fib_scan_stats_t age_scan_stats;
+
+  /* longest a scan runs before suspending */
+  f64 scan_slice_budget;
+
+  /*
+   * Set if all learning happens on the main thread, which is when
+   * learned macs can be tracked as they are learned: aging is then
+   * done on the per-bd wheels and mac events from the pending list,
+   * instead of by full table scans.
+   */
+  u8 age_by_wheel;
+
+  /* per bd aging wheels, and the set of keys filed on them */
+  l2fib_age_wheel_t *age_wheels;
+  uword *age_wheel_keys;
+
+  /* keys of macs learned or moved, to report to the mac event client */
+  u64 *pending_mac_events;
+
   /* delay between event scans, default to 100 msec */
   f64 event_scan_delay;
 
@@ -375,6 +428,9 @@ l2fib_lookup_4 (BVT (clib_bihash) * mac_table,
 
 void l2fib_clear_table (void);
 
+void l2fib_learn_notify (l2fib_entry_key_t * key,
+			 l2fib_entry_result_t * result);
+
 void
 l2fib_add_entry (u8 * mac,
 		 u32 bd_index,
@@ -146,8 +146,9 @@ static uword
 l2_input_classify_node_fn (vlib_main_t * vm,
 			   vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
-  u32 n_left_from, *from, *to_next;
-  l2_input_classify_next_t next_index;
+  u32 n_left_from, *from;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
   l2_input_classify_main_t *cm = &l2_input_classify_main;
   vnet_classify_main_t *vcm = cm->vnet_classify_main;
   l2_input_classify_runtime_t *rt =
@@ -164,13 +165,14 @@ l2_input_classify_node_fn (vlib_main_t * vm,
 
   n_left_from = frame->n_vectors;
   from = vlib_frame_vector_args (frame);
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+  b = bufs;
 
   /* First pass: compute hash */
 
   while (n_left_from > 2)
     {
       vlib_buffer_t *b0, *b1;
-      u32 bi0, bi1;
       ethernet_header_t *h0, *h1;
       u32 sw_if_index0, sw_if_index1;
       u16 type0, type1;
@@ -184,8 +186,8 @@ l2_input_classify_node_fn (vlib_main_t * vm,
       {
 	vlib_buffer_t *p1, *p2;
 
-	p1 = vlib_get_buffer (vm, from[1]);
-	p2 = vlib_get_buffer (vm, from[2]);
+	p1 = b[1];
+	p2 = b[2];
 
 	vlib_prefetch_buffer_header (p1, STORE);
 	CLIB_PREFETCH (p1->data, CLIB_CACHE_LINE_BYTES, STORE);
@@ -193,12 +195,10 @@ l2_input_classify_node_fn (vlib_main_t * vm,
 	CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, STORE);
       }
 
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
+      b0 = b[0];
       h0 = vlib_buffer_get_current (b0);
 
-      bi1 = from[1];
-      b1 = vlib_get_buffer (vm, bi1);
+      b1 = b[1];
       h1 = vlib_buffer_get_current (b1);
 
       sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
@@ -231,7 +231,7 @@ l2_input_classify_node_fn (vlib_main_t * vm,
 	  t0 = pool_elt_at_index (vcm->tables, table_index0);
 
 	  vnet_buffer (b0)->l2_classify.hash = hash0 =
-	    vnet_classify_hash_packet (t0, (u8 *) h0);
+	    vnet_classify_hash_packet_inline (t0, (u8 *) h0);
 	  vnet_classify_prefetch_bucket (t0, hash0);
 	}
 
@@ -245,18 +245,17 @@ l2_input_classify_node_fn (vlib_main_t * vm,
 	  t1 = pool_elt_at_index (vcm->tables, table_index1);
 
 	  vnet_buffer (b1)->l2_classify.hash = hash1 =
-	    vnet_classify_hash_packet (t1, (u8 *) h1);
+	    vnet_classify_hash_packet_inline (t1, (u8 *) h1);
 	  vnet_classify_prefetch_bucket (t1, hash1);
 	}
 
-      from += 2;
+      b += 2;
       n_left_from -= 2;
     }
 
   while (n_left_from > 0)
     {
       vlib_buffer_t *b0;
-      u32 bi0;
       ethernet_header_t *h0;
       u32 sw_if_index0;
       u16 type0;
@@ -265,8 +264,7 @@ l2_input_classify_node_fn (vlib_main_t * vm,
       u32 table_index0;
       u64 hash0;
 
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
+      b0 = b[0];
       h0 = vlib_buffer_get_current (b0);
 
       sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
@@ -289,76 +287,79 @@ l2_input_classify_node_fn (vlib_main_t * vm,
 	  t0 = pool_elt_at_index (vcm->tables, table_index0);
 
 	  vnet_buffer (b0)->l2_classify.hash = hash0 =
-	    vnet_classify_hash_packet (t0, (u8 *) h0);
+	    vnet_classify_hash_packet_inline (t0, (u8 *) h0);
 	  vnet_classify_prefetch_bucket (t0, hash0);
 	}
-      from++;
+      b += 1;
       n_left_from--;
     }
 
-  next_index = node->cached_next_index;
-  from = vlib_frame_vector_args (frame);
+  /*
+   * Second pass: prefetch the entries of the whole frame, so the
+   * bucket loads issued above have had the frame's worth of time to
+   * land before any of them is dereferenced.
+   */
+  b = bufs;
   n_left_from = frame->n_vectors;
 
   while (n_left_from > 0)
     {
-      u32 n_left_to_next;
+      vnet_classify_table_t *t0;
+      u32 table_index0;
+
+      table_index0 = vnet_buffer (b[0])->l2_classify.table_index;
+
+      if (PREDICT_TRUE (table_index0 != ~0))
+	{
+	  t0 = pool_elt_at_index (vcm->tables, table_index0);
+	  vnet_classify_prefetch_entry (t0,
+					vnet_buffer (b[0])->l2_classify.hash);
+	}
+
+      b += 1;
+      n_left_from--;
+    }
+
+  /* Third pass: match, walking the table chain on a miss */
+  b = bufs;
+  next = nexts;
+  n_left_from = frame->n_vectors;
+
+  while (n_left_from > 0)
+    {
+      vlib_buffer_t *b0;
+      u32 next0 = ~0;		/* next l2 input feature, please... */
+      ethernet_header_t *h0;
+      u32 table_index0;
+      u64 hash0;
+      vnet_classify_table_t *t0;
+      vnet_classify_entry_t *e0;
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      b0 = b[0];
+      h0 = vlib_buffer_get_current (b0);
+      table_index0 = vnet_buffer (b0)->l2_classify.table_index;
+      e0 = 0;
+      t0 = 0;
+      vnet_buffer (b0)->l2_classify.opaque_index = ~0;
 
-      /* Not enough load/store slots to dual loop... */
-      while (n_left_from > 0 && n_left_to_next > 0)
+      if (PREDICT_TRUE (table_index0 != ~0))
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0 = ~0;	/* next l2 input feature, please... */
-	  ethernet_header_t *h0;
-	  u32 table_index0;
-	  u64 hash0;
-	  vnet_classify_table_t *t0;
-	  vnet_classify_entry_t *e0;
-
-	  if (PREDICT_TRUE (n_left_from > 2))
+	  hash0 = vnet_buffer (b0)->l2_classify.hash;
+	  t0 = pool_elt_at_index (vcm->tables, table_index0);
+
+	  e0 = vnet_classify_find_entry_inline (t0, (u8 *) h0, hash0, now);
+	  if (e0)
 	    {
-	      vlib_buffer_t *p2 = vlib_get_buffer (vm, from[2]);
-	      u64 phash2;
-	      u32 table_index2;
-	      vnet_classify_table_t *tp2;
-
-	      /*
-	       * Prefetch table entry two ahead. Buffer / data
-	       * were prefetched above...
-	       */
-	      table_index2 = vnet_buffer (p2)->l2_classify.table_index;
-
-	      if (PREDICT_TRUE (table_index2 != ~0))
-		{
-		  tp2 = pool_elt_at_index (vcm->tables, table_index2);
-		  phash2 = vnet_buffer (p2)->l2_classify.hash;
-		  vnet_classify_prefetch_entry (tp2, phash2);
-		}
+	      vnet_buffer (b0)->l2_classify.opaque_index = e0->opaque_index;
+	      vlib_buffer_advance (b0, e0->advance);
+	      next0 = (e0->next_index < n_next_nodes) ?
+		e0->next_index : next0;
+	      hits++;
 	    }
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  h0 = vlib_buffer_get_current (b0);
-	  table_index0 = vnet_buffer (b0)->l2_classify.table_index;
-	  e0 = 0;
-	  vnet_buffer (b0)->l2_classify.opaque_index = ~0;
-
-	  if (PREDICT_TRUE (table_index0 != ~0))
+	  else
 	    {
-	      hash0 = vnet_buffer (b0)->l2_classify.hash;
-	      t0 = pool_elt_at_index (vcm->tables, table_index0);
-
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+	      e0 = vnet_classify_find_entry_in_chain (vcm, &t0, (u8 *) h0,
+						      now);
 	      if (e0)
 		{
 		  vnet_buffer (b0)->l2_classify.opaque_index
@@ -367,71 +368,46 @@ l2_input_classify_node_fn (vlib_main_t * vm,
 		  next0 = (e0->next_index < n_next_nodes) ?
 		    e0->next_index : next0;
 		  hits++;
+		  chain_hits++;
 		}
 	      else
 		{
-		  while (1)
-		    {
-		      if (t0->next_table_index != ~0)
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
-		    }
+		  next0 = (t0->miss_next_index < n_next_nodes) ?
+		    t0->miss_next_index : next0;
+		  misses++;
 		}
 	    }
+	}
 
-	  if (PREDICT_FALSE (next0 == 0))
-	    b0->error = node->errors[L2_INPUT_CLASSIFY_ERROR_DROP];
-
-	  /* Determine the next node and remove ourself from bitmap */
-	  if (PREDICT_TRUE (next0 == ~0))
-	    next0 = vnet_l2_feature_next (b0, cm->l2_inp_feat_next,
-					  L2INPUT_FEAT_INPUT_CLASSIFY);
-	  else
-	    vnet_buffer (b0)->l2.feature_bitmap &=
-	      ~L2INPUT_FEAT_INPUT_CLASSIFY;
+      if (PREDICT_FALSE (next0 == 0))
+	b0->error = node->errors[L2_INPUT_CLASSIFY_ERROR_DROP];
 
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
-			     && (b0->flags & VLIB_BUFFER_IS_TRACED)))
-	    {
-	      l2_input_classify_trace_t *t =
-		vlib_add_trace (vm, node, b0, sizeof (*t));
-	      t->sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	      t->table_index = table_index0;
-	      t->next_index = next0;
-	      t->session_offset = e0 ? vnet_classify_get_offset (t0, e0) : 0;
-	    }
+      /* Determine the next node and remove ourself from bitmap */
+      if (PREDICT_TRUE (next0 == ~0))
+	next0 = vnet_l2_feature_next (b0, cm->l2_inp_feat_next,
+				      L2INPUT_FEAT_INPUT_CLASSIFY);
+      else
+	vnet_buffer (b0)->l2.feature_bitmap &= ~L2INPUT_FEAT_INPUT_CLASSIFY;
 
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  l2_input_classify_trace_t *t =
+	    vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+	  t->table_index = table_index0;
+	  t->next_index = next0;
+	  t->session_offset = e0 ? vnet_classify_get_offset (t0, e0) : 0;
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      next[0] = next0;
+      b += 1;
+      next += 1;
+      n_left_from--;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   vlib_node_increment_counter (vm, node->node_index,
 			       L2_INPUT_CLASSIFY_ERROR_MISS, misses);
   vlib_node_increment_counter (vm, node->node_index,
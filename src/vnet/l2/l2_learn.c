@@ -81,7 +81,9 @@ _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
 _(HIT_UPDATE,        "L2 learn hit updates")		\
-_(FILTER_DROP,       "L2 filter mac drops")
+_(FILTER_DROP,       "L2 filter mac drops")		\
+_(QUEUED,            "L2 learn events queued")		\
+_(QUEUE_FULL,        "L2 learn events dropped, queue full")
 
 typedef enum
 {
@@ -105,7 +107,49 @@ typedef enum
 } l2learn_next_t;
 
 
-/** Perform learning on one packet based on the mac table lookup result. */
+/**
+ * Queue a mac table update for the learner. The one-entry lookup cache
+ * is set to the entry as it will be, so the rest of the frame does not
+ * queue the same update again.
+ */
+static_always_inline void
+l2learn_enqueue (l2learn_event_ring_t * ring,
+		 u64 * counter_base,
+		 l2fib_entry_key_t * key0,
+		 l2fib_entry_result_t * result0,
+		 l2fib_entry_key_t * cached_key,
+		 l2fib_entry_result_t * cached_result)
+{
+  l2learn_event_t *e;
+  u32 head = ring->head;
+
+  /* Already queued by an earlier packet of this frame */
+  if (key0->raw == cached_key->raw && result0->raw == cached_result->raw)
+    return;
+
+  if (PREDICT_FALSE (head - ring->tail >= L2LEARN_EVENT_RING_SIZE))
+    {
+      counter_base[L2LEARN_ERROR_QUEUE_FULL] += 1;
+      return;
+    }
+
+  e = &ring->events[head & (L2LEARN_EVENT_RING_SIZE - 1)];
+  e->key.raw = key0->raw;
+  e->result.raw = result0->raw;
+  CLIB_MEMORY_BARRIER ();
+  ring->head = head + 1;
+  counter_base[L2LEARN_ERROR_QUEUED] += 1;
+
+  cached_key->raw = key0->raw;
+  cached_result->raw = result0->raw;
+}
+
+/**
+ * Perform learning on one packet based on the mac table lookup result.
+ * With a ring, the table update is queued for the learner instead of
+ * being written here; until it is applied, traffic to the mac is
+ * flooded as it would be before learning.
+ */
 
 static_always_inline void
 l2learn_process (vlib_node_runtime_t * node,
@@ -115,6 +159,8 @@ l2learn_process (vlib_node_runtime_t * node,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
 		 l2fib_entry_key_t * cached_key,
+		 l2fib_entry_result_t * cached_result,
+		 l2learn_event_ring_t * ring,
 		 u32 * count,
 		 l2fib_entry_result_t * result0, u32 * next0, u8 timestamp)
 {
@@ -167,8 +213,9 @@ l2learn_process (vlib_node_runtime_t * node,
       if (key.raw == 0)
 	return;
 
-      /* It is ok to learn */
-      msm->global_learn_count++;
+      /* It is ok to learn, the learner counts queued entries */
+      if (ring == 0)
+	msm->global_learn_count++;
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       result0->fields.lrn_evt = (msm->client_pid != 0);
@@ -201,7 +248,7 @@ l2learn_process (vlib_node_runtime_t * node,
        * TODO: check global/bridge domain/interface learn limits
        */
       result0->fields.sw_if_index = sw_if_index0;
-      if (result0->fields.age_not)	/* The mac was provisioned */
+      if (result0->fields.age_not && ring == 0)	/* The mac was provisioned */
 	{
 	  msm->global_learn_count++;
 	  result0->fields.age_not = 0;
@@ -214,11 +261,22 @@ l2learn_process (vlib_node_runtime_t * node,
   result0->fields.timestamp = timestamp;
   result0->fields.sn.as_u16 = vnet_buffer (b0)->l2.l2fib_sn;
 
+  if (ring)
+    {
+      l2learn_enqueue (ring, counter_base, key0, result0,
+		       cached_key, cached_result);
+      return;
+    }
+
   BVT (clib_bihash_kv) kv;
   kv.key = key0->raw;
   kv.value = result0->raw;
   BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
 
+  /* Only the main thread learns inline when the fib ages by wheel */
+  if (l2fib_main.age_by_wheel)
+    l2fib_learn_notify (key0, result0);
+
   /* Invalidate the cache */
   cached_key->raw = ~0;
 }
@@ -238,6 +296,11 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   l2fib_entry_result_t cached_result;
   u8 timestamp = (u8) (vlib_time_now (vm) / 60);
   u32 count = 0;
+  l2learn_event_ring_t *ring = 0;
+
+  /* On a worker, queue table updates to the learner */
+  if (msm->async_learn && vm->thread_index != 0)
+    ring = vec_elt_at_index (msm->event_rings, vm->thread_index);
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;	/* number of packets to process */
@@ -373,19 +436,23 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
 			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+			   &cached_result, ring, &count, &result0, &next0,
+			   timestamp);
 
 	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
 			   b1, sw_if_index1, &key1, &cached_key,
-			   &count, &result1, &next1, timestamp);
+			   &cached_result, ring, &count, &result1, &next1,
+			   timestamp);
 
 	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
 			   b2, sw_if_index2, &key2, &cached_key,
-			   &count, &result2, &next2, timestamp);
+			   &cached_result, ring, &count, &result2, &next2,
+			   timestamp);
 
 	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
 			   b3, sw_if_index3, &key3, &cached_key,
-			   &count, &result3, &next3, timestamp);
+			   &cached_result, ring, &count, &result3, &next3,
+			   timestamp);
 
 	  /* verify speculative enqueues, maybe switch current next frame */
 	  /* if next0==next1==next_index then nothing special needs to be done */
@@ -440,7 +507,8 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
 			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+			   &cached_result, ring, &count, &result0, &next0,
+			   timestamp);
 
 	  /* verify speculative enqueue, maybe switch current next frame */
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
@@ -485,9 +553,175 @@ VLIB_REGISTER_NODE (l2learn_node,static) = {
 /* *INDENT-ON* */
 
 VLIB_NODE_FUNCTION_MULTIARCH (l2learn_node, l2learn_node_fn)
-     clib_error_t *l2learn_init (vlib_main_t * vm)
+
+/**
+ * Apply a queued update to the mac table as it is now. The entry may
+ * have been learned, moved, made static or removed since the worker
+ * looked, so the update is redone against the current entry rather
+ * than written as queued.
+ */
+static void
+l2learn_apply_event (l2learn_main_t * msm, l2learn_event_t * e)
+{
+  BVT (clib_bihash_kv) kv;
+  l2fib_entry_result_t result;
+
+  kv.key = e->key.raw;
+  if (BV (clib_bihash_search) (msm->mac_table, &kv, &kv))
+    {
+      /* Not in the table, learn it */
+      if (msm->global_learn_count >= msm->global_learn_limit)
+	{
+	  msm->n_events_stale++;
+	  return;
+	}
+      msm->global_learn_count++;
+      result.raw = 0;
+    }
+  else
+    {
+      result.raw = kv.value;
+
+      if (result.fields.filter || result.fields.static_mac)
+	{
+	  msm->n_events_stale++;
+	  return;
+	}
+
+      if (result.fields.sw_if_index == e->result.fields.sw_if_index)
+	{
+	  /* Refresh, unless it already has been */
+	  if (result.fields.age_not
+	      || (result.fields.timestamp == e->result.fields.timestamp
+		  && result.fields.sn.as_u16 == e->result.fields.sn.as_u16))
+	    {
+	      msm->n_events_stale++;
+	      return;
+	    }
+	}
+      else if (result.fields.age_not)
+	{
+	  /* Move of a provisioned mac, it is learned from now on */
+	  msm->global_learn_count++;
+	  result.fields.age_not = 0;
+	}
+    }
+
+  if (result.fields.sw_if_index != e->result.fields.sw_if_index)
+    result.fields.lrn_evt = (msm->client_pid != 0);
+  result.fields.sw_if_index = e->result.fields.sw_if_index;
+  result.fields.timestamp = e->result.fields.timestamp;
+  result.fields.sn.as_u16 = e->result.fields.sn.as_u16;
+
+  kv.key = e->key.raw;
+  kv.value = result.raw;
+  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
+  msm->n_events_applied++;
+
+  l2fib_learn_notify (&e->key, &result);
+}
+
+#define L2LEARN_EVENT_PROCESS_INTERVAL 1e-3
+
+typedef void (l2learn_apply_function_t) (l2learn_main_t * msm,
+					 l2learn_event_t * e);
+
+/**
+ * Apply up to budget queued events, serving the rings in turn starting
+ * with first_ring. Returns the number applied, and sets throttled if
+ * any ring still has events queued.
+ */
+static u32
+l2learn_drain_rings (l2learn_main_t * msm, l2learn_event_ring_t * rings,
+		     u32 budget, u32 first_ring,
+		     l2learn_apply_function_t * apply, u8 * throttled)
+{
+  l2learn_event_ring_t *ring;
+  u32 n_rings = vec_len (rings);
+  u32 head, tail, n, i, r, n_applied = 0;
+
+  *throttled = 0;
+  for (r = 0; r < n_rings; r++)
+    {
+      ring = vec_elt_at_index (rings, (first_ring + r) % n_rings);
+      tail = ring->tail;
+      head = ring->head;
+      CLIB_MEMORY_BARRIER ();
+
+      n = clib_min (head - tail, budget);
+      for (i = 0; i < n; i++)
+	apply (msm,
+	       &ring->events[(tail + i) & (L2LEARN_EVENT_RING_SIZE - 1)]);
+
+      CLIB_MEMORY_BARRIER ();
+      ring->tail = tail + n;
+      budget -= n;
+      n_applied += n;
+      *throttled |= (head - tail > n);
+    }
+  return n_applied;
+}
+
+/**
+ * The learner: drains the workers' learn event rings into the mac table
+ * on the main thread, at no more than learn_rate events per second.
+ * Events it has no budget for stay queued; a ring that fills up drops
+ * further events on its worker, and those macs are learned from a later
+ * packet.
+ */
+static uword
+l2learn_event_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		       vlib_frame_t * f)
+{
+  l2learn_main_t *msm = &l2learn_main;
+  f64 last_time = vlib_time_now (vm), now;
+  u32 first_ring = 0;
+  u32 budget, n_rings;
+  u8 throttled;
+
+  while (1)
+    {
+      if (!msm->async_learn || vec_len (msm->event_rings) == 0)
+	{
+	  vlib_process_suspend (vm, 1.0);
+	  continue;
+	}
+
+      vlib_process_suspend (vm, L2LEARN_EVENT_PROCESS_INTERVAL);
+
+      now = vlib_time_now (vm);
+      n_rings = vec_len (msm->event_rings);
+      budget = clib_min ((now - last_time) * msm->learn_rate,
+			 n_rings * L2LEARN_EVENT_RING_SIZE);
+      if (budget == 0)
+	continue;
+      last_time = now;
+
+      /* Rotate the first ring served, so no worker is starved */
+      l2learn_drain_rings (msm, msm->event_rings, budget, first_ring,
+			   l2learn_apply_event, &throttled);
+      first_ring = (first_ring + 1) % n_rings;
+
+      if (throttled)
+	msm->n_learner_throttled++;
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (l2learn_event_process_node) = {
+    .function = l2learn_event_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "l2-learn-event-process",
+};
+/* *INDENT-ON* */
+
+clib_error_t *
+l2learn_init (vlib_main_t * vm)
 {
   l2learn_main_t *mp = &l2learn_main;
+  l2learn_event_ring_t *ring;
+  u32 n_vlib_mains = vlib_get_thread_main ()->n_vlib_mains;
 
   mp->vlib_main = vm;
   mp->vnet_main = vnet_get_main ();
@@ -508,6 +742,21 @@ VLIB_NODE_FUNCTION_MULTIARCH (l2learn_node, l2learn_node_fn)
    */
   mp->global_learn_limit = L2LEARN_DEFAULT_LIMIT;
 
+  /*
+   * With workers, learn through the learner by default, so the workers
+   * never contend on the mac table writer lock.
+   */
+  mp->learn_rate = L2LEARN_DEFAULT_LEARN_RATE;
+  if (n_vlib_mains > 1)
+    {
+      mp->async_learn = 1;
+      vec_validate_aligned (mp->event_rings, n_vlib_mains - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_foreach (ring, mp->event_rings)
+	vec_validate_aligned (ring->events, L2LEARN_EVENT_RING_SIZE - 1,
+			      CLIB_CACHE_LINE_BYTES);
+    }
+
   return 0;
 }
 
@@ -578,6 +827,15 @@ l2learn_config (vlib_main_t * vm, unformat_input_t * input)
       if (unformat (input, "limit %d", &mp->global_learn_limit))
 	;
 
+      else if (unformat (input, "learn-rate %u", &mp->learn_rate))
+	{
+	  if (mp->learn_rate == 0)
+	    return clib_error_return (0, "learn-rate must be > 0");
+	}
+
+      else if (unformat (input, "learn-inline"))
+	mp->async_learn = 0;
+
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -588,6 +846,224 @@ l2learn_config (vlib_main_t * vm, unformat_input_t * input)
 
 VLIB_CONFIG_FUNCTION (l2learn_config, "l2learn");
 
+static clib_error_t *
+show_l2learn (vlib_main_t * vm,
+	      unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  l2learn_main_t *msm = &l2learn_main;
+  l2learn_event_ring_t *ring;
+
+  vlib_cli_output (vm, "learned %u, limit %u", msm->global_learn_count,
+		   msm->global_learn_limit);
+
+  if (!msm->async_learn)
+    {
+      vlib_cli_output (vm, "learning inline on the workers");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "learner rate limit %u events/s", msm->learn_rate);
+  vlib_cli_output (vm, "events applied %llu, stale %llu, "
+		   "learner throttled %llu times",
+		   msm->n_events_applied, msm->n_events_stale,
+		   msm->n_learner_throttled);
+
+  vec_foreach (ring, msm->event_rings)
+  {
+    if (ring == msm->event_rings)
+      continue;			/* main thread learns inline */
+    vlib_cli_output (vm, "thread %u: %u events queued",
+		     ring - msm->event_rings, ring->head - ring->tail);
+  }
+
+  return 0;
+}
+
+/*?
+ * Show the state of mac learning: the learned mac count and, when the
+ * workers queue their updates to the learner on the main thread, the
+ * learner's statistics and each worker's queue depth. Events queued
+ * and dropped on a full queue are counted by the l2-learn node.
+ *
+ * @cliexpar
+ * @cliexcmd{show l2learn}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_l2learn_cli, static) = {
+  .path = "show l2learn",
+  .short_help = "show l2learn",
+  .function = show_l2learn,
+};
+/* *INDENT-ON* */
+
+/* Per ring sequence the learner queue test expects next */
+static u32 *l2learn_test_next_seq;
+static u32 l2learn_test_n_applied;
+static u32 l2learn_test_n_out_of_order;
+
+/* Test events carry their ring in the key's high half, a sequence below */
+static void
+l2learn_test_apply_event (l2learn_main_t * msm, l2learn_event_t * e)
+{
+  u32 r = e->key.raw >> 32;
+  u32 seq = e->key.raw & 0xffffffff;
+
+  if (seq != l2learn_test_next_seq[r])
+    l2learn_test_n_out_of_order++;
+  l2learn_test_next_seq[r] = seq + 1;
+  l2learn_test_n_applied++;
+}
+
+/*
+ * Fill scratch rings as workers would, queueing each event twice, and
+ * drain them as the learner would, on a simulated clock. Checks that a
+ * full ring drops, that an event just queued is not queued again, that
+ * no interval applies more than its budget, and that every queued event
+ * is applied in order. The mac table and the live rings are untouched.
+ */
+static clib_error_t *
+test_l2learn_queue_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  l2learn_main_t *msm = &l2learn_main;
+  l2learn_event_ring_t *rings = 0, *ring;
+  l2fib_entry_key_t key, cached_key;
+  l2fib_entry_result_t result, cached_result;
+  u64 counters[L2LEARN_N_ERROR];
+  u32 n_rings = 2, n_events = L2LEARN_EVENT_RING_SIZE + 100;
+  u32 rate = msm->learn_rate;
+  u32 n_expected, budget, n, first_ring = 0, i;
+  u64 n_intervals = 0, max_intervals, n_dropped;
+  f64 now = 0, last_time = 0;
+  u8 throttled;
+  int failed = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rings %u", &n_rings))
+	;
+      else if (unformat (input, "events %u", &n_events))
+	;
+      else if (unformat (input, "rate %u", &rate))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_rings == 0 || rate == 0)
+    return clib_error_return (0, "rings and rate must be > 0");
+
+  vec_validate_aligned (rings, n_rings - 1, CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ring, rings)
+    vec_validate_aligned (ring->events, L2LEARN_EVENT_RING_SIZE - 1,
+			  CLIB_CACHE_LINE_BYTES);
+  vec_reset_length (l2learn_test_next_seq);
+  vec_validate (l2learn_test_next_seq, n_rings - 1);
+  l2learn_test_n_applied = l2learn_test_n_out_of_order = 0;
+  memset (counters, 0, sizeof (counters));
+
+  vec_foreach (ring, rings)
+  {
+    cached_key.raw = cached_result.raw = ~0ULL;
+    for (i = 0; i < n_events; i++)
+      {
+	key.raw = ((u64) (ring - rings) << 32) | i;
+	result.raw = i;
+	l2learn_enqueue (ring, counters, &key, &result, &cached_key,
+			 &cached_result);
+	l2learn_enqueue (ring, counters, &key, &result, &cached_key,
+			 &cached_result);
+      }
+  }
+
+  n_expected = n_rings * clib_min (n_events, L2LEARN_EVENT_RING_SIZE);
+  if (counters[L2LEARN_ERROR_QUEUED] != n_expected)
+    {
+      vlib_cli_output (vm, "FAIL: %llu events queued, expected %u",
+		       counters[L2LEARN_ERROR_QUEUED], n_expected);
+      failed = 1;
+    }
+  /* an event dropped on a full ring is not cached, so both copies drop */
+  n_dropped = 2 * ((u64) n_rings * n_events - n_expected);
+  if (counters[L2LEARN_ERROR_QUEUE_FULL] != n_dropped)
+    {
+      vlib_cli_output (vm, "FAIL: %llu events dropped, expected %llu",
+		       counters[L2LEARN_ERROR_QUEUE_FULL], n_dropped);
+      failed = 1;
+    }
+
+  /* Twice the time the rate allows for, and at least a few intervals */
+  max_intervals = 2 * (u64) (n_expected /
+			     (L2LEARN_EVENT_PROCESS_INTERVAL * rate)) + 16;
+
+  while (l2learn_test_n_applied < counters[L2LEARN_ERROR_QUEUED]
+	 && n_intervals < max_intervals)
+    {
+      n_intervals++;
+      now = n_intervals * L2LEARN_EVENT_PROCESS_INTERVAL;
+      budget = clib_min ((now - last_time) * rate,
+			 n_rings * L2LEARN_EVENT_RING_SIZE);
+      if (budget == 0)
+	continue;
+      last_time = now;
+
+      n = l2learn_drain_rings (msm, rings, budget, first_ring,
+			       l2learn_test_apply_event, &throttled);
+      first_ring = (first_ring + 1) % n_rings;
+      if (n > budget)
+	{
+	  vlib_cli_output (vm, "FAIL: %u events applied on a budget of %u",
+			   n, budget);
+	  failed = 1;
+	}
+    }
+
+  if (l2learn_test_n_applied != counters[L2LEARN_ERROR_QUEUED])
+    {
+      vlib_cli_output (vm, "FAIL: %u of %llu events applied in %llu "
+		       "intervals", l2learn_test_n_applied,
+		       counters[L2LEARN_ERROR_QUEUED], n_intervals);
+      failed = 1;
+    }
+  if (l2learn_test_n_out_of_order)
+    {
+      vlib_cli_output (vm, "FAIL: %u events applied out of order",
+		       l2learn_test_n_out_of_order);
+      failed = 1;
+    }
+
+  vlib_cli_output (vm, "%u rings, %u events each at %u events/s: "
+		   "%llu queued, %llu dropped, drained in %.3fs",
+		   n_rings, n_events, rate, counters[L2LEARN_ERROR_QUEUED],
+		   counters[L2LEARN_ERROR_QUEUE_FULL], now);
+
+  vec_foreach (ring, rings) vec_free (ring->events);
+  vec_free (rings);
+
+  if (failed)
+    return clib_error_return (0, "l2learn queue test failed");
+  return 0;
+}
+
+/*?
+ * Exercise the queue between the workers and the learner on scratch
+ * rings: fill them as the l2-learn node does, drain them at the given
+ * rate as the learner does on a simulated clock, and check what was
+ * queued, dropped and applied. Safe to run on a live system.
+ *
+ * @cliexpar
+ * @cliexcmd{test l2learn queue rings 4 events 5000 rate 100000}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_l2learn_queue_cli, static) = {
+  .path = "test l2learn queue",
+  .short_help = "test l2learn queue [rings <n>] [events <n>] [rate <n>]",
+  .function = test_l2learn_queue_command_fn,
+};
+/* *INDENT-ON* */
+
 
 /*
  * fd.io coding-style-patch-verification: ON
@@ -20,7 +20,40 @@
 
 #include <vlib/vlib.h>
 #include <vnet/ethernet/ethernet.h>
+#include <vnet/l2/l2_fib.h>
 
+/*
+ * A learn, move or refresh of a mac entry, queued by a worker for the
+ * learner on the main thread. The result is the entry the worker would
+ * have written; the learner checks it against the table as it is by
+ * then before writing it.
+ */
+typedef struct
+{
+  l2fib_entry_key_t key;
+  l2fib_entry_result_t result;
+} l2learn_event_t;
+
+/*
+ * Single producer (a worker), single consumer (the learner) ring of
+ * learn events. Head and tail are free running, each written by one
+ * side only, on cache lines of their own.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 head;
+
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 tail;
+
+  l2learn_event_t *events;
+} l2learn_event_ring_t;
+
+#define L2LEARN_EVENT_RING_SIZE (4 << 10)
+
+/* default learner rate limit, events per second */
+#define L2LEARN_DEFAULT_LEARN_RATE (256 << 10)
 
 typedef struct
 {
@@ -38,6 +71,20 @@ typedef struct
   u32 client_pid;
   u32 client_index;
 
+  /* workers queue their table updates to the learner, if set */
+  u8 async_learn;
+
+  /* learn event rings, by thread index, if there are workers */
+  l2learn_event_ring_t *event_rings;
+
+  /* learner rate limit, events per second */
+  u32 learn_rate;
+
+  /* learner statistics */
+  u64 n_events_applied;
+  u64 n_events_stale;
+  u64 n_learner_throttled;
+
   /* Next nodes for each feature */
   u32 feat_next_node_index[32];
 
@@ -51,6 +98,7 @@ typedef struct
 extern l2learn_main_t l2learn_main;
 
 extern vlib_node_registration_t l2fib_mac_age_scanner_process_node;
+extern vlib_node_registration_t l2learn_event_process_node;
 
 enum
 {
@@ -128,6 +128,29 @@ done:
   return error;
 }
 
+/**
+ * Precompute the bytes that follow the macs in the rewritten header.
+ * A single pushed tag is in tags[1], two are in tags[0] and tags[1].
+ */
+static void
+l2vtr_config_rewrite (vtr_config_t * config)
+{
+  config->head_tag = config->tail_tag = 0;
+  config->head_keep = config->tail_keep = ~0;
+
+  if (config->push_bytes == 4)
+    {
+      clib_memcpy (&config->head_tag, &config->tags[1], 4);
+      config->head_keep = 0;
+    }
+  else if (config->push_bytes == 8)
+    {
+      clib_memcpy (&config->head_tag, &config->tags[0], 4);
+      clib_memcpy (&config->tail_tag, &config->tags[1], 4);
+      config->head_keep = config->tail_keep = 0;
+    }
+}
+
 /**
  * Configure vtag tag rewrite on the given interface.
  * Return 1 if there is an error, 0 if ok
@@ -329,6 +352,9 @@ l2vtr_configure (vlib_main_t * vlib_main, vnet_main_t * vnet_main, u32 sw_if_ind
       out_config->tags[1].type = push_inner_et;
     }
 
+  l2vtr_config_rewrite (in_config);
+  l2vtr_config_rewrite (out_config);
+
   /* set the interface enable flags */
   enable = (vtr_op != L2_VTR_DISABLED);
   config->out_vtr_flag = (u8) enable;
@@ -678,6 +704,115 @@ VLIB_CLI_COMMAND (int_l2_vtr_cli, static) = {
 };
 /* *INDENT-ON* */
 
+/**
+ * Time the tag rewrite of a frame of packets: a QinQ push then the
+ * matching pop, checking the packets come back as they were.
+ */
+static clib_error_t *
+l2vtr_test_command_fn (vlib_main_t * vm,
+		       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  clib_error_t *error = 0;
+  vtr_config_t push_config, pop_config;
+  u32 buffers[VLIB_FRAME_SIZE];
+  u32 n_iter = 1000, n_buffers, iter, i, n_bad = 0;
+  u64 push_clocks = 0, pop_clocks = 0, t0, t1, t2;
+  u8 pkt[64];
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "iterations %u", &n_iter))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_iter == 0)
+    return clib_error_return (0, "iterations must be non-zero");
+
+  memset (&push_config, 0, sizeof (push_config));
+  push_config.push_bytes = 8;
+  push_config.tags[0].type = clib_host_to_net_u16 (ETHERNET_TYPE_DOT1AD);
+  push_config.tags[0].priority_cfi_and_id = clib_host_to_net_u16 (100);
+  push_config.tags[1].type = clib_host_to_net_u16 (ETHERNET_TYPE_VLAN);
+  push_config.tags[1].priority_cfi_and_id = clib_host_to_net_u16 (200);
+  l2vtr_config_rewrite (&push_config);
+
+  memset (&pop_config, 0, sizeof (pop_config));
+  pop_config.pop_bytes = 8;
+  l2vtr_config_rewrite (&pop_config);
+
+  /* an untagged ip4 frame */
+  for (i = 0; i < sizeof (pkt); i++)
+    pkt[i] = i;
+  *((u16 *) (pkt + 12)) = clib_host_to_net_u16 (ETHERNET_TYPE_IP4);
+
+  n_buffers = vlib_buffer_alloc (vm, buffers, VLIB_FRAME_SIZE);
+  if (n_buffers == 0)
+    return clib_error_return (0, "buffer allocation failure");
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      vlib_buffer_t *b = vlib_get_buffer (vm, buffers[i]);
+      b->current_data = 0;
+      b->current_length = sizeof (pkt);
+      clib_memcpy (b->data, pkt, sizeof (pkt));
+      vnet_buffer (b)->l2.l2_len = sizeof (ethernet_header_t);
+      vnet_buffer (b)->l2_hdr_offset = 0;
+    }
+
+  for (iter = 0; iter < n_iter; iter++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (i = 0; i < n_buffers; i++)
+	l2_vtr_process (vlib_get_buffer (vm, buffers[i]), &push_config);
+      t1 = clib_cpu_time_now ();
+      for (i = 0; i < n_buffers; i++)
+	l2_vtr_process (vlib_get_buffer (vm, buffers[i]), &pop_config);
+      t2 = clib_cpu_time_now ();
+
+      push_clocks += t1 - t0;
+      pop_clocks += t2 - t1;
+    }
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      vlib_buffer_t *b = vlib_get_buffer (vm, buffers[i]);
+      if (b->current_data != 0 || b->current_length != sizeof (pkt)
+	  || memcmp (b->data, pkt, sizeof (pkt)))
+	n_bad++;
+    }
+
+  vlib_cli_output (vm, "%u packets x %u iterations", n_buffers, n_iter);
+  vlib_cli_output (vm, "  QinQ push: %.2f clocks/pkt",
+		   (f64) push_clocks / ((f64) n_buffers * n_iter));
+  vlib_cli_output (vm, "  QinQ pop:  %.2f clocks/pkt",
+		   (f64) pop_clocks / ((f64) n_buffers * n_iter));
+  if (n_bad)
+    error = clib_error_return (0, "%u packets not restored by the pop",
+			       n_bad);
+
+  vlib_buffer_free (vm, buffers, n_buffers);
+  return error;
+}
+
+/*?
+ * Measure the cost of the vlan tag rewrite: a frame of packets has two
+ * tags pushed and then popped, for the given number of iterations, and
+ * the average clocks per packet of each operation are displayed.
+ *
+ * @cliexpar
+ * @cliexcmd{test l2 tag-rewrite iterations 10000}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (l2vtr_test_command, static) = {
+  .path = "test l2 tag-rewrite",
+  .short_help = "test l2 tag-rewrite [iterations <n>]",
+  .function = l2vtr_test_command_fn,
+};
+/* *INDENT-ON* */
+
 /**
  * Get pbb tag rewrite on the given interface.
  * Return 1 if there is an error, 0 if ok
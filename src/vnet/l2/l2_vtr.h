@@ -63,6 +63,16 @@ typedef struct
     };
     u16 push_and_pop_bytes;	/* if 0 then the feature is disabled */
   };
+
+  /*
+   * The rewrite as the 8 bytes that follow the macs in the rewritten
+   * header: each 4 bytes are either a pushed tag or kept from the packet.
+   * Computed from the above by l2vtr_configure.
+   */
+  u32 head_tag;
+  u32 head_keep;
+  u32 tail_tag;
+  u32 tail_keep;
 } vtr_config_t;
 
 
@@ -74,6 +84,35 @@ typedef struct
 always_inline u32
 l2_vtr_process (vlib_buffer_t * b0, vtr_config_t * config)
 {
+#ifdef CLIB_HAVE_VEC128_UNALIGNED_LOAD_STORE
+  u32x4 hdr;
+  u32 tail;
+  u8 *eth, *new_eth;
+
+  eth = vlib_buffer_get_current (b0);
+
+  /* if not enough tags to pop then drop packet */
+  if (PREDICT_FALSE ((vnet_buffer (b0)->l2.l2_len - 12) < config->pop_bytes))
+    {
+      return 1;
+    }
+
+  new_eth = eth + config->pop_bytes - config->push_bytes;
+
+  /*
+   * The new header is the 12B dmac and smac followed by up to 2 pushed
+   * tags, the rest of the packet stays where it is: one 16B store of
+   * the macs and the first 4B, then the next 4B.
+   */
+  hdr = u32x4_load_unaligned ((u32x4 *) eth);
+  hdr[3] = (*((u32 *) (new_eth + 12)) & config->head_keep) | config->head_tag;
+  tail = (*((u32 *) (new_eth + 16)) & config->tail_keep) | config->tail_tag;
+
+  /* TODO: set cos bits */
+
+  u32x4_store_unaligned (hdr, (u32x4 *) new_eth);
+  *((u32 *) (new_eth + 16)) = tail;
+#else
   u64 temp_8;
   u32 temp_4;
   u8 *eth;
@@ -104,6 +143,7 @@ l2_vtr_process (vlib_buffer_t * b0, vtr_config_t * config)
   /* copy the 12 dmac and smac back to the packet */
   *((u64 *) eth) = temp_8;
   *((u32 *) (eth + 8)) = temp_4;
+#endif
 
   /* Update l2 parameters */
   vnet_buffer (b0)->l2.l2_len +=
@@ -614,6 +614,81 @@ mfib_table_walk (u32 fib_index,
     }
 }
 
+static int
+mfib_table_walk_iter_collect (fib_node_index_t mfei,
+                              void *ctx)
+{
+    mfib_table_walk_iter_t *iter = ctx;
+
+    mfib_entry_lock(mfei);
+    vec_add1(iter->mtwi_entries, mfei);
+
+    return (0);
+}
+
+void
+mfib_table_walk_iter_add (mfib_table_walk_iter_t *iter,
+                          u32 fib_index,
+                          fib_protocol_t proto)
+{
+    u32 n_entries;
+
+    n_entries = vec_len(iter->mtwi_entries);
+    mfib_table_walk(fib_index, proto, mfib_table_walk_iter_collect, iter);
+
+    if (vec_len(iter->mtwi_entries) > n_entries)
+    {
+        qsort(iter->mtwi_entries + n_entries,
+              vec_len(iter->mtwi_entries) - n_entries,
+              sizeof(fib_node_index_t),
+              (void *) mfib_entry_cmp_for_sort);
+    }
+}
+
+int
+mfib_table_walk_iter_next (mfib_table_walk_iter_t *iter,
+                           u32 n_entries,
+                           mfib_table_walk_fn_t fn,
+                           void *ctx)
+{
+    fib_node_index_t mfei;
+
+    while (n_entries > 0 &&
+           iter->mtwi_pos < vec_len(iter->mtwi_entries))
+    {
+        mfei = iter->mtwi_entries[iter->mtwi_pos++];
+
+        /*
+         * skip entries removed from the table since the walk began
+         */
+        if (0 == vec_len(mfib_entry_get(mfei)->mfe_srcs))
+            continue;
+
+        if (MFIB_TABLE_WALK_PAUSE == fn(mfei, ctx))
+        {
+            /* visit this entry again on the next call */
+            iter->mtwi_pos--;
+            return (1);
+        }
+        n_entries--;
+    }
+
+    return (iter->mtwi_pos < vec_len(iter->mtwi_entries));
+}
+
+void
+mfib_table_walk_iter_done (mfib_table_walk_iter_t *iter)
+{
+    fib_node_index_t *mfei;
+
+    vec_foreach(mfei, iter->mtwi_entries)
+    {
+        mfib_entry_unlock(*mfei);
+    }
+    vec_free(iter->mtwi_entries);
+    iter->mtwi_pos = 0;
+}
+
 u8*
 format_mfib_table_name (u8* s, va_list *ap)
 {
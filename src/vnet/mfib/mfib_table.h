@@ -405,6 +405,12 @@ extern u32 mfib_table_get_num_entries(u32 fib_index,
 extern mfib_table_t *mfib_table_get(fib_node_index_t index,
                                     fib_protocol_t proto);
 
+/**
+ * @brief Returned by a walk function to pause a resumable walk before
+ * the entry, see mfib_table_walk_iter_next
+ */
+#define MFIB_TABLE_WALK_PAUSE 1
+
 /**
  * @brief Call back function when walking entries in a FIB table
  */
@@ -420,6 +426,49 @@ extern void mfib_table_walk(u32 fib_index,
                             fib_protocol_t proto,
                             mfib_table_walk_fn_t fn,
                             void *ctx);
+/**
+ * @brief State for a resumable walk of one or more MFIB tables.
+ * As fib_table_walk_iter_t; entries are locked when added to the walk.
+ */
+typedef struct mfib_table_walk_iter_t_
+{
+    /**
+     * The locked entries to visit
+     */
+    fib_node_index_t *mtwi_entries;
+
+    /**
+     * The position of the next entry to visit
+     */
+    u32 mtwi_pos;
+} mfib_table_walk_iter_t;
+
+/**
+ * @brief Add all the entries in a MFIB table to a resumable walk. The
+ * table's entries are visited, in prefix order, after those of the tables
+ * added before it. The iterator must be zero initialised before the first
+ * addition.
+ */
+extern void mfib_table_walk_iter_add(mfib_table_walk_iter_t *iter,
+                                     u32 fib_index,
+                                     fib_protocol_t proto);
+
+/**
+ * @brief Visit at most n_entries of the walk.
+ * If the walk function returns MFIB_TABLE_WALK_PAUSE, the walk stops and
+ * the next call starts with the same entry.
+ * Returns non-zero if there are entries left to visit.
+ */
+extern int mfib_table_walk_iter_next(mfib_table_walk_iter_t *iter,
+                                     u32 n_entries,
+                                     mfib_table_walk_fn_t fn,
+                                     void *ctx);
+
+/**
+ * @brief End a resumable walk, releasing the locks on the entries
+ */
+extern void mfib_table_walk_iter_done(mfib_table_walk_iter_t *iter);
+
 /**
  * @brief format (display) the memory usage for mfibs
  */
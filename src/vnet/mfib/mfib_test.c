@@ -1369,6 +1369,103 @@ mfib_test_v6 (void)
                         &pfx_ff));
 }
 
+/*
+ * Replication benchmark: clone a packet into a 1:N fan-out as the
+ * replicate node does, a private head per replica sharing the payload,
+ * then free them. Reports the replicated packet rate. The source
+ * packets are allocated up front so only the replication is timed.
+ */
+static int
+mfib_test_replicate (vlib_main_t * vm,
+                     u32 fan_out,
+                     u32 n_pkts,
+                     u32 size)
+{
+    u32 ii, jj, n_alloc, n_cloned, *clones, *pkts;
+    f64 start, elapsed;
+    vlib_buffer_t *b, *c;
+
+    if (0 == n_pkts)
+        return (0);
+
+    clones = NULL;
+    pkts = NULL;
+    vec_validate(clones, fan_out - 1);
+    vec_validate(pkts, n_pkts - 1);
+    size = clib_min(size, VLIB_BUFFER_DATA_SIZE);
+
+    n_alloc = vlib_buffer_alloc(vm, pkts, n_pkts);
+
+    if (n_alloc != n_pkts)
+    {
+        vlib_buffer_free(vm, pkts, n_alloc);
+        vec_free(pkts);
+        vec_free(clones);
+        MFIB_TEST(0, "allocated %d of %d source packets", n_alloc, n_pkts);
+    }
+
+    for (ii = 0; ii < n_pkts; ii++)
+    {
+        b = vlib_get_buffer(vm, pkts[ii]);
+        b->flags &= VLIB_BUFFER_FREE_LIST_INDEX_MASK;
+        b->current_data = 0;
+        b->current_length = size;
+        b->total_length_not_including_first_buffer = 0;
+    }
+
+    start = vlib_time_now(vm);
+
+    for (ii = 0; ii < n_pkts; ii++)
+    {
+        n_cloned = vlib_buffer_clone(vm, pkts[ii], clones, fan_out, 128);
+
+        if (n_cloned != fan_out)
+        {
+            vlib_buffer_free(vm, clones, n_cloned);
+            if (ii + 1 < n_pkts)
+                vlib_buffer_free(vm, pkts + ii + 1, n_pkts - ii - 1);
+            vec_free(pkts);
+            vec_free(clones);
+            MFIB_TEST(0, "cloned %d of %d", n_cloned, fan_out);
+        }
+
+        for (jj = 0; jj < n_cloned; jj++)
+        {
+            c = vlib_get_buffer(vm, clones[jj]);
+            vnet_buffer(c)->ip.adj_index[VLIB_TX] = jj;
+        }
+
+        if (0 == ii)
+        {
+            c = vlib_get_buffer(vm, clones[n_cloned - 1]);
+            jj = vlib_buffer_length_in_chain(vm, c);
+            if (size != jj)
+            {
+                vlib_buffer_free(vm, clones, n_cloned);
+                vlib_buffer_free(vm, pkts + 1, n_pkts - 1);
+                vec_free(pkts);
+                vec_free(clones);
+                MFIB_TEST(0, "replica length %d is the packet's", jj);
+            }
+        }
+
+        vlib_buffer_free(vm, clones, n_cloned);
+    }
+
+    elapsed = vlib_time_now(vm) - start;
+
+    vlib_cli_output(vm, "1:%d fan-out of %d %dB packets: %.6fs, %.2f Mpps replicated",
+                    fan_out, n_pkts, size, elapsed,
+                    (elapsed > 0 ?
+                     ((f64) n_pkts * fan_out) / (elapsed * 1e6) :
+                     0));
+
+    vec_free(pkts);
+    vec_free(clones);
+
+    return (0);
+}
+
 static clib_error_t *
 mfib_test (vlib_main_t * vm,
            unformat_input_t * input,
@@ -1376,9 +1473,39 @@ mfib_test (vlib_main_t * vm,
 {
     int res = 0;
 
-    res += mfib_test_mk_intf(4);
-    res += mfib_test_v4();
-    res += mfib_test_v6();
+    if (unformat (input, "replicate"))
+    {
+        u32 fan_out = 0, n_pkts = 10000, size = 1024;
+
+        while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+        {
+            if (unformat (input, "fan-out %d", &fan_out))
+                ;
+            else if (unformat (input, "count %d", &n_pkts))
+                ;
+            else if (unformat (input, "size %d", &size))
+                ;
+            else
+                return (clib_error_return (0, "unknown input '%U'",
+                                           format_unformat_error, input));
+        }
+
+        if (fan_out)
+        {
+            res += mfib_test_replicate(vm, fan_out, n_pkts, size);
+        }
+        else
+        {
+            for (fan_out = 1; fan_out <= 1024; fan_out <<= 2)
+                res += mfib_test_replicate(vm, fan_out, n_pkts, size);
+        }
+    }
+    else
+    {
+        res += mfib_test_mk_intf(4);
+        res += mfib_test_v4();
+        res += mfib_test_v6();
+    }
 
     if (res)
     {
@@ -1392,7 +1519,7 @@ mfib_test (vlib_main_t * vm,
 
 VLIB_CLI_COMMAND (test_fib_command, static) = {
     .path = "test mfib",
-    .short_help = "mfib unit tests - DO NOT RUN ON A LIVE SYSTEM",
+    .short_help = "test mfib [replicate [fan-out <n>] [count <n>] [size <n>]] - mfib unit tests - DO NOT RUN ON A LIVE SYSTEM",
     .function = mfib_test,
 };
 
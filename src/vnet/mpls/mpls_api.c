@@ -236,6 +236,8 @@ mpls_route_add_del_t_handler (vnet_main_t * vnm,
                                    0,	// l2_bridged
                                    0,   // is source_lookup
                                    0,   // is_udp_encap
+                                   0,   // is_resilient
+                                   mp->mr_is_uniform,
 				   fib_index, &pfx,
 				   mp->mr_next_hop_proto,
 				   &nh, ~0, // next_hop_id
@@ -490,15 +492,28 @@ send_mpls_fib_details (vpe_api_main_t * am,
 
 typedef struct vl_api_mpls_fib_dump_table_walk_ctx_t_
 {
-  fib_node_index_t *lfeis;
+  vl_api_registration_t *reg;
+  u32 context;
 } vl_api_mpls_fib_dump_table_walk_ctx_t;
 
 static fib_table_walk_rc_t
 vl_api_mpls_fib_dump_table_walk (fib_node_index_t fei, void *arg)
 {
   vl_api_mpls_fib_dump_table_walk_ctx_t *ctx = arg;
+  fib_route_path_encode_t *api_rpaths = NULL;
+  fib_table_t *fib_table;
+  fib_prefix_t pfx;
+
+  if (fib_api_dump_should_pause (ctx->reg))
+    return (FIB_TABLE_WALK_PAUSE);
 
-  vec_add1 (ctx->lfeis, fei);
+  fib_entry_get_prefix (fei, &pfx);
+  fib_table = fib_table_get (fib_entry_get_fib_index (fei), pfx.fp_proto);
+  fib_entry_encode (fei, &api_rpaths);
+  send_mpls_fib_details (&vpe_api_main, ctx->reg,
+			 fib_table, pfx.fp_label,
+			 pfx.fp_eos, api_rpaths, ctx->context);
+  vec_free (api_rpaths);
 
   return (FIB_TABLE_WALK_CONTINUE);
 }
@@ -506,47 +521,35 @@ vl_api_mpls_fib_dump_table_walk (fib_node_index_t fei, void *arg)
 static void
 vl_api_mpls_fib_dump_t_handler (vl_api_mpls_fib_dump_t * mp)
 {
-  vpe_api_main_t *am = &vpe_api_main;
-  vl_api_registration_t *reg;
   mpls_main_t *mm = &mpls_main;
   fib_table_t *fib_table;
-  mpls_fib_t *mpls_fib;
-  fib_node_index_t *lfeip = NULL;
-  fib_prefix_t pfx;
-  u32 fib_index;
-  fib_route_path_encode_t *api_rpaths;
+  fib_table_walk_iter_t iter = {
+    .ftwi_entries = NULL,
+  };
   vl_api_mpls_fib_dump_table_walk_ctx_t ctx = {
-    .lfeis = NULL,
+    .context = mp->context,
   };
 
-  reg = vl_api_client_index_to_registration (mp->client_index);
-  if (!reg)
+  ctx.reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!ctx.reg)
     return;
 
   /* *INDENT-OFF* */
-  pool_foreach (mpls_fib, mm->mpls_fibs,
+  pool_foreach (fib_table, mm->fibs,
   ({
-    mpls_fib_table_walk (mpls_fib,
-                         vl_api_mpls_fib_dump_table_walk,
-                         &ctx);
+    fib_table_walk_iter_add (&iter, fib_table->ft_index, FIB_PROTOCOL_MPLS);
   }));
   /* *INDENT-ON* */
-  vec_sort_with_function (ctx.lfeis, fib_entry_cmp_for_sort);
 
-  vec_foreach (lfeip, ctx.lfeis)
-  {
-    fib_entry_get_prefix (*lfeip, &pfx);
-    fib_index = fib_entry_get_fib_index (*lfeip);
-    fib_table = fib_table_get (fib_index, pfx.fp_proto);
-    api_rpaths = NULL;
-    fib_entry_encode (*lfeip, &api_rpaths);
-    send_mpls_fib_details (am, reg,
-			   fib_table, pfx.fp_label,
-			   pfx.fp_eos, api_rpaths, mp->context);
-    vec_free (api_rpaths);
-  }
+  while (fib_table_walk_iter_next (&iter, fib_api_dump_batch_size (),
+				   vl_api_mpls_fib_dump_table_walk, &ctx))
+    {
+      ctx.reg = fib_api_dump_yield (mp->client_index);
+      if (!ctx.reg)
+	break;
+    }
 
-  vec_free (ctx.lfeis);
+  fib_table_walk_iter_done (&iter);
 }
 
 /*
@@ -588,6 +591,11 @@ mpls_api_hookup (vlib_main_t * vm)
    */
   am->api_trace_cfg[VL_API_MPLS_TUNNEL_ADD_DEL].size += 8 * sizeof (u32);
 
+  /*
+   * The FIB dump only reads the tables and yields between batches
+   */
+  am->is_mp_safe[VL_API_MPLS_FIB_DUMP] = 1;
+
   /*
    * Set up the (msg_name, crc, message-id) table
    */
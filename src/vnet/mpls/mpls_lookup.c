@@ -174,7 +174,7 @@ mpls_lookup (vlib_main_t * vm,
               if (PREDICT_FALSE(lb0->lb_n_buckets > 1))
               {
                   hash_c0 = vnet_buffer (b0)->ip.flow_hash =
-                      mpls_compute_flow_hash(h0, lb0->lb_hash_config);
+                      mpls_compute_flow_hash_cached(b0, h0, lb0->lb_hash_config);
                   dpo0 = load_balance_get_fwd_bucket
                       (lb0,
                        (hash_c0 & (lb0->lb_n_buckets_minus_1)));
@@ -206,7 +206,7 @@ mpls_lookup (vlib_main_t * vm,
               if (PREDICT_FALSE(lb1->lb_n_buckets > 1))
               {
                   hash_c1 = vnet_buffer (b1)->ip.flow_hash =
-                      mpls_compute_flow_hash(h1, lb1->lb_hash_config);
+                      mpls_compute_flow_hash_cached(b1, h1, lb1->lb_hash_config);
                   dpo1 = load_balance_get_fwd_bucket
                       (lb1,
                        (hash_c1 & (lb1->lb_n_buckets_minus_1)));
@@ -238,7 +238,7 @@ mpls_lookup (vlib_main_t * vm,
               if (PREDICT_FALSE(lb2->lb_n_buckets > 1))
               {
                   hash_c2 = vnet_buffer (b2)->ip.flow_hash =
-                      mpls_compute_flow_hash(h2, lb2->lb_hash_config);
+                      mpls_compute_flow_hash_cached(b2, h2, lb2->lb_hash_config);
                   dpo2 = load_balance_get_fwd_bucket
                       (lb2,
                        (hash_c2 & (lb2->lb_n_buckets_minus_1)));
@@ -270,7 +270,7 @@ mpls_lookup (vlib_main_t * vm,
               if (PREDICT_FALSE(lb3->lb_n_buckets > 1))
               {
                   hash_c3 = vnet_buffer (b3)->ip.flow_hash =
-                      mpls_compute_flow_hash(h3, lb3->lb_hash_config);
+                      mpls_compute_flow_hash_cached(b3, h3, lb3->lb_hash_config);
                   dpo3 = load_balance_get_fwd_bucket
                       (lb3,
                        (hash_c3 & (lb3->lb_n_buckets_minus_1)));
@@ -404,7 +404,7 @@ mpls_lookup (vlib_main_t * vm,
               if (PREDICT_FALSE(lb0->lb_n_buckets > 1))
               {
                   hash_c0 = vnet_buffer (b0)->ip.flow_hash =
-                      mpls_compute_flow_hash(h0, lb0->lb_hash_config);
+                      mpls_compute_flow_hash_cached(b0, h0, lb0->lb_hash_config);
                   dpo0 = load_balance_get_fwd_bucket
                       (lb0,
                        (hash_c0 & (lb0->lb_n_buckets_minus_1)));
@@ -578,7 +578,7 @@ mpls_load_balance (vlib_main_t * vm,
               }
               else
               {
-                  hc0 = vnet_buffer(p0)->ip.flow_hash = mpls_compute_flow_hash(mpls0, hc0);
+                  hc0 = vnet_buffer(p0)->ip.flow_hash = mpls_compute_flow_hash_cached(p0, mpls0, lb0->lb_hash_config);
               }
               dpo0 = load_balance_get_fwd_bucket(lb0, (hc0 & lb0->lb_n_buckets_minus_1));
           }
@@ -594,7 +594,7 @@ mpls_load_balance (vlib_main_t * vm,
               }
               else
               {
-                  hc1 = vnet_buffer(p1)->ip.flow_hash = mpls_compute_flow_hash(mpls1, hc1);
+                  hc1 = vnet_buffer(p1)->ip.flow_hash = mpls_compute_flow_hash_cached(p1, mpls1, lb1->lb_hash_config);
               }
               dpo1 = load_balance_get_fwd_bucket(lb1, (hc1 & lb1->lb_n_buckets_minus_1));
           }
@@ -661,7 +661,7 @@ mpls_load_balance (vlib_main_t * vm,
               }
               else
               {
-                  hc0 = vnet_buffer(p0)->ip.flow_hash = mpls_compute_flow_hash(mpls0, hc0);
+                  hc0 = vnet_buffer(p0)->ip.flow_hash = mpls_compute_flow_hash_cached(p0, mpls0, lb0->lb_hash_config);
               }
                dpo0 = load_balance_get_fwd_bucket(lb0, (hc0 & lb0->lb_n_buckets_minus_1));
           }
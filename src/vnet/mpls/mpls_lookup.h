@@ -18,6 +18,7 @@
 
 #include <vnet/mpls/mpls.h>
 #include <vnet/ip/ip.h>
+#include <vnet/fib/mpls_fib.h>
 
 /**
  * The arc/edge from the MPLS lookup node to the MPLS replicate node
@@ -99,4 +100,28 @@ mpls_compute_flow_hash (const mpls_unicast_header_t * hdr,
     return (hash);
 }
 
+/*
+ * Compute the flow hash, or re-use the one cached in the buffer by an
+ * earlier stage. As for IP, only the default hash configs are cached.
+ */
+always_inline u32
+mpls_compute_flow_hash_cached (vlib_buffer_t * b,
+                               const mpls_unicast_header_t * hdr,
+                               flow_hash_config_t flow_hash_config)
+{
+    u32 hash;
+
+    if (PREDICT_FALSE(MPLS_FLOW_HASH_DEFAULT != flow_hash_config &&
+                      IP_FLOW_HASH_DEFAULT != flow_hash_config))
+        return (mpls_compute_flow_hash(hdr, flow_hash_config));
+
+    if (vnet_buffer_flow_hash_get(b, &hash))
+        return (hash);
+
+    hash = mpls_compute_flow_hash(hdr, flow_hash_config);
+    vnet_buffer_flow_hash_set(b, (hash >> 1) | (hash << 31));
+
+    return (hash);
+}
+
 #endif /* __MPLS_LOOKUP_H__ */
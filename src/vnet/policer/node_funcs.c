@@ -69,202 +69,104 @@ vnet_policer_inline (vlib_main_t * vm,
 		     vlib_node_runtime_t * node,
 		     vlib_frame_t * frame, vnet_policer_index_t which)
 {
-  u32 n_left_from, *from, *to_next;
-  vnet_policer_next_t next_index;
+  u32 n_left_from, *from;
   vnet_policer_main_t *pm = &vnet_policer_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u32 pis[VLIB_FRAME_SIZE], *pi;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
   u64 time_in_policer_periods;
   u32 transmitted = 0;
 
+  /* One clock read for the frame, every packet is policed at it */
   time_in_policer_periods =
     clib_cpu_time_now () >> POLICER_TICKS_PER_PERIOD_SHIFT;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+
+  /* First pass: find each packet's policer and prefetch it */
+  b = bufs;
+  pi = pis;
 
   while (n_left_from > 0)
     {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from >= 4 && n_left_to_next >= 2)
-	{
-	  u32 bi0, bi1;
-	  vlib_buffer_t *b0, *b1;
-	  u32 next0, next1;
-	  u32 sw_if_index0, sw_if_index1;
-	  u32 pi0 = 0, pi1 = 0;
-	  u8 act0, act1;
-
-	  /* Prefetch next iteration. */
-	  {
-	    vlib_buffer_t *b2, *b3;
-
-	    b2 = vlib_get_buffer (vm, from[2]);
-	    b3 = vlib_get_buffer (vm, from[3]);
-
-	    vlib_prefetch_buffer_header (b2, LOAD);
-	    vlib_prefetch_buffer_header (b3, LOAD);
-	  }
-
-	  /* speculatively enqueue b0 and b1 to the current next frame */
-	  to_next[0] = bi0 = from[0];
-	  to_next[1] = bi1 = from[1];
-	  from += 2;
-	  to_next += 2;
-	  n_left_from -= 2;
-	  n_left_to_next -= 2;
+      u32 sw_if_index0;
+      u32 pi0 = 0;
 
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b1 = vlib_get_buffer (vm, bi1);
+      if (PREDICT_TRUE (n_left_from > 4))
+	vlib_prefetch_buffer_header (b[4], LOAD);
 
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	  next0 = VNET_POLICER_NEXT_TRANSMIT;
+      sw_if_index0 = vnet_buffer (b[0])->sw_if_index[VLIB_RX];
 
-	  sw_if_index1 = vnet_buffer (b1)->sw_if_index[VLIB_RX];
-	  next1 = VNET_POLICER_NEXT_TRANSMIT;
+      if (which == VNET_POLICER_INDEX_BY_SW_IF_INDEX)
+	pi0 = pm->policer_index_by_sw_if_index[sw_if_index0];
 
+      if (which == VNET_POLICER_INDEX_BY_OPAQUE)
+	pi0 = vnet_buffer (b[0])->policer.index;
 
-	  if (which == VNET_POLICER_INDEX_BY_SW_IF_INDEX)
-	    {
-	      pi0 = pm->policer_index_by_sw_if_index[sw_if_index0];
-	      pi1 = pm->policer_index_by_sw_if_index[sw_if_index1];
-	    }
-
-	  if (which == VNET_POLICER_INDEX_BY_OPAQUE)
-	    {
-	      pi0 = vnet_buffer (b0)->policer.index;
-	      pi1 = vnet_buffer (b1)->policer.index;
-	    }
-
-	  if (which == VNET_POLICER_INDEX_BY_EITHER)
-	    {
-	      pi0 = vnet_buffer (b0)->policer.index;
-	      pi0 = (pi0 != ~0) ? pi0 :
-		pm->policer_index_by_sw_if_index[sw_if_index0];
-	      pi1 = vnet_buffer (b1)->policer.index;
-	      pi1 = (pi1 != ~0) ? pi1 :
-		pm->policer_index_by_sw_if_index[sw_if_index1];
-	    }
+      if (which == VNET_POLICER_INDEX_BY_EITHER)
+	{
+	  pi0 = vnet_buffer (b[0])->policer.index;
+	  pi0 = (pi0 != ~0) ? pi0 :
+	    pm->policer_index_by_sw_if_index[sw_if_index0];
+	}
 
-	  act0 = vnet_policer_police (vm, b0, pi0, time_in_policer_periods,
-				      POLICE_CONFORM /* no chaining */ );
+      CLIB_PREFETCH (&pm->policers[pi0], CLIB_CACHE_LINE_BYTES, STORE);
+      pi[0] = pi0;
 
-	  act1 = vnet_policer_police (vm, b1, pi1, time_in_policer_periods,
-				      POLICE_CONFORM /* no chaining */ );
+      b += 1;
+      pi += 1;
+      n_left_from -= 1;
+    }
 
-	  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))	/* drop action */
-	    {
-	      next0 = VNET_POLICER_NEXT_DROP;
-	      b0->error = node->errors[VNET_POLICER_ERROR_DROP];
-	    }
-	  else			/* transmit or mark-and-transmit action */
-	    {
-	      transmitted++;
-	    }
+  /* Second pass: police */
+  b = bufs;
+  pi = pis;
+  next = nexts;
+  n_left_from = frame->n_vectors;
 
-	  if (PREDICT_FALSE (act1 == SSE2_QOS_ACTION_DROP))	/* drop action */
-	    {
-	      next1 = VNET_POLICER_NEXT_DROP;
-	      b1->error = node->errors[VNET_POLICER_ERROR_DROP];
-	    }
-	  else			/* transmit or mark-and-transmit action */
-	    {
-	      transmitted++;
-	    }
+  while (n_left_from > 0)
+    {
+      vlib_buffer_t *b0;
+      u32 next0;
+      u8 act0;
 
+      b0 = b[0];
+      next0 = VNET_POLICER_NEXT_TRANSMIT;
 
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)))
-	    {
-	      if (b0->flags & VLIB_BUFFER_IS_TRACED)
-		{
-		  vnet_policer_trace_t *t =
-		    vlib_add_trace (vm, node, b0, sizeof (*t));
-		  t->sw_if_index = sw_if_index0;
-		  t->next_index = next0;
-		}
-	      if (b1->flags & VLIB_BUFFER_IS_TRACED)
-		{
-		  vnet_policer_trace_t *t =
-		    vlib_add_trace (vm, node, b1, sizeof (*t));
-		  t->sw_if_index = sw_if_index1;
-		  t->next_index = next1;
-		}
-	    }
+      act0 = vnet_policer_police (vm, b0, pi[0], time_in_policer_periods,
+				  POLICE_CONFORM /* no chaining */ );
 
-	  /* verify speculative enqueues, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, bi1, next0, next1);
+      if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))	/* drop action */
+	{
+	  next0 = VNET_POLICER_NEXT_DROP;
+	  b0->error = node->errors[VNET_POLICER_ERROR_DROP];
 	}
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      else			/* transmit or mark-and-transmit action */
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0;
-	  u32 sw_if_index0;
-	  u32 pi0 = 0;
-	  u8 act0;
-
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	  next0 = VNET_POLICER_NEXT_TRANSMIT;
-
-	  if (which == VNET_POLICER_INDEX_BY_SW_IF_INDEX)
-	    pi0 = pm->policer_index_by_sw_if_index[sw_if_index0];
-
-	  if (which == VNET_POLICER_INDEX_BY_OPAQUE)
-	    pi0 = vnet_buffer (b0)->policer.index;
-
-	  if (which == VNET_POLICER_INDEX_BY_EITHER)
-	    {
-	      pi0 = vnet_buffer (b0)->policer.index;
-	      pi0 = (pi0 != ~0) ? pi0 :
-		pm->policer_index_by_sw_if_index[sw_if_index0];
-	    }
-
-	  act0 = vnet_policer_police (vm, b0, pi0, time_in_policer_periods,
-				      POLICE_CONFORM /* no chaining */ );
-
-	  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))	/* drop action */
-	    {
-	      next0 = VNET_POLICER_NEXT_DROP;
-	      b0->error = node->errors[VNET_POLICER_ERROR_DROP];
-	    }
-	  else			/* transmit or mark-and-transmit action */
-	    {
-	      transmitted++;
-	    }
-
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
-			     && (b0->flags & VLIB_BUFFER_IS_TRACED)))
-	    {
-	      vnet_policer_trace_t *t =
-		vlib_add_trace (vm, node, b0, sizeof (*t));
-	      t->sw_if_index = sw_if_index0;
-	      t->next_index = next0;
-	      t->policer_index = pi0;
-	    }
+	  transmitted++;
+	}
 
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  vnet_policer_trace_t *t =
+	    vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+	  t->next_index = next0;
+	  t->policer_index = pi[0];
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      next[0] = next0;
+      b += 1;
+      pi += 1;
+      next += 1;
+      n_left_from -= 1;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   vlib_node_increment_counter (vm, node->node_index,
 			       VNET_POLICER_ERROR_TRANSMIT, transmitted);
   return frame->n_vectors;
@@ -358,6 +260,7 @@ test_policer_add_del (u32 rx_sw_if_index, u8 * config_name, int is_add)
       pool_get_aligned (pm->policers, policer, CLIB_CACHE_LINE_BYTES);
 
       policer[0] = template[0];
+      policer_instance_init (policer - pm->policers);
 
       vec_validate (pm->policer_index_by_sw_if_index, rx_sw_if_index);
       pm->policer_index_by_sw_if_index[rx_sw_if_index]
@@ -372,7 +275,7 @@ test_policer_add_del (u32 rx_sw_if_index, u8 * config_name, int is_add)
 
       pi = pm->policer_index_by_sw_if_index[rx_sw_if_index];
       pm->policer_index_by_sw_if_index[rx_sw_if_index] = ~0;
-      pool_put_index (pm->policers, pi);
+      policer_instance_free (pi);
     }
 
   return 0;
@@ -507,6 +410,66 @@ static char *policer_classify_error_strings[] = {
 #undef _
 };
 
+/*
+ * Look a packet up the chain of tables from *t0p, hash0 being its hash
+ * in that first table, and police it by the entry found. Return the
+ * drop next if the policer drops it, on a miss the last table's miss
+ * next if it is one of the node's, and next0 otherwise. *t0p and *e0p
+ * are left at the last table looked in and the entry found.
+ */
+always_inline u32
+policer_classify_lookup (vlib_main_t * vm, vlib_buffer_t * b0,
+			 vnet_classify_table_t ** t0p,
+			 vnet_classify_entry_t ** e0p, u64 hash0, f64 now,
+			 u64 time_in_policer_periods, u32 n_next_nodes,
+			 u32 next0, vlib_node_runtime_t * node, u32 * hits,
+			 u32 * misses, u32 * chain_hits, u32 * drop)
+{
+  vnet_classify_main_t *vcm = policer_classify_main.vnet_classify_main;
+  vnet_classify_table_t *t0 = *t0p;
+  vnet_classify_entry_t *e0;
+  u8 *h0 = b0->data;
+  int chained = 0;
+  u8 act0;
+
+  while (1)
+    {
+      if (chained)
+	hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
+      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+      if (e0)
+	{
+	  act0 = vnet_policer_police (vm, b0, e0->next_index,
+				      time_in_policer_periods,
+				      e0->opaque_index);
+	  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
+	    {
+	      next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
+	      b0->error = node->errors[POLICER_CLASSIFY_ERROR_DROP];
+	      *drop += 1;
+	    }
+	  *hits += 1;
+	  *chain_hits += chained;
+	  break;
+	}
+
+      if (t0->next_table_index == ~0)
+	{
+	  next0 = (t0->miss_next_index < n_next_nodes) ?
+	    t0->miss_next_index : next0;
+	  *misses += 1;
+	  break;
+	}
+
+      t0 = pool_elt_at_index (vcm->tables, t0->next_table_index);
+      chained = 1;
+    }
+
+  *t0p = t0;
+  *e0p = e0;
+  return next0;
+}
+
 static inline uword
 policer_classify_inline (vlib_main_t * vm,
 			 vlib_node_runtime_t * node,
@@ -641,9 +604,6 @@ policer_classify_inline (vlib_main_t * vm,
 	  u32 table_index0;
 	  vnet_classify_table_t *t0;
 	  vnet_classify_entry_t *e0;
-	  u64 hash0;
-	  u8 *h0;
-	  u8 act0;
 
 	  /* Stride 3 seems to work best */
 	  if (PREDICT_TRUE (n_left_from > 3))
@@ -672,7 +632,6 @@ policer_classify_inline (vlib_main_t * vm,
 	  n_left_to_next -= 1;
 
 	  b0 = vlib_get_buffer (vm, bi0);
-	  h0 = b0->data;
 	  table_index0 = vnet_buffer (b0)->l2_classify.table_index;
 	  e0 = 0;
 	  t0 = 0;
@@ -692,65 +651,14 @@ policer_classify_inline (vlib_main_t * vm,
 
 	  if (PREDICT_TRUE (table_index0 != ~0))
 	    {
-	      hash0 = vnet_buffer (b0)->l2_classify.hash;
 	      t0 = pool_elt_at_index (vcm->tables, table_index0);
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-
-	      if (e0)
-		{
-		  act0 = vnet_policer_police (vm,
-					      b0,
-					      e0->next_index,
-					      time_in_policer_periods,
-					      e0->opaque_index);
-		  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
-		    {
-		      next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
-		      b0->error = node->errors[POLICER_CLASSIFY_ERROR_DROP];
-		      drop++;
-		    }
-		  hits++;
-		}
-	      else
-		{
-		  while (1)
-		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
-			{
-			  t0 = pool_elt_at_index (vcm->tables,
-						  t0->next_table_index);
-			}
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  act0 = vnet_policer_police (vm,
-						      b0,
-						      e0->next_index,
-						      time_in_policer_periods,
-						      e0->opaque_index);
-			  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
-			    {
-			      next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
-			      b0->error =
-				node->errors[POLICER_CLASSIFY_ERROR_DROP];
-			      drop++;
-			    }
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
-		    }
-		}
+	      next0 = policer_classify_lookup (vm, b0, &t0, &e0,
+					       vnet_buffer (b0)->
+					       l2_classify.hash, now,
+					       time_in_policer_periods,
+					       n_next_nodes, next0, node,
+					       &hits, &misses, &chain_hits,
+					       &drop);
 	    }
 	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
 			     && (b0->flags & VLIB_BUFFER_IS_TRACED)))
@@ -834,6 +742,66 @@ VLIB_REGISTER_NODE (ip6_policer_classify_node) = {
 VLIB_NODE_FUNCTION_MULTIARCH (ip6_policer_classify_node, ip6_policer_classify);
 /* *INDENT-ON* */
 
+always_inline u32
+policer_classify_fused_inline (vlib_main_t * vm, vlib_buffer_t * b0,
+			       policer_classify_table_id_t tid)
+{
+  policer_classify_main_t *pcm = &policer_classify_main;
+  vnet_classify_main_t *vcm = pcm->vnet_classify_main;
+  vlib_node_runtime_t *node;
+  vnet_classify_table_t *t0;
+  vnet_classify_entry_t *e0;
+  u32 table_index0, node_index, next0;
+  u32 hits = 0, misses = 0, chain_hits = 0, drop = 0;
+  u64 now = vnet_feature_fused_cpu_time (vm);
+
+  node_index = (tid == POLICER_CLASSIFY_TABLE_IP4 ?
+		ip4_policer_classify_node.index :
+		ip6_policer_classify_node.index);
+
+  vnet_buffer (b0)->l2_classify.opaque_index = ~0;
+  table_index0 = pcm->classify_table_index_by_sw_if_index[tid]
+    [vnet_buffer (b0)->sw_if_index[VLIB_RX]];
+
+  if (PREDICT_FALSE (table_index0 == ~0))
+    return VNET_FEATURE_FUSED_CONTINUE;
+
+  node = vlib_node_get_runtime (vm, node_index);
+  t0 = pool_elt_at_index (vcm->tables, table_index0);
+  next0 = policer_classify_lookup (vm, b0, &t0, &e0,
+				   vnet_classify_hash_packet (t0, b0->data),
+				   vlib_time_now_ticks (vm, now),
+				   now >> POLICER_TICKS_PER_PERIOD_SHIFT,
+				   node->n_next_nodes,
+				   VNET_FEATURE_FUSED_CONTINUE, node, &hits,
+				   &misses, &chain_hits, &drop);
+
+  vlib_node_increment_counter (vm, node_index,
+			       hits ? POLICER_CLASSIFY_ERROR_HIT :
+			       POLICER_CLASSIFY_ERROR_MISS, 1);
+  if (chain_hits)
+    vlib_node_increment_counter (vm, node_index,
+				 POLICER_CLASSIFY_ERROR_CHAIN_HIT, 1);
+  if (drop)
+    vlib_node_increment_counter (vm, node_index,
+				 POLICER_CLASSIFY_ERROR_DROP, 1);
+  return next0;
+}
+
+u32
+ip4_policer_classify_fused (vlib_main_t * vm, vlib_buffer_t * b,
+			    void *feature_config)
+{
+  return policer_classify_fused_inline (vm, b, POLICER_CLASSIFY_TABLE_IP4);
+}
+
+u32
+ip6_policer_classify_fused (vlib_main_t * vm, vlib_buffer_t * b,
+			    void *feature_config)
+{
+  return policer_classify_fused_inline (vm, b, POLICER_CLASSIFY_TABLE_IP6);
+}
+
 static uword
 l2_policer_classify (vlib_main_t * vm,
 		     vlib_node_runtime_t * node, vlib_frame_t * frame)
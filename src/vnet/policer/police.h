@@ -52,7 +52,11 @@ typedef enum
 //
 // The 64-bit last_update_time supports a 4Ghz CPU without rollover for 100 years
 //
-// The lock field should be used for a spin-lock on the struct.
+// The lock field should be used for a spin-lock on the struct. With more
+// than one thread, packets are colored against per-thread leases on the
+// buckets and the lock is only taken to renew or return a lease, see
+// police_inlines.h. Leases not renewed for a while are returned from the
+// main thread by the policer-lease-reclaim process.
 
 #define POLICER_TICKS_PER_PERIOD_SHIFT 17
 #define POLICER_TICKS_PER_PERIOD       (1 << POLICER_TICKS_PER_PERIOD_SHIFT)
@@ -82,21 +86,18 @@ typedef struct
   u32 extended_bucket;		// MOD
 
   u64 last_update_time;		// MOD
-  u64 pad64;
+  u32 parent_index;		// for hierarchical policing, ~0 if none
+  u32 pad32;
 
 } policer_read_response_type_st;
 
-static inline policer_result_e
-vnet_police_packet (policer_read_response_type_st * policer,
-		    u32 packet_length,
-		    policer_result_e packet_color, u64 time)
+// Bring the buckets up to date at the given time, returning the
+// token counts (capped at the limits) without storing them.
+static inline void
+vnet_police_refill (policer_read_response_type_st * policer, u64 time,
+		    u64 * current_tokens, u64 * extended_tokens)
 {
   u64 n_periods;
-  u64 current_tokens, extended_tokens;
-  policer_result_e result;
-
-  // Scale packet length to support a wide range of speeds
-  packet_length = packet_length << policer->scale;
 
   // Compute the number of policer periods that have passed since the last
   // operation.
@@ -119,42 +120,62 @@ vnet_police_packet (policer_read_response_type_st * policer,
 
   if (policer->single_rate)
     {
-
-      // Compute number of tokens for this time period
-      current_tokens =
+      *current_tokens =
 	policer->current_bucket + n_periods * policer->cir_tokens_per_period;
-      if (current_tokens > policer->current_limit)
-	{
-	  current_tokens = policer->current_limit;
-	}
-
-      extended_tokens =
+      *extended_tokens =
 	policer->extended_bucket + n_periods * policer->cir_tokens_per_period;
-      if (extended_tokens > policer->extended_limit)
-	{
-	  extended_tokens = policer->extended_limit;
-	}
+    }
+  else
+    {
+      *current_tokens =
+	policer->current_bucket + n_periods * policer->cir_tokens_per_period;
+      *extended_tokens =
+	policer->extended_bucket + n_periods * policer->pir_tokens_per_period;
+    }
+
+  if (*current_tokens > policer->current_limit)
+    {
+      *current_tokens = policer->current_limit;
+    }
+  if (*extended_tokens > policer->extended_limit)
+    {
+      *extended_tokens = policer->extended_limit;
+    }
+}
 
+// Color a packet against the given token counts and store what is left
+// in the given buckets. The buckets are the policer's own, or a thread's
+// lease on them. packet_length is already scaled.
+static inline policer_result_e
+vnet_police_color (policer_read_response_type_st * policer,
+		   u64 current_tokens, u64 extended_tokens,
+		   u32 * current_bucket, u32 * extended_bucket,
+		   u32 packet_length, policer_result_e packet_color)
+{
+  policer_result_e result;
+
+  if (policer->single_rate)
+    {
       // Determine color
 
       if ((!policer->color_aware || (packet_color == POLICE_CONFORM))
 	  && (current_tokens >= packet_length))
 	{
-	  policer->current_bucket = current_tokens - packet_length;
-	  policer->extended_bucket = extended_tokens - packet_length;
+	  *current_bucket = current_tokens - packet_length;
+	  *extended_bucket = extended_tokens - packet_length;
 	  result = POLICE_CONFORM;
 	}
       else if ((!policer->color_aware || (packet_color != POLICE_VIOLATE))
 	       && (extended_tokens >= packet_length))
 	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens - packet_length;
+	  *current_bucket = current_tokens;
+	  *extended_bucket = extended_tokens - packet_length;
 	  result = POLICE_EXCEED;
 	}
       else
 	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens;
+	  *current_bucket = current_tokens;
+	  *extended_bucket = extended_tokens;
 	  result = POLICE_VIOLATE;
 	}
 
@@ -163,46 +184,50 @@ vnet_police_packet (policer_read_response_type_st * policer,
     {
       // Two-rate policer
 
-      // Compute number of tokens for this time period
-      current_tokens =
-	policer->current_bucket + n_periods * policer->cir_tokens_per_period;
-      extended_tokens =
-	policer->extended_bucket + n_periods * policer->pir_tokens_per_period;
-      if (current_tokens > policer->current_limit)
-	{
-	  current_tokens = policer->current_limit;
-	}
-      if (extended_tokens > policer->extended_limit)
-	{
-	  extended_tokens = policer->extended_limit;
-	}
-
       // Determine color
 
       if ((policer->color_aware && (packet_color == POLICE_VIOLATE))
 	  || (extended_tokens < packet_length))
 	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens;
+	  *current_bucket = current_tokens;
+	  *extended_bucket = extended_tokens;
 	  result = POLICE_VIOLATE;
 	}
       else if ((policer->color_aware && (packet_color == POLICE_EXCEED))
 	       || (current_tokens < packet_length))
 	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens - packet_length;
+	  *current_bucket = current_tokens;
+	  *extended_bucket = extended_tokens - packet_length;
 	  result = POLICE_EXCEED;
 	}
       else
 	{
-	  policer->current_bucket = current_tokens - packet_length;
-	  policer->extended_bucket = extended_tokens - packet_length;
+	  *current_bucket = current_tokens - packet_length;
+	  *extended_bucket = extended_tokens - packet_length;
 	  result = POLICE_CONFORM;
 	}
     }
   return result;
 }
 
+static inline policer_result_e
+vnet_police_packet (policer_read_response_type_st * policer,
+		    u32 packet_length,
+		    policer_result_e packet_color, u64 time)
+{
+  u64 current_tokens, extended_tokens;
+
+  // Scale packet length to support a wide range of speeds
+  packet_length = packet_length << policer->scale;
+
+  vnet_police_refill (policer, time, &current_tokens, &extended_tokens);
+
+  return vnet_police_color (policer, current_tokens, extended_tokens,
+			    &policer->current_bucket,
+			    &policer->extended_bucket,
+			    packet_length, packet_color);
+}
+
 #endif // __POLICE_H__
 
 /*
@@ -16,6 +16,7 @@
 #define __POLICE_INLINES_H__
 
 #include <vnet/policer/police.h>
+#include <vnet/policer/policer.h>
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
 
@@ -55,6 +56,161 @@ vnet_policer_mark (vlib_buffer_t * b, u8 dscp)
     }
 }
 
+/*
+ * Renew a thread's lease on a shared policer: under the policer's lock,
+ * bring the buckets up to date, give back what is left of the old lease
+ * and take a new one. A lease is POLICER_LEASE_PERIODS worth of tokens
+ * at the policer's rates, but no more than a 1/n_threads share of the
+ * limits unless a single packet needs more, and no more than the
+ * buckets hold. The policer's buckets and the leases out on it
+ * together never exceed the limits, so tokens are only moved between
+ * them and the threads cannot admit more than the policer would alone.
+ */
+static inline void
+vnet_police_lease (policer_read_response_type_st * policer,
+		   policer_lease_t * leased, policer_lease_t * lease,
+		   u32 packet_length, u64 time, u32 n_threads)
+{
+  u64 current_tokens, extended_tokens;
+  u64 current_lease, extended_lease;
+  u64 current_others, extended_others;
+  u32 extended_rate;
+
+  while (__sync_lock_test_and_set (&policer->lock, 1))
+    ;
+
+  vnet_police_refill (policer, time, &current_tokens, &extended_tokens);
+
+  /* what the other threads hold counts against the limits */
+  current_others = leased->current_bucket - lease->current_bucket;
+  extended_others = leased->extended_bucket - lease->extended_bucket;
+
+  current_tokens = clib_min (current_tokens + lease->current_bucket,
+			     policer->current_limit - current_others);
+  extended_tokens = clib_min (extended_tokens + lease->extended_bucket,
+			      policer->extended_limit - extended_others);
+
+  extended_rate = policer->single_rate ?
+    policer->cir_tokens_per_period : policer->pir_tokens_per_period;
+
+  current_lease = clib_min ((u64) policer->cir_tokens_per_period *
+			    POLICER_LEASE_PERIODS,
+			    policer->current_limit / n_threads);
+  current_lease = clib_max (current_lease, packet_length);
+  current_lease = clib_min (current_lease, current_tokens);
+
+  extended_lease = clib_min ((u64) extended_rate * POLICER_LEASE_PERIODS,
+			     policer->extended_limit / n_threads);
+  extended_lease = clib_max (extended_lease, packet_length);
+  extended_lease = clib_min (extended_lease, extended_tokens);
+
+  policer->current_bucket = current_tokens - current_lease;
+  policer->extended_bucket = extended_tokens - extended_lease;
+  leased->current_bucket = current_others + current_lease;
+  leased->extended_bucket = extended_others + extended_lease;
+
+  __sync_lock_release (&policer->lock);
+
+  lease->current_bucket = current_lease;
+  lease->extended_bucket = extended_lease;
+  lease->lease_time = time;
+}
+
+/*
+ * Hand a thread's lease back to the policer. The thread must not be
+ * policing meanwhile: stale leases are taken back from the main thread
+ * with the workers stopped, so that an idle thread does not sit on
+ * tokens the busy ones could use.
+ */
+static inline void
+vnet_police_lease_return (policer_read_response_type_st * policer,
+			  policer_lease_t * leased, policer_lease_t * lease,
+			  u64 time)
+{
+  u64 current_tokens, extended_tokens;
+
+  while (__sync_lock_test_and_set (&policer->lock, 1))
+    ;
+
+  vnet_police_refill (policer, time, &current_tokens, &extended_tokens);
+
+  leased->current_bucket -= lease->current_bucket;
+  leased->extended_bucket -= lease->extended_bucket;
+
+  policer->current_bucket =
+    clib_min (current_tokens + lease->current_bucket,
+	      (u64) policer->current_limit - leased->current_bucket);
+  policer->extended_bucket =
+    clib_min (extended_tokens + lease->extended_bucket,
+	      (u64) policer->extended_limit - leased->extended_bucket);
+
+  __sync_lock_release (&policer->lock);
+
+  /* renewed on the thread's next packet */
+  memset (lease, 0, sizeof (*lease));
+}
+
+/* Whether a lease holds tokens and has not been renewed for a while */
+always_inline int
+vnet_police_lease_is_stale (policer_lease_t * lease, u64 time)
+{
+  return ((lease->current_bucket || lease->extended_bucket)
+	  && time - lease->lease_time > POLICER_LEASE_MAX_AGE);
+}
+
+/*
+ * Color a packet against a thread's lease on a shared policer,
+ * renewing the lease if it is short of the packet or stale. A lease
+ * is renewed at most once per policer period, so a policer that is
+ * out of tokens costs a thread one locked access per period, not
+ * one per packet.
+ */
+static_always_inline policer_result_e
+vnet_police_packet_leased (policer_read_response_type_st * policer,
+			   policer_lease_t * leased, policer_lease_t * lease,
+			   u32 packet_length, policer_result_e packet_color,
+			   u64 time, u32 n_threads)
+{
+  packet_length = packet_length << policer->scale;
+
+  if (PREDICT_FALSE (time != lease->lease_time
+		     && (lease->current_bucket < packet_length
+			 || lease->extended_bucket < packet_length
+			 || time - lease->lease_time >
+			 POLICER_LEASE_MAX_AGE)))
+    vnet_police_lease (policer, leased, lease, packet_length, time,
+		       n_threads);
+
+  return vnet_police_color (policer, lease->current_bucket,
+			    lease->extended_bucket, &lease->current_bucket,
+			    &lease->extended_bucket, packet_length,
+			    packet_color);
+}
+
+static_always_inline policer_result_e
+vnet_policer_police_one (vnet_policer_main_t * pm, u32 thread_index,
+			 u32 policer_index, u32 packet_length,
+			 policer_result_e packet_color, u64 time)
+{
+  policer_read_response_type_st *pol = &pm->policers[policer_index];
+
+  if (PREDICT_TRUE (pm->n_threads == 1))
+    return vnet_police_packet (pol, packet_length, packet_color, time);
+
+  return vnet_police_packet_leased
+    (pol, &pm->leased[policer_index],
+     &pm->per_thread[thread_index].leases[policer_index],
+     packet_length, packet_color, time, pm->n_threads);
+}
+
+/*
+ * Police a packet through a policer and then its parents. Each parent
+ * sees the color given below it, which a color-aware parent honours.
+ * The packet ends up with the worst color given anywhere on the way
+ * up, and the action of the policer that gave it. A drop stops the
+ * walk, so the parents are not charged for packets their children
+ * drop.
+ */
 static_always_inline u8
 vnet_policer_police (vlib_main_t * vm,
 		     vlib_buffer_t * b,
@@ -64,16 +220,34 @@ vnet_policer_police (vlib_main_t * vm,
 {
   u8 act;
   u32 len;
-  u32 col;
-  policer_read_response_type_st *pol;
+  u32 col, pcol;
+  policer_read_response_type_st *pol, *mark_pol;
   vnet_policer_main_t *pm = &vnet_policer_main;
 
   len = vlib_buffer_length_in_chain (vm, b);
   pol = &pm->policers[policer_index];
-  col = vnet_police_packet (pol, len, packet_color, time_in_policer_periods);
+  col = vnet_policer_police_one (pm, vm->thread_index, policer_index, len,
+				 packet_color, time_in_policer_periods);
   act = pol->action[col];
+  mark_pol = pol;
+
+  while (PREDICT_FALSE (pol->parent_index != ~0)
+	 && act != SSE2_QOS_ACTION_DROP)
+    {
+      policer_index = pol->parent_index;
+      pol = &pm->policers[policer_index];
+      pcol = vnet_policer_police_one (pm, vm->thread_index, policer_index,
+				      len, col, time_in_policer_periods);
+      if (pcol >= col)
+	{
+	  col = pcol;
+	  act = pol->action[col];
+	  mark_pol = pol;
+	}
+    }
+
   if (PREDICT_TRUE (act == SSE2_QOS_ACTION_MARK_AND_TRANSMIT))
-    vnet_policer_mark (b, pol->mark_dscp[col]);
+    vnet_policer_mark (b, mark_pol->mark_dscp[col]);
 
   return act;
 }
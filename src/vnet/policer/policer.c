@@ -14,10 +14,123 @@
  */
 #include <stdint.h>
 #include <vnet/policer/policer.h>
+#include <vnet/policer/police_inlines.h>
 #include <vnet/classify/vnet_classify.h>
 
 vnet_policer_main_t vnet_policer_main;
 
+/**
+ * Set up a policer just copied from its template: no parent, and
+ * a fresh lease on it for every thread.
+ */
+void
+policer_instance_init (u32 policer_index)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *policer;
+  vnet_policer_per_thread_t *ptd;
+
+  policer = pool_elt_at_index (pm->policers, policer_index);
+  policer->parent_index = ~0;
+  policer->lock = 0;
+
+  vec_validate (pm->leased, policer_index);
+  memset (&pm->leased[policer_index], 0, sizeof (policer_lease_t));
+
+  vec_foreach (ptd, pm->per_thread)
+  {
+    vec_validate (ptd->leases, policer_index);
+    memset (&ptd->leases[policer_index], 0, sizeof (policer_lease_t));
+  }
+}
+
+/**
+ * Free a policer, detaching any children it has.
+ */
+void
+policer_instance_free (u32 policer_index)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *policer;
+
+  /* *INDENT-OFF* */
+  pool_foreach (policer, pm->policers,
+  ({
+    if (policer->parent_index == policer_index)
+      policer->parent_index = ~0;
+  }));
+  /* *INDENT-ON* */
+
+  pool_put_index (pm->policers, policer_index);
+}
+
+/**
+ * The number of levels of children below a policer, 0 if it has none.
+ */
+static u32
+policer_subtree_height (u32 policer_index)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *policer, *child;
+  u32 height = 0, depth;
+
+  /* *INDENT-OFF* */
+  pool_foreach (child, pm->policers,
+  ({
+    policer = child;
+    for (depth = 1;
+	 policer->parent_index != ~0 && depth <= POLICER_MAX_HIERARCHY_DEPTH;
+	 depth++)
+      {
+	if (policer->parent_index == policer_index)
+	  {
+	    height = clib_max (height, depth);
+	    break;
+	  }
+	policer = pool_elt_at_index (pm->policers, policer->parent_index);
+      }
+  }));
+  /* *INDENT-ON* */
+
+  return (height);
+}
+
+/**
+ * Make one policer the parent of another, or with a parent_index of ~0
+ * detach it. Refuses loops and chains deeper than
+ * POLICER_MAX_HIERARCHY_DEPTH, counting the children the policer
+ * brings with it.
+ */
+clib_error_t *
+policer_set_parent (u32 policer_index, u32 parent_index)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *policer, *parent;
+  u32 depth;
+
+  policer = pool_elt_at_index (pm->policers, policer_index);
+  depth = 1 + policer_subtree_height (policer_index);
+
+  if (parent_index != ~0)
+    {
+      parent = pool_elt_at_index (pm->policers, parent_index);
+      while (1)
+	{
+	  if (parent == policer)
+	    return clib_error_return (0, "policer hierarchy would loop");
+	  if (++depth > POLICER_MAX_HIERARCHY_DEPTH)
+	    return clib_error_return (0, "policer hierarchy deeper than %d",
+				      POLICER_MAX_HIERARCHY_DEPTH);
+	  if (parent->parent_index == ~0)
+	    break;
+	  parent = pool_elt_at_index (pm->policers, parent->parent_index);
+	}
+    }
+
+  policer->parent_index = parent_index;
+  return 0;
+}
+
 clib_error_t *
 policer_add_del (vlib_main_t * vm,
 		 u8 * name,
@@ -52,7 +165,7 @@ policer_add_del (vlib_main_t * vm,
 	  vec_free (name);
 	  return clib_error_return (0, "No such policer");
 	}
-      pool_put_index (pm->policers, p[0]);
+      policer_instance_free (p[0]);
       hash_unset_mem (pm->policer_index_by_name, name);
 
       vec_free (name);
@@ -78,6 +191,7 @@ policer_add_del (vlib_main_t * vm,
 
       ASSERT (cp - pm->configs == pp - pm->policer_templates);
 
+      test_policer.parent_index = ~0;
       clib_memcpy (cp, cfg, sizeof (*cp));
       clib_memcpy (pp, &test_policer, sizeof (*pp));
 
@@ -85,6 +199,7 @@ policer_add_del (vlib_main_t * vm,
       pool_get_aligned (pm->policers, policer, CLIB_CACHE_LINE_BYTES);
       policer[0] = pp[0];
       pi = policer - pm->policers;
+      policer_instance_init (pi);
       hash_set_mem (pm->policer_index_by_name, name, pi);
       *policer_index = pi;
     }
@@ -112,6 +227,8 @@ format_policer_instance (u8 * s, va_list * va)
 	      i->current_limit,
 	      i->current_bucket, i->extended_limit, i->extended_bucket);
   s = format (s, "last update %llu\n", i->last_update_time);
+  if (i->parent_index != ~0)
+    s = format (s, "parent %u\n", i->parent_index);
   return s;
 }
 
@@ -536,6 +653,324 @@ VLIB_CLI_COMMAND (show_policer_pools_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_policer_parent_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u8 *name = 0, *parent_name = 0;
+  u32 parent_index = ~0;
+  clib_error_t *error = NULL;
+  uword *p;
+  int is_del = 0;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "del"))
+	is_del = 1;
+      else if (name == 0 && unformat (line_input, "%s", &name))
+	;
+      else if (unformat (line_input, "%s", &parent_name))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (name == 0 || (parent_name == 0 && !is_del))
+    {
+      error = clib_error_return (0, "policer and parent names required");
+      goto done;
+    }
+
+  p = hash_get_mem (pm->policer_index_by_name, name);
+  if (p == 0)
+    {
+      error = clib_error_return (0, "No such policer: %s", name);
+      goto done;
+    }
+
+  if (!is_del)
+    {
+      uword *pp = hash_get_mem (pm->policer_index_by_name, parent_name);
+      if (pp == 0)
+	{
+	  error = clib_error_return (0, "No such policer: %s", parent_name);
+	  goto done;
+	}
+      parent_index = pp[0];
+    }
+
+  error = policer_set_parent (p[0], parent_index);
+
+done:
+  vec_free (name);
+  vec_free (parent_name);
+  unformat_free (line_input);
+
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_policer_parent_command, static) = {
+    .path = "set policer parent",
+    .short_help = "set policer parent <name> [<parent-name> | del]",
+    .function = set_policer_parent_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * Take back the leases that idle threads have not renewed for
+ * POLICER_LEASE_MAX_AGE periods. A thread only renews its lease when it
+ * sees a packet, so without this a thread that stops receiving would
+ * keep its share of the bucket for good. The workers are stopped while
+ * the leases are returned, and only when there is one to return.
+ */
+static uword
+policer_lease_reclaim_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+			       vlib_frame_t * f)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *policer;
+  vnet_policer_per_thread_t *ptd;
+  u32 policer_index;
+  u64 time;
+  int stale;
+
+  if (pm->n_threads < 2)
+    return 0;
+
+  while (1)
+    {
+      vlib_process_suspend (vm, POLICER_LEASE_RECLAIM_INTERVAL);
+
+      time = clib_cpu_time_now () >> POLICER_TICKS_PER_PERIOD_SHIFT;
+      stale = 0;
+
+      /* *INDENT-OFF* */
+      pool_foreach (policer, pm->policers,
+      ({
+        policer_index = policer - pm->policers;
+        vec_foreach (ptd, pm->per_thread)
+          stale |= vnet_police_lease_is_stale (&ptd->leases[policer_index],
+                                               time);
+      }));
+      /* *INDENT-ON* */
+
+      if (!stale)
+	continue;
+
+      vlib_worker_thread_barrier_sync (vm);
+
+      /* *INDENT-OFF* */
+      pool_foreach (policer, pm->policers,
+      ({
+        policer_index = policer - pm->policers;
+        vec_foreach (ptd, pm->per_thread)
+          {
+            if (vnet_police_lease_is_stale (&ptd->leases[policer_index],
+                                            time))
+              vnet_police_lease_return (policer, &pm->leased[policer_index],
+                                        &ptd->leases[policer_index], time);
+          }
+      }));
+      /* *INDENT-ON* */
+
+      vlib_worker_thread_barrier_release (vm);
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (policer_lease_reclaim_node, static) = {
+    .function = policer_lease_reclaim_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "policer-lease-reclaim",
+};
+/* *INDENT-ON* */
+
+typedef enum
+{
+  POLICER_TEST_MODE_STEADY,
+  POLICER_TEST_MODE_IDLE,
+  POLICER_TEST_MODE_BURST,
+} policer_test_mode_t;
+
+/*
+ * Offer a policer a fixed multiple of its committed rate, with the
+ * packets spread over a number of simulated threads, each with its own
+ * lease, and report how much was admitted against what an ideal policer
+ * would have admitted. In steady mode the packets go round-robin over
+ * the threads. In idle mode every thread but the first sees one packet
+ * and then goes quiet, and the reclaim process is simulated. In burst
+ * mode all the packets arrive in the same period, so no more than the
+ * limit may conform. The policer's template is used, the live instance
+ * is left alone.
+ */
+static clib_error_t *
+test_policer_accuracy_command_fn (vlib_main_t * vm,
+				  unformat_input_t * input,
+				  vlib_cli_command_t * cmd)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st policer, *templ;
+  policer_lease_t *leases = 0, leased = { 0 };
+  policer_test_mode_t mode = POLICER_TEST_MODE_STEADY;
+  u32 n_threads = 8, n_packets = 1000000, packet_size = 1000, load = 200;
+  u64 n_tokens[POLICE_VIOLATE + 1] = { 0 };
+  u32 n_results[POLICE_VIOLATE + 1] = { 0 };
+  u64 time = 0, start, clocks, ideal, reclaim_periods, next_reclaim;
+  u32 n_reclaimed = 0;
+  u8 *name = 0;
+  uword *p;
+  u32 i, t, len;
+  policer_result_e col;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "name %s", &name))
+	;
+      else if (unformat (input, "threads %u", &n_threads))
+	;
+      else if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "size %u", &packet_size))
+	;
+      else if (unformat (input, "load %u", &load))
+	;
+      else if (unformat (input, "steady"))
+	mode = POLICER_TEST_MODE_STEADY;
+      else if (unformat (input, "idle"))
+	mode = POLICER_TEST_MODE_IDLE;
+      else if (unformat (input, "burst"))
+	mode = POLICER_TEST_MODE_BURST;
+      else
+	{
+	  vec_free (name);
+	  return clib_error_return (0, "unknown input `%U'",
+				    format_unformat_error, input);
+	}
+    }
+
+  if (name == 0)
+    return clib_error_return (0, "policer name required");
+
+  p = hash_get_mem (pm->policer_config_by_name, name);
+  vec_free (name);
+  if (p == 0)
+    return clib_error_return (0, "No such policer configuration");
+
+  templ = pool_elt_at_index (pm->policer_templates, p[0]);
+  if (templ->cir_tokens_per_period == 0 || n_threads == 0 || load == 0
+      || n_packets == 0)
+    return clib_error_return (0, "nothing to measure");
+
+  policer = templ[0];
+  policer.current_bucket = policer.current_limit;
+  policer.extended_bucket = policer.extended_limit;
+  policer.last_update_time = 0;
+  policer.lock = 0;
+  vec_validate (leases, n_threads - 1);
+
+  len = packet_size << policer.scale;
+
+  reclaim_periods = POLICER_LEASE_RECLAIM_INTERVAL *
+    vm->clib_time.clocks_per_second / POLICER_TICKS_PER_PERIOD;
+  reclaim_periods = clib_max (reclaim_periods, 1);
+  next_reclaim = reclaim_periods;
+
+  start = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    {
+      /*
+       * The period this packet arrives in at the offered load, counted
+       * from 1 so that no lease looks renewed before the first packet.
+       * A small rate or load makes for long gaps, never a zero divisor.
+       */
+      if (mode == POLICER_TEST_MODE_BURST)
+	time = 1;
+      else
+	time = 1 + (u64) i *len * 100 /
+	  ((u64) policer.cir_tokens_per_period * load);
+
+      if (mode == POLICER_TEST_MODE_IDLE)
+	t = i < n_threads - 1 ? i + 1 : 0;
+      else
+	t = i % n_threads;
+
+      if (n_threads == 1)
+	col = vnet_police_packet (&policer, packet_size, POLICE_CONFORM,
+				  time);
+      else
+	col = vnet_police_packet_leased (&policer, &leased, &leases[t],
+					 packet_size, POLICE_CONFORM, time,
+					 n_threads);
+      n_results[col]++;
+      n_tokens[col] += len;
+
+      /* what policer-lease-reclaim would have done by now */
+      if (mode == POLICER_TEST_MODE_IDLE && n_threads > 1
+	  && time >= next_reclaim)
+	{
+	  for (t = 0; t < n_threads; t++)
+	    if (vnet_police_lease_is_stale (&leases[t], time))
+	      {
+		vnet_police_lease_return (&policer, &leased, &leases[t],
+					  time);
+		n_reclaimed++;
+	      }
+	  next_reclaim = time + reclaim_periods;
+	}
+    }
+  clocks = clib_cpu_time_now () - start;
+
+  if (mode == POLICER_TEST_MODE_BURST)
+    ideal = clib_min ((u64) n_packets * len, templ->current_limit);
+  else
+    ideal = clib_min ((u64) n_packets * len,
+		      templ->current_limit +
+		      (u64) policer.cir_tokens_per_period * (time - 1));
+
+  vlib_cli_output (vm, "%u packets of %u bytes at %u%% of cir over "
+		   "%u threads, %s, %llu periods",
+		   n_packets, packet_size, load, n_threads,
+		   mode == POLICER_TEST_MODE_BURST ? "burst" :
+		   mode == POLICER_TEST_MODE_IDLE ? "idle" : "steady",
+		   time - 1);
+  vlib_cli_output (vm, "conform %u exceed %u violate %u",
+		   n_results[POLICE_CONFORM], n_results[POLICE_EXCEED],
+		   n_results[POLICE_VIOLATE]);
+  vlib_cli_output (vm, "conformed %.2f%% of the ideal%s",
+		   ideal ? 100.0 * n_tokens[POLICE_CONFORM] / ideal : 0.0,
+		   n_tokens[POLICE_CONFORM] > ideal + len ?
+		   ", over the limit" : "");
+  if (mode == POLICER_TEST_MODE_IDLE)
+    vlib_cli_output (vm, "%u stale leases reclaimed", n_reclaimed);
+  vlib_cli_output (vm, "%.2f clocks/packet", (f64) clocks / n_packets);
+
+  vec_free (leases);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_policer_accuracy_command, static) = {
+    .path = "test policer accuracy",
+    .short_help = "test policer accuracy name <name> [threads <n>] "
+    "[packets <n>] [size <bytes>] [load <percent-of-cir>] "
+    "[steady | idle | burst]",
+    .function = test_policer_accuracy_command_fn,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 policer_init (vlib_main_t * vm)
 {
@@ -547,6 +982,11 @@ policer_init (vlib_main_t * vm)
   pm->vlib_main = vm;
   pm->vnet_main = vnet_get_main ();
 
+  pm->n_threads = vlib_get_thread_main ()->n_vlib_mains;
+  if (pm->n_threads > 1)
+    vec_validate_aligned (pm->per_thread, pm->n_threads - 1,
+			  CLIB_CACHE_LINE_BYTES);
+
   pm->policer_config_by_name = hash_create_string (0, sizeof (uword));
   pm->policer_index_by_name = hash_create_string (0, sizeof (uword));
 
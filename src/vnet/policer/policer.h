@@ -21,6 +21,35 @@
 #include <vnet/policer/xlate.h>
 #include <vnet/policer/police.h>
 
+/*
+ * Tokens one thread holds on a shared policer's buckets. The thread
+ * colors packets against these, and renews them from the policer, at
+ * most once per policer period, when they run short or get old.
+ */
+typedef struct
+{
+  u32 current_bucket;
+  u32 extended_bucket;
+  /* policer period of the last renewal */
+  u64 lease_time;
+} policer_lease_t;
+
+typedef struct
+{
+  /* leases on the policers, by policer index */
+  policer_lease_t *leases;
+} vnet_policer_per_thread_t;
+
+/* A lease covers this many periods at the policer's rate ... */
+#define POLICER_LEASE_PERIODS 16
+/* ... and is handed back after this many, used or not */
+#define POLICER_LEASE_MAX_AGE 64
+/* How often the main thread takes back the leases of idle threads */
+#define POLICER_LEASE_RECLAIM_INTERVAL 10e-3
+
+/* Longest parent chain a policer may sit at the bottom of */
+#define POLICER_MAX_HIERARCHY_DEPTH 4
+
 typedef struct
 {
   /* policer pool, aligned */
@@ -39,6 +68,15 @@ typedef struct
   /* Policer by sw_if_index vector */
   u32 *policer_index_by_sw_if_index;
 
+  /* Threads policing, leases are used if more than one */
+  u32 n_threads;
+
+  /* Per-thread leases, only allocated if n_threads > 1 */
+  vnet_policer_per_thread_t *per_thread;
+
+  /* Sum of the leases out on each policer, by policer index */
+  policer_lease_t *leased;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -95,6 +133,9 @@ clib_error_t *policer_add_del (vlib_main_t * vm,
 			       u8 * name,
 			       sse2_qos_pol_cfg_params_st * cfg,
 			       u32 * policer_index, u8 is_add);
+void policer_instance_init (u32 policer_index);
+void policer_instance_free (u32 policer_index);
+clib_error_t *policer_set_parent (u32 policer_index, u32 parent_index);
 
 #endif /* __included_policer_h__ */
 
@@ -105,8 +105,8 @@ replication_recycle (vlib_main_t * vm, vlib_buffer_t * b0, u32 is_last)
   clib_memcpy (vnet_buffer (b0), ctx->vnet_buffer,
 	       sizeof (vnet_buffer_opaque_t));
 
-  /* Restore the vlan flags */
-  b0->flags &= ~VNET_BUFFER_FLAGS_VLAN_BITS;
+  /* Restore the vlan flags, the next replica computes its own hash */
+  b0->flags &= ~(VNET_BUFFER_FLAGS_VLAN_BITS | VNET_BUFFER_F_FLOW_HASH_VALID);
   b0->flags |= ctx->flags;
 
   /* Restore the packet start (current_data) and length */
@@ -26,6 +26,7 @@
 #include <vppinfra/elog.h>
 
 vlib_node_registration_t span_node;
+vlib_node_registration_t span_input_node;
 
 /* packet trace format function */
 u8 *
@@ -287,6 +288,47 @@ span_l2_output_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   return span_node_inline_fn (vm, node, frame, VLIB_TX, SPAN_FEAT_L2);
 }
 
+/*
+ * Received packets mirrored by the fused device-input features: the
+ * copies are gathered in per-thread frames until the fused node is done
+ * with its frame and flushes them.
+ */
+static __thread vlib_frame_t **span_fused_mirror_frames = 0;
+
+u32
+span_input_fused (vlib_main_t * vm, vlib_buffer_t * b0, void *feature_config)
+{
+  span_main_t *sm = &span_main;
+
+  vec_validate_aligned (span_fused_mirror_frames, sm->max_sw_if_index,
+			CLIB_CACHE_LINE_BYTES);
+
+  /* traced copies are recorded as span-input's */
+  span_mirror (vm, vlib_node_get_runtime (vm, span_input_node.index),
+	       vnet_buffer (b0)->sw_if_index[VLIB_RX], b0,
+	       span_fused_mirror_frames, VLIB_RX, SPAN_FEAT_DEVICE);
+
+  return VNET_FEATURE_FUSED_CONTINUE;
+}
+
+void
+span_input_fused_flush (vlib_main_t * vm)
+{
+  vnet_main_t *vnm = &vnet_main;
+  u32 sw_if_index;
+
+  for (sw_if_index = 0; sw_if_index < vec_len (span_fused_mirror_frames);
+       sw_if_index++)
+    {
+      vlib_frame_t *f = span_fused_mirror_frames[sw_if_index];
+      if (f == 0)
+	continue;
+
+      vnet_put_frame_to_sw_interface (vnm, sw_if_index, f);
+      span_fused_mirror_frames[sw_if_index] = 0;
+    }
+}
+
 #define span_node_defs                           \
   .vector_size = sizeof (u32),                   \
   .format_trace = format_span_trace,             \
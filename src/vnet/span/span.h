@@ -63,6 +63,9 @@ typedef struct
   u32 mirror_sw_if_index;	/* output interface index */
 } span_trace_t;
 
+vnet_feature_fused_function_t span_input_fused;
+vnet_feature_fused_flush_function_t span_input_fused_flush;
+
 #endif /* __span_h__ */
 
 int
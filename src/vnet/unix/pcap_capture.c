@@ -0,0 +1,865 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief Line-rate rx/tx packet capture to rotating pcapng files.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/classify/vnet_classify.h>
+#include <vnet/unix/pcap_capture.h>
+#include <sys/fcntl.h>
+
+pcap_capture_main_t pcap_capture_main;
+
+/* pcapng block types and options */
+#define PCAPNG_BLOCK_SHB 0x0a0d0d0a
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_OPT_END 0
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_EPB_FLAGS 2
+#define PCAPNG_LINKTYPE_ETHERNET 1
+#define PCAPNG_LINKTYPE_RAW 101
+
+/* Flush the write buffer once it holds this many bytes */
+#define PCAP_CAPTURE_WRITE_BYTES (256 << 10)
+
+/* Writer process poll interval while capture is on */
+#define PCAP_CAPTURE_POLL_INTERVAL 10e-3
+
+static int
+pcap_capture_filter_match (vnet_classify_main_t * vcm, u32 table_index,
+			   u8 * h, f64 now)
+{
+  vnet_classify_table_t *t;
+  u64 hash;
+
+  while (table_index != ~0)
+    {
+      /* A table deleted while capturing matches nothing */
+      if (PREDICT_FALSE (pool_is_free_index (vcm->tables, table_index)))
+	return 0;
+      t = pool_elt_at_index (vcm->tables, table_index);
+      hash = vnet_classify_hash_packet_inline (t, h);
+      if (vnet_classify_find_entry_inline (t, h, hash, now))
+	return 1;
+      table_index = t->next_table_index;
+    }
+  return 0;
+}
+
+void
+pcap_capture_buffers_internal (vlib_main_t * vm, u32 * buffers,
+			       u32 n_buffers, u32 sw_if_index,
+			       pcap_capture_direction_t direction)
+{
+  pcap_capture_main_t *cm = &pcap_capture_main;
+  vnet_classify_main_t *vcm = &vnet_classify_main;
+  u64 cpu_time = clib_cpu_time_now ();
+  f64 now = vlib_time_now (vm);
+  pcap_capture_ring_t *r;
+  pcap_capture_slot_t *s;
+  vlib_buffer_t *b;
+  u32 head, tail, i, capture_sw_if_index;
+
+  if (PREDICT_FALSE (vm->thread_index >= vec_len (cm->rings)))
+    return;
+
+  capture_sw_if_index = (direction == PCAP_CAPTURE_RX ?
+			 cm->rx_sw_if_index : cm->sw_if_index);
+
+  r = vec_elt_at_index (cm->rings, vm->thread_index);
+  head = r->head;
+  tail = r->tail;
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      u32 n_left, n_bytes, this_sw_if_index;
+      u8 *d;
+
+      b = vlib_get_buffer (vm, buffers[i]);
+      this_sw_if_index = sw_if_index != ~0 ? sw_if_index :
+	vnet_buffer (b)->sw_if_index[VLIB_RX];
+
+      if (capture_sw_if_index != ~0
+	  && this_sw_if_index != capture_sw_if_index)
+	continue;
+
+      if (cm->filter_table_index != ~0
+	  && !pcap_capture_filter_match (vcm, cm->filter_table_index,
+					 vlib_buffer_get_current (b), now))
+	{
+	  r->n_filtered++;
+	  continue;
+	}
+
+      if (PREDICT_FALSE (head - tail > r->slot_mask))
+	{
+	  /* Writer may have caught up since we last looked */
+	  tail = r->tail;
+	  if (head - tail > r->slot_mask)
+	    {
+	      r->n_ring_full++;
+	      continue;
+	    }
+	}
+
+      s = (pcap_capture_slot_t *) (r->slots
+				   + (head & r->slot_mask) * r->slot_bytes);
+      n_bytes = vlib_buffer_length_in_chain (vm, b);
+      n_left = clib_min (n_bytes, cm->snap_length);
+
+      s->cpu_time = cpu_time;
+      s->sw_if_index = this_sw_if_index;
+      s->n_bytes_in_packet = n_bytes;
+      s->n_bytes_captured = n_left;
+      s->direction = direction;
+
+      d = s->data;
+      while (1)
+	{
+	  u32 copy_length = clib_min (n_left, b->current_length);
+	  clib_memcpy (d, vlib_buffer_get_current (b), copy_length);
+	  n_left -= copy_length;
+	  d += copy_length;
+	  if (n_left == 0 || !(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	    break;
+	  b = vlib_get_buffer (vm, b->next_buffer);
+	}
+
+      head++;
+      r->n_captured++;
+    }
+
+  /* Publish slot contents before the new head */
+  CLIB_MEMORY_STORE_BARRIER ();
+  r->head = head;
+}
+
+/*
+ * Received packets are captured on the device-input arc, which every
+ * packet from a device goes through whatever node the driver hands it
+ * to next, starting at its ethernet header.
+ */
+static uword
+pcap_capture_rx_node_fn (vlib_main_t * vm,
+			 vlib_node_runtime_t * node, vlib_frame_t * frame)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 n_left, *from;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+
+  pcap_capture_buffers (vm, from, n_left, ~0, PCAP_CAPTURE_RX);
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+  while (n_left > 0)
+    {
+      u32 next0;
+
+      vnet_feature_next (vnet_buffer (b[0])->sw_if_index[VLIB_RX], &next0,
+			 b[0]);
+      next[0] = next0;
+
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  return frame->n_vectors;
+}
+
+static u32
+pcap_capture_rx_fused (vlib_main_t * vm, vlib_buffer_t * b,
+		       void *feature_config)
+{
+  u32 bi = vlib_get_buffer_index (vm, b);
+
+  pcap_capture_buffers (vm, &bi, 1, ~0, PCAP_CAPTURE_RX);
+  return VNET_FEATURE_FUSED_CONTINUE;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (pcap_capture_rx_node, static) = {
+  .function = pcap_capture_rx_node_fn,
+  .name = "pcap-capture-rx",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+};
+
+VNET_FEATURE_INIT (pcap_capture_rx_feature, static) = {
+  .arc_name = "device-input",
+  .node_name = "pcap-capture-rx",
+  .runs_before = VNET_FEATURES ("ethernet-input"),
+  .fused_function = pcap_capture_rx_fused,
+};
+/* *INDENT-ON* */
+
+static void
+pcap_capture_rx_feature_enable (pcap_capture_main_t * cm)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_interface_t *hi;
+  u32 *sw_if_index;
+
+  if (cm->sw_if_index != ~0)
+    vec_add1 (cm->rx_feature_sw_if_indices, cm->rx_sw_if_index);
+  else
+    {
+      /* *INDENT-OFF* */
+      pool_foreach (hi, vnm->interface_main.hw_interfaces,
+      ({
+        vec_add1 (cm->rx_feature_sw_if_indices, hi->sw_if_index);
+      }));
+      /* *INDENT-ON* */
+    }
+
+  vec_foreach (sw_if_index, cm->rx_feature_sw_if_indices)
+    vnet_feature_enable_disable ("device-input", "pcap-capture-rx",
+				 sw_if_index[0], 1, 0, 0);
+}
+
+static void
+pcap_capture_rx_feature_disable (pcap_capture_main_t * cm)
+{
+  u32 *sw_if_index;
+
+  vec_foreach (sw_if_index, cm->rx_feature_sw_if_indices)
+    vnet_feature_enable_disable ("device-input", "pcap-capture-rx",
+				 sw_if_index[0], 0, 0, 0);
+  vec_reset_length (cm->rx_feature_sw_if_indices);
+}
+
+static void
+pcapng_add (u8 ** v, void *data, u32 n_bytes)
+{
+  u8 *d;
+
+  vec_add2 (*v, d, round_pow2 (n_bytes, 4));
+  clib_memcpy (d, data, n_bytes);
+  memset (d + n_bytes, 0, round_pow2 (n_bytes, 4) - n_bytes);
+}
+
+static void
+pcapng_add_u32 (u8 ** v, u32 x)
+{
+  pcapng_add (v, &x, sizeof (x));
+}
+
+static void
+pcapng_add_option (u8 ** v, u16 code, void *data, u16 n_bytes)
+{
+  u16 hdr[2] = { code, n_bytes };
+
+  pcapng_add (v, hdr, sizeof (hdr));
+  if (n_bytes)
+    pcapng_add (v, data, n_bytes);
+}
+
+/* Patch the leading block length and append the trailing copy */
+static void
+pcapng_block_end (u8 ** v, u32 block_offset)
+{
+  u32 n_bytes = vec_len (*v) - block_offset + sizeof (u32);
+
+  *(u32 *) (*v + block_offset + sizeof (u32)) = n_bytes;
+  pcapng_add_u32 (v, n_bytes);
+}
+
+static void
+pcap_capture_add_section_header (pcap_capture_main_t * cm)
+{
+  u32 offset = vec_len (cm->write_buffer);
+  u16 version[2] = { 1, 0 };
+  i64 section_length = -1;
+
+  pcapng_add_u32 (&cm->write_buffer, PCAPNG_BLOCK_SHB);
+  pcapng_add_u32 (&cm->write_buffer, 0);
+  pcapng_add_u32 (&cm->write_buffer, PCAPNG_BYTE_ORDER_MAGIC);
+  pcapng_add (&cm->write_buffer, version, sizeof (version));
+  pcapng_add (&cm->write_buffer, &section_length, sizeof (section_length));
+  pcapng_block_end (&cm->write_buffer, offset);
+}
+
+static u32
+pcap_capture_interface_id (pcap_capture_main_t * cm, u32 sw_if_index)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_interface_t *hi;
+  u16 linktype[2] = { PCAPNG_LINKTYPE_RAW, 0 };
+  u32 offset;
+  uword *p;
+  u8 *name;
+
+  p = hash_get (cm->interface_id_by_sw_if_index, sw_if_index);
+  if (p)
+    return p[0];
+
+  if (!pool_is_free_index (vnm->interface_main.sw_interfaces, sw_if_index))
+    {
+      hi = vnet_get_sup_hw_interface (vnm, sw_if_index);
+      if (hi->hw_class_index == ethernet_hw_interface_class.index)
+	linktype[0] = PCAPNG_LINKTYPE_ETHERNET;
+      name = format (0, "%U", format_vnet_sw_if_index_name, vnm,
+		     sw_if_index);
+    }
+  else
+    name = format (0, "sw_if_index %d", sw_if_index);
+
+  offset = vec_len (cm->write_buffer);
+  pcapng_add_u32 (&cm->write_buffer, PCAPNG_BLOCK_IDB);
+  pcapng_add_u32 (&cm->write_buffer, 0);
+  pcapng_add (&cm->write_buffer, linktype, sizeof (linktype));
+  pcapng_add_u32 (&cm->write_buffer, cm->snap_length);
+  pcapng_add_option (&cm->write_buffer, PCAPNG_OPT_IF_NAME, name,
+		     vec_len (name));
+  pcapng_add_option (&cm->write_buffer, PCAPNG_OPT_END, 0, 0);
+  pcapng_block_end (&cm->write_buffer, offset);
+  vec_free (name);
+
+  hash_set (cm->interface_id_by_sw_if_index, sw_if_index,
+	    cm->n_interface_ids);
+  return cm->n_interface_ids++;
+}
+
+static void
+pcap_capture_add_packet (pcap_capture_main_t * cm, pcap_capture_slot_t * s)
+{
+  u32 offset, interface_id, epb_flags;
+  u64 usec;
+
+  interface_id = pcap_capture_interface_id (cm, s->sw_if_index);
+
+  usec = 1e6 * (cm->start_unix_time
+		+ (f64) (s->cpu_time - cm->start_cpu_time)
+		* cm->seconds_per_clock);
+
+  /* Inbound = 1, outbound = 2 */
+  epb_flags = s->direction == PCAP_CAPTURE_RX ? 1 : 2;
+
+  offset = vec_len (cm->write_buffer);
+  pcapng_add_u32 (&cm->write_buffer, PCAPNG_BLOCK_EPB);
+  pcapng_add_u32 (&cm->write_buffer, 0);
+  pcapng_add_u32 (&cm->write_buffer, interface_id);
+  pcapng_add_u32 (&cm->write_buffer, usec >> 32);
+  pcapng_add_u32 (&cm->write_buffer, usec);
+  pcapng_add_u32 (&cm->write_buffer, s->n_bytes_captured);
+  pcapng_add_u32 (&cm->write_buffer, s->n_bytes_in_packet);
+  pcapng_add (&cm->write_buffer, s->data, s->n_bytes_captured);
+  pcapng_add_option (&cm->write_buffer, PCAPNG_OPT_EPB_FLAGS, &epb_flags,
+		     sizeof (epb_flags));
+  pcapng_add_option (&cm->write_buffer, PCAPNG_OPT_END, 0, 0);
+  pcapng_block_end (&cm->write_buffer, offset);
+
+  cm->n_packets_written++;
+}
+
+static clib_error_t *
+pcap_capture_file_open (pcap_capture_main_t * cm)
+{
+  u8 *name;
+
+  if (cm->max_file_bytes)
+    name = format (0, "%s.%d%c", cm->file_name, cm->file_index, 0);
+  else
+    name = format (0, "%s%c", cm->file_name, 0);
+
+  cm->file_descriptor = open ((char *) name, O_CREAT | O_TRUNC | O_WRONLY,
+			      0664);
+  if (cm->file_descriptor < 0)
+    {
+      clib_error_t *error =
+	clib_error_return_unix (0, "failed to open `%s'", name);
+      vec_free (name);
+      return error;
+    }
+  vec_free (name);
+
+  cm->n_file_bytes = 0;
+  cm->n_files_written++;
+  hash_free (cm->interface_id_by_sw_if_index);
+  cm->n_interface_ids = 0;
+
+  ASSERT (vec_len (cm->write_buffer) == 0);
+  pcap_capture_add_section_header (cm);
+
+  return 0;
+}
+
+static void
+pcap_capture_file_close (pcap_capture_main_t * cm)
+{
+  if (cm->file_descriptor >= 0)
+    close (cm->file_descriptor);
+  cm->file_descriptor = -1;
+}
+
+static clib_error_t *
+pcap_capture_flush (pcap_capture_main_t * cm)
+{
+  u32 n_written = 0;
+  int n;
+
+  while (n_written < vec_len (cm->write_buffer))
+    {
+      n = write (cm->file_descriptor, cm->write_buffer + n_written,
+		 vec_len (cm->write_buffer) - n_written);
+      if (n < 0)
+	{
+	  if (unix_error_is_fatal (errno))
+	    return clib_error_return_unix (0, "write `%s'", cm->file_name);
+	  continue;
+	}
+      n_written += n;
+    }
+
+  cm->n_file_bytes += n_written;
+  vec_reset_length (cm->write_buffer);
+
+  /* Rotate */
+  if (cm->max_file_bytes && cm->n_file_bytes >= cm->max_file_bytes)
+    {
+      pcap_capture_file_close (cm);
+      cm->file_index = (cm->file_index + 1) % cm->max_files;
+    }
+
+  return 0;
+}
+
+/* Move everything the workers have published into the output file */
+static clib_error_t *
+pcap_capture_drain (pcap_capture_main_t * cm)
+{
+  clib_error_t *error = 0;
+  pcap_capture_ring_t *r;
+  pcap_capture_slot_t *s;
+  u32 head, tail;
+
+  vec_foreach (r, cm->rings)
+  {
+    head = r->head;
+    CLIB_MEMORY_BARRIER ();
+
+    for (tail = r->tail; tail != head; tail++)
+      {
+	if (cm->file_descriptor < 0
+	    && (error = pcap_capture_file_open (cm)))
+	  goto done;
+
+	s = (pcap_capture_slot_t *) (r->slots
+				     + (tail & r->slot_mask) * r->slot_bytes);
+	pcap_capture_add_packet (cm, s);
+
+	if (vec_len (cm->write_buffer) >= PCAP_CAPTURE_WRITE_BYTES
+	    && (error = pcap_capture_flush (cm)))
+	  goto done;
+      }
+
+  done:
+    /* Slots are copied out, hand them back to the worker */
+    CLIB_MEMORY_BARRIER ();
+    r->tail = tail;
+    if (error)
+      return error;
+  }
+
+  if (vec_len (cm->write_buffer))
+    error = pcap_capture_flush (cm);
+
+  return error;
+}
+
+static uword
+pcap_capture_writer_process (vlib_main_t * vm,
+			     vlib_node_runtime_t * rt, vlib_frame_t * f)
+{
+  pcap_capture_main_t *cm = &pcap_capture_main;
+  clib_error_t *error;
+  uword *event_data = 0;
+
+  while (1)
+    {
+      if (cm->enabled_directions)
+	vlib_process_wait_for_event_or_clock (vm,
+					      PCAP_CAPTURE_POLL_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+
+      if (!cm->enabled_directions)
+	continue;
+
+      error = pcap_capture_drain (cm);
+      if (error)
+	{
+	  /* Stop capturing rather than spin on a broken file */
+	  clib_error_report (error);
+	  cm->enabled_directions = 0;
+	  vec_reset_length (cm->write_buffer);
+	  pcap_capture_file_close (cm);
+	}
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (pcap_capture_writer_node, static) = {
+  .function = pcap_capture_writer_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "pcap-capture-writer",
+};
+/* *INDENT-ON* */
+
+static void
+pcap_capture_rings_free (pcap_capture_main_t * cm)
+{
+  pcap_capture_ring_t *r;
+
+  vec_foreach (r, cm->rings) clib_mem_free (r->slots);
+  vec_free (cm->rings);
+}
+
+static void
+pcap_capture_rings_alloc (pcap_capture_main_t * cm)
+{
+  pcap_capture_ring_t *r;
+  u32 slot_bytes;
+
+  slot_bytes = round_pow2 (sizeof (pcap_capture_slot_t) + cm->snap_length,
+			   CLIB_CACHE_LINE_BYTES);
+
+  vec_validate_aligned (cm->rings, vec_len (vlib_mains) - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (r, cm->rings)
+  {
+    r->slot_bytes = slot_bytes;
+    r->slot_mask = cm->ring_size - 1;
+    r->slots = clib_mem_alloc_aligned (cm->ring_size * slot_bytes,
+				       CLIB_CACHE_LINE_BYTES);
+  }
+}
+
+/** Capture settings, as parsed from the CLI */
+typedef struct
+{
+  u32 enabled_directions;
+  u32 sw_if_index;
+  u32 filter_table_index;
+  u32 snap_length;
+  u32 ring_size;
+  u64 max_file_bytes;
+  u32 max_files;
+  /** Output file, 0 to keep the current one */
+  u8 *file_name;
+} pcap_capture_args_t;
+
+static clib_error_t *
+pcap_capture_enable (vlib_main_t * vm, pcap_capture_main_t * cm,
+		     pcap_capture_args_t * a)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  pcap_capture_ring_t *r = vec_len (cm->rings) ? cm->rings : 0;
+
+  if (cm->enabled_directions)
+    return clib_error_return (0, "capture already on, turn it off first");
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  /* Capture is off, so no worker looks at these */
+  cm->sw_if_index = a->sw_if_index;
+  cm->rx_sw_if_index = (a->sw_if_index == ~0 ? ~0 :
+			vnet_get_sup_sw_interface (vnm,
+						   a->sw_if_index)->sw_if_index);
+  cm->filter_table_index = a->filter_table_index;
+  cm->snap_length = a->snap_length;
+  cm->ring_size = a->ring_size;
+  cm->max_file_bytes = a->max_file_bytes;
+  cm->max_files = a->max_files;
+  if (a->file_name)
+    {
+      vec_free (cm->file_name);
+      cm->file_name = a->file_name;
+      a->file_name = 0;
+    }
+
+  /* Reallocate if the geometry changed, otherwise just empty them */
+  if (r == 0 || vec_len (cm->rings) != vec_len (vlib_mains)
+      || r->slot_mask != cm->ring_size - 1
+      || r->slot_bytes != round_pow2 (sizeof (pcap_capture_slot_t)
+				      + cm->snap_length,
+				      CLIB_CACHE_LINE_BYTES))
+    {
+      pcap_capture_rings_free (cm);
+      pcap_capture_rings_alloc (cm);
+    }
+
+  vec_foreach (r, cm->rings)
+  {
+    r->head = r->tail = 0;
+    r->n_captured = r->n_filtered = r->n_ring_full = 0;
+  }
+
+  vlib_worker_thread_barrier_release (vm);
+
+  cm->start_unix_time = unix_time_now ();
+  cm->start_cpu_time = clib_cpu_time_now ();
+  cm->seconds_per_clock = vm->clib_time.seconds_per_clock;
+  cm->file_index = 0;
+  cm->n_files_written = 0;
+  cm->n_packets_written = 0;
+
+  /* Left enabled if the writer stopped the capture on an error */
+  pcap_capture_rx_feature_disable (cm);
+  if (a->enabled_directions & (1 << PCAP_CAPTURE_RX))
+    pcap_capture_rx_feature_enable (cm);
+
+  /* Workers start capturing as soon as they see this */
+  CLIB_MEMORY_BARRIER ();
+  cm->enabled_directions = a->enabled_directions;
+
+  vlib_process_signal_event (vm, pcap_capture_writer_node.index, 0, 0);
+  return 0;
+}
+
+static clib_error_t *
+pcap_capture_disable (vlib_main_t * vm, pcap_capture_main_t * cm)
+{
+  clib_error_t *error = 0;
+
+  if (cm->enabled_directions == 0)
+    return 0;
+
+  /* No worker is inside the capture function after the barrier */
+  vlib_worker_thread_barrier_sync (vm);
+  cm->enabled_directions = 0;
+  vlib_worker_thread_barrier_release (vm);
+
+  pcap_capture_rx_feature_disable (cm);
+
+  error = pcap_capture_drain (cm);
+  vec_reset_length (cm->write_buffer);
+  pcap_capture_file_close (cm);
+
+  return error;
+}
+
+static clib_error_t *
+pcap_capture_init (vlib_main_t * vm)
+{
+  pcap_capture_main_t *cm = &pcap_capture_main;
+
+  cm->sw_if_index = ~0;
+  cm->rx_sw_if_index = ~0;
+  cm->filter_table_index = ~0;
+  cm->snap_length = 128;
+  cm->ring_size = 4096;
+  cm->max_files = 4;
+  cm->file_descriptor = -1;
+  cm->file_name = format (0, "/tmp/capture.pcapng%c", 0);
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (pcap_capture_init);
+
+static clib_error_t *
+pcap_capture_command_fn (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  pcap_capture_main_t *cm = &pcap_capture_main;
+  vnet_classify_main_t *vcm = &vnet_classify_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  pcap_capture_args_t _a, *a = &_a;
+  clib_error_t *error = 0;
+  u32 max_mbytes;
+  u8 *filename;
+  int off = 0;
+
+  /* Settings not given keep their last value */
+  memset (a, 0, sizeof (*a));
+  a->sw_if_index = cm->sw_if_index;
+  a->filter_table_index = cm->filter_table_index;
+  a->snap_length = cm->snap_length;
+  a->ring_size = cm->ring_size;
+  a->max_file_bytes = cm->max_file_bytes;
+  a->max_files = cm->max_files;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "off"))
+	off = 1;
+      else if (unformat (input, "rx"))
+	a->enabled_directions |= 1 << PCAP_CAPTURE_RX;
+      else if (unformat (input, "tx"))
+	a->enabled_directions |= 1 << PCAP_CAPTURE_TX;
+      else if (unformat (input, "intfc any"))
+	a->sw_if_index = ~0;
+      else if (unformat (input, "intfc %U",
+			 unformat_vnet_sw_interface, vnm, &a->sw_if_index))
+	;
+      else if (unformat (input, "filter-table %d", &a->filter_table_index))
+	;
+      else if (unformat (input, "no-filter"))
+	a->filter_table_index = ~0;
+      else if (unformat (input, "snaplen %d", &a->snap_length))
+	;
+      else if (unformat (input, "ring-size %d", &a->ring_size))
+	;
+      else if (unformat (input, "max-file-size %d", &max_mbytes))
+	a->max_file_bytes = (u64) max_mbytes << 20;
+      else if (unformat (input, "max-files %d", &a->max_files))
+	;
+      else if (unformat (input, "file %s", &filename))
+	{
+	  /* Brain-police user path input */
+	  if (strstr ((char *) filename, "..")
+	      || index ((char *) filename, '/'))
+	    {
+	      vec_free (filename);
+	      error = clib_error_return (0, "illegal characters in filename");
+	      goto done;
+	    }
+	  vec_free (a->file_name);
+	  a->file_name = format (0, "/tmp/%s%c", filename, 0);
+	  vec_free (filename);
+	}
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, input);
+	  goto done;
+	}
+    }
+
+  if (off)
+    {
+      error = pcap_capture_disable (vm, cm);
+      goto done;
+    }
+
+  if (a->enabled_directions == 0)
+    error = clib_error_return (0, "specify rx, tx or off");
+  else if (a->filter_table_index != ~0
+	   && pool_is_free_index (vcm->tables, a->filter_table_index))
+    error = clib_error_return (0, "no such classify table %d",
+			       a->filter_table_index);
+  else if (a->snap_length == 0 || a->snap_length > (64 << 10))
+    error = clib_error_return (0, "snaplen must be between 1 and 65536");
+  else if (!is_pow2 (a->ring_size) || a->ring_size < 64)
+    error = clib_error_return (0, "ring-size must be a power of 2 >= 64");
+  else if (a->max_files == 0)
+    error = clib_error_return (0, "max-files must be non-zero");
+  else
+    error = pcap_capture_enable (vm, cm, a);
+
+done:
+  vec_free (a->file_name);
+  return error;
+}
+
+/*?
+ * Capture received and/or transmitted packets at line rate into pcapng
+ * files. Each thread copies matching packets, truncated to
+ * '<em>snaplen</em>' bytes, into its own ring of '<em>ring-size</em>'
+ * slots; a process on the main thread streams them to
+ * '<em>/tmp/<file></em>'. If the writer falls behind the capture is
+ * dropped (see '<em>show pcap capture</em>'), never the packet.
+ *
+ * Packets may be restricted to one interface and to those that hit a
+ * classify table chain, evaluated on the packet starting at its
+ * ethernet header. With '<em>max-file-size</em>' set, output rotates
+ * through '<em>max-files</em>' files named <file>.0, <file>.1, ...
+ *
+ * Received packets are captured on the device-input feature arc of the
+ * interface, or of every hardware interface for '<em>intfc any</em>',
+ * so packets of a sub-interface are captured on its parent. Transmitted
+ * packets are captured at the interface output node. Settings only
+ * change while capture is off.
+ *
+ * @cliexpar
+ * @cliexcmd{pcap capture rx tx intfc GigabitEthernet0/8/0 snaplen 96 max-file-size 100 max-files 8}
+ * @cliexcmd{pcap capture off}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (pcap_capture_command, static) = {
+  .path = "pcap capture",
+  .short_help = "pcap capture [rx] [tx] [intfc <intfc>|any] "
+  "[filter-table <n>|no-filter] [snaplen <n>] [ring-size <n>] "
+  "[file <name>] [max-file-size <MB>] [max-files <n>] | off",
+  .function = pcap_capture_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_pcap_capture_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  pcap_capture_main_t *cm = &pcap_capture_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  pcap_capture_ring_t *r;
+
+  vlib_cli_output (vm, "pcap capture %s%s%s, file %s",
+		   cm->enabled_directions ? "on" : "off",
+		   (cm->enabled_directions & (1 << PCAP_CAPTURE_RX)) ?
+		   " rx" : "",
+		   (cm->enabled_directions & (1 << PCAP_CAPTURE_TX)) ?
+		   " tx" : "", cm->file_name);
+  if (cm->sw_if_index != ~0)
+    vlib_cli_output (vm, "  interface %U", format_vnet_sw_if_index_name,
+		     vnm, cm->sw_if_index);
+  if (cm->filter_table_index != ~0)
+    vlib_cli_output (vm, "  filter classify table %d",
+		     cm->filter_table_index);
+  vlib_cli_output (vm, "  snaplen %d, ring size %d, max file size %lluMB, "
+		   "max files %d", cm->snap_length, cm->ring_size,
+		   cm->max_file_bytes >> 20, cm->max_files);
+  vlib_cli_output (vm, "  %llu packets written to %d files",
+		   cm->n_packets_written, cm->n_files_written);
+
+  vec_foreach (r, cm->rings)
+  {
+    vlib_cli_output (vm, "  thread %d: captured %llu filtered %llu "
+		     "ring full %llu in ring %u",
+		     r - cm->rings, r->n_captured, r->n_filtered,
+		     r->n_ring_full, r->head - r->tail);
+  }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_pcap_capture_command, static) = {
+  .path = "show pcap capture",
+  .short_help = "show pcap capture",
+  .function = show_pcap_capture_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
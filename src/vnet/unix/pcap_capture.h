@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief Line-rate rx/tx packet capture.
+ *
+ * Worker threads copy matching packets, truncated to the snap length,
+ * into a per-thread single-producer/single-consumer ring. A process on
+ * the main thread drains the rings and streams pcapng blocks to disk,
+ * rotating files by size. A full ring drops the capture, never the
+ * packet.
+ */
+#ifndef included_vnet_pcap_capture_h
+#define included_vnet_pcap_capture_h
+
+#include <vlib/vlib.h>
+
+typedef enum
+{
+  PCAP_CAPTURE_RX,
+  PCAP_CAPTURE_TX,
+  PCAP_CAPTURE_N_DIRECTIONS,
+} pcap_capture_direction_t;
+
+/** Ring slot header, snap length bytes of packet data follow. */
+typedef struct
+{
+  u64 cpu_time;
+  u32 sw_if_index;
+  u32 n_bytes_in_packet;
+  u32 n_bytes_captured;
+  u32 direction;
+  u8 data[0];
+} pcap_capture_slot_t;
+
+/** Per-thread capture ring */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /** Read-only after setup */
+  u8 *slots;
+  u32 slot_mask;
+  u32 slot_bytes;
+
+  /** Producer (worker) side */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 head;
+  u64 n_captured;
+  u64 n_filtered;
+  u64 n_ring_full;
+
+  /** Consumer (writer process) side */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  volatile u32 tail;
+} pcap_capture_ring_t;
+
+typedef struct
+{
+  /** Bitmap of enabled directions, checked in the data path */
+  u32 enabled_directions;
+
+  /** Capture only this interface, ~0 for any */
+  u32 sw_if_index;
+
+  /** Received packets are seen on the interface's hardware interface */
+  u32 rx_sw_if_index;
+
+  /** Interfaces the rx capture feature is enabled on */
+  u32 *rx_feature_sw_if_indices;
+
+  /** Classify table chain the packet must hit, ~0 for none */
+  u32 filter_table_index;
+
+  /** Bytes of each packet to keep */
+  u32 snap_length;
+
+  /** Slots per thread ring, power of 2 */
+  u32 ring_size;
+
+  /** One ring per thread */
+  pcap_capture_ring_t *rings;
+
+  /** Output file base name, rotated files get a .<n> suffix */
+  u8 *file_name;
+  u64 max_file_bytes;
+  u32 max_files;
+
+  /** Current output file */
+  int file_descriptor;
+  u32 file_index;
+  u32 n_files_written;
+  u64 n_file_bytes;
+  u64 n_packets_written;
+
+  /** pcapng interface id by sw_if_index, per file */
+  uword *interface_id_by_sw_if_index;
+  u32 n_interface_ids;
+
+  /** Blocks waiting to be written */
+  u8 *write_buffer;
+
+  /** Maps cpu clocks in slots to wall clock time */
+  f64 start_unix_time;
+  u64 start_cpu_time;
+  f64 seconds_per_clock;
+
+  u32 writer_process_node_index;
+} pcap_capture_main_t;
+
+extern pcap_capture_main_t pcap_capture_main;
+
+void pcap_capture_buffers_internal (vlib_main_t * vm, u32 * buffers,
+				    u32 n_buffers, u32 sw_if_index,
+				    pcap_capture_direction_t direction);
+
+/**
+ * @brief Capture a vector of buffers if capture is enabled in the given
+ * direction. sw_if_index ~0 takes the interface from each buffer's
+ * sw_if_index[VLIB_RX].
+ */
+always_inline void
+pcap_capture_buffers (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
+		      u32 sw_if_index, pcap_capture_direction_t direction)
+{
+  if (PREDICT_FALSE (pcap_capture_main.enabled_directions & (1 << direction)))
+    pcap_capture_buffers_internal (vm, buffers, n_buffers, sw_if_index,
+				   direction);
+}
+
+#endif /* included_vnet_pcap_capture_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
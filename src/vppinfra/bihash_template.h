@@ -337,11 +337,47 @@ static inline int BV (clib_bihash_search_inline)
   return -1;
 }
 
-static inline int BV (clib_bihash_search_inline_2)
+/*
+ * Prefetch the bucket, and then the key/value page, for a key's hash
+ * ahead of a clib_bihash_search_inline_2_with_hash()
+ */
+static inline void BV (clib_bihash_prefetch_bucket)
+  (BVT (clib_bihash) * h, u64 hash)
+{
+  u32 bucket_index;
+  BVT (clib_bihash_bucket) * b;
+
+  bucket_index = hash & (h->nbuckets - 1);
+  b = &h->buckets[bucket_index];
+
+  CLIB_PREFETCH (b, CLIB_CACHE_LINE_BYTES, READ);
+}
+
+static inline void BV (clib_bihash_prefetch_data)
+  (BVT (clib_bihash) * h, u64 hash)
+{
+  u32 bucket_index;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_bucket) * b;
+
+  bucket_index = hash & (h->nbuckets - 1);
+  b = &h->buckets[bucket_index];
+
+  if (PREDICT_FALSE (b->offset == 0))
+    return;
+
+  hash >>= h->log2_nbuckets;
+  v = BV (clib_bihash_get_value) (h, b->offset);
+
+  v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
+
+  CLIB_PREFETCH (v, CLIB_CACHE_LINE_BYTES, READ);
+}
+
+static inline int BV (clib_bihash_search_inline_2_with_hash)
   (BVT (clib_bihash) * h,
-   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+   u64 hash, BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
 {
-  u64 hash;
   u32 bucket_index;
   BVT (clib_bihash_value) * v;
   BVT (clib_bihash_bucket) * b;
@@ -352,8 +388,6 @@ static inline int BV (clib_bihash_search_inline_2)
 
   ASSERT (valuep);
 
-  hash = BV (clib_bihash_hash) (search_key);
-
   bucket_index = hash & (h->nbuckets - 1);
   b = &h->buckets[bucket_index];
 
@@ -414,6 +448,14 @@ static inline int BV (clib_bihash_search_inline_2)
   return -1;
 }
 
+static inline int BV (clib_bihash_search_inline_2)
+  (BVT (clib_bihash) * h,
+   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  return BV (clib_bihash_search_inline_2_with_hash)
+    (h, BV (clib_bihash_hash) (search_key), search_key, valuep);
+}
+
 #endif /* __included_bihash_template_h__ */
 
 /** @endcond */
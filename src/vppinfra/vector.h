@@ -122,6 +122,10 @@ typedef u64 u64x4 _vector_size (32);
 
 typedef f32 f32x8 _vector_size (32);
 typedef f64 f64x4 _vector_size (32);
+
+/* Unaligned views, for loads from packet data and the like. */
+typedef u64 u64x2u _vector_size (16) __attribute__ ((aligned (1), __may_alias__));
+typedef u64 u64x4u _vector_size (32) __attribute__ ((aligned (1), __may_alias__));
 #endif /* CLIB_HAVE_VEC128 */
 
 #ifdef CLIB_HAVE_VEC512
@@ -257,6 +257,8 @@ u64x2_write_hi (u64x2 x, u64 * a)
 
 /* Unaligned loads/stores. */
 
+#define CLIB_HAVE_VEC128_UNALIGNED_LOAD_STORE
+
 #define _(t)						\
   always_inline void t##_store_unaligned (t x, t * a)	\
   { _mm_storeu_si128 ((__m128i *) a, (__m128i) x); }	\
@@ -593,6 +595,8 @@ i32x4_get0 (i32x4 x)
 }
 
 /* Converts all ones/zeros compare mask to bitmap. */
+#define CLIB_HAVE_VEC128_MSB_MASK
+
 always_inline u32
 u8x16_compare_byte_mask (u8x16 x)
 {
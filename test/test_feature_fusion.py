@@ -0,0 +1,317 @@
+#!/usr/bin/env python
+
+import unittest
+import socket
+import binascii
+
+from framework import VppTestCase, VppTestRunner
+
+from scapy.packet import Raw
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from util import ppp
+
+
+class TestFeatureFusion(VppTestCase):
+    """ Feature Fusion Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        """
+        Perform standard class setup (defined by class method setUpClass in
+        class VppTestCase) before running the test case, set test case related
+        variables and configure VPP.
+
+        **Config:**
+            - create 2 pg interfaces, pg0 (inside) and pg1 (outside)
+            - enable on the ip4-unicast arc of pg0:
+                - strict unicast RPF
+                - input ACL, denying packets for pg1 host 1
+                - policer classify, dropping packets for pg1 host 2
+                - ACL plugin, permitting UDP and adding sessions
+        """
+        super(TestFeatureFusion, cls).setUpClass()
+
+        cls.create_pg_interfaces(range(2))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+        cls.pg1.generate_remote_hosts(3)
+        cls.pg1.configure_ipv4_neighbors()
+
+        cls.nat_addr = '10.0.0.3'
+        cls.spoofed_src = '172.16.1.1'
+        cls.flows_per_kind = 4
+
+        cls.vapi.cli("set interface ip source-check %s" % cls.pg0.name)
+
+        cls.inacl_table = cls.create_classify_table()
+        cls.vapi.classify_add_del_session(
+            1, cls.inacl_table,
+            cls.build_ip_dst_match(cls.pg1.remote_hosts[1].ip4),
+            hit_next_index=0)
+        cls.vapi.input_acl_set_interface(
+            1, cls.pg0.sw_if_index, ip4_table_index=cls.inacl_table)
+
+        policer = cls.vapi.policer_add_del("fusion-drop", 400, 0, 10, 0,
+                                           rate_type=1,
+                                           conform_action_type=0)
+        cls.policer_table = cls.create_classify_table()
+        cls.vapi.classify_add_del_session(
+            1, cls.policer_table,
+            cls.build_ip_dst_match(cls.pg1.remote_hosts[2].ip4),
+            hit_next_index=policer.policer_index)
+        cls.vapi.cli("set policer classify interface %s ip4-table %d" %
+                     (cls.pg0.name, cls.policer_table))
+
+        rule = {'is_permit': 2, 'is_ipv6': 0,
+                'src_ip_addr': socket.inet_pton(socket.AF_INET, "0.0.0.0"),
+                'src_ip_prefix_len': 0,
+                'dst_ip_addr': socket.inet_pton(socket.AF_INET, "0.0.0.0"),
+                'dst_ip_prefix_len': 0,
+                'srcport_or_icmptype_first': 0,
+                'srcport_or_icmptype_last': 65535,
+                'dstport_or_icmpcode_first': 0,
+                'dstport_or_icmpcode_last': 65535,
+                'proto': socket.IPPROTO_UDP}
+        reply = cls.vapi.acl_add_replace(0xffffffff, [rule])
+        cls.acl_index = reply.acl_index
+        cls.vapi.acl_interface_set_acl_list(cls.pg0.sw_if_index, 1,
+                                            [cls.acl_index])
+
+    def tearDown(self):
+        super(TestFeatureFusion, self).tearDown()
+        if not self.vpp_dead:
+            self.logger.info(self.vapi.cli("show feature fusion"))
+            self.logger.info(self.vapi.cli("show interface features %s" %
+                                           self.pg0.name))
+            self.logger.info(self.vapi.cli("show acl-plugin sessions"))
+            self.logger.info(self.vapi.cli("show nat44 verbose"))
+
+    @classmethod
+    def create_classify_table(cls):
+        """Create a classify table matching the IPv4 destination address
+        behind the ethernet header, whose misses continue along the arc
+
+        :returns: the new table index
+        """
+        mask = '{:0>60}{:0>8}'.format('', 'ffffffff')
+        r = cls.vapi.classify_add_del_table(
+            1,
+            binascii.unhexlify(mask),
+            match_n_vectors=(len(mask) - 1) // 32 + 1)
+        return r.new_table_index
+
+    @staticmethod
+    def build_ip_dst_match(dst_ip):
+        """Build the classify match for an IPv4 destination address
+
+        :param str dst_ip: destination ip address with format of "x.x.x.x"
+        """
+        return binascii.unhexlify('{:0>60}{:0>8}'.format(
+            '', socket.inet_aton(dst_ip).encode('hex')))
+
+    def create_stream(self, sport_base, kinds):
+        """Create the same mix of packets for every run, on flows of their
+        own
+
+        :param int sport_base: first UDP source port of the run's flows
+        :param list kinds: (source, destination) address of each kind
+                           of packet
+        :returns: list of packets
+        """
+        pkts = []
+        for i in range(self.flows_per_kind):
+            for src, dst in kinds:
+                pkts.append(Ether(dst=self.pg0.local_mac,
+                                  src=self.pg0.remote_mac) /
+                            IP(src=src, dst=dst) /
+                            UDP(sport=sport_base + i, dport=5678) /
+                            Raw('\xa5' * 64))
+        return pkts
+
+    def error_counters(self):
+        """Read the error counters since the last 'clear errors'
+
+        :returns: dictionary of counts, keyed by node and reason
+        """
+        counters = {}
+        for line in self.vapi.cli("show errors").split('\n')[1:]:
+            fields = line.split()
+            if len(fields) < 3 or not fields[0].isdigit():
+                continue
+            counters[(fields[1], ' '.join(fields[2:]))] = int(fields[0])
+        return counters
+
+    def run_traffic(self, sport_base, kinds, n_expected):
+        """Send a run's packets twice, first on new flows, then on the ACL
+        and NAT sessions the first burst added
+
+        :param int sport_base: first UDP source port of the run's flows
+        :param list kinds: (source, destination) address of each kind
+                           of packet
+        :param int n_expected: packets of a burst expected on pg1
+        :returns: error counters of the run, packets received on pg1,
+                  and the number of NAT sessions the run added
+        """
+        pkts = self.create_stream(sport_base, kinds)
+        n_sessions = len(self.vapi.nat44_user_session_dump(
+            self.pg0.remote_ip4n, 0))
+        self.vapi.cli("clear errors")
+
+        rx = []
+        for burst in range(2):
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            rx.extend(self.pg1.get_capture(n_expected))
+            self.pg0.assert_nothing_captured()
+
+        counters = self.error_counters()
+        n_sessions = len(self.vapi.nat44_user_session_dump(
+            self.pg0.remote_ip4n, 0)) - n_sessions
+        return counters, rx, n_sessions
+
+    def run_unfused_and_fused(self, kinds, n_expected):
+        """Run the same traffic with the ip4-unicast arc unfused, then
+        fused, and check both runs count the same errors
+
+        :param list kinds: (source, destination) address of each kind
+                           of packet
+        :param int n_expected: packets of a burst expected on pg1
+        :returns: counters of the unfused run, packets received on pg1
+                  and NAT sessions added by each run, and the fused
+                  node's counts of fused and punted packets
+        """
+        unfused_counters, unfused_rx, unfused_sessions = \
+            self.run_traffic(10000, kinds, n_expected)
+
+        self.vapi.cli("set feature fusion ip4-unicast")
+        self.logger.info(self.vapi.cli("show feature fusion"))
+        try:
+            fused_counters, fused_rx, fused_sessions = \
+                self.run_traffic(20000, kinds, n_expected)
+        finally:
+            self.vapi.cli("set feature fusion ip4-unicast disable")
+
+        fused_node = "ip4-unicast-fused"
+        n_punted = fused_counters.pop(
+            (fused_node, "packets handed to a feature node"), 0)
+        n_fused = fused_counters.pop(
+            (fused_node, "packets through fused features"), 0)
+        self.assertEqual(n_fused + n_punted, 2 * len(kinds) *
+                         self.flows_per_kind)
+        self.assertEqual(fused_counters, unfused_counters)
+        self.assertEqual(fused_sessions, unfused_sessions)
+        return (unfused_counters, unfused_rx, fused_rx, unfused_sessions,
+                n_fused, n_punted)
+
+    def verify_forwarded(self, rx, src):
+        """Verify the packets received on pg1 were forwarded to pg1 host 0
+
+        :param list rx: packets received on pg1
+        :param str src: source address expected on pg1
+        :returns: sorted list of the received flows' fields but the
+                  source port, which each run picks
+        """
+        flows = []
+        for p in rx:
+            try:
+                self.assertEqual(p[IP].src, src)
+                self.assertEqual(p[IP].dst, self.pg1.remote_hosts[0].ip4)
+                self.assertEqual(p[UDP].dport, 5678)
+                flows.append((p[IP].dst, p[UDP].dport, p[IP].ttl))
+            except:
+                self.logger.error(ppp("Unexpected or invalid packet:", p))
+                raise
+        return sorted(flows)
+
+    def test_fused_same_as_unfused(self):
+        """ Fused ip4-unicast features behave as the feature nodes
+
+        Test scenario:
+            - send the same mix of packets through the pg0 arc unfused,
+              then fused, each time on new flows followed by flows with
+              ACL sessions: forwarded, dropped by uRPF, by the input ACL
+              and by the policer
+            - verify both runs forward and drop the same packets and
+              count the same errors
+            - verify the fused run went through the fused node, and handed
+              the packets adding ACL sessions to the ACL node
+        """
+        kinds = [(self.pg0.remote_ip4, self.pg1.remote_hosts[0].ip4),
+                 (self.spoofed_src, self.pg1.remote_hosts[0].ip4),
+                 (self.pg0.remote_ip4, self.pg1.remote_hosts[1].ip4),
+                 (self.pg0.remote_ip4, self.pg1.remote_hosts[2].ip4)]
+        n_flows = len(kinds) * self.flows_per_kind
+
+        counters, unfused_rx, fused_rx, n_sessions, n_fused, n_punted = \
+            self.run_unfused_and_fused(kinds, self.flows_per_kind)
+
+        # the ACL comes first, every packet of a new flow adds a session
+        self.assertEqual(n_punted, n_flows)
+        self.assertEqual(
+            counters.get(("acl-plugin-in-ip4-fa", "new sessions added")),
+            n_flows)
+        self.assertEqual(
+            counters.get(("ip4-input", "ip4 unicast source check fails")),
+            2 * self.flows_per_kind)
+        self.assertEqual(
+            counters.get(("ip4-input", "input ACL session deny drops")),
+            2 * self.flows_per_kind)
+        self.assertEqual(
+            counters.get(("ip4-policer-classify",
+                          "Policer classify hits")),
+            2 * self.flows_per_kind)
+
+        self.assertEqual(
+            self.verify_forwarded(fused_rx, self.pg0.remote_ip4),
+            self.verify_forwarded(unfused_rx, self.pg0.remote_ip4))
+
+    def test_fused_nat_same_as_unfused(self):
+        """ Fused NAT44 classify behaves as its node
+
+        NAT44 classify sorts ahead of the other features of the arc and
+        takes the packets off it, so its flows go through no other feature.
+
+        Test scenario:
+            - make pg0 both NAT44 inside and outside
+            - send the same flows through the pg0 arc unfused, then fused
+            - verify both runs translate the same packets in2out, count the
+              same errors and add the same NAT sessions
+            - verify the fused run dealt with all packets in the fused node
+        """
+        nat_addr_n = socket.inet_pton(socket.AF_INET, self.nat_addr)
+        self.vapi.nat44_add_del_address_range(nat_addr_n, nat_addr_n)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        try:
+            kinds = [(self.pg0.remote_ip4, self.pg1.remote_hosts[0].ip4)]
+
+            counters, unfused_rx, fused_rx, n_sessions, n_fused, n_punted = \
+                self.run_unfused_and_fused(kinds, self.flows_per_kind)
+
+            self.assertEqual(n_punted, 0)
+            self.assertEqual(n_sessions, self.flows_per_kind)
+            self.assertEqual(
+                self.verify_forwarded(fused_rx, self.nat_addr),
+                self.verify_forwarded(unfused_rx, self.nat_addr))
+        finally:
+            self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                      is_inside=0,
+                                                      is_add=0)
+            self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index,
+                                                      is_inside=0,
+                                                      is_add=0)
+            self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index,
+                                                      is_add=0)
+            self.vapi.nat44_add_del_address_range(nat_addr_n, nat_addr_n,
+                                                  is_add=0)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
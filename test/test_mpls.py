@@ -48,6 +48,24 @@ def verify_mpls_stack(tst, rx, mpls_labels, ttl=255, num=0):
             rx_mpls = rx_mpls[MPLS].payload
 
 
+def verify_mpls_stack_uniform(tst, rx, mpls_labels, ttl, exp):
+    # in uniform mode every label takes the TTL and EXP of the payload
+    eth = rx[Ether]
+    tst.assertEqual(eth.type, 0x8847)
+
+    rx_mpls = rx[MPLS]
+
+    for ii in range(len(mpls_labels)):
+        tst.assertEqual(rx_mpls.label, mpls_labels[ii])
+        tst.assertEqual(rx_mpls.cos, exp)
+        tst.assertEqual(rx_mpls.ttl, ttl)
+        if ii == len(mpls_labels) - 1:
+            tst.assertEqual(rx_mpls.s, 1)
+        else:
+            tst.assertEqual(rx_mpls.s, 0)
+            rx_mpls = rx_mpls[MPLS].payload
+
+
 class TestMPLS(VppTestCase):
     """ MPLS Test Case """
 
@@ -107,7 +125,8 @@ class TestMPLS(VppTestCase):
             ip_itf=None,
             dst_ip=None,
             chksum=None,
-            n=257):
+            n=257,
+            mpls_exp=0):
         self.reset_packet_infos()
         pkts = []
         for i in range(0, n):
@@ -117,9 +136,11 @@ class TestMPLS(VppTestCase):
 
             for ii in range(len(mpls_labels)):
                 if ii == len(mpls_labels) - 1:
-                    p = p / MPLS(label=mpls_labels[ii], ttl=mpls_ttl, s=1)
+                    p = p / MPLS(label=mpls_labels[ii], ttl=mpls_ttl,
+                                 cos=mpls_exp, s=1)
                 else:
-                    p = p / MPLS(label=mpls_labels[ii], ttl=mpls_ttl, s=0)
+                    p = p / MPLS(label=mpls_labels[ii], ttl=mpls_ttl,
+                                 cos=mpls_exp, s=0)
             if not ping:
                 if not dst_ip:
                     p = (p / IP(src=src_if.local_ip4, dst=src_if.remote_ip4) /
@@ -140,14 +161,15 @@ class TestMPLS(VppTestCase):
             pkts.append(p)
         return pkts
 
-    def create_stream_ip4(self, src_if, dst_ip):
+    def create_stream_ip4(self, src_if, dst_ip, ip_ttl=64, ip_dscp=0):
         self.reset_packet_infos()
         pkts = []
         for i in range(0, 257):
             info = self.create_packet_info(src_if, src_if)
             payload = self.info_to_payload(info)
             p = (Ether(dst=src_if.local_mac, src=src_if.remote_mac) /
-                 IP(src=src_if.remote_ip4, dst=dst_ip) /
+                 IP(src=src_if.remote_ip4, dst=dst_ip,
+                    ttl=ip_ttl, tos=ip_dscp << 2) /
                  UDP(sport=1234, dport=1234) /
                  Raw(payload))
             info.data = p.copy()
@@ -226,6 +248,33 @@ class TestMPLS(VppTestCase):
         except:
             raise
 
+    def verify_capture_labelled_ip4_uniform(self, src_if, capture, sent,
+                                            mpls_labels):
+        try:
+            capture = verify_filter(capture, sent)
+
+            self.assertEqual(len(capture), len(sent))
+
+            for i in range(len(capture)):
+                tx = sent[i]
+                rx = capture[i]
+                tx_ip = tx[IP]
+                rx_ip = rx[IP]
+
+                # every label has the IP's TTL, and its precedence as EXP
+                verify_mpls_stack_uniform(self, rx, mpls_labels,
+                                          rx_ip.ttl, tx_ip.tos >> 5)
+
+                self.assertEqual(rx_ip.src, tx_ip.src)
+                self.assertEqual(rx_ip.dst, tx_ip.dst)
+                self.assertEqual(rx_ip.tos, tx_ip.tos)
+                self.assertEqual(rx_ip.ttl + 1, tx_ip.ttl)
+                # the stack ends where the payload starts
+                self.assertEqual(rx[Raw].load, tx[Raw].load)
+
+        except:
+            raise
+
     def verify_capture_tunneled_ip4(self, src_if, capture, sent, mpls_labels,
                                     ttl=255, top=None):
         if top is None:
@@ -715,6 +764,128 @@ class TestMPLS(VppTestCase):
         route_10_0_0_2.remove_vpp_config()
         route_10_0_0_1.remove_vpp_config()
 
+    def test_imposition_mode(self):
+        """ MPLS label imposition, uniform and pipe mode """
+
+        #
+        # pipe mode, the default; the outer labels have TTL 255, the
+        # inner most the IP's, and no label takes the IP's precedence
+        #
+        route_10_0_0_1 = VppIpRoute(self, "10.0.0.1", 32,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=[32, 33, 34])])
+        route_10_0_0_1.add_vpp_config()
+
+        tx = self.create_stream_ip4(self.pg0, "10.0.0.1",
+                                    ip_ttl=44, ip_dscp=0x38)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        self.verify_capture_labelled_ip4(self.pg0, rx, tx, [32, 33, 34])
+        for i in range(len(rx)):
+            self.assertEqual(rx[i][Raw].load, tx[i][Raw].load)
+
+        #
+        # uniform mode; every label takes the IP's TTL and precedence
+        #
+        route_10_0_0_2 = VppIpRoute(self, "10.0.0.2", 32,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=[32, 33, 34],
+                                                  is_uniform=1)])
+        route_10_0_0_2.add_vpp_config()
+
+        tx = self.create_stream_ip4(self.pg0, "10.0.0.2",
+                                    ip_ttl=44, ip_dscp=0x38)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        self.verify_capture_labelled_ip4_uniform(self.pg0, rx, tx,
+                                                 [32, 33, 34])
+
+        #
+        # a single label and the largest stack, which are painted
+        # differently from the rest
+        #
+        route_10_0_0_3 = VppIpRoute(self, "10.0.0.3", 32,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=[32],
+                                                  is_uniform=1)])
+        route_10_0_0_3.add_vpp_config()
+
+        tx = self.create_stream_ip4(self.pg0, "10.0.0.3",
+                                    ip_ttl=20, ip_dscp=0x28)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        self.verify_capture_labelled_ip4_uniform(self.pg0, rx, tx, [32])
+
+        labels_12 = list(range(40, 52))
+        route_10_0_0_4 = VppIpRoute(self, "10.0.0.4", 32,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=labels_12,
+                                                  is_uniform=1)])
+        route_10_0_0_4.add_vpp_config()
+
+        tx = self.create_stream_ip4(self.pg0, "10.0.0.4",
+                                    ip_ttl=33, ip_dscp=0x10)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        self.verify_capture_labelled_ip4_uniform(self.pg0, rx, tx,
+                                                 labels_12)
+
+        route_10_0_0_5 = VppIpRoute(self, "10.0.0.5", 32,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=labels_12)])
+        route_10_0_0_5.add_vpp_config()
+
+        tx = self.create_stream_ip4(self.pg0, "10.0.0.5",
+                                    ip_ttl=33, ip_dscp=0x10)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        self.verify_capture_labelled_ip4(self.pg0, rx, tx, labels_12)
+        for i in range(len(rx)):
+            self.assertEqual(rx[i][Raw].load, tx[i][Raw].load)
+
+        #
+        # swap in uniform mode; the out labels take the TTL, less one,
+        # and the EXP of the label swapped
+        #
+        route_34_eos = VppMplsRoute(self, 34, 1,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=[35, 36],
+                                                  is_uniform=1)])
+        route_34_eos.add_vpp_config()
+
+        tx = self.create_stream_labelled_ip4(self.pg0, [34],
+                                             mpls_ttl=40, mpls_exp=5)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        for p in rx:
+            verify_mpls_stack_uniform(self, p, [35, 36], 39, 5)
+
+        #
+        # and in pipe mode only the inner most label takes the TTL
+        #
+        route_37_eos = VppMplsRoute(self, 37, 1,
+                                    [VppRoutePath(self.pg0.remote_ip4,
+                                                  self.pg0.sw_if_index,
+                                                  labels=[38, 39])])
+        route_37_eos.add_vpp_config()
+
+        tx = self.create_stream_labelled_ip4(self.pg0, [37],
+                                             mpls_ttl=40, mpls_exp=5)
+        rx = self.send_and_expect(self.pg0, tx, self.pg0)
+        self.verify_capture_labelled(self.pg0, rx, tx, [38, 39],
+                                     ttl=39, num=1)
+
+        #
+        # cleanup
+        #
+        route_37_eos.remove_vpp_config()
+        route_34_eos.remove_vpp_config()
+        route_10_0_0_5.remove_vpp_config()
+        route_10_0_0_4.remove_vpp_config()
+        route_10_0_0_3.remove_vpp_config()
+        route_10_0_0_2.remove_vpp_config()
+        route_10_0_0_1.remove_vpp_config()
+
     def test_tunnel(self):
         """ MPLS Tunnel Tests """
 
@@ -111,6 +111,7 @@ class VppRoutePath(object):
             is_source_lookup=0,
             is_udp_encap=0,
             is_dvr=0,
+            is_uniform=0,
             next_hop_id=0xffffffff,
             proto=DpoProto.DPO_PROTO_IP4):
         self.nh_itf = nh_sw_if_index
@@ -137,6 +138,7 @@ class VppRoutePath(object):
         self.is_udp_encap = is_udp_encap
         self.next_hop_id = next_hop_id
         self.is_dvr = is_dvr
+        self.is_uniform = is_uniform
 
 
 class VppMRoutePath(VppRoutePath):
@@ -213,6 +215,7 @@ class VppIpRoute(VppObject):
                     is_resolve_attached=path.is_resolve_attached,
                     is_source_lookup=path.is_source_lookup,
                     is_udp_encap=path.is_udp_encap,
+                    is_uniform=path.is_uniform,
                     is_multipath=1 if len(self.paths) > 1 else 0)
         self._test.registry.register(self, self._test.logger)
 
@@ -528,7 +531,8 @@ class VppMplsRoute(VppObject):
                 next_hop_n_out_labels=len(
                     path.nh_labels),
                 next_hop_via_label=path.nh_via_label,
-                next_hop_table_id=path.nh_table_id)
+                next_hop_table_id=path.nh_table_id,
+                is_uniform=path.is_uniform)
         self._test.registry.register(self, self._test.logger)
 
     def remove_vpp_config(self):
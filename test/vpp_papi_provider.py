@@ -761,7 +761,8 @@ class VppPapiProvider(object):
             is_multipath=0,
             is_dvr=0,
             is_udp_encap=0,
-            is_source_lookup=0):
+            is_source_lookup=0,
+            is_uniform=0):
         """
 
         :param dst_address_length:
@@ -782,6 +783,7 @@ class VppPapiProvider(object):
         :param is_resolve_attached:  (Default value = 0)
         :param is_dvr:  (Default value = 0)
         :param is_source_lookup:  (Default value = 0)
+        :param is_uniform:  (Default value = 0)
         :param next_hop_weight:  (Default value = 1)
 
         """
@@ -810,6 +812,7 @@ class VppPapiProvider(object):
              'dst_address': dst_address,
              'next_hop_id': next_hop_id,
              'next_hop_address': next_hop_address,
+             'is_uniform': is_uniform,
              'next_hop_n_out_labels': next_hop_n_out_labels,
              'next_hop_via_label': next_hop_via_label,
              'next_hop_out_label_stack': next_hop_out_label_stack})
@@ -1072,7 +1075,8 @@ class VppPapiProvider(object):
             is_drop=0,
             is_multipath=0,
             classify_table_index=0xFFFFFFFF,
-            is_classify=0):
+            is_classify=0,
+            is_uniform=0):
         """
 
         :param dst_address_length:
@@ -1092,6 +1096,7 @@ class VppPapiProvider(object):
         :param is_multicast:  (Default value = 0)
         :param is_resolve_host:  (Default value = 0)
         :param is_resolve_attached:  (Default value = 0)
+        :param is_uniform:  (Default value = 0)
         :param next_hop_weight:  (Default value = 1)
 
         """
@@ -1113,6 +1118,7 @@ class VppPapiProvider(object):
              'mr_next_hop_proto': next_hop_proto,
              'mr_next_hop_weight': next_hop_weight,
              'mr_next_hop': next_hop_address,
+             'mr_is_uniform': is_uniform,
              'mr_next_hop_n_out_labels': next_hop_n_out_labels,
              'mr_next_hop_sw_if_index': next_hop_sw_if_index,
              'mr_next_hop_table_id': next_hop_table_id,